@@ -142,6 +142,12 @@ public:
 	bool getVorticityConfinement();
 	ciMsaFluidSolver& setWrap( bool bx, bool by );
 	
+	// solve on numThreads threads, one per core if numThreads is 0, each taking a band of rows
+	// the parallel solver relaxes red and black cells in turn rather than sweeping in order, so its results
+	// differ slightly from the serial solver's, but they don't depend on the number of threads
+	ciMsaFluidSolver& enableParallel( bool b, int numThreads = 0 );
+	bool getParallel() const;
+	
 	// returns average density of fluid 
 	float getAvgDensity() const;
 	
@@ -192,6 +198,44 @@ public:
 	
 	void	destroy();
 	
+	// runs a pass on every band of rows, one per thread; defined in ciMsaFluidSolver.cpp
+	class	Workers;
+	friend class Workers;
+	typedef void (ciMsaFluidSolver::*BandFn)( int band );
+	Workers	*_workers;			// NULL unless enableParallel(true)
+	
+	enum	RelaxBoundary { RELAX_BOUNDARY, RELAX_BOUNDARY_RGB, RELAX_BOUNDARY_UV };
+	// the arguments of the red-black linear solve run by relaxBand()
+	struct RelaxPass {
+		float			*x[3];
+		const float		*x0[3];		// NULL entries for no source term
+		int				numFields;
+		int				componentsPerCell;	// 2 for the interleaved components of a ci::Vec2f array
+		float			a, c;
+		RelaxBoundary	boundary;
+		int				bound;
+	};
+	RelaxPass	_relax;
+	// the arguments of the advect and project passes run on every band
+	struct BandArgs {
+		float			*d;
+		const float		*d0;
+		ci::Vec2f		*uv;
+		const ci::Vec2f	*duv;
+	};
+	BandArgs	_bandArgs;
+	
+	void	runBands( BandFn fn );
+	void	getBandRows( int band, int *firstRow, int *lastRow ) const;
+	void	relaxParallel( const RelaxPass &pass );
+	void	relaxBand( int band );
+	void	projectParallel( ci::Vec2f *xy );
+	void	divergenceBand( int band );
+	void	gradientBand( int band );
+	void	advectBand( int band );
+	void	advect2dBand( int band );
+	void	advectRGBBand( int band );
+	
 	inline	float	calcCurl(int i, int j);
 	void	vorticityConfinement(ci::Vec2f *Fvc_xy);
 	
@@ -202,6 +246,9 @@ public:
 	void	advect(int b, float *d, const float *d0, const ci::Vec2f *duv);
 	void	advect2d( ci::Vec2f *uv, const ci::Vec2f *duv );
 	void	advectRGB(int b, const ci::Vec2f *duv);
+	void	advectRows( float *d, const float *d0, const ci::Vec2f *duv, int firstRow, int lastRow );
+	void	advect2dRows( ci::Vec2f *uv, const ci::Vec2f *duv, int firstRow, int lastRow );
+	void	advectRGBRows( const ci::Vec2f *duv, int firstRow, int lastRow );
 	
 	void	diffuse(int b, float *c, float *c0, float diff);
 	void	diffuseRGB(int b, float diff);
@@ -46,6 +46,66 @@
 
 #include "ciMsaFluidSolver.h"
 #include "cinder/Rand.h"
+#include "cinder/System.h"
+#include "cinder/Thread.h"
+
+#include <boost/thread/barrier.hpp>
+#include <vector>
+
+#if defined( CINDER_SSE2 )
+	#include <emmintrin.h>
+#endif
+
+// Runs a solver pass on a fixed set of threads, each taking one band of rows. The calling thread takes band 0.
+class ciMsaFluidSolver::Workers {
+  public:
+	Workers( ciMsaFluidSolver *solver, int numThreads )
+		: mSolver( solver ), mBarrier( numThreads ), mFn( NULL ), mQuit( false )
+	{
+		for( int band = 1; band < numThreads; ++band )
+			mThreads.push_back( std::shared_ptr<std::thread>( new std::thread( &Workers::threadMain, this, band ) ) );
+	}
+	
+	~Workers()
+	{
+		mQuit = true;
+		mBarrier.wait();
+		for( size_t i = 0; i < mThreads.size(); ++i )
+			mThreads[i]->join();
+	}
+	
+	int		getNumThreads() const { return (int)mThreads.size() + 1; }
+	
+	// calls fn for every band and returns once all of them are done
+	void	run( BandFn fn )
+	{
+		mFn = fn;
+		mBarrier.wait();
+		(mSolver->*fn)( 0 );
+		mBarrier.wait();
+	}
+	
+	// for passes which need every band to finish a step before any starts the next
+	void	barrier() { mBarrier.wait(); }
+	
+  private:
+	void	threadMain( int band )
+	{
+		while( true ) {
+			mBarrier.wait();
+			if( mQuit )
+				return;
+			(mSolver->*mFn)( band );
+			mBarrier.wait();
+		}
+	}
+	
+	ciMsaFluidSolver		*mSolver;
+	boost::barrier			mBarrier;
+	BandFn					mFn;
+	bool					mQuit;
+	std::vector<std::shared_ptr<std::thread> >	mThreads;
+};
 
 ciMsaFluidSolver::ciMsaFluidSolver()
 :r(NULL)
@@ -58,6 +118,8 @@ ciMsaFluidSolver::ciMsaFluidSolver()
 ,uvOld(NULL)
 ,curl(NULL)
 ,_isInited(false)
+,_tmp(NULL)
+,_workers(NULL)
 {
 }
 
@@ -137,7 +199,20 @@ bool ciMsaFluidSolver::isInited() const {
 	return _isInited;
 }
 
+ciMsaFluidSolver& ciMsaFluidSolver::enableParallel( bool b, int numThreads ) {
+	delete _workers;
+	_workers = NULL;
+	if( b )
+		_workers = new Workers( this, ( numThreads > 0 ) ? numThreads : ci::math<int>::max( 1, ci::System::getNumCores() ) );
+	return *this;
+}
+
+bool ciMsaFluidSolver::getParallel() const {
+	return _workers != NULL;
+}
+
 ciMsaFluidSolver::~ciMsaFluidSolver() {
+	delete _workers;
 	destroy();
 }
 
@@ -156,6 +231,7 @@ void ciMsaFluidSolver::destroy() {
 	if(uv)		delete []uv;
 	if(uvOld)	delete []uvOld;
 	if(curl)       delete []curl;
+	if(_tmp)	delete []_tmp;
 }
 
 
@@ -175,11 +251,12 @@ void ciMsaFluidSolver::reset() {
 	uv    = new ci::Vec2f[_numCells];
 	uvOld = new ci::Vec2f[_numCells];
 	curl = new float[_numCells];
+	_tmp = new float[_numCells];
 	
 	for ( int i = _numCells-1; i>=0; --i )
 	{
 		uv[i] = uvOld[i] = ci::Vec2f::zero();
-		curl[i] = 0.0f;
+		curl[i] = _tmp[i] = 0.0f;
 		r[i] = rOld[i] = g[i] = gOld[i] = b[i] = bOld[i] = 0;
 	}
 }
@@ -487,6 +564,17 @@ void ciMsaFluidSolver::addSource(float* x, float* x0) {
 }
 
 void ciMsaFluidSolver::advect( int bound, float* d, const float* d0, const ci::Vec2f* duv) {
+	if( _workers ) {
+		BandArgs args = { d, d0, NULL, duv };
+		_bandArgs = args;
+		runBands( &ciMsaFluidSolver::advectBand );
+	}
+	else
+		advectRows( d, d0, duv, 1, _NY );
+	setBoundary(bound, d);
+}
+
+void ciMsaFluidSolver::advectRows( float* d, const float* d0, const ci::Vec2f* duv, int firstRow, int lastRow ) {
 	int i0, j0, i1, j1;
 	float x, y, s0, t0, s1, t1;
 	int	index;
@@ -494,7 +582,7 @@ void ciMsaFluidSolver::advect( int bound, float* d, const float* d0, const ci::V
 	const float dt0x = _dt * _NX;
 	const float dt0y = _dt * _NY;
 	
-	for (int j = _NY; j > 0; --j)
+	for (int j = lastRow; j >= firstRow; --j)
 	{
 		for (int i = _NX; i > 0; --i)
 		{
@@ -524,13 +612,24 @@ void ciMsaFluidSolver::advect( int bound, float* d, const float* d0, const ci::V
 			
 		}
 	}
-	setBoundary(bound, d);
 }
 
 //          d    d0    du    dv
 // advect(1, u, uOld, uOld, vOld);
 // advect(2, v, vOld, uOld, vOld);
 void ciMsaFluidSolver::advect2d( ci::Vec2f *uv, const ci::Vec2f *duv ) {
+	if( _workers ) {
+		BandArgs args = { NULL, NULL, uv, duv };
+		_bandArgs = args;
+		runBands( &ciMsaFluidSolver::advect2dBand );
+	}
+	else
+		advect2dRows( uv, duv, 1, _NY );
+	setBoundary2d(1, uv);
+	setBoundary2d(2, uv);	
+}
+
+void ciMsaFluidSolver::advect2dRows( ci::Vec2f *uv, const ci::Vec2f *duv, int firstRow, int lastRow ) {
 	int i0, j0, i1, j1;
 	float s0, t0, s1, t1;
 	int	index;
@@ -538,7 +637,7 @@ void ciMsaFluidSolver::advect2d( ci::Vec2f *uv, const ci::Vec2f *duv ) {
 	const float dt0x = _dt * _NX;
 	const float dt0y = _dt * _NY;
 	
-	for (int j = _NY; j > 0; --j)
+	for (int j = lastRow; j >= firstRow; --j)
 	{
 		for (int i = _NX; i > 0; --i)
 		{
@@ -570,11 +669,20 @@ void ciMsaFluidSolver::advect2d( ci::Vec2f *uv, const ci::Vec2f *duv ) {
 			
 		}
 	}
-	setBoundary2d(1, uv);
-	setBoundary2d(2, uv);	
 }
 
 void ciMsaFluidSolver::advectRGB(int bound, const ci::Vec2f* duv) {
+	if( _workers ) {
+		BandArgs args = { NULL, NULL, NULL, duv };
+		_bandArgs = args;
+		runBands( &ciMsaFluidSolver::advectRGBBand );
+	}
+	else
+		advectRGBRows( duv, 1, _NY );
+	setBoundaryRGB();
+}
+
+void ciMsaFluidSolver::advectRGBRows( const ci::Vec2f* duv, int firstRow, int lastRow ) {
 	int i0, j0;
 	float x, y, s0, t0, s1, t1, dt0x, dt0y;
 	int	index;
@@ -582,7 +690,7 @@ void ciMsaFluidSolver::advectRGB(int bound, const ci::Vec2f* duv) {
 	dt0x = _dt * _NX;
 	dt0y = _dt * _NY;
 	
-	for (int j = _NY; j > 0; --j)
+	for (int j = lastRow; j >= firstRow; --j)
 	{
 		for (int i = _NX; i > 0; --i)
 		{
@@ -612,7 +720,6 @@ void ciMsaFluidSolver::advectRGB(int bound, const ci::Vec2f* duv) {
 			b[index] = s0 * ( t0 * bOld[i0] + t1 * bOld[j0] ) + s1 * ( t0 * bOld[i0+1] + t1 * bOld[j0+1] );                          
 		}
 	}
-	setBoundaryRGB();
 }
 
 void ciMsaFluidSolver::diffuse( int bound, float* c, float* c0, float diff )
@@ -635,6 +742,11 @@ void ciMsaFluidSolver::diffuseUV( float diff )
 
 void ciMsaFluidSolver::project(ci::Vec2f* xy, ci::Vec2f* pDiv) 
 {
+	if( _workers ) {
+		projectParallel( xy );
+		return;
+	}
+	
 	float	h;
 	int		index;
 	int		step_x = _NX + 2;
@@ -677,6 +789,12 @@ void ciMsaFluidSolver::project(ci::Vec2f* xy, ci::Vec2f* pDiv)
 //	Gauss-Seidel relaxation
 void ciMsaFluidSolver::linearSolver( int bound, float* __restrict x, const float* __restrict x0, float a, float c )
 {
+	if( _workers ) {
+		RelaxPass pass = { { x }, { x0 }, 1, 1, a, 1.0f / c, RELAX_BOUNDARY, bound };
+		relaxParallel( pass );
+		return;
+	}
+	
 	int	step_x = _NX + 2;
 	int index;
 	c = 1. / c;
@@ -716,6 +834,12 @@ void ciMsaFluidSolver::linearSolverProject( ci::Vec2f* __restrict pdiv )
 
 void ciMsaFluidSolver::linearSolverRGB( float a, float c )
 {
+	if( _workers ) {
+		RelaxPass pass = { { r, g, b }, { rOld, gOld, bOld }, 3, 1, a, 1.0f / c, RELAX_BOUNDARY_RGB, 0 };
+		relaxParallel( pass );
+		return;
+	}
+	
 	int index3, index4, index;
 	int	step_x = _NX + 2;
 	c = 1. / c;
@@ -745,6 +869,12 @@ void ciMsaFluidSolver::linearSolverRGB( float a, float c )
 
 void ciMsaFluidSolver::linearSolverUV( float a, float c )
 {
+	if( _workers ) {
+		RelaxPass pass = { { &uv[0].x }, { &uvOld[0].x }, 1, 2, a, 1.0f / c, RELAX_BOUNDARY_UV, 1 };
+		relaxParallel( pass );
+		return;
+	}
+	
 	int index;
 	int	step_x = _NX + 2;
 	c = 1. / c;
@@ -960,3 +1090,197 @@ void ciMsaFluidSolver::randomizeColor() {
 	}
 }
 
+
+// parallel solver
+
+void ciMsaFluidSolver::runBands( BandFn fn )
+{
+	_workers->run( fn );
+}
+
+// splits rows 1.._NY into one contiguous band per thread, so that each thread keeps to its own part of the grid
+void ciMsaFluidSolver::getBandRows( int band, int *firstRow, int *lastRow ) const
+{
+	int numBands = _workers->getNumThreads();
+	*firstRow = 1 + band * _NY / numBands;
+	*lastRow = ( band + 1 ) * _NY / numBands;
+}
+
+// One half sweep of red-black Gauss-Seidel over rows firstRow..lastRow: each cell (i, j) with (i + j) & 1 == color is set to
+// ((left + right + up + down) * a + x0) * c, in each of the numFields fields at once. A cell's neighbours are all of the
+// other color, so the cells of one color can be relaxed in any order, and by several threads.
+// The SSE2 path computes four components at a time and keeps only those of the right color; it gives the same results as the
+// scalar path. The discarded lanes may read cells another band is writing, but only cells of this row are ever written.
+static void relaxRows( float * const *x, const float * const *x0, int numFields, int componentsPerCell, int NX, int firstRow, int lastRow, int color, float a, float c )
+{
+	const int C = componentsPerCell;
+	const int stride = ( NX + 2 ) * C;
+	
+	for( int j = firstRow; j <= lastRow; ++j ) {
+		const int rowStart = j * stride;
+		int i = 1;
+#if defined( CINDER_SSE2 )
+		static const bool useSse2 = ci::System::hasSse2();
+		if( useSse2 ) {
+			// each vector holds 4 / C cells starting at an odd i, so the lanes of this color are the same in every vector of the row
+			const int cellsPerVector = 4 / C;
+			int lanes[4];
+			for( int k = 0; k < 4; ++k )
+				lanes[k] = ( ( ( 1 + k / C + j ) & 1 ) == color ) ? -1 : 0;
+			const __m128 mask = _mm_castsi128_ps( _mm_set_epi32( lanes[3], lanes[2], lanes[1], lanes[0] ) );
+			const __m128 va = _mm_set1_ps( a );
+			const __m128 vc = _mm_set1_ps( c );
+			
+			// the left and right neighbours are shuffled from the vectors on either side rather than loaded, since an unaligned
+			// load overlapping the previous store stalls. They're of the other color, so the stored vector didn't change them.
+			__m128 prev[3], cur[3];
+			for( int f = 0; f < numFields; ++f ) {
+				prev[f] = _mm_loadu_ps( x[f] + rowStart + i * C - 4 );
+				cur[f] = _mm_loadu_ps( x[f] + rowStart + i * C );
+			}
+			for( ; i + cellsPerVector - 1 <= NX; i += cellsPerVector ) {
+				const int o = rowStart + i * C;
+				for( int f = 0; f < numFields; ++f ) {
+					float *p = x[f] + o;
+					__m128 next = _mm_loadu_ps( p + 4 );
+					__m128 left, right;
+					if( C == 1 ) {
+						left = _mm_shuffle_ps( _mm_shuffle_ps( prev[f], cur[f], _MM_SHUFFLE(0,0,3,3) ), cur[f], _MM_SHUFFLE(2,1,2,0) );
+						right = _mm_shuffle_ps( cur[f], _mm_shuffle_ps( cur[f], next, _MM_SHUFFLE(0,0,3,3) ), _MM_SHUFFLE(2,0,2,1) );
+					}
+					else {
+						left = _mm_shuffle_ps( prev[f], cur[f], _MM_SHUFFLE(1,0,3,2) );
+						right = _mm_shuffle_ps( cur[f], next, _MM_SHUFFLE(1,0,3,2) );
+					}
+					__m128 sum = _mm_add_ps( _mm_add_ps( _mm_add_ps( left, right ), _mm_loadu_ps( p - stride ) ), _mm_loadu_ps( p + stride ) );
+					__m128 result = _mm_mul_ps( sum, va );
+					if( x0[f] )
+						result = _mm_add_ps( result, _mm_loadu_ps( x0[f] + o ) );
+					result = _mm_mul_ps( result, vc );
+					_mm_storeu_ps( p, _mm_or_ps( _mm_and_ps( mask, result ), _mm_andnot_ps( mask, cur[f] ) ) );
+					prev[f] = cur[f];
+					cur[f] = next;
+				}
+			}
+		}
+#endif
+		// the remaining cells of this color
+		if( ( ( i + j ) & 1 ) != color )
+			++i;
+		for( ; i <= NX; i += 2 ) {
+			for( int f = 0; f < numFields; ++f ) {
+				for( int k = 0; k < C; ++k ) {
+					const int o = rowStart + i * C + k;
+					float *p = x[f] + o;
+					float result = ( p[-C] + p[C] + p[-stride] + p[stride] ) * a;
+					if( x0[f] )
+						result += x0[f][o];
+					*p = result * c;
+				}
+			}
+		}
+	}
+}
+
+void ciMsaFluidSolver::relaxParallel( const RelaxPass &pass )
+{
+	_relax = pass;
+	runBands( &ciMsaFluidSolver::relaxBand );
+}
+
+void ciMsaFluidSolver::relaxBand( int band )
+{
+	int firstRow, lastRow;
+	getBandRows( band, &firstRow, &lastRow );
+	
+	for( int k = solverIterations; k > 0; --k ) {
+		for( int color = 0; color < 2; ++color ) {
+			relaxRows( _relax.x, _relax.x0, _relax.numFields, _relax.componentsPerCell, _NX, firstRow, lastRow, color, _relax.a, _relax.c );
+			_workers->barrier();
+		}
+		
+		// the boundaries copy from the edges of every band, so they're set once all bands are done
+		if( band == 0 ) {
+			if( _relax.boundary == RELAX_BOUNDARY_RGB )
+				setBoundaryRGB();
+			else if( _relax.boundary == RELAX_BOUNDARY_UV )
+				setBoundary2d( _relax.bound, reinterpret_cast<ci::Vec2f*>( _relax.x[0] ) );
+			else
+				setBoundary( _relax.bound, _relax.x[0] );
+		}
+		_workers->barrier();
+	}
+}
+
+// as project(), but the pressure is solved in _tmp rather than interleaved with the divergence, so the solver can run on four cells at a time
+void ciMsaFluidSolver::projectParallel( ci::Vec2f *xy )
+{
+	BandArgs args = { NULL, NULL, xy, NULL };
+	_bandArgs = args;
+	runBands( &ciMsaFluidSolver::divergenceBand );
+	setBoundary( 0, _tmp );
+	
+	RelaxPass pass = { { _tmp }, { NULL }, 1, 1, 1.0f, 0.25f, RELAX_BOUNDARY, 0 };
+	relaxParallel( pass );
+	
+	runBands( &ciMsaFluidSolver::gradientBand );
+	setBoundary2d(1, xy);
+	setBoundary2d(2, xy);
+}
+
+void ciMsaFluidSolver::divergenceBand( int band )
+{
+	int firstRow, lastRow;
+	getBandRows( band, &firstRow, &lastRow );
+	
+	const ci::Vec2f *xy = _bandArgs.uv;
+	int step_x = _NX + 2;
+	float h = - 0.5f / _NX;
+	for( int j = firstRow; j <= lastRow; ++j ) {
+		int index = FLUID_IX(1, j);
+		for( int i = 1; i <= _NX; ++i, ++index )
+			_tmp[index] = h * ( xy[index+1].x - xy[index-1].x + xy[index+step_x].y - xy[index-step_x].y );
+	}
+}
+
+void ciMsaFluidSolver::gradientBand( int band )
+{
+	int firstRow, lastRow;
+	getBandRows( band, &firstRow, &lastRow );
+	
+	ci::Vec2f *xy = _bandArgs.uv;
+	const float *p = _tmp;
+	int step_x = _NX + 2;
+	float fx = 0.5f * _NX;
+	float fy = 0.5f * _NY;
+	for( int j = firstRow; j <= lastRow; ++j ) {
+		int index = FLUID_IX(1, j);
+		for( int i = 1; i <= _NX; ++i, ++index ) {
+			xy[index].x -= fx * (p[index+1] - p[index-1]);
+			xy[index].y -= fy * (p[index+step_x] - p[index-step_x]);
+		}
+	}
+}
+
+// advection only reads the previous step, so the bands are independent
+
+void ciMsaFluidSolver::advectBand( int band )
+{
+	int firstRow, lastRow;
+	getBandRows( band, &firstRow, &lastRow );
+	advectRows( _bandArgs.d, _bandArgs.d0, _bandArgs.duv, firstRow, lastRow );
+}
+
+void ciMsaFluidSolver::advect2dBand( int band )
+{
+	int firstRow, lastRow;
+	getBandRows( band, &firstRow, &lastRow );
+	advect2dRows( _bandArgs.uv, _bandArgs.duv, firstRow, lastRow );
+}
+
+void ciMsaFluidSolver::advectRGBBand( int band )
+{
+	int firstRow, lastRow;
+	getBandRows( band, &firstRow, &lastRow );
+	advectRGBRows( _bandArgs.duv, firstRow, lastRow );
+}
@@ -40,6 +40,10 @@ class Listener {
 	Listener();
 	
 	void setup(int listen_port);
+	/** Like setup(), but messages are received into a pool of \a capacity PooledMessages and handed out by drainMessages(), so receiving neither allocates nor locks.
+	 * Messages which arrive while the whole pool is waiting to be drained, or which don't fit in a PooledMessage, are dropped and counted by getDroppedMessageCount().
+	 * Callbacks registered with registerMessageReceived() aren't called in this mode. **/
+	void setupPooled( int listen_port, uint32_t capacity = 1024 );
 	void shutdown();
 	
 	// Callback methods
@@ -55,6 +59,12 @@ class Listener {
 	bool hasWaitingMessages() const;
 	//! Gets the next message to be processed and puts it in \a resultMessage. Returns whether there was a message to process or not. Always \c false if callbacks have been registered using registerMessageReceived().
 	bool getNextMessage( Message *resultMessage );
+
+	/** Calls \a callback with each waiting message, oldest first, without copying them, and returns the number of messages. Only for listeners created with setupPooled().
+	 * The messages are recycled once drainMessages() returns, so \a callback must not keep references to them. Call from one thread at a time. **/
+	size_t		drainMessages( const std::function<void (const PooledMessage&)> &callback );
+	//! Returns the number of messages setupPooled() listeners have dropped. Wraps at 2^32.
+	uint32_t	getDroppedMessageCount() const;
 	
   private:
 	std::shared_ptr<class OscListener>   oscListener;
@@ -45,7 +45,7 @@ namespace cinder { namespace osc {
 		Message& copy( const Message& other );
 		void clear();
 		
-		std::string getAddress() const { return address; }
+		const std::string& getAddress() const { return address; }
 		std::string getRemoteIp() const { return remote_host; }
 		int getRemotePort() const { return remote_port; }
 		void setAddress( std::string _address ) { address = _address; };
@@ -71,6 +71,67 @@ namespace cinder { namespace osc {
 		int remote_port;	
 	};
 	
+	/** A received message whose address, arguments and strings are stored inline, so that Listener can recycle it without allocating.
+	 * Only int32, float and string arguments are kept, up to MAX_ARGS of them, and the address and strings share MAX_STRING_BYTES.
+	 * Strings point into the message, so they are only valid as long as it is. **/
+	class PooledMessage {
+	public:
+		static const int	MAX_ARGS = 16;
+		static const int	MAX_STRING_BYTES = 480;
+
+		PooledMessage() { clear(); }
+
+		void clear() { mNumArgs = 0; mStringBytes = 0; mAddressLength = 0; mStorage[0] = 0; mRemoteAddress = 0; mRemotePort = 0; }
+
+		const char* getAddress() const { return mStorage; }
+		size_t getAddressLength() const { return mAddressLength; }
+		//! Returns the sender's IPv4 address in host byte order
+		uint32_t getRemoteAddress() const { return mRemoteAddress; }
+		//! Formats the sender's address as a dotted quad, which allocates; prefer getRemoteAddress() when receiving at high rates
+		std::string getRemoteIp() const;
+		int getRemotePort() const { return mRemotePort; }
+
+		int getNumArgs() const { return mNumArgs; }
+		ArgType getArgType( int index ) const;
+
+		int32_t getArgAsInt32( int index, bool typeConvert = false ) const;
+		float getArgAsFloat( int index, bool typeConvert = false ) const;
+		const char* getArgAsString( int index ) const;
+
+		//! Copies the message into \a message, replacing its contents
+		void toMessage( Message *message ) const;
+
+		//! Sets the address, returning \c false if it doesn't fit
+		bool setAddress( const char *address );
+		void setRemoteEndpoint( uint32_t address, int port ) { mRemoteAddress = address; mRemotePort = port; }
+		//! The add methods return \c false, leaving the message unchanged, when it has no room for the argument
+		bool addIntArg( int32_t argument );
+		bool addFloatArg( float argument );
+		bool addStringArg( const char *argument );
+
+	protected:
+		//! Copies \a str into mStorage, returning its offset or -1 if it doesn't fit
+		int storeString( const char *str, size_t *length );
+
+		struct ArgSlot {
+			ArgType		mType;
+			union {
+				int32_t		mInt;
+				float		mFloat;
+				int32_t		mStringOffset;
+			};
+		};
+
+		ArgSlot		mArgs[MAX_ARGS];
+		int			mNumArgs;
+		uint32_t	mRemoteAddress;
+		int			mRemotePort;
+		size_t		mAddressLength;
+		size_t		mStringBytes;
+		//! The address followed by the string arguments, each null-terminated
+		char		mStorage[MAX_STRING_BYTES];
+	};
+
 	class OscExc : public Exception {
 	};
 	class OscExcInvalidArgumentType : public OscExc {
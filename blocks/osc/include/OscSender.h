@@ -27,6 +27,7 @@
 #pragma once
 
 class UdpTransmitSocket;
+#include <cstddef>
 #include <string>
 #include "OscBundle.h"
 #include "OscMessage.h"
@@ -34,9 +35,28 @@ class UdpTransmitSocket;
 namespace cinder  { namespace osc {
 	class Sender  {
 	public:
+		//! When a setupBatched() Sender hands its bundles to the background thread
+		enum FlushPolicy {
+			//! Each bundle is sent as soon as it's full, and flush() sends the last, partially filled one
+			FLUSH_WHEN_FULL,
+			//! Bundles are held until flush(), which is meant to be called once per frame, so that a frame's messages go out together
+			FLUSH_PER_FRAME
+		};
+		
+		//! The largest UDP payload which fits an Ethernet frame without fragmenting: 1500 byte MTU less the IP and UDP headers
+		static const size_t DEFAULT_MAX_PACKET_SIZE = 1472;
+		
 		Sender();
 		
 		void setup(std::string hostname, int port);
+		/** Like setup(), but sendMessage() and sendBundle() only serialize into bundles of up to \a maxPacketSize bytes, which a background thread sends according to \a flushPolicy.
+		 * This makes one send per bundle instead of one per message. A message too large for \a maxPacketSize is sent in a bundle of its own.
+		 * The serialization buffers are reused, so a steady stream of messages doesn't allocate. Call sendMessage(), sendBundle() and flush() from one thread at a time. **/
+		void setupBatched( std::string hostname, int port, FlushPolicy flushPolicy = FLUSH_PER_FRAME, size_t maxPacketSize = DEFAULT_MAX_PACKET_SIZE );
+		//! Sends whatever has been queued since the last flush(). Does nothing unless the Sender was created with setupBatched().
+		void flush();
+		//! Sends anything still queued and closes the socket
+		void shutdown();
 		
 		void sendMessage(Message& message);
 		void sendBundle(Bundle& bundle);
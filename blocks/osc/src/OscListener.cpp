@@ -26,6 +26,7 @@
 
 #include "cinder/Thread.h" 
 #include "cinder/Utilities.h"
+#include "cinder/audio/CircularBuffer.h"
 #include "OscListener.h"
 #include "osc/OscTypes.h"
 #include "osc/OscPacketListener.h"
@@ -36,6 +37,7 @@
 #include <assert.h>
 #include <deque>
 #include <map>
+#include <vector>
 using namespace std;
 
 namespace cinder { namespace osc {
@@ -46,10 +48,14 @@ class OscListener : public ::osc::OscPacketListener {
 	~OscListener();
 	
 	void setup(int listen_port);
+	void setupPooled( int listen_port, uint32_t capacity );
 	
 	bool hasWaitingMessages() const;
 	bool getNextMessage( Message * );
 
+	size_t		drainMessages( const std::function<void (const PooledMessage&)> &callback );
+	uint32_t	getDroppedMessageCount() const { return mDroppedMessageCount; }
+
 	CallbackId	registerMessageReceived( std::function<void (const osc::Message*)> callback );
 	void		unregisterMessageReceived( CallbackId id );
 	
@@ -60,8 +66,20 @@ class OscListener : public ::osc::OscPacketListener {
 	
   private:
 	void threadSocket();
+	void startSocket( int listen_port );
+	//! Receives \a m into the pool on the socket thread. The socket thread is the only producer of mReceivedMessages and consumer of mFreeMessages.
+	void processPooledMessage( const ::osc::ReceivedMessage &m, const IpEndpointName& remoteEndpoint );
 	
 	deque<Message*> mMessages;
+
+	// pooled mode: indices into mPool circulate from mFreeMessages, through the socket thread, to mReceivedMessages and back through drainMessages()
+	static const uint32_t	NO_MESSAGE = 0xFFFFFFFF;
+	bool					mIsPooled;
+	std::vector<PooledMessage>	mPool;
+	std::shared_ptr<audio::SpscCircularBuffer<uint32_t> >	mFreeMessages, mReceivedMessages;
+	//! A message taken from mFreeMessages which the socket thread hasn't published yet
+	uint32_t				mPendingMessage;
+	volatile uint32_t		mDroppedMessageCount;
 	
 	UdpListeningReceiveSocket* mListen_socket;
 	
@@ -73,6 +91,7 @@ class OscListener : public ::osc::OscPacketListener {
 };
 
 OscListener::OscListener()
+	: mIsPooled( false ), mPendingMessage( NO_MESSAGE ), mDroppedMessageCount( 0 )
 {
 	mListen_socket = NULL;
 }
@@ -83,6 +102,31 @@ void OscListener::setup(int listen_port)
 		shutdown();
 	}
 	
+	mIsPooled = false;
+	startSocket( listen_port );
+}
+
+void OscListener::setupPooled( int listen_port, uint32_t capacity )
+{
+	if (mListen_socket) {
+		shutdown();
+	}
+	
+	// the socket thread isn't running, so the rings can be filled from here
+	mIsPooled = true;
+	mPool.assign( capacity, PooledMessage() );
+	mFreeMessages = std::shared_ptr<audio::SpscCircularBuffer<uint32_t> >( new audio::SpscCircularBuffer<uint32_t>( capacity ) );
+	mReceivedMessages = std::shared_ptr<audio::SpscCircularBuffer<uint32_t> >( new audio::SpscCircularBuffer<uint32_t>( capacity ) );
+	for( uint32_t i = 0; i < capacity; ++i )
+		mFreeMessages->write( &i, 1 );
+	mPendingMessage = NO_MESSAGE;
+	mDroppedMessageCount = 0;
+	
+	startSocket( listen_port );
+}
+
+void OscListener::startSocket( int listen_port )
+{
 	mSocketHasShutdown = false;
 	
 	mListen_socket = new UdpListeningReceiveSocket(IpEndpointName(IpEndpointName::ANY_ADDRESS, listen_port), this);
@@ -116,7 +160,44 @@ void OscListener::threadSocket() {
 	
 }
 
+void OscListener::processPooledMessage( const ::osc::ReceivedMessage &m, const IpEndpointName& remoteEndpoint ) {
+	if( mPendingMessage == NO_MESSAGE ) {
+		if( ( mFreeMessages->getReadAvailable() == 0 ) || ( mFreeMessages->read( &mPendingMessage, 1 ) == 0 ) ) {
+			mDroppedMessageCount++;
+			return;
+		}
+	}
+	
+	PooledMessage &message = mPool[mPendingMessage];
+	bool fits = message.setAddress( m.AddressPattern() );
+	message.setRemoteEndpoint( (uint32_t)remoteEndpoint.address, remoteEndpoint.port );
+	for( ::osc::ReceivedMessage::const_iterator arg = m.ArgumentsBegin(); fits && ( arg != m.ArgumentsEnd() ); ++arg ) {
+		if( arg->IsInt32() )
+			fits = message.addIntArg( arg->AsInt32Unchecked() );
+		else if( arg->IsFloat() )
+			fits = message.addFloatArg( arg->AsFloatUnchecked() );
+		else if( arg->IsString() )
+			fits = message.addStringArg( arg->AsStringUnchecked() );
+		else
+			fits = false;
+	}
+	
+	// a message which doesn't fit is dropped, and its slot reused for the next one
+	if( ! fits ) {
+		mDroppedMessageCount++;
+		return;
+	}
+	
+	mReceivedMessages->write( &mPendingMessage, 1 );
+	mPendingMessage = NO_MESSAGE;
+}
+
 void OscListener::ProcessMessage( const ::osc::ReceivedMessage &m, const IpEndpointName& remoteEndpoint ) {
+	if( mIsPooled ) {
+		processPooledMessage( m, remoteEndpoint );
+		return;
+	}
+	
 	Message* message = new Message();
 	
 	message->setAddress(m.AddressPattern());
@@ -147,12 +228,24 @@ void OscListener::ProcessMessage( const ::osc::ReceivedMessage &m, const IpEndpo
 
 bool OscListener::hasWaitingMessages() const
 {
+	if( mIsPooled )
+		return mReceivedMessages->getReadAvailable() > 0;
+	
 	std::lock_guard<mutex> lock( mMutex );
 	return ! mMessages.empty();
 }
 
 bool OscListener::getNextMessage( Message* message )
 {
+	if( mIsPooled ) {
+		uint32_t index;
+		if( ( mReceivedMessages->getReadAvailable() == 0 ) || ( mReceivedMessages->read( &index, 1 ) == 0 ) )
+			return false;
+		mPool[index].toMessage( message );
+		mFreeMessages->write( &index, 1 );
+		return true;
+	}
+	
 	lock_guard<mutex> lock( mMutex );
 	
 	if( mMessages.empty() )
@@ -167,6 +260,25 @@ bool OscListener::getNextMessage( Message* message )
 	return true;
 }
 
+size_t OscListener::drainMessages( const std::function<void (const PooledMessage&)> &callback )
+{
+	if( ! mIsPooled )
+		throw OscExc();
+	
+	audio::SpscCircularBuffer<uint32_t>::ArrayRange ranges[2];
+	mReceivedMessages->getReadRanges( &ranges[0], &ranges[1] );
+	for( int r = 0; r < 2; ++r ) {
+		for( uint32_t i = 0; i < ranges[r].second; ++i )
+			callback( mPool[ranges[r].first[i]] );
+	}
+	
+	// hand the messages back to the socket thread; mFreeMessages holds the whole pool, so this never drops any
+	for( int r = 0; r < 2; ++r )
+		mFreeMessages->write( ranges[r].first, ranges[r].second );
+	mReceivedMessages->commitRead( ranges[0].second + ranges[1].second );
+	return ranges[0].second + ranges[1].second;
+}
+
 CallbackId OscListener::registerMessageReceived( std::function<void (const osc::Message*)> callback )
 {
 	lock_guard<mutex> lock( mMutex );
@@ -201,6 +313,21 @@ bool Listener::getNextMessage(Message* message) {
 	return oscListener->getNextMessage(message);
 }
 
+void Listener::setupPooled( int listen_port, uint32_t capacity )
+{
+	oscListener->setupPooled( listen_port, capacity );
+}
+
+size_t Listener::drainMessages( const std::function<void (const PooledMessage&)> &callback )
+{
+	return oscListener->drainMessages( callback );
+}
+
+uint32_t Listener::getDroppedMessageCount() const
+{
+	return oscListener->getDroppedMessageCount();
+}
+
 CallbackId Listener::registerMessageReceived( std::function<void (const osc::Message*)> callback )
 {
 	return oscListener->registerMessageReceived( callback );
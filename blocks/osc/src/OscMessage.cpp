@@ -26,6 +26,9 @@
 
 #include "OscMessage.h"
 
+#include <cstdio>
+#include <cstring>
+
 namespace cinder { namespace osc {
 
 Message::~Message(){
@@ -112,6 +115,9 @@ void Message::addStringArg( std::string argument ){
 }
 	
 Message& Message::copy( const Message& other ){
+	if( &other == this )
+		return *this;
+	clear();
 
 	address = other.address;
 	
@@ -135,5 +141,106 @@ Message& Message::copy( const Message& other ){
 	return *this;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PooledMessage
+std::string PooledMessage::getRemoteIp() const{
+	char buf[16];
+	sprintf( buf, "%u.%u.%u.%u", ( mRemoteAddress >> 24 ) & 0xFF, ( mRemoteAddress >> 16 ) & 0xFF, ( mRemoteAddress >> 8 ) & 0xFF, mRemoteAddress & 0xFF );
+	return std::string( buf );
+}
+
+ArgType PooledMessage::getArgType( int index ) const{
+	if( ( index < 0 ) || ( index >= mNumArgs ) ){
+		throw OscExcOutOfBounds();
+	}
+	return mArgs[index].mType;
+}
+
+int32_t PooledMessage::getArgAsInt32( int index, bool typeConvert ) const{
+	ArgType argType = getArgType( index );
+	if( argType == TYPE_INT32 )
+		return mArgs[index].mInt;
+	else if( typeConvert && ( argType == TYPE_FLOAT ) )
+		return (int32_t)mArgs[index].mFloat;
+	else
+		throw OscExcInvalidArgumentType();
+}
+
+float PooledMessage::getArgAsFloat( int index, bool typeConvert ) const{
+	ArgType argType = getArgType( index );
+	if( argType == TYPE_FLOAT )
+		return mArgs[index].mFloat;
+	else if( typeConvert && ( argType == TYPE_INT32 ) )
+		return (float)mArgs[index].mInt;
+	else
+		throw OscExcInvalidArgumentType();
+}
+
+const char* PooledMessage::getArgAsString( int index ) const{
+	if( getArgType( index ) != TYPE_STRING )
+		throw OscExcInvalidArgumentType();
+	return mStorage + mArgs[index].mStringOffset;
+}
+
+void PooledMessage::toMessage( Message *message ) const{
+	message->clear();
+	message->setAddress( getAddress() );
+	message->setRemoteEndpoint( getRemoteIp(), mRemotePort );
+	for( int i = 0; i < mNumArgs; ++i ){
+		if( mArgs[i].mType == TYPE_INT32 )
+			message->addIntArg( mArgs[i].mInt );
+		else if( mArgs[i].mType == TYPE_FLOAT )
+			message->addFloatArg( mArgs[i].mFloat );
+		else
+			message->addStringArg( getArgAsString( i ) );
+	}
+}
+
+int PooledMessage::storeString( const char *str, size_t *length ){
+	size_t size = strlen( str ) + 1;
+	if( mStringBytes + size > (size_t)MAX_STRING_BYTES )
+		return -1;
+	int offset = (int)mStringBytes;
+	memcpy( mStorage + offset, str, size );
+	mStringBytes += size;
+	if( length )
+		*length = size - 1;
+	return offset;
+}
+
+bool PooledMessage::setAddress( const char *address ){
+	// the address always comes first, so setting it discards any arguments
+	mNumArgs = 0;
+	mStringBytes = 0;
+	return storeString( address, &mAddressLength ) >= 0;
+}
+
+bool PooledMessage::addIntArg( int32_t argument ){
+	if( mNumArgs >= MAX_ARGS )
+		return false;
+	mArgs[mNumArgs].mType = TYPE_INT32;
+	mArgs[mNumArgs++].mInt = argument;
+	return true;
+}
+
+bool PooledMessage::addFloatArg( float argument ){
+	if( mNumArgs >= MAX_ARGS )
+		return false;
+	mArgs[mNumArgs].mType = TYPE_FLOAT;
+	mArgs[mNumArgs++].mFloat = argument;
+	return true;
+}
+
+bool PooledMessage::addStringArg( const char *argument ){
+	if( mNumArgs >= MAX_ARGS )
+		return false;
+	int offset = storeString( argument, 0 );
+	if( offset < 0 )
+		return false;
+	mArgs[mNumArgs].mType = TYPE_STRING;
+	mArgs[mNumArgs++].mStringOffset = offset;
+	return true;
+}
+
 } // namespace cinder
 } // namespace osc
@@ -27,10 +27,17 @@
 
 #include "OscSender.h"
 
+#include "cinder/Thread.h"
+
 #include "osc/OscOutboundPacketStream.h"
 #include "osc/OscTypes.h"
 #include "ip/UdpSocket.h"
 
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <vector>
+
 #include <assert.h>
 namespace cinder { namespace osc {
 	
@@ -40,23 +47,59 @@ namespace cinder { namespace osc {
 		~OscSender();
 		
 		void setup(std::string hostname, int port);
+		void setupBatched(std::string hostname, int port, Sender::FlushPolicy flushPolicy, size_t maxPacketSize);
 		
 		void sendMessage(Message& message);
 		void sendBundle(Bundle& bundle);
+		void flush();
 		
 		void shutdown();
 	private:
+		//! A bundle being filled or waiting to be sent. The stream stays bound to mData, so a Packet is recycled by clearing it.
+		struct Packet {
+			Packet( size_t capacity ) : mData( capacity ), mStream( &mData[0], capacity ), mMessageCount( 0 ) {}
+			
+			std::vector<char>				mData;
+			::osc::OutboundPacketStream		mStream;
+			size_t							mMessageCount;
+		};
 		
 		void appendBundle(Bundle& bundle, ::osc::OutboundPacketStream& p);
 		void appendMessage(Message& message, ::osc::OutboundPacketStream& p);
 		
+		static size_t getMessageSize( Message& message );
+		static size_t getBundleSize( Bundle& bundle );
+		
+		//! Makes mCurrentPacket a bundle with room for an element of \a elementSize bytes, closing the current one if it's too full
+		void reservePacket( size_t elementSize );
+		Packet* acquirePacket( size_t capacity );
+		//! Ends the bundle in mCurrentPacket and queues it according to mFlushPolicy
+		void closePacket();
+		//! Hands \a packets to the send thread and empties it
+		void sendPackets( std::vector<Packet*> *packets );
+		void threadSend();
+		
 		UdpTransmitSocket* socket;
 		
+		// batched sending; mCurrentPacket and mHeldPackets belong to the calling thread, the rest is guarded by mMutex
+		bool							mIsBatched;
+		Sender::FlushPolicy				mFlushPolicy;
+		size_t							mMaxPacketSize;
+		Packet							*mCurrentPacket;
+		std::vector<Packet*>			mHeldPackets;
+		std::deque<Packet*>				mReadyPackets;
+		std::vector<Packet*>			mFreePackets;
+		bool							mShouldStop;
+		std::mutex						mMutex;
+		std::condition_variable			mPacketsReady;
+		std::shared_ptr<std::thread>	mThread;
 	};
 	
 	
 
-OscSender::OscSender(){
+OscSender::OscSender()
+	: mIsBatched( false ), mFlushPolicy( Sender::FLUSH_PER_FRAME ), mMaxPacketSize( Sender::DEFAULT_MAX_PACKET_SIZE ), mCurrentPacket( NULL ), mShouldStop( false )
+{
 	socket = NULL;
 }
 
@@ -71,13 +114,48 @@ void OscSender::setup(std::string hostname, int port){
 	socket = new UdpTransmitSocket( IpEndpointName(hostname.c_str(), port));
 }
 
+void OscSender::setupBatched(std::string hostname, int port, Sender::FlushPolicy flushPolicy, size_t maxPacketSize){
+	setup( hostname, port );
+	
+	mIsBatched = true;
+	mFlushPolicy = flushPolicy;
+	mMaxPacketSize = maxPacketSize;
+	mShouldStop = false;
+	mThread = std::shared_ptr<std::thread>( new std::thread( &OscSender::threadSend, this ) );
+}
+
 void OscSender::shutdown(){
+	if( mIsBatched ) {
+		flush();
+		{
+			std::lock_guard<std::mutex> lock( mMutex );
+			mShouldStop = true;
+		}
+		mPacketsReady.notify_one();
+		mThread->join();
+		mThread.reset();
+		
+		delete mCurrentPacket;
+		mCurrentPacket = NULL;
+		for( size_t i = 0; i < mFreePackets.size(); ++i )
+			delete mFreePackets[i];
+		mFreePackets.clear();
+		mIsBatched = false;
+	}
+	
 	if (socket)
 		delete socket;
 	socket = NULL;
 }
 
 void OscSender::sendBundle(Bundle& bundle){
+	if( mIsBatched ) {
+		reservePacket( getBundleSize( bundle ) );
+		appendBundle( bundle, mCurrentPacket->mStream );
+		mCurrentPacket->mMessageCount++;
+		return;
+	}
+	
 	static const int OUTPUT_BUFFER_SIZE = 32768;
 	char buffer[OUTPUT_BUFFER_SIZE];
 	
@@ -89,6 +167,13 @@ void OscSender::sendBundle(Bundle& bundle){
 }
 
 void OscSender::sendMessage(Message& message){
+	if( mIsBatched ) {
+		reservePacket( getMessageSize( message ) );
+		appendMessage( message, mCurrentPacket->mStream );
+		mCurrentPacket->mMessageCount++;
+		return;
+	}
+	
 	static const int OUTPUT_BUFFER_SIZE = 16384;
 	char buffer[OUTPUT_BUFFER_SIZE];
 	::osc::OutboundPacketStream p(buffer, OUTPUT_BUFFER_SIZE);
@@ -100,6 +185,126 @@ void OscSender::sendMessage(Message& message){
 	socket->Send(p.Data(), p.Size());
 }
 
+void OscSender::flush(){
+	if( ! mIsBatched )
+		return;
+	
+	closePacket();
+	sendPackets( &mHeldPackets );
+}
+
+// OSC strings are null-terminated and padded to a multiple of 4 bytes
+static size_t getPaddedStringSize( size_t length )
+{
+	return ( length + 4 ) & ~(size_t)3;
+}
+
+size_t OscSender::getMessageSize( Message& message ){
+	// the type tag string is a ',' followed by one tag per argument
+	size_t result = getPaddedStringSize( message.getAddress().size() ) + getPaddedStringSize( 1 + message.getNumArgs() );
+	for (int i = 0; i < message.getNumArgs(); ++i) {
+		if (message.getArgType(i) == TYPE_STRING)
+			result += getPaddedStringSize( message.getArgAsString(i).size() );
+		else
+			result += 4;
+	}
+	return result;
+}
+
+size_t OscSender::getBundleSize( Bundle& bundle ){
+	// "#bundle" and the time tag, then each element prefixed by its size
+	size_t result = 16;
+	for (int i = 0; i < bundle.getBundleCount(); i++)
+		result += 4 + getBundleSize( bundle.getBundleAt(i) );
+	for (int i = 0; i < bundle.getMessageCount(); i++)
+		result += 4 + getMessageSize( bundle.getMessageAt(i) );
+	return result;
+}
+
+void OscSender::reservePacket( size_t elementSize ){
+	if( mCurrentPacket && ( mCurrentPacket->mStream.Size() + 4 + elementSize > mMaxPacketSize ) )
+		closePacket();
+	
+	if( ! mCurrentPacket ) {
+		mCurrentPacket = acquirePacket( 16 + 4 + elementSize );
+		mCurrentPacket->mStream << ::osc::BeginBundleImmediate;
+	}
+}
+
+OscSender::Packet* OscSender::acquirePacket( size_t capacity ){
+	if( capacity <= mMaxPacketSize ) {
+		std::lock_guard<std::mutex> lock( mMutex );
+		if( ! mFreePackets.empty() ) {
+			Packet *result = mFreePackets.back();
+			mFreePackets.pop_back();
+			return result;
+		}
+	}
+	
+	return new Packet( std::max( capacity, mMaxPacketSize ) );
+}
+
+void OscSender::closePacket(){
+	if( ( ! mCurrentPacket ) || ( mCurrentPacket->mMessageCount == 0 ) )
+		return;
+	
+	mCurrentPacket->mStream << ::osc::EndBundle;
+	mHeldPackets.push_back( mCurrentPacket );
+	mCurrentPacket = NULL;
+	
+	if( mFlushPolicy == Sender::FLUSH_WHEN_FULL )
+		sendPackets( &mHeldPackets );
+}
+
+void OscSender::sendPackets( std::vector<Packet*> *packets ){
+	if( packets->empty() )
+		return;
+	
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		mReadyPackets.insert( mReadyPackets.end(), packets->begin(), packets->end() );
+	}
+	packets->clear();
+	mPacketsReady.notify_one();
+}
+
+void OscSender::threadSend(){
+	std::vector<Packet*> sending;
+	while( true ) {
+		{
+			std::unique_lock<std::mutex> lock( mMutex );
+			while( mReadyPackets.empty() && ( ! mShouldStop ) )
+				mPacketsReady.wait( lock );
+			// shutdown() flushes before stopping, so everything queued is sent first
+			if( mReadyPackets.empty() )
+				return;
+			sending.assign( mReadyPackets.begin(), mReadyPackets.end() );
+			mReadyPackets.clear();
+		}
+		
+		for( size_t i = 0; i < sending.size(); ++i ) {
+			// there's no caller to report a failed send to, so the bundle is dropped, as a lost datagram would be
+			try {
+				socket->Send( sending[i]->mStream.Data(), sending[i]->mStream.Size() );
+			}
+			catch( std::exception & ) {
+			}
+		}
+		
+		std::lock_guard<std::mutex> lock( mMutex );
+		for( size_t i = 0; i < sending.size(); ++i ) {
+			// oversized packets for single large messages aren't kept
+			if( sending[i]->mStream.Capacity() > mMaxPacketSize )
+				delete sending[i];
+			else {
+				sending[i]->mStream.Clear();
+				sending[i]->mMessageCount = 0;
+				mFreePackets.push_back( sending[i] );
+			}
+		}
+	}
+}
+
 void OscSender::appendBundle(Bundle& bundle, ::osc::OutboundPacketStream& p){
 	p << ::osc::BeginBundleImmediate;
 	for (int i = 0; i < bundle.getBundleCount(); i++){
@@ -137,6 +342,18 @@ void OscSender::appendMessage(Message& message, ::osc::OutboundPacketStream& p){
 		oscSender->setup(hostname, port);
 	}
 	
+	void Sender::setupBatched(std::string hostname, int port, FlushPolicy flushPolicy, size_t maxPacketSize){
+		oscSender->setupBatched(hostname, port, flushPolicy, maxPacketSize);
+	}
+	
+	void Sender::flush(){
+		oscSender->flush();
+	}
+	
+	void Sender::shutdown(){
+		oscSender->shutdown();
+	}
+	
 	void Sender::sendMessage(Message& message){
 		oscSender->sendMessage(message);
 	}
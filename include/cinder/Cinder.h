@@ -68,6 +68,11 @@ using boost::checked_array_deleter;
 
 #define CINDER_LITTLE_ENDIAN
 
+// SSE2 intrinsics can be compiled; use System::hasSse2() to determine whether the host CPU supports them
+#if defined( __SSE2__ ) || defined( _M_X64 ) || defined( _M_IX86 )
+	#define CINDER_SSE2
+#endif
+
 } // namespace cinder
 
 // Create a namepace alias as shorthand for cinder::
@@ -80,6 +80,35 @@ class DataSourcePath : public DataSource {
 
 DataSourcePathRef	loadFile( const std::string &path );
 
+typedef std::shared_ptr<class DataSourceMapped>	DataSourceMappedRef;
+
+//! A DataSource for a file which is memory-mapped rather than read. Its streams are IStreamMapped, and getBuffer() wraps the mapping rather than copying it.
+class DataSourceMapped : public DataSource {
+  public:
+	static DataSourceMappedRef	createRef( const std::string &path );
+
+	virtual bool	isFilePath() { return true; }
+	virtual bool	isUrl() { return false; }
+
+	//! Returns a new stream over the mapping, with its own offset
+	virtual IStreamRef	createStream();
+
+	//! Returns a pointer to the mapped contents of the file, which remains valid for the lifetime of the DataSourceMapped
+	const void*		getData() const { return mStream->getData(); }
+	//! Returns the size of the file in bytes
+	size_t			getDataSize() const { return static_cast<size_t>( mStream->size() ); }
+
+  protected:
+	DataSourceMapped( const std::string &path );
+
+	virtual	void	createBuffer();
+
+	IStreamMappedRef	mStream;
+};
+
+//! Memory-maps the file at \a path. Throws StreamExc if it can't be opened or mapped.
+DataSourceMappedRef	loadFileMapped( const std::string &path );
+
 typedef std::shared_ptr<class DataSourceUrl>	DataSourceUrlRef;
 
 class DataSourceUrl : public DataSource {
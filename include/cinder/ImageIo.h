@@ -107,11 +107,19 @@ class ImageSource : public ImageIo {
 	RowFunc		setupRowFuncForTypes( ImageTargetRef target );
 	template<typename SD>
 	RowFunc		setupRowFuncForSourceType( ImageTargetRef target );
+	//! Returns a RowFunc which skips the per-channel conversion when the source and target layouts allow it, or NULL
+	template<typename SD, typename TD, ColorModel TCM>
+	RowFunc		setupRowFuncFastPath( ImageTargetRef target );
 
 	template<typename SD, typename TD, ImageIo::ColorModel TCM, bool ALPHA>
 	void		rowFuncSourceRgb( ImageTargetRef target, int32_t row, const void *data );
 	template<typename SD, typename TD, ColorModel TCM, bool ALPHA>
 	void		rowFuncSourceGray( ImageTargetRef target, int32_t row, const void *data );
+	template<typename T>
+	void		rowFuncCopy( ImageTargetRef target, int32_t row, const void *data );
+	template<typename SD, typename TD>
+	void		rowFuncConvert( ImageTargetRef target, int32_t row, const void *data );
+	void		rowFuncSwizzle8u( ImageTargetRef target, int32_t row, const void *data );
 
 	float						mPixelAspectRatio;
 	bool						mIsPremultiplied;
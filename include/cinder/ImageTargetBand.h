@@ -0,0 +1,78 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/ImageIo.h"
+#include "cinder/Surface.h"
+#include "cinder/Function.h"
+
+namespace cinder {
+
+/** \brief An ImageTarget which holds only a band of rows rather than the whole image.
+ *
+ * Rows are decoded into a Surface of \a bandHeight rows. Once the band is full, and before the first row of the next band is written, it is passed to \a bandFn along with the index of its first row in the source image. The band is then reused, so peak memory is proportional to \a bandHeight rather than to the height of the image. The final band may be shorter than \a bandHeight. Sources must deliver their rows top to bottom, which all of the built-in ImageSources do.
+ * \note The Surface passed to \a bandFn is only valid for the duration of the call; copy it if it needs to outlive the band. **/
+template<typename T>
+class ImageTargetBandT : public ImageTarget {
+  public:
+	typedef std::function<void( const SurfaceT<T> &band, int32_t firstRow )>	BandFn;
+
+	static std::shared_ptr<ImageTargetBandT<T> > createRef( ImageSourceRef imageSource, int32_t bandHeight, BandFn bandFn, const SurfaceConstraints &constraints = SurfaceConstraintsDefault(), boost::tribool alpha = boost::logic::indeterminate )
+		{ return std::shared_ptr<ImageTargetBandT<T> >( new ImageTargetBandT<T>( imageSource, bandHeight, bandFn, constraints, alpha ) ); }
+
+	virtual bool	hasAlpha() const;
+	virtual void*	getRowPointer( int32_t row );
+	//! Hands the final, possibly partial, band to the BandFn
+	virtual void	finalize();
+
+	//! Returns the maximum number of rows held at once
+	int32_t			getBandHeight() const { return mBand.getHeight(); }
+	//! Returns the band Surface rows are decoded into
+	const SurfaceT<T>&	getBand() const { return mBand; }
+
+  protected:
+	ImageTargetBandT( ImageSourceRef imageSource, int32_t bandHeight, BandFn bandFn, const SurfaceConstraints &constraints, boost::tribool alpha );
+
+	void			flush();
+
+	SurfaceT<T>		mBand;
+	BandFn			mBandFn;
+	int32_t			mBandStart, mBandEnd;
+	bool			mFillAlpha;
+};
+
+typedef ImageTargetBandT<uint8_t>	ImageTargetBand8u;
+typedef ImageTargetBandT<float>		ImageTargetBand32f;
+
+/** \brief Loads \a imageSource \a bandHeight rows at a time, calling \a bandFn with each band and the index of its first row.
+ * Unlike constructing a Surface from \a imageSource, the whole image is never resident; only a band of \a bandHeight rows plus whatever the decoder itself buffers. For example:
+ * \code loadImageBands<uint8_t>( loadImage( "scan.png" ), 64, writeBand ); \endcode
+ * where \c writeBand is a <tt>void writeBand( const Surface8u &band, int32_t firstRow )</tt>. **/
+template<typename T>
+void loadImageBands( ImageSourceRef imageSource, int32_t bandHeight, typename ImageTargetBandT<T>::BandFn bandFn, const SurfaceConstraints &constraints = SurfaceConstraintsDefault(), boost::tribool alpha = boost::logic::indeterminate );
+
+class ImageTargetBandException : public ImageIoException {
+};
+
+} // namespace cinder
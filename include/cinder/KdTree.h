@@ -24,7 +24,10 @@
 
 #include "cinder/Cinder.h"
 #include "cinder/Vector.h"
+#include "cinder/Thread.h"
+#include "cinder/ip/Parallel.h"
 
+#include <boost/noncopyable.hpp>
 #include <vector>
 #include <float.h>
 #include <stdlib.h>
@@ -59,32 +62,155 @@ struct NullLookupProc {
 	void process( uint32_t id, float distSqrd, float &maxDistSqrd ) {}
 };
 
-template <typename NodeData, unsigned char K=3, class LookupProc = NullLookupProc> class KdTree {
+// A bounded max-heap of the nearest neighbors found so far by KdTree::findKNearest(), kept in the caller's arrays
+class KdNeighborHeap {
+ public:
+	KdNeighborHeap( uint32_t capacity, uint32_t *indices, float *distancesSqrd, float maxDistSqrd )
+		: mCapacity( capacity ), mSize( 0 ), mIndices( indices ), mDistancesSqrd( distancesSqrd ), mMaxDistSqrd( maxDistSqrd ) {}
+
+	//! Returns the squared distance a neighbor must be closer than to be inserted
+	float		getMaxDistSqrd() const { return ( mSize == mCapacity ) ? mDistancesSqrd[0] : mMaxDistSqrd; }
+	//! Inserts a neighbor closer than getMaxDistSqrd(), replacing the farthest one if the heap is full
+	void		insert( uint32_t index, float distSqrd ) {
+		uint32_t i;
+		if( mSize < mCapacity ) {
+			// sift up from the new last entry
+			for( i = mSize++; i > 0 && mDistancesSqrd[( i - 1 ) / 2] < distSqrd; i = ( i - 1 ) / 2 ) {
+				mIndices[i] = mIndices[( i - 1 ) / 2];
+				mDistancesSqrd[i] = mDistancesSqrd[( i - 1 ) / 2];
+			}
+		}
+		else {
+			// sift down from the root, which is replaced
+			i = 0;
+			while( true ) {
+				uint32_t child = i * 2 + 1;
+				if( child >= mSize )
+					break;
+				if( child + 1 < mSize && mDistancesSqrd[child + 1] > mDistancesSqrd[child] )
+					++child;
+				if( mDistancesSqrd[child] <= distSqrd )
+					break;
+				mIndices[i] = mIndices[child];
+				mDistancesSqrd[i] = mDistancesSqrd[child];
+				i = child;
+			}
+		}
+		mIndices[i] = index;
+		mDistancesSqrd[i] = distSqrd;
+	}
+	//! Sorts the neighbors nearest first, pads the arrays to the heap's capacity with \c ~0 and \c FLT_MAX and returns the number of neighbors
+	uint32_t	finish() {
+		const uint32_t size = mSize;
+		while( mSize > 1 ) {
+			// move the farthest remaining neighbor to the end and restore the heap in front of it
+			uint32_t index = mIndices[mSize - 1];
+			float distSqrd = mDistancesSqrd[mSize - 1];
+			mIndices[mSize - 1] = mIndices[0];
+			mDistancesSqrd[mSize - 1] = mDistancesSqrd[0];
+			--mSize;
+			mIndices[0] = index;
+			mDistancesSqrd[0] = distSqrd;
+			uint32_t i = 0;
+			while( true ) {
+				uint32_t child = i * 2 + 1;
+				if( child >= mSize )
+					break;
+				if( child + 1 < mSize && mDistancesSqrd[child + 1] > mDistancesSqrd[child] )
+					++child;
+				if( mDistancesSqrd[child] <= mDistancesSqrd[i] )
+					break;
+				std::swap( mIndices[i], mIndices[child] );
+				std::swap( mDistancesSqrd[i], mDistancesSqrd[child] );
+				i = child;
+			}
+		}
+		for( uint32_t i = size; i < mCapacity; ++i ) {
+			mIndices[i] = ~0u;
+			mDistancesSqrd[i] = FLT_MAX;
+		}
+		mSize = size;
+		return size;
+	}
+
+ private:
+	uint32_t	mCapacity, mSize;
+	uint32_t	*mIndices;
+	float		*mDistancesSqrd;
+	float		mMaxDistSqrd;
+};
+
+template <typename NodeData, unsigned char K=3, class LookupProc = NullLookupProc> class KdTree : private boost::noncopyable {
 public:
 	typedef std::pair<const NodeData*, uint32_t> NodeDataIndex;
 	
 	// KdTree Public Methods
+	//! Builds a tree over \a data, which must outlive it. Subtrees are built concurrently on \a numThreads threads, where \c 0 uses one per hardware core.
 	template<typename NodeDataVector>
-	KdTree( const NodeDataVector &data );
-	KdTree() {}
+	KdTree( const NodeDataVector &data, int32_t numThreads = 0 );
+	KdTree() : nodes( 0 ), mNodeData( 0 ), mPoints( 0 ), nNodes( 0 ) {}
 	template<typename NodeDataVector>
-	void initialize( const NodeDataVector &d );
+	void initialize( const NodeDataVector &d, int32_t numThreads = 0 );
 	~KdTree() {
 		free( nodes );
 		delete[] mNodeData;
+		delete[] mPoints;
 	}
-	void recursiveBuild( uint32_t nodeNum, uint32_t start, uint32_t end, std::vector<NodeDataIndex> &buildNodes );
+	//! Builds the subtree over \a buildNodes [\a start, \a end) at \a nodeNum, building one child on a new thread for the top \a parallelDepth levels
+	void recursiveBuild( uint32_t nodeNum, uint32_t start, uint32_t end, std::vector<NodeDataIndex> &buildNodes, int32_t parallelDepth = 0 );
 	void lookup( const NodeData &p, const LookupProc &process, float maxDist ) const;
 	void findNearest( float p[K], float result[K], uint32_t *resultIndex ) const;
+	/** Finds the \a k points nearest \a p within \a maxDist, storing their indices and squared distances nearest first in \a resultIndices and \a resultDistancesSqrd,
+		which must hold \a k values each. Returns the number of points found; the remaining entries are set to \c ~0 and \c FLT_MAX. **/
+	uint32_t findKNearest( const float p[K], uint32_t k, uint32_t *resultIndices, float *resultDistancesSqrd, float maxDist = FLT_MAX ) const;
+	/** Calls findKNearest() for each of \a numPoints \a points, storing \a k results per point consecutively in \a resultIndices and \a resultDistancesSqrd.
+		The points are divided among \a numThreads threads, where \c 0 uses one per hardware core. **/
+	void findKNearest( const NodeData *points, size_t numPoints, uint32_t k, uint32_t *resultIndices, float *resultDistancesSqrd, float maxDist = FLT_MAX, int32_t numThreads = 0 ) const;
 	
 private:
+	// Builds a subtree on its own thread
+	struct BuildTask {
+		BuildTask( KdTree *tree, uint32_t nodeNum, uint32_t start, uint32_t end, std::vector<NodeDataIndex> *buildNodes, int32_t parallelDepth )
+			: mTree( tree ), mNodeNum( nodeNum ), mStart( start ), mEnd( end ), mBuildNodes( buildNodes ), mParallelDepth( parallelDepth ) {}
+		void operator()() const { mTree->recursiveBuild( mNodeNum, mStart, mEnd, *mBuildNodes, mParallelDepth ); }
+
+		KdTree						*mTree;
+		uint32_t					mNodeNum, mStart, mEnd;
+		std::vector<NodeDataIndex>	*mBuildNodes;
+		int32_t						mParallelDepth;
+	};
+
+	// Answers the queries [begin, end) of a batched findKNearest() on one band of ip::parallelRows()
+	struct KNearestTask {
+		KNearestTask( const KdTree *tree, const NodeData *points, uint32_t k, uint32_t *resultIndices, float *resultDistancesSqrd, float maxDist )
+			: mTree( tree ), mPoints( points ), mK( k ), mResultIndices( resultIndices ), mResultDistancesSqrd( resultDistancesSqrd ), mMaxDist( maxDist ) {}
+		void operator()( int32_t begin, int32_t end ) const;
+
+		const KdTree	*mTree;
+		const NodeData	*mPoints;
+		uint32_t		mK;
+		uint32_t		*mResultIndices;
+		float			*mResultDistancesSqrd;
+		float			mMaxDist;
+	};
+
 	// KdTree Private Methods
 	void privateLookup(uint32_t nodeNum, float p[K], const LookupProc &process, float &maxDistSquared) const;
 	void privateFindNearest( uint32_t nodeNum, float p[K], float &maxDistSquared, float result[K], uint32_t *resultIndex ) const;
+	void privateFindKNearest( uint32_t nodeNum, const float p[K], KdNeighborHeap *heap ) const;
+	float distanceSquared( uint32_t nodeNum, const float p[K] ) const {
+		const float *point = &mPoints[nodeNum * K];
+		float result = 0;
+		for( unsigned char k = 0; k < K; ++k )
+			result += ( point[k] - p[k] ) * ( point[k] - p[k] );
+		return result;
+	}
 	// KdTree Private Data
 	KdNode<K> *nodes;
 	NodeDataIndex *mNodeData;
-	uint32_t nNodes, nextFreeNode;
+	// the coordinates of each node's point, so queries needn't visit the original data
+	float *mPoints;
+	uint32_t nNodes;
 };
 
 
@@ -145,34 +271,52 @@ template<typename NodeData> struct CompareNode {
 // KdTree Method Definitions
 template<typename NodeData, unsigned char K, typename LookupProc>
  template<typename NodeDataVector>
-KdTree<NodeData, K, LookupProc>::KdTree(const NodeDataVector &d)
+KdTree<NodeData, K, LookupProc>::KdTree( const NodeDataVector &d, int32_t numThreads )
+	: nodes( 0 ), mNodeData( 0 ), mPoints( 0 ), nNodes( 0 )
 {
-	initialize( d );
+	initialize( d, numThreads );
 }
 
 template<typename NodeData, unsigned char K, typename LookupProc>
  template<typename NodeDataVector>
-void KdTree<NodeData, K, LookupProc>::initialize( const NodeDataVector &d )
+void KdTree<NodeData, K, LookupProc>::initialize( const NodeDataVector &d, int32_t numThreads )
 {
+	free( nodes );
+	delete[] mNodeData;
+	delete[] mPoints;
+
 	nNodes = NodeDataVectorTraits<NodeDataVector>::getSize( d );
-	nextFreeNode = 1;
 	nodes = (KdNode<K> *)malloc(nNodes * sizeof(KdNode<K>));
 	mNodeData = new NodeDataIndex[nNodes];
+	mPoints = new float[nNodes * K];
 	std::vector<NodeDataIndex> buildNodes;
 	buildNodes.reserve( nNodes );
 	for( uint32_t i = 0; i < nNodes; ++i )
 		buildNodes.push_back( std::make_pair( &d[i], i ) );
+	if( nNodes == 0 )
+		return;
+
+	// one level more than strictly needed to occupy every thread, which helps balance threads of uneven speed
+	numThreads = ip::resolveNumThreads( numThreads );
+	int32_t parallelDepth = 0;
+	while( ( 1 << parallelDepth ) < numThreads )
+		++parallelDepth;
+	if( numThreads > 1 )
+		++parallelDepth;
+
 	// Begin the KdTree building process
-	recursiveBuild( 0, 0, nNodes, buildNodes );
+	recursiveBuild( 0, 0, nNodes, buildNodes, parallelDepth );
 }
 
 template<typename NodeData, unsigned char K, typename LookupProc>
-void KdTree<NodeData, K, LookupProc>::recursiveBuild( uint32_t nodeNum, uint32_t start, uint32_t end, std::vector<NodeDataIndex> &buildNodes )
+void KdTree<NodeData, K, LookupProc>::recursiveBuild( uint32_t nodeNum, uint32_t start, uint32_t end, std::vector<NodeDataIndex> &buildNodes, int32_t parallelDepth )
 {
 	// Create leaf node of kd-tree if we've reached the bottom
 	if( start + 1 == end) {
 		nodes[nodeNum].initLeaf();
 		mNodeData[nodeNum] = buildNodes[start];
+		for( unsigned char k = 0; k < K; ++k )
+			mPoints[nodeNum * K + k] = NodeDataTraits<NodeData>::getAxis( *buildNodes[start].first, k );
 		return;
 	}
 	// Choose split direction and partition data
@@ -180,7 +324,7 @@ void KdTree<NodeData, K, LookupProc>::recursiveBuild( uint32_t nodeNum, uint32_t
 	float boundMin[K], boundMax[K];
 	for( unsigned char k = 0; k < K; ++k ) {
 		boundMin[k] = FLT_MAX;
-		boundMax[k] = FLT_MIN;
+		boundMax[k] = -FLT_MAX;
 	}
 	
 	for( uint32_t i = start; i < end; ++i ) {
@@ -203,14 +347,26 @@ void KdTree<NodeData, K, LookupProc>::recursiveBuild( uint32_t nodeNum, uint32_t
 	// Allocate kd-tree node and continue recursively
 	nodes[nodeNum].init( NodeDataTraits<NodeData>::getAxis( *buildNodes[splitPos].first, splitAxis ), splitAxis );
 	mNodeData[nodeNum] = buildNodes[splitPos];
-	if( start < splitPos ) {
+	for( unsigned char k = 0; k < K; ++k )
+		mPoints[nodeNum * K + k] = NodeDataTraits<NodeData>::getAxis( *buildNodes[splitPos].first, k );
+	// nodes are numbered depth-first, so the left subtree's splitPos - start nodes precede the right child; the subtrees
+	// occupy disjoint ranges of every array and may be built concurrently
+	const bool hasLeft = start < splitPos, hasRight = splitPos + 1 < end;
+	if( hasLeft )
 		nodes[nodeNum].hasLeftChild = 1;
-		uint32_t childNum = nextFreeNode++;
-		recursiveBuild( childNum, start, splitPos, buildNodes );
+	if( hasRight )
+		nodes[nodeNum].rightChild = nodeNum + 1 + ( splitPos - start );
+	const uint32_t minParallelNodes = 16384;
+	if( hasLeft && hasRight && ( parallelDepth > 0 ) && ( end - start >= minParallelNodes ) ) {
+		std::thread thread( BuildTask( this, nodeNum + 1, start, splitPos, &buildNodes, parallelDepth - 1 ) );
+		recursiveBuild( nodes[nodeNum].rightChild, splitPos + 1, end, buildNodes, parallelDepth - 1 );
+		thread.join();
 	}
-	if( splitPos + 1 < end ) {
-		nodes[nodeNum].rightChild = nextFreeNode++;
-		recursiveBuild( nodes[nodeNum].rightChild, splitPos + 1, end, buildNodes );
+	else {
+		if( hasLeft )
+			recursiveBuild( nodeNum + 1, start, splitPos, buildNodes, parallelDepth - 1 );
+		if( hasRight )
+			recursiveBuild( nodes[nodeNum].rightChild, splitPos + 1, end, buildNodes, parallelDepth - 1 );
 	}
 }
 
@@ -222,7 +378,8 @@ void KdTree<NodeData, K, LookupProc>::lookup( const NodeData &p, const LookupPro
 	for( unsigned char k = 0; k < K; ++k )
 		pt[k] = NodeDataTraits<NodeData>::getAxis( p, k );
 
-	privateLookup( 0, pt, proc, maxDistSqrd );
+	if( nNodes > 0 )
+		privateLookup( 0, pt, proc, maxDistSqrd );
 }
 
 template<typename NodeData, unsigned char K, typename LookupProc>
@@ -247,12 +404,7 @@ void KdTree<NodeData, K, LookupProc>::privateLookup( uint32_t nodeNum, float p[K
 		}
 	}
 	// Hand kd-tree node to processing function
-	float distSqr = 0.0f;
-	for( unsigned char k = 0; k < K; ++k ) {
-		float v = NodeDataTraits<NodeData>::getAxis( *mNodeData[nodeNum].first, k ) - p[k];
-		distSqr += v * v;
-	}
-	
+	float distSqr = distanceSquared( nodeNum, p );
 	if( distSqr < maxDistSquared )
 		process.process( mNodeData[nodeNum].second, distSqr, maxDistSquared );
 }
@@ -263,7 +415,8 @@ void KdTree<NodeData, K, LookupProc>::findNearest( float p[K], float result[K],
 {
 	float maxDist = FLT_MAX;
 	*resultIndex = -1;
-	privateFindNearest( 0, p, maxDist, result, resultIndex );
+	if( nNodes > 0 )
+		privateFindNearest( 0, p, maxDist, result, resultIndex );
 }
 
 template<typename NodeData, unsigned char K, typename LookupProc>
@@ -292,13 +445,67 @@ void KdTree<NodeData, K, LookupProc>::privateFindNearest( uint32_t nodeNum, floa
 		}
 	}
 	
-	float distSqr = NodeDataTraits<NodeData>::distanceSquared( *mNodeData[nodeNum].first, p );
+	float distSqr = distanceSquared( nodeNum, p );
 	if( distSqr < maxDistSquared ) {
 		maxDistSquared = distSqr;
 		for( unsigned char k = 0; k < K; ++k )
-			result[k] = NodeDataTraits<NodeData>::getAxis( *mNodeData[nodeNum].first, k );
+			result[k] = mPoints[nodeNum * K + k];
 		*resultIndex = mNodeData[nodeNum].second;
 	}
 }
 
+// Find K Nearest
+template<typename NodeData, unsigned char K, typename LookupProc>
+uint32_t KdTree<NodeData, K, LookupProc>::findKNearest( const float p[K], uint32_t k, uint32_t *resultIndices, float *resultDistancesSqrd, float maxDist ) const
+{
+	KdNeighborHeap heap( k, resultIndices, resultDistancesSqrd, ( maxDist < FLT_MAX ) ? maxDist * maxDist : FLT_MAX );
+	if( ( nNodes > 0 ) && ( k > 0 ) )
+		privateFindKNearest( 0, p, &heap );
+	return heap.finish();
+}
+
+template<typename NodeData, unsigned char K, typename LookupProc>
+void KdTree<NodeData, K, LookupProc>::findKNearest( const NodeData *points, size_t numPoints, uint32_t k, uint32_t *resultIndices, float *resultDistancesSqrd, float maxDist, int32_t numThreads ) const
+{
+	ip::parallelRows( 0, (int32_t)numPoints, numThreads, KNearestTask( this, points, k, resultIndices, resultDistancesSqrd, maxDist ), 256 );
+}
+
+template<typename NodeData, unsigned char K, typename LookupProc>
+void KdTree<NodeData, K, LookupProc>::KNearestTask::operator()( int32_t begin, int32_t end ) const
+{
+	float p[K];
+	for( int32_t i = begin; i < end; ++i ) {
+		for( unsigned char axis = 0; axis < K; ++axis )
+			p[axis] = NodeDataTraits<NodeData>::getAxis( mPoints[i], axis );
+		mTree->findKNearest( p, mK, mResultIndices + (size_t)i * mK, mResultDistancesSqrd + (size_t)i * mK, mMaxDist );
+	}
+}
+
+template<typename NodeData, unsigned char K, typename LookupProc>
+void KdTree<NodeData, K, LookupProc>::privateFindKNearest( uint32_t nodeNum, const float p[K], KdNeighborHeap *heap ) const
+{
+	const KdNode<K> *node = &nodes[nodeNum];
+	// descend into the child containing p first, then the other only if the splitting plane is nearer than the farthest neighbor so far
+	int axis = node->splitAxis;
+	if( axis != K ) {
+		float dist = p[axis] - node->splitPos;
+		if( dist <= 0 ) {
+			if( node->hasLeftChild )
+				privateFindKNearest( nodeNum + 1, p, heap );
+			if( ( dist * dist < heap->getMaxDistSqrd() ) && ( node->rightChild < nNodes ) )
+				privateFindKNearest( node->rightChild, p, heap );
+		}
+		else {
+			if( node->rightChild < nNodes )
+				privateFindKNearest( node->rightChild, p, heap );
+			if( ( dist * dist < heap->getMaxDistSqrd() ) && node->hasLeftChild )
+				privateFindKNearest( nodeNum + 1, p, heap );
+		}
+	}
+
+	float distSqr = distanceSquared( nodeNum, p );
+	if( distSqr < heap->getMaxDistSqrd() )
+		heap->insert( mNodeData[nodeNum].second, distSqr );
+}
+
 } // namespace ci
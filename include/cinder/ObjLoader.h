@@ -26,14 +26,13 @@
 #include "cinder/Stream.h"
 
 #include <boost/logic/tribool.hpp>
-#include <boost/tuple/tuple_comparison.hpp>
-#include <map>
 
 namespace cinder {
 
 /** \brief Loads Alias|Wavefront .OBJ file format
  *
- * Currently does not support anything but polygonal data
+ * Currently does not support anything but polygonal data. Large files are split on line boundaries and parsed in parallel.
+ * Streams over memory, such as those of loadFileMapped(), are parsed in place; any other stream is read into memory first.
  * \n Example usage:
  * \code
  * cinder::TriMesh myCube;
@@ -58,7 +57,8 @@ class ObjLoader {
 	 * \param destTriMesh the destination TriMesh, whose contents are cleared first
 	 * \param loadNormals  should normals be loaded or generated if not present. Default determines from the contents of the file
 	 * \param loadTexCoords  should 2D texture coordinates be loaded or set to zero if not present. Default determines from the contents of the file
-	 * \param optimizeVertices  should the loader minimze the vertices by identifying shared vertices between faces. */
+	 * \param optimizeVertices  should the loader minimze the vertices by identifying shared vertices between faces. Files with several groups
+	 * are optimized one group per thread and then merged, giving the same result as a sequential load. */
 	void	load( TriMesh *destTriMesh, boost::tribool loadNormals = boost::logic::indeterminate, boost::tribool loadTexCoords = boost::logic::indeterminate, bool optimizeVertices = true );
 	/**Loads a particular group into a TriMesh
 	 * \param loadNormals  should normals be loaded or generated if not present. Default determines from the contents of the file
@@ -85,17 +85,18 @@ class ObjLoader {
 	static void		write( DataTargetRef dataTarget, const TriMesh &mesh, bool writeNormals = true, bool writeUVs = true );
 	
  private:
-	typedef boost::tuple<int,int> VertexPair;
-	typedef boost::tuple<int,int,int> VertexTriple;
+	class VertexTable;
+	struct GroupLoader;
+	friend struct GroupLoader;
 
 	void	parse( bool includeUVs );
-
- 	void	parseFace( Group *group, const std::string &s, bool includeUVs );
 	void	loadInternalNoOptimize( const Group &group, TriMesh *destTriMesh, bool texCoords, bool normals );
-	void	loadInternalNormalsTextures( const Group &group, std::map<boost::tuple<int,int,int>,int> &uniqueVerts, TriMesh *destTriMesh );
-	void	loadInternalNormals( const Group &group, std::map<boost::tuple<int,int>,int> &uniqueVerts, TriMesh *destTriMesh );
-	void	loadInternalTextures( const Group &group, std::map<boost::tuple<int,int>,int> &uniqueVerts, TriMesh *destTriMesh );
-	void	loadInternal( const Group &group, std::map<int,int> &uniqueVerts, TriMesh *destTriMesh );	
+	void	loadInternalOptimize( const Group &group, VertexTable &uniqueVerts, TriMesh *destTriMesh, bool texCoords, bool normals );
+	void	loadInternalNormalsTextures( const Group &group, VertexTable &uniqueVerts, TriMesh *destTriMesh );
+	void	loadInternalNormals( const Group &group, VertexTable &uniqueVerts, TriMesh *destTriMesh );
+	void	loadInternalTextures( const Group &group, VertexTable &uniqueVerts, TriMesh *destTriMesh );
+	void	loadInternal( const Group &group, VertexTable &uniqueVerts, TriMesh *destTriMesh );
+	void	loadParallelOptimize( TriMesh *destTriMesh, bool texCoords, bool normals );
  
 	std::shared_ptr<IStream>	mStream;
 	std::vector<Vec3f>			mVertices, mNormals;
@@ -272,6 +272,25 @@ class IStreamMem : public IStream {
 };
 
 
+typedef std::shared_ptr<class IStreamMapped>	IStreamMappedRef;
+//! An IStreamMem over a read-only memory mapping of a file. getData() points directly into the mapping, so bytes are only paged in as they're touched and never copied by the stream itself.
+class IStreamMapped : public IStreamMem {
+ public:
+	//! Maps the file at \a path. Throws StreamExc if the file can't be opened or mapped.
+	static IStreamMappedRef		createRef( const std::string &path );
+	//! Creates a new stream over the same mapping as \a stream, with its own offset starting at the beginning of the file
+	static IStreamMappedRef		createRef( const IStreamMappedRef &stream );
+	~IStreamMapped();
+
+ protected:
+	struct Mapping;
+
+	IStreamMapped( const std::shared_ptr<Mapping> &mapping );
+
+	std::shared_ptr<Mapping>	mMapping;
+};
+
+
 class OStreamMem : public OStream {
  public:
 	~OStreamMem();
@@ -310,6 +329,8 @@ class IStreamStateRestore {
 
 //! Opens the file lcoated at \a path for read access as a stream.
 IStreamFileRef	loadFileStream( const std::string &path );
+//! Maps the file located at \a path into memory for read access as a stream. Throws StreamExc on failure.
+IStreamMappedRef	loadFileStreamMapped( const std::string &path );
 //! Opens the file located at \a path for write access as a stream, and creates it if it does not exist. Optionally creates any intermediate directories when \a createParents is true.
 OStreamFileRef	writeFileStream( const std::string &path, bool createParents = true );
 //! Opens a path for read-write access as a stream.
@@ -29,11 +29,29 @@
 #include "cinder/DataTarget.h"
 #include "cinder/Matrix.h"
 #include "cinder/Color.h"
+#include "cinder/Exception.h"
 
 namespace cinder {
 
 class TriMesh {
  public:
+	//! Options for write()
+	class WriteOptions {
+	  public:
+		WriteOptions() : mQuantizeNormals( false ), mQuantizeTexCoords( false ) {}
+
+		//! Stores normals as octahedrally encoded pairs of 16-bit values, a third of their size. Only directions are preserved, to within 1e-4 radians.
+		WriteOptions&	quantizeNormals( bool quantize = true ) { mQuantizeNormals = quantize; return *this; }
+		/** Stores tex coords as 16-bit fractions of their bounding rectangle, half their size. Each coordinate is preserved to within half a step,
+			1/131070 of the rectangle's extent along its axis, e.g. about 7.6e-6 for tex coords spanning [0, 1] and 6.1e-5 for a span of 8. **/
+		WriteOptions&	quantizeTexCoords( bool quantize = true ) { mQuantizeTexCoords = quantize; return *this; }
+
+		bool	getQuantizeNormals() const { return mQuantizeNormals; }
+		bool	getQuantizeTexCoords() const { return mQuantizeTexCoords; }
+
+	  private:
+		bool	mQuantizeNormals, mQuantizeTexCoords;
+	};
 
 	void		clear();
 	
@@ -72,10 +90,17 @@ class TriMesh {
 	//! Calculates the bounding box of all vertices as transformed by \a transform
 	AxisAlignedBox3f	calcBoundingBox( const Matrix44f &transform ) const;
 
+	/** Reads a mesh written by write(), in either the current or the original format. On little-endian hosts attributes are read
+		in bulk, directly from memory when \a in is a DataSourceMapped, and otherwise with a single read of the rest of the file. **/
 	void		read( DataSourceRef in );
-	void		write( DataTargetRef out ) const;
+	/** Writes the mesh in the current binary format: a fixed header followed by a 16-byte aligned, contiguous block per attribute, with every
+		value little-endian. Indices are stored as 16-bit values whenever they fit. Files can be viewed in place through TriMeshMapped. **/
+	void		write( DataTargetRef out, const WriteOptions &options = WriteOptions() ) const;
 	
  private:
+	void		readVersion1( IStreamRef in );
+	void		readVersion2( const uint8_t *data, size_t dataSize );
+
 	std::vector<Vec3f>		mVertices;
 	std::vector<Vec3f>		mNormals;
 	std::vector<Color>		mColorsRGB;
@@ -84,4 +109,60 @@ class TriMesh {
 	std::vector<size_t>		mIndices;
 };
 
+typedef std::shared_ptr<class TriMeshMapped>	TriMeshMappedRef;
+
+/** A read-only view of a file written by TriMesh::write(), directly over its memory mapping. Nothing is copied or decoded, so attributes
+	stored quantized are only available in their quantized form, and everything is little-endian, so it is unavailable on big-endian hosts.
+	Pass the same DataSourceMapped to TriMesh::read() to decode the whole mesh. **/
+class TriMeshMapped {
+  public:
+	//! Throws TriMeshExc if \a dataSource isn't a TriMesh in the current format, or on a big-endian host
+	static TriMeshMappedRef		createRef( DataSourceMappedRef dataSource );
+
+	size_t			getNumVertices() const { return mNumVertices; }
+	size_t			getNumNormals() const { return mNumNormals; }
+	size_t			getNumTexCoords() const { return mNumTexCoords; }
+	size_t			getNumIndices() const { return mNumIndices; }
+	size_t			getNumTriangles() const { return mNumIndices / 3; }
+
+	const Vec3f*	getVertices() const { return mVertices; }
+
+	//! Returns whether normals are stored as octahedrally encoded pairs of snorm16 values, available through getQuantizedNormals()
+	bool			hasQuantizedNormals() const { return mQuantizedNormals != 0; }
+	//! Returns NULL when the normals are quantized
+	const Vec3f*	getNormals() const { return mNormals; }
+	const int16_t*	getQuantizedNormals() const { return mQuantizedNormals; }
+
+	//! Returns whether tex coords are stored as pairs of unorm16 fractions of the rectangle from getTexCoordMin() to getTexCoordMax(), available through getQuantizedTexCoords()
+	bool			hasQuantizedTexCoords() const { return mQuantizedTexCoords != 0; }
+	//! Returns NULL when the tex coords are quantized
+	const Vec2f*	getTexCoords() const { return mTexCoords; }
+	const uint16_t*	getQuantizedTexCoords() const { return mQuantizedTexCoords; }
+	const Vec2f&	getTexCoordMin() const { return mTexCoordMin; }
+	const Vec2f&	getTexCoordMax() const { return mTexCoordMax; }
+
+	//! Returns the size of each index in bytes, either 2 or 4
+	size_t			getIndexSize() const { return ( mIndices16 ) ? 2 : 4; }
+	//! Returns NULL unless getIndexSize() is 2
+	const uint16_t*	getIndices16() const { return mIndices16; }
+	//! Returns NULL unless getIndexSize() is 4
+	const uint32_t*	getIndices32() const { return mIndices32; }
+
+  protected:
+	TriMeshMapped( DataSourceMappedRef dataSource );
+
+	DataSourceMappedRef		mDataSource;
+	size_t					mNumVertices, mNumNormals, mNumTexCoords, mNumIndices;
+	const Vec3f				*mVertices, *mNormals;
+	const int16_t			*mQuantizedNormals;
+	const Vec2f				*mTexCoords;
+	const uint16_t			*mQuantizedTexCoords;
+	Vec2f					mTexCoordMin, mTexCoordMax;
+	const uint16_t			*mIndices16;
+	const uint32_t			*mIndices32;
+};
+
+class TriMeshExc : public Exception {
+};
+
 } // namespace cinder
@@ -0,0 +1,125 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "cinder/TriMesh.h"
+#include "cinder/Ray.h"
+#include "cinder/AxisAlignedBox.h"
+
+#include <vector>
+#include <limits>
+
+namespace cinder {
+
+/** A bounding volume hierarchy over the triangles of a TriMesh for fast ray queries. The tree is built with a binned surface area heuristic,
+	with large subtrees built concurrently, and is stored as a flat depth-first array of nodes. Triangles are copied into the hierarchy in
+	groups of four which are tested against a ray at once, so the TriMesh need not outlive it. **/
+class TriMeshBvh {
+ public:
+	//! Options for construction
+	class Options {
+	  public:
+		Options() : mMaxLeafSize( 4 ), mNumBins( 16 ), mNumThreads( 0 ) {}
+
+		//! Sets the largest number of triangles a leaf may hold. Default is \c 4, and the maximum is \c 64.
+		Options&	maxLeafSize( int32_t size ) { mMaxLeafSize = size; return *this; }
+		//! Sets the number of bins each axis is divided into when evaluating splits. Default is \c 16, and the maximum is \c 64.
+		Options&	numBins( int32_t bins ) { mNumBins = bins; return *this; }
+		//! Sets the number of threads used to build subtrees. Default is \c 0, which uses one thread per hardware core.
+		Options&	numThreads( int32_t threads ) { mNumThreads = threads; return *this; }
+
+		int32_t		getMaxLeafSize() const { return mMaxLeafSize; }
+		int32_t		getNumBins() const { return mNumBins; }
+		int32_t		getNumThreads() const { return mNumThreads; }
+
+	  private:
+		int32_t		mMaxLeafSize, mNumBins, mNumThreads;
+	};
+
+	//! The result of a ray query
+	struct Hit {
+		Hit() : mTriangle( NO_TRIANGLE ), mDistance( std::numeric_limits<float>::max() ), mU( 0 ), mV( 0 ) {}
+
+		bool		isValid() const { return mTriangle != NO_TRIANGLE; }
+
+		//! The index of the triangle hit, as passed to TriMesh::getTriangleVertices(), or \c NO_TRIANGLE
+		uint32_t	mTriangle;
+		//! The hit position is Ray::calcPosition( mDistance )
+		float		mDistance;
+		//! Barycentric coordinates of the hit position, weighting the triangle's second and third vertices
+		float		mU, mV;
+	};
+
+	static const uint32_t NO_TRIANGLE = 0xFFFFFFFF;
+
+	TriMeshBvh() : mNumTriangles( 0 ) {}
+	//! Builds a hierarchy over the triangles of \a mesh
+	explicit TriMeshBvh( const TriMesh &mesh, const Options &options = Options() );
+
+	//! Finds the closest triangle hit by \a ray within \a maxDistance, returning whether there was one and storing it in \a result if so
+	bool	intersect( const Ray &ray, Hit *result, float maxDistance = std::numeric_limits<float>::max() ) const;
+	//! Returns whether \a ray hits any triangle within \a maxDistance. This is faster than intersect() and suits occlusion tests.
+	bool	intersects( const Ray &ray, float maxDistance = std::numeric_limits<float>::max() ) const;
+	/** Finds the closest hit for each of \a numRays \a rays, storing them in \a results, which are invalid for rays that hit nothing. Rays are traced
+		in packets of four which share a traversal, which is fastest when consecutive rays are coherent, e.g. neighboring pixels. Packets are
+		divided among \a numThreads threads, where \c 0 uses one thread per hardware core. **/
+	void	intersect( const Ray *rays, size_t numRays, Hit *results, int32_t numThreads = 1 ) const;
+
+	//! Returns the bounds of all the triangles
+	AxisAlignedBox3f	getBoundingBox() const;
+	size_t				getNumTriangles() const { return mNumTriangles; }
+	size_t				getNumNodes() const { return mNodes.size(); }
+
+	//! A node of the hierarchy. The first child of an interior node immediately follows it.
+	struct Node {
+		float		mMin[3];
+		//! For a leaf, the index of its first TriangleBlock; otherwise the index of its second child
+		uint32_t	mOffset;
+		float		mMax[3];
+		//! The number of TriangleBlocks of a leaf, or \c 0 for an interior node
+		uint16_t	mNumBlocks;
+		//! The axis an interior node was split along
+		uint8_t		mAxis;
+		uint8_t		mPadding;
+	};
+
+	//! Four triangles stored as their first vertex and two edges, one array per coordinate. Unused entries are degenerate.
+	struct TriangleBlock {
+		float		mVert0[3][4];
+		float		mEdge1[3][4];
+		float		mEdge2[3][4];
+		uint32_t	mTriangles[4];
+	};
+
+ private:
+	struct PacketTask;
+	friend struct PacketTask;
+
+	void	intersectPackets( const Ray *rays, size_t numRays, Hit *results ) const;
+
+	std::vector<Node>			mNodes;
+	std::vector<TriangleBlock>	mBlocks;
+	size_t						mNumTriangles;
+};
+
+} // namespace cinder
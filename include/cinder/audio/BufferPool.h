@@ -0,0 +1,90 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/Thread.h"
+
+#include <vector>
+
+namespace cinder { namespace audio {
+
+typedef std::shared_ptr<class BufferPool> BufferPoolRef;
+
+/** \brief Size-class pool of memory for audio sample data
+ *
+ * Requests are rounded up to a power of two of at least 256 bytes, and released blocks are kept on a free list for their size class, so once a pool is warm
+ * allocating and releasing a buffer doesn't reach the heap. Blocks larger than 256MB bypass the free lists. Every block records the pool it came from, so
+ * release() needs only the pointer. A pool must outlive the blocks allocated from it; the default pool is never destroyed. Thread-safe. **/
+class BufferPool {
+ public:
+	struct Stats {
+		//! Allocations satisfied from a free list
+		uint64_t	mHits;
+		//! Allocations which reached the heap
+		uint64_t	mMisses;
+		//! Released blocks which were freed because their free list was full
+		uint64_t	mDiscards;
+		//! Bytes held in free lists
+		size_t		mCachedBytes;
+	};
+
+	//! Creates a pool which keeps up to \a maxFreeBlocks released blocks of each size class
+	static BufferPoolRef	createRef( uint32_t maxFreeBlocks = 64 );
+	//! Returns the pool which PcmBufferT and createBufferList() use by default
+	static BufferPoolRef	getDefault();
+	~BufferPool();
+
+	//! Returns a block of at least \a byteSize bytes, aligned as by malloc()
+	void*		allocate( size_t byteSize );
+	//! Returns an array of \a count T's, which must be released with release()
+	template<typename T>
+	T*			allocate( size_t count ) { return static_cast<T*>( allocate( count * sizeof(T) ) ); }
+	//! Returns \a data, which may come from any BufferPool, to the pool it came from. Ignores NULL.
+	static void	release( void *data );
+
+	//! Fills the free list for blocks of \a byteSize bytes with up to \a count blocks, so that later allocations of that size don't reach the heap
+	void		reserve( size_t byteSize, uint32_t count );
+	//! Frees every block held in the free lists
+	void		trim();
+
+	Stats		getStats() const;
+	void		resetStats();
+
+ private:
+	BufferPool( uint32_t maxFreeBlocks );
+
+	//! Returns the size class of \a byteSize, or \c NUM_SIZE_CLASSES if it's too large to pool
+	static uint32_t	sizeClass( size_t byteSize );
+	void			release( void *block, uint32_t sizeClass );
+
+	static const uint32_t	MIN_SIZE_CLASS_SHIFT = 8;
+	static const uint32_t	NUM_SIZE_CLASSES = 21;
+
+	mutable std::mutex				mMutex;
+	uint32_t						mMaxFreeBlocks;
+	std::vector<void*>				mFreeBlocks[NUM_SIZE_CLASSES];
+	Stats							mStats;
+};
+
+}} //namespace
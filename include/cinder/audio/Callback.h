@@ -116,7 +116,7 @@ Callback<T,U>::Callback( T* callbackObj, CallbackFunction callbackFn, bool ownCa
 		mDataType = Io::UINT32;
 		mBitsPerSample = 32;
 	} else if( boost::is_same<U,int32_t>::value ) {
-		mDataType = Io::UINT32;
+		mDataType = Io::INT32;
 		mBitsPerSample = 32;
 	} else if( boost::is_same<U,float>::value ) {
 		mDataType = Io::FLOAT32;
@@ -142,6 +142,7 @@ void Callback<T,U>::getData( uint64_t inSampleOffset, uint32_t ioSampleCount, Bu
 	BufferT<U> typedBuffer;
 	typedBuffer.mNumberChannels = ioBuffer->mNumberChannels;
 	typedBuffer.mDataByteSize = ioBuffer->mDataByteSize;
+	typedBuffer.mSampleCount = ioSampleCount;
 	typedBuffer.mData = reinterpret_cast<U*>( ioBuffer->mData );
 	
 	( mCallbackObj->*mCallbackFn )( inSampleOffset, ioSampleCount, &typedBuffer );
@@ -191,7 +192,7 @@ void LoaderSourceCallback<T,U>::loadData( BufferList *ioData ) {
 #if defined( CINDER_COCOA )
 	mConverter->loadData( ioData );
 	mSampleOffset += ioData->mBuffers[0].mSampleCount;
-#elif defined( CINDER_MSW )
+#else
 	mSource->getData( mSampleOffset, ioData->mBuffers[0].mSampleCount, &ioData->mBuffers[0] );
 	mSampleOffset += ioData->mBuffers[0].mSampleCount;
 #endif
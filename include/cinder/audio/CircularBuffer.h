@@ -22,6 +22,18 @@
 
 #pragma once
 
+#include "cinder/Cinder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#if defined( CINDER_COCOA )
+	#include <libkern/OSAtomic.h>
+#elif defined( CINDER_MSW )
+	#include <intrin.h>
+#endif
+
 namespace cinder { namespace audio {
 
 template<typename T>
@@ -108,4 +120,164 @@ void CircularBuffer<T>::insert( const T* src, uint32_t size )
 }
 
 
-}} //namespace
\ No newline at end of file
+
+/** \brief Wait-free ring buffer for one producer thread and one consumer thread, such as an audio callback and an analysis thread
+ *
+ * Unlike CircularBuffer, which always holds the most recent samples, samples are removed as they are read, and samples which don't fit are dropped rather than
+ * overwriting unread ones. The capacity is rounded up to a power of two. Only the producer may call write(), getWriteRanges() and commitWrite(), and only the
+ * consumer may call read(), getReadRanges() and commitRead(); neither side ever blocks the other. **/
+template<typename T>
+class SpscCircularBuffer {
+ public:
+	typedef std::pair<T*,uint32_t> ArrayRange;
+
+	//! Creates a buffer which holds at least \a minSize samples
+	SpscCircularBuffer( uint32_t minSize );
+	~SpscCircularBuffer();
+
+	//! Copies up to \a size samples from \a src and returns the number copied. Samples which don't fit are dropped and counted by getOverrunCount().
+	uint32_t	write( const T *src, uint32_t size );
+	//! Sets \a one and \a two to the free space, in the order it will be filled. Follow with commitWrite() once samples have been written there.
+	void		getWriteRanges( ArrayRange *one, ArrayRange *two ) const;
+	//! Publishes \a size samples written to the ranges returned by getWriteRanges()
+	void		commitWrite( uint32_t size );
+
+	//! Copies up to \a size samples to \a dst, oldest first, and returns the number copied. A shortfall is counted by getUnderrunCount().
+	uint32_t	read( T *dst, uint32_t size );
+	//! Sets \a one and \a two to the unread samples, oldest first, without consuming them. Follow with commitRead() to consume them.
+	void		getReadRanges( ArrayRange *one, ArrayRange *two ) const;
+	//! Consumes \a size samples from the ranges returned by getReadRanges()
+	void		commitRead( uint32_t size );
+
+	//! Returns the number of samples available to the consumer
+	uint32_t	getReadAvailable() const { return loadAcquire( mWriteIndex ) - mReadIndex; }
+	//! Returns the number of samples which the producer can write without dropping any
+	uint32_t	getWriteAvailable() const { return mMaxSize - ( mWriteIndex - loadAcquire( mReadIndex ) ); }
+	uint32_t	maxSize() const { return mMaxSize; }
+
+	//! Returns the number of samples write() has dropped because the buffer was full. Safe to call from any thread; wraps at 2^32.
+	uint32_t	getOverrunCount() const { return mOverrunCount; }
+	//! Returns the number of samples read() was asked for but which weren't available. Safe to call from any thread; wraps at 2^32.
+	uint32_t	getUnderrunCount() const { return mUnderrunCount; }
+
+ private:
+	// Prevents the compiler and CPU from moving loads and stores across the call
+	static void		memoryBarrier();
+	static uint32_t	loadAcquire( const volatile uint32_t &index ) { uint32_t result = index; memoryBarrier(); return result; }
+	static void		storeRelease( volatile uint32_t &index, uint32_t value ) { memoryBarrier(); index = value; }
+
+	//! Splits the \a size samples starting at free-running index \a start into up to two ranges
+	void			ranges( uint32_t start, uint32_t size, ArrayRange *one, ArrayRange *two ) const;
+
+	T			* mBuffer;
+	uint32_t	mMaxSize;
+	uint32_t	mMask;
+
+	// The indices increase forever and are masked on access, so that a full buffer can be told from an empty one. Each is written by one side only,
+	// and they are kept on separate cache lines so that the producer and consumer don't contend.
+	char				mPad0[64];
+	volatile uint32_t	mWriteIndex;
+	volatile uint32_t	mOverrunCount;
+	char				mPad1[64];
+	volatile uint32_t	mReadIndex;
+	volatile uint32_t	mUnderrunCount;
+	char				mPad2[64];
+};
+
+template<typename T>
+SpscCircularBuffer<T>::SpscCircularBuffer( uint32_t minSize )
+	: mWriteIndex( 0 ), mOverrunCount( 0 ), mReadIndex( 0 ), mUnderrunCount( 0 )
+{
+	// the indices are compared modulo 2^32, which limits the capacity to 2^31
+	mMaxSize = 1;
+	while( ( mMaxSize < minSize ) && ( mMaxSize < 0x80000000u ) )
+		mMaxSize *= 2;
+	mMask = mMaxSize - 1;
+	mBuffer = new T[mMaxSize];
+}
+
+template<typename T>
+SpscCircularBuffer<T>::~SpscCircularBuffer()
+{
+	delete [] mBuffer;
+}
+
+template<typename T>
+void SpscCircularBuffer<T>::memoryBarrier()
+{
+#if defined( CINDER_COCOA )
+	OSMemoryBarrier();
+#elif defined( CINDER_MSW )
+	// x86 doesn't reorder stores with other stores or loads with other loads, so only the compiler needs to be restrained
+	_ReadWriteBarrier();
+#else
+	__sync_synchronize();
+#endif
+}
+
+template<typename T>
+void SpscCircularBuffer<T>::ranges( uint32_t start, uint32_t size, ArrayRange *one, ArrayRange *two ) const
+{
+	uint32_t offset = start & mMask;
+	uint32_t sizeOne = std::min( size, mMaxSize - offset );
+	*one = ArrayRange( mBuffer + offset, sizeOne );
+	*two = ArrayRange( mBuffer, size - sizeOne );
+}
+
+template<typename T>
+void SpscCircularBuffer<T>::getWriteRanges( ArrayRange *one, ArrayRange *two ) const
+{
+	ranges( mWriteIndex, getWriteAvailable(), one, two );
+}
+
+template<typename T>
+void SpscCircularBuffer<T>::commitWrite( uint32_t size )
+{
+	storeRelease( mWriteIndex, mWriteIndex + size );
+}
+
+template<typename T>
+uint32_t SpscCircularBuffer<T>::write( const T *src, uint32_t size )
+{
+	ArrayRange one, two;
+	getWriteRanges( &one, &two );
+	uint32_t sizeOne = std::min( size, one.second );
+	uint32_t sizeTwo = std::min( size - sizeOne, two.second );
+	memcpy( one.first, src, sizeof(T) * sizeOne );
+	memcpy( two.first, src + sizeOne, sizeof(T) * sizeTwo );
+	commitWrite( sizeOne + sizeTwo );
+
+	if( sizeOne + sizeTwo < size )
+		mOverrunCount = mOverrunCount + ( size - sizeOne - sizeTwo );
+	return sizeOne + sizeTwo;
+}
+
+template<typename T>
+void SpscCircularBuffer<T>::getReadRanges( ArrayRange *one, ArrayRange *two ) const
+{
+	ranges( mReadIndex, getReadAvailable(), one, two );
+}
+
+template<typename T>
+void SpscCircularBuffer<T>::commitRead( uint32_t size )
+{
+	storeRelease( mReadIndex, mReadIndex + size );
+}
+
+template<typename T>
+uint32_t SpscCircularBuffer<T>::read( T *dst, uint32_t size )
+{
+	ArrayRange one, two;
+	getReadRanges( &one, &two );
+	uint32_t sizeOne = std::min( size, one.second );
+	uint32_t sizeTwo = std::min( size - sizeOne, two.second );
+	memcpy( dst, one.first, sizeof(T) * sizeOne );
+	memcpy( dst + sizeOne, two.first, sizeof(T) * sizeTwo );
+	commitRead( sizeOne + sizeTwo );
+
+	if( sizeOne + sizeTwo < size )
+		mUnderrunCount = mUnderrunCount + ( size - sizeOne - sizeTwo );
+	return sizeOne + sizeTwo;
+}
+
+}} //namespace
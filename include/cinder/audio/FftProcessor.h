@@ -23,17 +23,26 @@
 #pragma once
 
 #include "cinder/Cinder.h"
+#include "cinder/Exception.h"
 #include "cinder/audio/PcmBuffer.h"
 
 namespace cinder { namespace audio {
 
 std::shared_ptr<float> calculateFft( Buffer32fRef aBuffer, uint16_t aBandCount );
 
+/** Platform implementation of FftProcessor. Every implementation transforms \c 2 * getBandCount() real samples and follows the scaling and packing of vDSP_fft_zrip():
+ * each band is twice the unnormalized DFT, and band 0 holds the DC term in its real part and the Nyquist term in its imaginary part. **/
 class FftProcessorImpl {
  public:
 	FftProcessorImpl( uint16_t aBandCount );
 	virtual ~FftProcessorImpl() {}
 	virtual std::shared_ptr<float> process( const float * inBuffer ) = 0;
+	//! Writes the magnitude of each band of \a inBuffer to \a outMagnitudes, which must hold getBandCount() floats
+	virtual void process( const float * inBuffer, float * outMagnitudes ) = 0;
+	//! Writes the real and imaginary parts of each band of \a inBuffer to \a outReal and \a outImag, which must each hold getBandCount() floats
+	virtual void processComplex( const float * inBuffer, float * outReal, float * outImag ) = 0;
+	//! Writes the \c 2 * getBandCount() real samples whose spectrum is \a inReal and \a inImag, packed as processComplex() writes it, to \a outBuffer
+	virtual void processInverse( const float * inReal, const float * inImag, float * outBuffer ) = 0;
 	uint16_t getBandCount() const { return mBandCount; }
  protected:
 	uint16_t mBandCount;
@@ -47,11 +56,25 @@ class FftProcessor {
 	
 	static FftProcessorRef createRef( uint16_t aBandCount = DEFAULT_BAND_COUNT );
 	
+	//! Returns the magnitude of each of the getBandCount() bands of the \c 2 * getBandCount() samples in \a inBuffer, in newly allocated memory
 	std::shared_ptr<float> process( const float * inBuffer ) { return mImpl->process( inBuffer ); }
+	//! Writes the magnitude of each band of \a inBuffer to \a outMagnitudes, which must hold getBandCount() floats. Doesn't allocate.
+	void process( const float * inBuffer, float * outMagnitudes ) { mImpl->process( inBuffer, outMagnitudes ); }
+	//! Writes the real and imaginary parts of each band of \a inBuffer to \a outReal and \a outImag. Band 0 holds the DC term in \a outReal and the Nyquist term in \a outImag. Doesn't allocate.
+	void processComplex( const float * inBuffer, float * outReal, float * outImag ) { mImpl->processComplex( inBuffer, outReal, outImag ); }
+	//! Inverse of processComplex(). Writes the \c 2 * getBandCount() samples whose spectrum is \a inReal and \a inImag to \a outBuffer, so that a round trip reproduces the input. Doesn't allocate.
+	void processInverse( const float * inReal, const float * inImag, float * outBuffer ) { mImpl->processInverse( inReal, inImag, outBuffer ); }
 	uint16_t getBandCount() const { return mImpl->getBandCount(); }
  private:
 	FftProcessor( uint16_t aBandCount );
 	std::shared_ptr<FftProcessorImpl> mImpl;
 };
 
+class FftProcessorException : public Exception {
+};
+
+//! Thrown when an FftProcessor is created with a band count which isn't a power of two
+class FftProcessorExceptionInvalidBandCount : public FftProcessorException {
+};
+
 }} //namespace
\ No newline at end of file
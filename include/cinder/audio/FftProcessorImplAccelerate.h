@@ -33,7 +33,12 @@ class FftProcessorImplAccelerate : public FftProcessorImpl {
 	~FftProcessorImplAccelerate();
 	
 	std::shared_ptr<float> process( const float * inBuffer );
+	void process( const float * inBuffer, float * outMagnitudes );
+	void processComplex( const float * inBuffer, float * outReal, float * outImag );
+	void processInverse( const float * inReal, const float * inImag, float * outBuffer );
  private:
+	void transform( const float * inBuffer );
+
 	const static vDSP_Stride	sStride = 1;
 	
 	uint32_t			mLog2Size;
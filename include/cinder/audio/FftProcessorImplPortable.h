@@ -0,0 +1,58 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "cinder/audio/FftProcessor.h"
+
+#include <vector>
+
+namespace cinder { namespace audio {
+
+/** Portable FftProcessorImpl, used wherever the Accelerate framework isn't available.
+ * The real input is transformed as a half-length complex FFT followed by a split into the real spectrum. The bit-reversal table and twiddle factors for each band count are built once and shared between processors. No memory is allocated per call except by the shared_ptr variant of process(). **/
+class FftProcessorImplPortable : public FftProcessorImpl {
+ public:
+	FftProcessorImplPortable( uint16_t aBandCount );
+	~FftProcessorImplPortable();
+
+	std::shared_ptr<float> process( const float * inBuffer );
+	void process( const float * inBuffer, float * outMagnitudes );
+	void processComplex( const float * inBuffer, float * outReal, float * outImag );
+	void processInverse( const float * inReal, const float * inImag, float * outBuffer );
+
+	//! The bit-reversal table and twiddle factors for one band count, shared by every processor of that band count
+	struct Plan;
+	//! Returns the shared Plan for \a bandCount bands, building it on first use
+	static std::shared_ptr<const Plan>	getPlan( uint16_t bandCount );
+
+ private:
+	//! Runs the half-length complex FFT of \a inBuffer into mReal and mImag
+	void transform( const float * inBuffer );
+	//! Runs the butterfly stages over mReal and mImag, which must already be in bit-reversed order
+	void butterflies();
+
+	std::shared_ptr<const Plan>		mPlan;
+	std::vector<float>				mReal, mImag, mOutReal, mOutImag;
+};
+
+}} //namespace
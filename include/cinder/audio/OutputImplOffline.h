@@ -0,0 +1,153 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "cinder/audio/Output.h"
+#include "cinder/audio/PcmBuffer.h"
+#include "cinder/audio/SampleConversion.h"
+#include "cinder/Stream.h"
+
+#include <boost/thread/mutex.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace cinder { namespace audio {
+
+class TargetOutputImplOffline : public Target {
+  public:
+	static std::shared_ptr<TargetOutputImplOffline> createRef( const Source *aSource, int32_t aSampleRate ) { return std::shared_ptr<TargetOutputImplOffline>( new TargetOutputImplOffline( aSource, aSampleRate ) ); }
+	~TargetOutputImplOffline() {}
+  private:
+	TargetOutputImplOffline( const Source *aSource, int32_t aSampleRate );
+};
+
+typedef std::shared_ptr<class OutputImplOffline>	OutputImplOfflineRef;
+
+/** An Output with no device, which renders its tracks only when asked to, as fast as the CPU allows. Tracks are mixed a block of samples at a time into
+ * interleaved float samples, which render() returns in a PcmBuffer or writes to a WAV file. Useful for bouncing audio and for regression tests on headless machines.
+ * Sources must have the Output's sample rate, and either its channel count or a single channel, which is mixed into every channel.
+ * Not thread-safe; add tracks and render from the same thread. **/
+class OutputImplOffline : public OutputImpl {
+  public:
+	struct Format {
+		Format() : mSampleRate( 44100 ), mChannelCount( 2 ), mBlockSize( 512 ) {}
+
+		Format&		setSampleRate( int32_t sampleRate ) { mSampleRate = sampleRate; return *this; }
+		Format&		setChannelCount( uint16_t channelCount ) { mChannelCount = channelCount; return *this; }
+		//! Sets the number of samples per channel each track is asked for at a time, which is also the granularity of play() and stop()
+		Format&		setBlockSize( uint32_t blockSize ) { mBlockSize = blockSize; return *this; }
+
+		int32_t		getSampleRate() const { return mSampleRate; }
+		uint16_t	getChannelCount() const { return mChannelCount; }
+		uint32_t	getBlockSize() const { return mBlockSize; }
+
+	  private:
+		int32_t		mSampleRate;
+		uint16_t	mChannelCount;
+		uint32_t	mBlockSize;
+	};
+
+	static OutputImplOfflineRef	createRef( const Format &format = Format() ) { return OutputImplOfflineRef( new OutputImplOffline( format ) ); }
+	OutputImplOffline( const Format &format = Format() );
+	~OutputImplOffline();
+
+	TrackRef	addTrack( SourceRef aSource, bool autoplay );
+	void		removeTrack( TrackId trackId );
+
+	void		setVolume( float aVolume ) { mVolume = aVolume; }
+	float		getVolume() const { return mVolume; }
+
+	const Format&	getFormat() const { return mFormat; }
+	//! Returns the number of samples per channel rendered so far
+	uint64_t		getSampleOffset() const { return mSampleOffset; }
+	double			getTime() const { return mSampleOffset / (double)mFormat.getSampleRate(); }
+
+	//! Renders the next \a sampleCount samples per channel of the mix into \a interleavedData, which must hold \a sampleCount * getChannelCount() floats
+	void				render( float *interleavedData, uint32_t sampleCount );
+	//! Renders the next \a sampleCount samples per channel of the mix into a new interleaved PcmBuffer
+	PcmBuffer32fRef		render( uint32_t sampleCount );
+	//! Renders the next \a sampleCount samples per channel of the mix to \a stream as a WAV file of \a dataType, which is either Io::INT16, dithered, or Io::FLOAT32
+	void				renderToWav( OStreamRef stream, uint64_t sampleCount, Io::DataType dataType = Io::INT16 );
+	void				renderToWav( const std::string &path, uint64_t sampleCount, Io::DataType dataType = Io::INT16 ) { renderToWav( writeFileStream( path ), sampleCount, dataType ); }
+
+  private:
+	class Track : public cinder::audio::Track
+	{
+	  public:
+		Track( SourceRef source, OutputImplOffline *output );
+		~Track() {}
+		void play() { mIsPlaying = true; }
+		void stop() { mIsPlaying = false; }
+		bool isPlaying() const { return mIsPlaying; }
+
+		TrackId getTrackId() const { return mTrackId; }
+
+		void setVolume( float aVolume ) { mVolume = aVolume; }
+		float getVolume() const { return mVolume; }
+
+		double getTime() const { return ( mLoader->getSampleOffset() / (double)mSource->getSampleRate() ); }
+		void setTime( double aTime );
+
+		bool isLooping() const { return mIsLooping; }
+		void setLooping( bool isLooping ) { mIsLooping = isLooping; }
+
+		void enablePcmBuffering( bool isBuffering ) { mIsPcmBuffering = isBuffering; }
+		bool isPcmBuffering() { return mIsPcmBuffering; }
+
+		PcmBuffer32fRef getPcmBuffer();
+
+		//! Adds the track's next \a sampleCount samples, scaled by its volume and \a gain, to \a mixData. Stops the track when its source runs out.
+		void mix( float *mixData, uint32_t sampleCount, float gain );
+	  private:
+		//! Converts \a sampleCount loaded samples per channel to float, returning either \a data itself or mFloatData
+		const float*	toFloat( const void *data, uint32_t sampleCount );
+		void			appendToPcmBuffer( const float *data, uint32_t sampleCount );
+
+		SourceRef		mSource;
+		std::shared_ptr<TargetOutputImplOffline> mTarget;
+		OutputImplOffline	* mOutput;
+		TrackId			mTrackId;
+		LoaderRef		mLoader;
+		bool			mIsPlaying;
+		bool			mIsLooping;
+		bool			mIsPcmBuffering;
+		float			mVolume;
+
+		std::vector<uint8_t>	mLoadData;
+		std::vector<float>		mFloatData;
+
+		PcmBuffer32fRef	mLoadingPcmBuffer;
+		PcmBuffer32fRef	mLoadedPcmBuffer;
+		boost::mutex	mPcmBufferMutex;
+	};
+
+	Format				mFormat;
+	float				mVolume;
+	uint64_t			mSampleOffset;
+	SampleDither		mDither;
+
+	std::map<TrackId,std::shared_ptr<OutputImplOffline::Track> >	mTracks;
+};
+
+}} //namespace
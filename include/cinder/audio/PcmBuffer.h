@@ -24,6 +24,7 @@
 
 #include "cinder/Cinder.h"
 #include "cinder/Exception.h"
+#include "cinder/audio/BufferPool.h"
 #include <vector>
 #include <boost/preprocessor/seq.hpp>
 
@@ -67,10 +68,11 @@ typedef std::shared_ptr<BufferList32f> BufferList32fRef;
 template<typename T>
 class PcmBufferT {
  public:
-	PcmBufferT( uint32_t aMaxSampleCount, uint16_t aChannelCount, bool isInterleaved );
+	//! Creates a buffer whose sample data, and the copies made by getChannelData() and getInterleavedData(), are allocated from \a pool
+	PcmBufferT( uint32_t aMaxSampleCount, uint16_t aChannelCount, bool isInterleaved, BufferPoolRef pool = BufferPool::getDefault() );
 	~PcmBufferT();
 	
-	uint32_t	getSampleCount( ChannelIdentifier channelId = CHANNEL_FRONT_LEFT ) const { return mBufferSampleCounts[channelId]; }
+	uint32_t	getSampleCount( ChannelIdentifier channelId = CHANNEL_FRONT_LEFT ) const { return mBufferSampleCounts[mIsInterleaved ? 0 : channelId]; }
 	uint32_t	getMaxSampleCount() const { return mMaxSampleCount; }
 	uint16_t	getChannelCount() const { return mChannelCount; }
 	bool		isInterleaved() const  { return mIsInterleaved; }
@@ -82,6 +84,8 @@ class PcmBufferT {
 	//TODO: add support for an appendData method that just accepts a Buffer or BufferList and interprets interleaving accordingly
 	void		appendInterleavedData( T * aData, uint32_t aSampleCount );
 	void		appendChannelData( T * aData, uint32_t aSampleCount, ChannelIdentifier channelId );
+	//! Empties the buffer so that it can be refilled without reallocating
+	void		clear();
  private:
 	std::vector<std::shared_ptr<BufferT<T> > > mBuffers;
 	
@@ -90,6 +94,7 @@ class PcmBufferT {
 	uint32_t		mMaxSampleCount;
 	uint16_t		mChannelCount;
 	bool			mIsInterleaved;
+	BufferPoolRef	mPool;
 };
 
 typedef PcmBufferT<float> PcmBuffer32f;
@@ -115,9 +120,15 @@ inline void silenceBuffers( BufferList * aBufferList )
 template<typename T> 
 void deleteBuffer( BufferT<T> * aBuffer );
 
+//! Deletes \a aBuffer, whose data was allocated from a BufferPool
+template<typename T> 
+void releaseBuffer( BufferT<T> * aBuffer );
+
+//! Creates a BufferList whose data is allocated from \a pool
 template<typename T>
-std::shared_ptr<BufferListT<T> > createBufferList( uint32_t sampleCount, uint16_t channelCount, bool isInterleaved );
+std::shared_ptr<BufferListT<T> > createBufferList( uint32_t sampleCount, uint16_t channelCount, bool isInterleaved, BufferPoolRef pool = BufferPool::getDefault() );
 
+//! Deletes a BufferList created by createBufferList()
 template<typename T> 
 void deleteBufferList( BufferListT<T> * aBufferList );
 
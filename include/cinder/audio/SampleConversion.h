@@ -0,0 +1,57 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/audio/PcmBuffer.h"
+
+namespace cinder { namespace audio {
+
+//! State of the triangular (TPDF) dither convertSamples() adds when reducing bit depth. Give each stream its own, so that its noise continues from call to call.
+struct SampleDither {
+	SampleDither( uint32_t seed = 0x9E3779B9 );
+
+	//! xorshift generator states, one per SIMD lane
+	uint32_t	mState[4];
+};
+
+/** Converts \a count samples of \a src to \a dst, for any pair of the types in \c AUDIO_DATA_TYPES. Integer samples are fractions of full scale, uint8_t is centered on 128 and float spans [-1, 1].
+ * Results are rounded to nearest and clamped to the range of \a dst. When \a dither is non-NULL, triangular dither of one LSB is added to conversions to a narrower integer type. **/
+template<typename SrcT, typename DstT>
+void convertSamples( const SrcT *src, DstT *dst, size_t count, SampleDither *dither = 0 );
+
+//! Interleaves \a frameCount samples from each of the \a channelCount arrays in \a src into \a dst
+template<typename T>
+void interleaveSamples( const T * const *src, T *dst, uint16_t channelCount, size_t frameCount );
+//! Deinterleaves \a frameCount frames of \a channelCount channels from \a src into the \a channelCount arrays in \a dst
+template<typename T>
+void deinterleaveSamples( const T *src, T * const *dst, uint16_t channelCount, size_t frameCount );
+
+//! Adds \a count samples of \a src scaled by \a gain to \a dst
+void mixSamples( const float *src, float *dst, size_t count, float gain = 1.0f );
+
+//! Reverses the byte order of each of the \a count samples in \a data
+template<typename T>
+void swapSampleBytes( T *data, size_t count );
+
+}} //namespace
@@ -23,12 +23,45 @@
 
 #include "cinder/Cinder.h"
 #include "cinder/audio/Io.h"
+#include "cinder/audio/SampleConversion.h"
 
 namespace cinder { namespace audio {
 
 typedef std::shared_ptr<class SourceFileWav>	SourceFileWavRef;
 typedef std::shared_ptr<class LoaderSourceFileWav>	LoaderSourceFileWavRef;
 
+//! A read-only view of a range of interleaved samples in a memory-mapped WAV file. The view keeps the mapping alive, and copying it never copies samples.
+template<typename T>
+class SampleWindowT {
+ public:
+	SampleWindowT() : mData( 0 ), mSampleOffset( 0 ), mSampleCount( 0 ), mChannelCount( 0 ) {}
+
+	//! Returns the interleaved samples of the window
+	const T*	getData() const { return mData; }
+	//! Returns the \a channelCount samples of the frame \a index samples into the window
+	const T*	getFrame( uint32_t index ) const { return mData + (size_t)index * mChannelCount; }
+	T			getSample( uint32_t index, uint16_t channel ) const { return mData[(size_t)index * mChannelCount + channel]; }
+
+	//! Returns the offset in samples of the start of the window from the start of the file
+	uint64_t	getSampleOffset() const { return mSampleOffset; }
+	//! Returns the number of samples per channel in the window, which is less than requested at the end of the file
+	uint32_t	getSampleCount() const { return mSampleCount; }
+	uint16_t	getChannelCount() const { return mChannelCount; }
+	bool		empty() const { return mSampleCount == 0; }
+
+ private:
+	DataSourceRef	mDataSource;
+	const T			*mData;
+	uint64_t		mSampleOffset;
+	uint32_t		mSampleCount;
+	uint16_t		mChannelCount;
+	
+	friend class SourceFileWav;
+};
+
+typedef SampleWindowT<int16_t>	SampleWindow16i;
+typedef SampleWindowT<float>	SampleWindow32f;
+
 class LoaderSourceFileWav : public Loader {
  public:
 	static LoaderSourceFileWavRef	createRef( SourceFileWav *source, Target *target );	
@@ -38,19 +71,29 @@ class LoaderSourceFileWav : public Loader {
 	void loadData( BufferList *ioData );
 
 	uint64_t getSampleOffset() const;
+	//! When the source is memory-mapped this only records \a anOffset, otherwise it seeks the loader's own stream
 	void setSampleOffset( uint64_t anOffset );
 protected:
 	LoaderSourceFileWav( SourceFileWav * source, Target * target );
+	
+	//! Copies \a dataSize bytes of the data chunk at mSampleOffset into \a data
+	void readFileData( void *data, uint32_t dataSize );
 
 	SourceFileWav	* mSource;
 	IStreamRef		mStream;
 	uint64_t		mSampleOffset;
+	
+	//! The format loadData() converts to when it differs from the file's, or DATA_UNKNOWN to pass the file's samples through
+	Io::DataType	mTargetDataType;
+	SampleDither	mDither;
 };
 
 class SourceFileWav : public Source {
  public:
 	static SourceRef					createRef( DataSourceRef dataSourceRef ) { return createFileWavRef( dataSourceRef ); }
 	static SourceFileWavRef				createFileWavRef( DataSourceRef dataSourceRef );
+	//! Creates a source which memory-maps the file at \a path, so that its loaders read without a stream and getSampleWindow() can return views of the samples
+	static SourceFileWavRef				createFileWavMappedRef( const std::string &path ) { return createFileWavRef( loadFileMapped( path ) ); }
 	~SourceFileWav();
 
 	LoaderRef createLoader( Target *target ) { return LoaderSourceFileWav::createRef( this, target ); }
@@ -58,6 +101,17 @@ class SourceFileWav : public Source {
 	uint32_t getLength() const { return mDataLength; };
 	double getDuration() const { /*TODO*/ return 0.0;  }
 
+	//! Whether the source was created from a DataSourceMapped, which getSampleWindow() requires
+	bool		isMapped() const { return mMappedData != 0; }
+	//! Returns the number of samples per channel in the file
+	uint64_t	getSampleCount() const { return mSampleCount; }
+	
+	/** Returns a view of up to \a sampleCount samples per channel starting \a sampleOffset samples into the file, without copying or converting them.
+	 * \a T must match the file's native-endian sample type, and the source must be mapped. Otherwise this throws IoExceptionUnsupportedDataType.
+	 * Safe to call from any number of threads at once. **/
+	template<typename T>
+	SampleWindowT<T>	getSampleWindow( uint64_t sampleOffset, uint32_t sampleCount ) const;
+
 	static void		registerSelf();
  private:
 	SourceFileWav( DataSourceRef dataSourceRef );
@@ -68,6 +122,8 @@ class SourceFileWav : public Source {
 	uint32_t		mDataLength;
 	uint32_t		mDataStart;
 	uint64_t		mSampleCount;
+	//! The start of the data chunk when mDataSource is a DataSourceMapped, otherwise NULL
+	const uint8_t	*mMappedData;
 
 	uint16_t		mAudioFormat;
 	uint32_t		mByteRate;
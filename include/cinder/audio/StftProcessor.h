@@ -0,0 +1,176 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/Exception.h"
+#include "cinder/audio/FftProcessor.h"
+#include "cinder/audio/CircularBuffer.h"
+#include "cinder/audio/PcmBuffer.h"
+
+#include <vector>
+
+namespace cinder { namespace audio {
+
+typedef std::shared_ptr<class StftProcessor> StftProcessorRef;
+
+/** \brief Streaming short-time Fourier transform built on FftProcessor
+ *
+ * Samples are written incrementally, per channel or interleaved, and every getHopSize() samples a frame of \c 2 * getBandCount() samples is windowed and transformed.
+ * Each frame's magnitudes and phases are stored in a ring of Format::getFrameCapacity() frames per channel, which is allocated up front along with all other
+ * storage, so no memory is allocated while streaming. Frames are read with getFrame() and released with popFrames(); when a channel's ring is full the oldest
+ * frame is overwritten and counted by getDroppedFrameCount().
+ *
+ * Each frame has getBinCount() bins, from DC up to and including the Nyquist frequency. Magnitudes are scaled like FftProcessor's, so bins 1 through
+ * \c getBandCount() - 1 match FftProcessor::process() of the windowed frame.
+ *
+ * synthesize() inverts the transform with a weighted overlap-add. Running every frame back through it, after a flush(), reproduces the input
+ * for any window which covers every sample, except for the first \c getFrameSize() - getHopSize() samples, which fewer frames overlap.
+ * Samples at positions the overlapping windows barely cover, below 1/10000th of the best covered position's sum of squared windows, are
+ * output as silence rather than amplified. **/
+class StftProcessor {
+ public:
+	typedef enum WindowType { WINDOW_RECTANGULAR, WINDOW_HANN, WINDOW_HAMMING, WINDOW_BLACKMAN } WindowType;
+
+	struct Format {
+	  public:
+		//! Default constructor, sets 512 bands with a hop of 256 samples and a Hann window, for one channel with a 64 frame ring
+		Format();
+
+		//! Sets the number of bands of each frame, which must be a power of two. The frame size is twice the band count. Defaults to 512.
+		void	setBandCount( uint16_t bandCount ) { mBandCount = bandCount; }
+		//! Sets the number of samples between the starts of consecutive frames, which must be between 1 and the frame size. Defaults to 256.
+		void	setHopSize( uint32_t hopSize ) { mHopSize = hopSize; }
+		//! Sets the number of channels. Defaults to 1.
+		void	setChannelCount( uint16_t channelCount ) { mChannelCount = channelCount; }
+		//! Sets the number of frames each channel's ring holds before the oldest is overwritten. Defaults to 64.
+		void	setFrameCapacity( uint32_t frameCapacity ) { mFrameCapacity = frameCapacity; }
+		//! Sets the analysis and synthesis window. Defaults to \c WINDOW_HANN.
+		void	setWindow( WindowType window ) { mWindow = window; mCustomWindow.clear(); }
+		//! Sets a custom window of \c 2 * getBandCount() coefficients, which overrides setWindow()
+		void	setWindow( const std::vector<float> &window ) { mCustomWindow = window; }
+		//! Enables or disables calculating the phase of each bin. Phases are required by synthesize(). Defaults to enabled.
+		void	enablePhase( bool phase = true ) { mPhase = phase; }
+
+		uint16_t					getBandCount() const { return mBandCount; }
+		uint32_t					getHopSize() const { return mHopSize; }
+		uint16_t					getChannelCount() const { return mChannelCount; }
+		uint32_t					getFrameCapacity() const { return mFrameCapacity; }
+		WindowType					getWindow() const { return mWindow; }
+		const std::vector<float>&	getCustomWindow() const { return mCustomWindow; }
+		bool						hasPhase() const { return mPhase; }
+
+	  protected:
+		uint16_t			mBandCount;
+		uint32_t			mHopSize;
+		uint16_t			mChannelCount;
+		uint32_t			mFrameCapacity;
+		WindowType			mWindow;
+		std::vector<float>	mCustomWindow;
+		bool				mPhase;
+	};
+
+	//! A frame in a channel's ring. The pointers remain valid until the frame is popped or overwritten.
+	struct Frame {
+		//! getBinCount() magnitudes
+		const float		*mMagnitudes;
+		//! getBinCount() phases in radians, or NULL if phase is disabled
+		const float		*mPhases;
+		//! The index of the frame since the channel was created or reset(). The frame starts at sample \c mIndex * getHopSize().
+		uint64_t		mIndex;
+	};
+
+	static StftProcessorRef createRef( const Format &format = Format() );
+
+	//! Writes \a sampleCount samples of channel \a channel, transforming a frame whenever a hop's worth of samples is complete
+	void	write( const float *samples, uint32_t sampleCount, uint16_t channel = 0 );
+	//! Writes \a sampleCount samples of every channel, interleaved in \a samples
+	void	writeInterleaved( const float *samples, uint32_t sampleCount );
+	//! Writes the contents of \a buffer, oldest first, to channel \a channel
+	void	write( const CircularBuffer<float> &buffer, uint16_t channel = 0 );
+	//! Writes the contents of \a buffer. Its channel count must match getChannelCount().
+	void	write( const PcmBuffer32f &buffer );
+	/** Zero-pads each channel until every sample written so far has been part of every frame which overlaps it, which takes up to
+	 * \c ceil( getFrameSize() / getHopSize() ) frames. Samples written afterwards start the frame following the padding. **/
+	void	flush();
+	//! Discards all pending samples, frames and synthesis state
+	void	reset();
+
+	//! Returns the number of frames in channel \a channel's ring
+	uint32_t	getFrameCount( uint16_t channel = 0 ) const { return mChannels[channel].mFrameCount; }
+	//! Returns frame \a index of channel \a channel's ring, where 0 is the oldest frame
+	Frame		getFrame( uint32_t index, uint16_t channel = 0 ) const;
+	//! Removes the \a count oldest frames from channel \a channel's ring
+	void		popFrames( uint32_t count, uint16_t channel = 0 );
+	//! Returns the number of frames of channel \a channel which were overwritten before being popped
+	uint64_t	getDroppedFrameCount( uint16_t channel = 0 ) const { return mChannels[channel].mDroppedFrameCount; }
+
+	/** Adds the frame described by \a magnitudes and \a phases, each holding getBinCount() values, to channel \a channel's overlap-add
+	 * and writes the getHopSize() samples which are now complete to \a outSamples **/
+	void	synthesize( const float *magnitudes, const float *phases, float *outSamples, uint16_t channel = 0 );
+	//! Writes the \c getFrameSize() - getHopSize() samples still pending in channel \a channel's overlap-add to \a outSamples
+	void	flushSynthesis( float *outSamples, uint16_t channel = 0 );
+
+	const Format&	getFormat() const { return mFormat; }
+	uint16_t		getBandCount() const { return mFormat.getBandCount(); }
+	uint32_t		getBinCount() const { return mFormat.getBandCount() + 1; }
+	uint32_t		getFrameSize() const { return mFrameSize; }
+	uint32_t		getHopSize() const { return mFormat.getHopSize(); }
+	uint16_t		getChannelCount() const { return mFormat.getChannelCount(); }
+	//! Returns the window applied to each frame
+	const std::vector<float>&	getWindow() const { return mWindow; }
+
+ private:
+	StftProcessor( const Format &format );
+
+	struct Channel {
+		std::vector<float>	mInput;				// the frame being gathered
+		uint32_t			mInputCount;		// samples in mInput
+		std::vector<float>	mMagnitudes, mPhases;	// the ring, getBinCount() values per frame
+		uint32_t			mFirstFrame, mFrameCount;
+		uint64_t			mNextFrameIndex, mDroppedFrameCount;
+		std::vector<float>	mOverlap;			// synthesis accumulator of getFrameSize() samples
+	};
+
+	//! Appends \a sampleCount samples to \a channel, every \a stride floats apart
+	void	append( Channel *channel, const float *samples, uint32_t sampleCount, size_t stride );
+	//! Windows and transforms the full input of \a channel into its ring, then drops its first hop
+	void	analyze( Channel *channel );
+
+	Format					mFormat;
+	uint32_t				mFrameSize;
+	FftProcessorRef			mFft;
+	std::vector<float>		mWindow;
+	std::vector<float>		mSynthesisScale;	// 1 / the sum of the squared windows overlapping each position in a hop
+	std::vector<Channel>	mChannels;
+	std::vector<float>		mFrame, mReal, mImag;
+};
+
+class StftProcessorException : public Exception {
+};
+
+//! Thrown when a StftProcessor's Format has an invalid hop size, window size or channel count
+class StftProcessorExceptionInvalidFormat : public StftProcessorException {
+};
+
+}} //namespace
@@ -0,0 +1,79 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/Surface.h"
+#include "cinder/Channel.h"
+
+#include <vector>
+
+namespace cinder { namespace ip {
+
+//! Intermediate storage for ip::blur() and ip::blurRecursive(). Passing the same BlurBuffer to successive calls avoids reallocating it for every image.
+class BlurBuffer {
+ public:
+	BlurBuffer() {}
+
+	//! Returns storage for at least \a numValues floats, growing the buffer if necessary
+	float*	getData( size_t numValues ) { if( mData.size() < numValues ) mData.resize( numValues ); return &mData[0]; }
+	//! Returns the number of floats currently allocated
+	size_t	getCapacity() const { return mData.size(); }
+	//! Frees the storage
+	void	clear() { std::vector<float>().swap( mData ); }
+
+ private:
+	std::vector<float>	mData;
+};
+
+/** Blurs \a srcSurface with a Gaussian of standard deviation \a sigma, clamping at the edges, and stores the result in \a dstSurface. All channels including alpha are blurred.
+	The kernel is applied separably and its cost grows with \a sigma; see blurRecursive() for large values. Rows are split across \a numThreads threads, where \c 0 means one per hardware core.
+	\a scratch may be supplied to reuse intermediate storage across calls. **/
+template<typename T>
+void blur( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface, float sigma, int32_t numThreads = 1, BlurBuffer *scratch = 0 );
+//! Blurs \a surface in place with a Gaussian of standard deviation \a sigma. See the out-of-place variant for details.
+template<typename T>
+void blur( SurfaceT<T> *surface, float sigma, int32_t numThreads = 1, BlurBuffer *scratch = 0 );
+//! Blurs \a srcChannel with a Gaussian of standard deviation \a sigma and stores the result in \a dstChannel. See the Surface variant for details.
+template<typename T>
+void blur( const ChannelT<T> &srcChannel, ChannelT<T> *dstChannel, float sigma, int32_t numThreads = 1, BlurBuffer *scratch = 0 );
+//! Blurs \a channel in place with a Gaussian of standard deviation \a sigma. See the Surface variant for details.
+template<typename T>
+void blur( ChannelT<T> *channel, float sigma, int32_t numThreads = 1, BlurBuffer *scratch = 0 );
+
+/** Blurs \a srcSurface with a recursive (IIR) approximation of a Gaussian of standard deviation \a sigma and stores the result in \a dstSurface.
+	Implements the filter described in "Recursive implementation of the Gaussian filter" by Young & van Vliet, whose cost per pixel is independent of \a sigma. Values of \a sigma below \c 1 fall back to blur(), which is as fast at such small radii and more accurate.
+	Rows and columns are split across \a numThreads threads, where \c 0 means one per hardware core. \a scratch may be supplied to reuse intermediate storage across calls. **/
+template<typename T>
+void blurRecursive( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface, float sigma, int32_t numThreads = 1, BlurBuffer *scratch = 0 );
+//! Blurs \a surface in place with a recursive approximation of a Gaussian of standard deviation \a sigma. See the out-of-place variant for details.
+template<typename T>
+void blurRecursive( SurfaceT<T> *surface, float sigma, int32_t numThreads = 1, BlurBuffer *scratch = 0 );
+//! Blurs \a srcChannel with a recursive approximation of a Gaussian of standard deviation \a sigma and stores the result in \a dstChannel. See the Surface variant for details.
+template<typename T>
+void blurRecursive( const ChannelT<T> &srcChannel, ChannelT<T> *dstChannel, float sigma, int32_t numThreads = 1, BlurBuffer *scratch = 0 );
+//! Blurs \a channel in place with a recursive approximation of a Gaussian of standard deviation \a sigma. See the Surface variant for details.
+template<typename T>
+void blurRecursive( ChannelT<T> *channel, float sigma, int32_t numThreads = 1, BlurBuffer *scratch = 0 );
+
+} } // namespace cinder::ip
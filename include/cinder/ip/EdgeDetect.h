@@ -26,13 +26,21 @@
 
 namespace cinder { namespace ip {
 
+//! Stores the Sobel gradient magnitude of \a srcArea of \a srcChannel in \a dstChannel with the area's upper-left corner at \a dstOffset, clamped to the channel's maximum. The outermost rows and columns of the area are left untouched. Rows are split across \a numThreads threads, where \c 0 means one per hardware core.
 template<typename T>
-void edgeDetectSobel( const ChannelT<T> &srcChannel, const Area &srcArea, const Vec2i &dstOffset, ChannelT<T> *dstChannel );
+void edgeDetectSobel( const ChannelT<T> &srcChannel, const Area &srcArea, const Vec2i &dstOffset, ChannelT<T> *dstChannel, int32_t numThreads = 1 );
+//! Stores the Sobel gradient magnitude of each color channel of \a srcArea of \a srcSurface in \a dstSurface with the area's upper-left corner at \a dstOffset, as well as alpha when both Surfaces have it
 template<typename T>
-void edgeDetectSobel( const SurfaceT<T> &srcSurface, const Area &srcArea, const Vec2i &dstOffset, SurfaceT<T> *dstSuface );
+void edgeDetectSobel( const SurfaceT<T> &srcSurface, const Area &srcArea, const Vec2i &dstOffset, SurfaceT<T> *dstSuface, int32_t numThreads = 1 );
+//! Stores the Sobel gradient magnitude of \a srcChannel in \a dstChannel
 template<typename T>
-void edgeDetectSobel( const ChannelT<T> &srcChannel, ChannelT<T> *dstChannel );
+void edgeDetectSobel( const ChannelT<T> &srcChannel, ChannelT<T> *dstChannel, int32_t numThreads = 1 );
+//! Stores the Sobel gradient magnitude of each channel of \a srcSurface in \a dstSurface
 template<typename T>
-void edgeDetectSobel( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSuface );
+void edgeDetectSobel( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSuface, int32_t numThreads = 1 );
+/** Computes the Sobel gradient of \a srcChannel in a single pass, storing its magnitude in \a dstMagnitude and its direction in \a dstDirection, either of which may be NULL.
+	The direction is the angle in radians of the vector (X response, Y response) in the range [-pi, pi], computed by a polynomial approximation of atan2() with under 2e-6 radians of error. The outermost rows and columns are left untouched. **/
+template<typename T>
+void edgeDetectSobel( const ChannelT<T> &srcChannel, ChannelT<T> *dstMagnitude, Channel32f *dstDirection, int32_t numThreads = 1 );
 
 } } // namespace cinder::ip
@@ -27,11 +27,11 @@
 
 namespace cinder { namespace ip {
 
-//! Converts Surface \a srcSurface to grayscale and stores the result in Surface \a dstSurface. Uses primary weights dictated by the Rec. 709 Video Standard
+//! Converts Surface \a srcSurface to grayscale and stores the result in Surface \a dstSurface. Uses primary weights dictated by the Rec. 709 Video Standard. Rows are split across \a numThreads threads, where \c 0 means one per hardware core.
 template<typename T>
-void grayscale( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface );
-//! Converts Surface \a srcSurface to grayscale and stores the result in Channel \a dstChannel. Uses primary weights dictated by the Rec. 709 Video Standard
+void grayscale( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface, int32_t numThreads = 1 );
+//! Converts Surface \a srcSurface to grayscale and stores the result in Channel \a dstChannel. Uses primary weights dictated by the Rec. 709 Video Standard. Rows are split across \a numThreads threads, where \c 0 means one per hardware core.
 template<typename T>
-void grayscale( const SurfaceT<T> &srcSurface, ChannelT<T> *dstChannel );
+void grayscale( const SurfaceT<T> &srcSurface, ChannelT<T> *dstChannel, int32_t numThreads = 1 );
 
 } } // namespace cinder::ip
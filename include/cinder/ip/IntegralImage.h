@@ -0,0 +1,121 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/Channel.h"
+#include "cinder/Area.h"
+#include "cinder/ChanTraits.h"
+
+namespace cinder { namespace ip {
+
+/** \brief Summed-area table of a Channel, optionally with a second table of squared values
+	Once built, the sum of any rectangle of the source is available in constant time, so any number of window-based filters can share a single pass over the image.
+	\a SUMT is the accumulator type. Unsigned integer accumulators wrap on overflow, but rectangle sums remain exact so long as the true sum of the rectangle fits in \a SUMT.
+	Like the other ip classes, copies share the same underlying tables. **/
+template<typename T, typename SUMT = typename CHANTRAIT<T>::Accum>
+class IntegralImageT {
+ private:
+	struct Obj {
+		Obj( int32_t width, int32_t height, bool squaredSums );
+		~Obj();
+
+		int32_t		mWidth, mHeight;
+		int32_t		mStride; // mWidth + 1, since row and column 0 of each table are zero
+		SUMT		*mSums;
+		SUMT		*mSquaredSums;
+	};
+
+ public:
+	typedef SUMT	SumType;
+
+	IntegralImageT() {}
+	//! Builds the integral image of \a channel, along with the integral of its squared values when \a squaredSums is true. Rows and columns are split across \a numThreads threads, where \c 0 means one per hardware core.
+	IntegralImageT( const ChannelT<T> &channel, bool squaredSums = false, int32_t numThreads = 1 );
+
+	//! Recalculates the tables from \a channel, reusing the existing allocation when \a channel is the same size. Useful for successive frames of a video stream.
+	void	update( const ChannelT<T> &channel, int32_t numThreads = 1 );
+
+	int32_t		getWidth() const { return mObj->mWidth; }
+	int32_t		getHeight() const { return mObj->mHeight; }
+	Vec2i		getSize() const { return Vec2i( mObj->mWidth, mObj->mHeight ); }
+	Area		getBounds() const { return Area( 0, 0, mObj->mWidth, mObj->mHeight ); }
+	bool		hasSquaredSums() const { return mObj->mSquaredSums != 0; }
+
+	//! Returns the sum of the source values in [\a x1, \a x2) x [\a y1, \a y2). Coordinates must lie within [0, getWidth()] and [0, getHeight()].
+	SUMT	getSum( int32_t x1, int32_t y1, int32_t x2, int32_t y2 ) const { return rectSum( mObj->mSums, x1, y1, x2, y2 ); }
+	//! Returns the sum of the source values in \a area, which must lie within getBounds()
+	SUMT	getSum( const Area &area ) const { return getSum( area.getX1(), area.getY1(), area.getX2(), area.getY2() ); }
+	//! Returns the sum of the squared source values in [\a x1, \a x2) x [\a y1, \a y2). Requires hasSquaredSums().
+	SUMT	getSquaredSum( int32_t x1, int32_t y1, int32_t x2, int32_t y2 ) const { return rectSum( mObj->mSquaredSums, x1, y1, x2, y2 ); }
+	//! Returns the sum of the squared source values in \a area. Requires hasSquaredSums().
+	SUMT	getSquaredSum( const Area &area ) const { return getSquaredSum( area.getX1(), area.getY1(), area.getX2(), area.getY2() ); }
+
+	//! Returns the raw table of (getWidth() + 1) x (getHeight() + 1) sums, where entry (x, y) is the sum of the source values above and to the left of (x, y)
+	const SUMT*		getSumData() const { return mObj->mSums; }
+	//! Returns the raw table of squared sums laid out like getSumData(), or NULL without squared sums
+	const SUMT*		getSquaredSumData() const { return mObj->mSquaredSums; }
+
+	//@{
+	//! Emulates shared_ptr-like behavior
+	typedef std::shared_ptr<Obj> IntegralImageT::*unspecified_bool_type;
+	operator unspecified_bool_type() const { return ( mObj.get() == 0 ) ? 0 : &IntegralImageT::mObj; }
+	void reset() { mObj.reset(); }
+	//@}
+
+ private:
+	SUMT	rectSum( const SUMT *table, int32_t x1, int32_t y1, int32_t x2, int32_t y2 ) const
+	{
+		const int32_t stride = mObj->mStride;
+		return table[y2 * stride + x2] - table[y1 * stride + x2] - table[y2 * stride + x1] + table[y1 * stride + x1];
+	}
+
+	std::shared_ptr<Obj>		mObj;
+};
+
+typedef IntegralImageT<uint8_t>				IntegralImage;
+typedef IntegralImageT<uint8_t>				IntegralImage8u;
+typedef IntegralImageT<uint8_t,uint64_t>	IntegralImage8u64;
+typedef IntegralImageT<uint8_t,double>		IntegralImage8uD;
+typedef IntegralImageT<float>				IntegralImage32f;
+typedef IntegralImageT<float,double>		IntegralImage32fD;
+
+//! Averages each value of \a integralImage's source over the square window of \a radius pixels around it, clipped to the image, and stores the result in \a dstChannel. Runs in constant time per pixel regardless of \a radius.
+template<typename T, typename SUMT>
+void boxBlur( const IntegralImageT<T,SUMT> &integralImage, int32_t radius, ChannelT<T> *dstChannel, int32_t numThreads = 1 );
+//! Averages each value of \a srcChannel over the square window of \a radius pixels around it and stores the result in \a dstChannel. Builds a temporary IntegralImage; prefer the IntegralImageT variant when running several filters on the same image.
+template<typename T>
+void boxBlur( const ChannelT<T> &srcChannel, int32_t radius, ChannelT<T> *dstChannel, int32_t numThreads = 1 );
+
+//! Stores the mean of the square window of \a radius pixels around each value of \a integralImage's source in \a dstChannel, in the units of the source.
+template<typename T, typename SUMT>
+void localMean( const IntegralImageT<T,SUMT> &integralImage, int32_t radius, Channel32f *dstChannel, int32_t numThreads = 1 );
+//! Stores the variance of the square window of \a radius pixels around each value of \a integralImage's source in \a dstChannel. Requires \a integralImage to have squared sums.
+template<typename T, typename SUMT>
+void localVariance( const IntegralImageT<T,SUMT> &integralImage, int32_t radius, Channel32f *dstChannel, int32_t numThreads = 1 );
+/** Stores the local contrast of each value of \a srcChannel in \a dstChannel: its distance from the mean of the square window of \a radius pixels around it, divided by that window's standard deviation.
+	Standard deviations below \a minStdDev are clamped to it to avoid amplifying noise in flat regions. \a integralImage must be built from \a srcChannel with squared sums. **/
+template<typename T, typename SUMT>
+void localContrast( const ChannelT<T> &srcChannel, const IntegralImageT<T,SUMT> &integralImage, int32_t radius, float minStdDev, Channel32f *dstChannel, int32_t numThreads = 1 );
+
+} } // namespace cinder::ip
@@ -0,0 +1,71 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/Thread.h"
+
+#include <vector>
+#include <algorithm>
+
+namespace cinder { namespace ip {
+
+//! Returns the number of threads to use for a requested \a numThreads, where \c 0 means one per hardware core
+inline int32_t resolveNumThreads( int32_t numThreads )
+{
+	if( numThreads <= 0 )
+		numThreads = std::max<int32_t>( 1, std::thread::hardware_concurrency() );
+	return numThreads;
+}
+
+/** Splits the rows [\a rowBegin, \a rowEnd) into at most \a numThreads consecutive bands of at least \a minRowsPerBand rows and calls \a fn( bandBegin, bandEnd ) for each concurrently.
+	The calling thread processes the first band and the function returns once every band is complete. A \a numThreads of \c 0 uses one thread per hardware core. **/
+template<typename FN>
+void parallelRows( int32_t rowBegin, int32_t rowEnd, int32_t numThreads, const FN &fn, int32_t minRowsPerBand = 1 )
+{
+	const int32_t rows = rowEnd - rowBegin;
+	if( rows <= 0 )
+		return;
+
+	const int32_t numBands = std::max<int32_t>( 1, std::min<int32_t>( resolveNumThreads( numThreads ), rows / std::max<int32_t>( 1, minRowsPerBand ) ) );
+	if( numBands == 1 ) {
+		fn( rowBegin, rowEnd );
+		return;
+	}
+
+	const int32_t bandHeight = ( rows + numBands - 1 ) / numBands;
+	std::vector<std::shared_ptr<std::thread> > threads;
+	for( int32_t band = 1; band < numBands; ++band ) {
+		int32_t bandBegin = rowBegin + band * bandHeight;
+		int32_t bandEnd = std::min( rowEnd, bandBegin + bandHeight );
+		if( bandBegin < bandEnd )
+			threads.push_back( std::shared_ptr<std::thread>( new std::thread( fn, bandBegin, bandEnd ) ) );
+	}
+	fn( rowBegin, std::min( rowEnd, rowBegin + bandHeight ) );
+
+	for( size_t t = 0; t < threads.size(); ++t )
+		threads[t]->join();
+}
+
+} } // namespace cinder::ip
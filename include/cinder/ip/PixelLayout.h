@@ -0,0 +1,90 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#pragma once
+
+#include "cinder/Cinder.h"
+#include "cinder/Surface.h"
+
+namespace cinder { namespace ip {
+
+/** \brief Compile-time description of an interleaved SurfaceChannelOrder.
+	Pixel loops templated on a PixelLayout see the channel offsets and pixel increment as constants, which lets the compiler unroll and vectorize them. **/
+template<uint8_t RED, uint8_t GREEN, uint8_t BLUE, uint8_t ALPHA, uint8_t PIXEL_INC>
+struct PixelLayout {
+	static const uint8_t	R = RED;
+	static const uint8_t	G = GREEN;
+	static const uint8_t	B = BLUE;
+	static const uint8_t	A = ALPHA;
+	static const uint8_t	INC = PIXEL_INC;
+	static const bool		HAS_ALPHA = ( ALPHA != SurfaceChannelOrder::INVALID );
+};
+
+typedef PixelLayout<0,1,2,3,4>								PixelLayoutRgba;
+typedef PixelLayout<2,1,0,3,4>								PixelLayoutBgra;
+typedef PixelLayout<1,2,3,0,4>								PixelLayoutArgb;
+typedef PixelLayout<0,1,2,SurfaceChannelOrder::INVALID,3>	PixelLayoutRgb;
+
+/** Calls \a op.template process<LAYOUT>() with the PixelLayout matching \a order, which must be one of \c RGBA, \c BGRA, \c ARGB or \c RGB.
+	Returns \c false without calling \a op for any other order, in which case the caller should fall back to a loop using runtime offsets. **/
+template<typename OP>
+bool dispatchPixelLayout( const SurfaceChannelOrder &order, OP &op )
+{
+	switch( order.getCode() ) {
+		case SurfaceChannelOrder::RGBA:
+			op.template process<PixelLayoutRgba>();
+		return true;
+		case SurfaceChannelOrder::BGRA:
+			op.template process<PixelLayoutBgra>();
+		return true;
+		case SurfaceChannelOrder::ARGB:
+			op.template process<PixelLayoutArgb>();
+		return true;
+		case SurfaceChannelOrder::RGB:
+			op.template process<PixelLayoutRgb>();
+		return true;
+		default:
+			return false;
+	}
+}
+
+//! Like dispatchPixelLayout() but only for the orders with an alpha channel: \c RGBA, \c BGRA and \c ARGB
+template<typename OP>
+bool dispatchPixelLayoutAlpha( const SurfaceChannelOrder &order, OP &op )
+{
+	switch( order.getCode() ) {
+		case SurfaceChannelOrder::RGBA:
+			op.template process<PixelLayoutRgba>();
+		return true;
+		case SurfaceChannelOrder::BGRA:
+			op.template process<PixelLayoutBgra>();
+		return true;
+		case SurfaceChannelOrder::ARGB:
+			op.template process<PixelLayoutArgb>();
+		return true;
+		default:
+			return false;
+	}
+}
+
+} } // namespace cinder::ip
@@ -27,12 +27,14 @@
 
 namespace cinder { namespace ip {
 
-/** Premultiplies the contents of a Surface using its own alpha channel. Marks the Surface as being premultiplied. **/
+/** Premultiplies the contents of a Surface using its own alpha channel. Marks the Surface as being premultiplied.
+	Rows are split across \a numThreads threads, where \c 0 means one per hardware core. **/
 template<typename T>
-void premultiply( SurfaceT<T> *surface );
+void premultiply( SurfaceT<T> *surface, int32_t numThreads = 1 );
 
-/** Unpremultiplies the contents of a Surface using its own alpha channel. Marks the Surface as being unpremultiplied. **/
+/** Unpremultiplies the contents of a Surface using its own alpha channel. Marks the Surface as being unpremultiplied.
+	Rows are split across \a numThreads threads, where \c 0 means one per hardware core. **/
 template<typename T>
-void unpremultiply( SurfaceT<T> *surface );
+void unpremultiply( SurfaceT<T> *surface, int32_t numThreads = 1 );
 
 } } // namespace cinder::ip
@@ -25,19 +25,75 @@
 #include "cinder/Surface.h"
 #include "cinder/Filter.h"
 #include "cinder/Rect.h"
+#include "cinder/Exception.h"
 
 namespace cinder { namespace ip {
 
+/** Resizes \a srcSurface into \a dstSurface using filter \a filter.
+	When \a numThreads is greater than 1 the destination is split into horizontal bands which are filtered concurrently. The result is identical to the serial path. A \a numThreads of \c 0 uses one thread per hardware core. **/
 template<typename T>
-void resize( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface, const FilterBase &filter = FilterTriangle() );
+void resize( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface, const FilterBase &filter = FilterTriangle(), int32_t numThreads = 1 );
 template<typename T>
-void resize( const ChannelT<T> &srcChannel, ChannelT<T> *dstChannel, const FilterBase &filter = FilterTriangle() );
+void resize( const ChannelT<T> &srcChannel, ChannelT<T> *dstChannel, const FilterBase &filter = FilterTriangle(), int32_t numThreads = 1 );
 template<typename T>
-void resize( const SurfaceT<T> &srcSurface, const Area &srcArea, SurfaceT<T> *dstSurface, const Area &dstArea, const FilterBase &filter = FilterTriangle() );
-//! Returns a new Surface which is a copy of \a srcSurface's area \a srcArea scaled to size \a dstSize using filter \a filter
+void resize( const SurfaceT<T> &srcSurface, const Area &srcArea, SurfaceT<T> *dstSurface, const Area &dstArea, const FilterBase &filter = FilterTriangle(), int32_t numThreads = 1 );
+//! Returns a new Surface which is a copy of \a srcSurface's area \a srcArea scaled to size \a dstSize using filter \a filter, split across \a numThreads threads
 template<typename T>
-SurfaceT<T> resizeCopy( const SurfaceT<T> &srcSurface, const Area &srcArea, const Vec2i &dstSize, const FilterBase &filter = FilterTriangle() );
+SurfaceT<T> resizeCopy( const SurfaceT<T> &srcSurface, const Area &srcArea, const Vec2i &dstSize, const FilterBase &filter = FilterTriangle(), int32_t numThreads = 1 );
 template<typename T>
-void resize( const ChannelT<T> &srcChannel, const Area &srcArea, ChannelT<T> *dstChannel, const Area &dstArea, const FilterBase &filter = FilterTriangle() );
+void resize( const ChannelT<T> &srcChannel, const Area &srcArea, ChannelT<T> *dstChannel, const Area &dstArea, const FilterBase &filter = FilterTriangle(), int32_t numThreads = 1 );
+
+/** \brief Precomputed filter weights and scratch buffers for repeatedly resizing images of the same geometry.
+	Useful for resizing every frame of a video, where it avoids recalculating the filter and reallocating the line buffers on each call.
+	A plan's scratch buffers are not shared between threads, so a single plan should not be applied from multiple threads simultaneously. **/
+template<typename T>
+class ResizePlanT {
+  private:
+	struct Obj;
+  public:
+	ResizePlanT() {}
+	//! Creates a plan for resizing the Area \a srcArea of an image of size \a srcSize into the Area \a dstArea of an image of size \a dstSize, split across \a numThreads threads
+	ResizePlanT( const Vec2i &srcSize, const Area &srcArea, const Vec2i &dstSize, const Area &dstArea, const FilterBase &filter = FilterTriangle(), int32_t numThreads = 1 );
+	//! Creates a plan for resizing an entire image of size \a srcSize to the size \a dstSize, split across \a numThreads threads
+	ResizePlanT( const Vec2i &srcSize, const Vec2i &dstSize, const FilterBase &filter = FilterTriangle(), int32_t numThreads = 1 );
+
+	//! Returns the source image size the plan was created for
+	const Vec2i&	getSrcSize() const;
+	//! Returns the destination image size the plan was created for
+	const Vec2i&	getDstSize() const;
+
+	//! Resizes \a srcSurface into \a dstSurface. Throws ResizePlanExcGeometryMismatch if their sizes differ from the plan's.
+	void	apply( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface );
+	//! Resizes \a srcChannel into \a dstChannel. Throws ResizePlanExcGeometryMismatch if their sizes differ from the plan's.
+	void	apply( const ChannelT<T> &srcChannel, ChannelT<T> *dstChannel );
+
+	//@{
+	//! Emulates shared_ptr-like behavior
+	typedef std::shared_ptr<Obj> ResizePlanT::*unspecified_bool_type;
+	operator unspecified_bool_type() const { return ( mObj.get() == 0 ) ? 0 : &ResizePlanT::mObj; }
+	void reset() { mObj.reset(); }
+	//@}
+
+  private:
+	std::shared_ptr<Obj>	mObj;
+};
+
+typedef ResizePlanT<uint8_t>	ResizePlan;
+typedef ResizePlanT<uint8_t>	ResizePlan8u;
+typedef ResizePlanT<float>		ResizePlan32f;
+
+//! Resizes \a srcSurface into \a dstSurface using the precomputed \a plan
+template<typename T>
+inline void resize( ResizePlanT<T> &plan, const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface ) { plan.apply( srcSurface, dstSurface ); }
+//! Resizes \a srcChannel into \a dstChannel using the precomputed \a plan
+template<typename T>
+inline void resize( ResizePlanT<T> &plan, const ChannelT<T> &srcChannel, ChannelT<T> *dstChannel ) { plan.apply( srcChannel, dstChannel ); }
+
+class ResizeExc : public Exception {
+};
+
+//! Exception thrown when a ResizePlanT is applied to images whose sizes differ from those it was created for
+class ResizePlanExcGeometryMismatch : public ResizeExc {
+};
 
 } } // namespace cinder::ip
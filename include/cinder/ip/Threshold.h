@@ -24,21 +24,22 @@
 
 #include "cinder/Cinder.h"
 #include "cinder/Surface.h"
+#include "cinder/ip/IntegralImage.h"
 
 namespace cinder { namespace ip {
 
-//! Thresholds \a surface setting any values below \a value to zero and any values above to unity inside the Area \a area
+//! Thresholds \a surface setting any values below \a value to zero and any values above to unity inside the Area \a area. Rows are split across \a numThreads threads, where \c 0 means one per hardware core.
 template<typename T>
-void threshold( SurfaceT<T> *surface, T value, const Area &area );
-//! Thresholds \a surface setting any values below \a value to zero and any values above to unity
+void threshold( SurfaceT<T> *surface, T value, const Area &area, int32_t numThreads = 1 );
+//! Thresholds \a surface setting any values below \a value to zero and any values above to unity. Rows are split across \a numThreads threads, where \c 0 means one per hardware core.
 template<typename T>
-void threshold( SurfaceT<T> *surface, T value );
-//! Thresholds \a srcSurface setting any values below \a value to zero and any values above to unity and storing the result in \a dstSurface
+void threshold( SurfaceT<T> *surface, T value, int32_t numThreads = 1 );
+//! Thresholds \a srcSurface setting any values below \a value to zero and any values above to unity and storing the result in \a dstSurface. Rows are split across \a numThreads threads, where \c 0 means one per hardware core.
 template<typename T>
-void threshold( const SurfaceT<T> &srcSurface, T value, SurfaceT<T> *dstSurface );
-//! Thresholds \a srcChannel setting any values below \a value to zero and any values above to unity and storing the result in \a dstChannel
+void threshold( const SurfaceT<T> &srcSurface, T value, SurfaceT<T> *dstSurface, int32_t numThreads = 1 );
+//! Thresholds \a srcChannel setting any values below \a value to zero and any values above to unity and storing the result in \a dstChannel. Rows are split across \a numThreads threads, where \c 0 means one per hardware core.
 template<typename T>
-void threshold( const ChannelT<T> &srcSurface, T value, ChannelT<T> *dstSurface );
+void threshold( const ChannelT<T> &srcSurface, T value, ChannelT<T> *dstSurface, int32_t numThreads = 1 );
 //! Thresholds \a srcChannel using an adaptive thresholding algorithm which considers a window of size \a windowSize pixels and stores the result in \a dstChannel.
 /** Implements the algorithm described in "Adaptive Thresholding Using the Integral Image" by Bradley & Roth. The srcSurface.getWidth() / 8 is a good default for \a windowSize and 0.15 is for \a percentageDelta **/
 template<typename T>
@@ -57,22 +58,28 @@ void adaptiveThresholdZero( const ChannelT<T> &srcChannel, int32_t windowSize, C
 
 template<typename T>
 class AdaptiveThresholdT {
+ public:
+	typedef IntegralImageT<T>	IntegralImageType;
+
  private:
-	typedef typename CHANTRAIT<T>::Accum SUMT;
 	struct Obj {
-		Obj( ChannelT<T> *channel );
-		~Obj();
+		Obj( ChannelT<T> *channel, const IntegralImageType &integralImage );
 	
 		ChannelT<T>	* mChannel;
 		int32_t		mImageWidth;
 		int32_t		mImageHeight;
 		int8_t		mIncrement;
-		SUMT		* mIntegralImage;
+		IntegralImageType	mIntegralImage;
 	};
  public:
 	AdaptiveThresholdT() {};
 	AdaptiveThresholdT( ChannelT<T> *channel );
+	//! Shares the existing \a integralImage of \a channel rather than building a new one, so other window-based filters can reuse the same sums
+	AdaptiveThresholdT( ChannelT<T> *channel, const IntegralImageType &integralImage );
 	void calculate( int32_t windowSize, float percentageDelta, ChannelT<T> *dstChannel );
+
+	//! Returns the integral image of the source Channel
+	const IntegralImageType&	getIntegralImage() const { return mObj->mIntegralImage; }
 	
 	//@{
 	//! Emulates shared_ptr-like behavior
@@ -83,6 +83,36 @@ DataSourcePathRef loadFile( const std::string &path )
 	return DataSourcePath::createRef( path );
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// DataSourceMapped
+DataSourceMappedRef DataSourceMapped::createRef( const std::string &path )
+{
+	return DataSourceMappedRef( new DataSourceMapped( path ) );
+}
+
+DataSourceMapped::DataSourceMapped( const std::string &path )
+	: DataSource( path, Url() )
+{
+	setFilePathHint( path );
+	mStream = loadFileStreamMapped( path );
+}
+
+void DataSourceMapped::createBuffer()
+{
+	// the Buffer doesn't own the mapping; it refers to it for as long as we do
+	mBuffer = Buffer( const_cast<void*>( mStream->getData() ), getDataSize() );
+}
+
+IStreamRef DataSourceMapped::createStream()
+{
+	return IStreamMapped::createRef( mStream );
+}
+
+DataSourceMappedRef loadFileMapped( const std::string &path )
+{
+	return DataSourceMapped::createRef( path );
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // DataSourceUrl
 DataSourceUrlRef DataSourceUrl::createRef( const Url &url )
@@ -22,9 +22,15 @@
 
 #include "cinder/ImageIo.h"
 #include "cinder/Utilities.h"
+#include "cinder/System.h"
 
 #include <boost/type_traits/is_same.hpp>
 #include <cctype>
+#include <cstring>
+
+#if defined( CINDER_SSE2 )
+	#include <emmintrin.h>
+#endif
 
 #if defined( CINDER_MSW )
 	#include "cinder/ImageSourceFileWic.h" // this is necessary to force the instantiation of the IMAGEIO_REGISTER macro
@@ -254,6 +260,181 @@ void ImageSource::rowFuncSourceGray( ImageTargetRef target, int32_t row, const v
 	}
 }
 
+namespace {
+
+// Converts the first values of \a src into \a dst, returning the number converted; the remainder is converted with CHANTRAIT
+template<typename SD, typename TD>
+int32_t convertValuesSimd( const SD * /*src*/, TD * /*dst*/, int32_t /*count*/ )
+{
+	return 0;
+}
+
+#if defined( CINDER_SSE2 )
+template<>
+int32_t convertValuesSimd<uint8_t,float>( const uint8_t *src, float *dst, int32_t count )
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 scale = _mm_set1_ps( 255.0f );
+	int32_t i = 0;
+	for( ; i + 16 <= count; i += 16 ) {
+		__m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + i ) );
+		__m128i lo = _mm_unpacklo_epi8( v, zero );
+		__m128i hi = _mm_unpackhi_epi8( v, zero );
+		// division rather than multiplication by the reciprocal so the result matches CHANTRAIT<float>::convert() exactly
+		_mm_storeu_ps( dst + i, _mm_div_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( lo, zero ) ), scale ) );
+		_mm_storeu_ps( dst + i + 4, _mm_div_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( lo, zero ) ), scale ) );
+		_mm_storeu_ps( dst + i + 8, _mm_div_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( hi, zero ) ), scale ) );
+		_mm_storeu_ps( dst + i + 12, _mm_div_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( hi, zero ) ), scale ) );
+	}
+	return i;
+}
+
+template<>
+int32_t convertValuesSimd<uint16_t,float>( const uint16_t *src, float *dst, int32_t count )
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 scale = _mm_set1_ps( 65535.0f );
+	int32_t i = 0;
+	for( ; i + 8 <= count; i += 8 ) {
+		__m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + i ) );
+		_mm_storeu_ps( dst + i, _mm_div_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( v, zero ) ), scale ) );
+		_mm_storeu_ps( dst + i + 4, _mm_div_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( v, zero ) ), scale ) );
+	}
+	return i;
+}
+
+template<>
+int32_t convertValuesSimd<uint16_t,uint8_t>( const uint16_t *src, uint8_t *dst, int32_t count )
+{
+	// v / 257 == ( v * 0xFF01 ) >> 24 for every 16-bit v
+	const __m128i magic = _mm_set1_epi16( (short)0xFF01 );
+	int32_t i = 0;
+	for( ; i + 16 <= count; i += 16 ) {
+		__m128i lo = _mm_srli_epi16( _mm_mulhi_epu16( _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + i ) ), magic ), 8 );
+		__m128i hi = _mm_srli_epi16( _mm_mulhi_epu16( _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + i + 8 ) ), magic ), 8 );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( dst + i ), _mm_packus_epi16( lo, hi ) );
+	}
+	return i;
+}
+#endif
+
+// Describes a reordering of the bytes of a 4-channel uint8 pixel as a set of masked shifts on its 32-bit little-endian value.
+// For example RGBA to BGRA is three shifts: red left 16 bits, blue right 16 bits, and green and alpha in place.
+struct Swizzle8u {
+	Swizzle8u( int8_t srcR, int8_t srcG, int8_t srcB, int8_t srcA, int8_t dstR, int8_t dstG, int8_t dstB, int8_t dstA )
+		: mNumChannels( 0 ), mKeep( 0xFFFFFFFF )
+	{
+		add( srcR, dstR );
+		add( srcG, dstG );
+		add( srcB, dstB );
+		if( ( srcA != -1 ) && ( dstA != -1 ) )
+			add( srcA, dstA );
+	}
+
+	uint32_t apply( uint32_t src, uint32_t dst ) const
+	{
+		uint32_t result = dst & mKeep;
+		for( int c = 0; c < mNumChannels; ++c )
+			result |= ( mShift[c] >= 0 ) ? ( ( src & mMask[c] ) << mShift[c] ) : ( ( src & mMask[c] ) >> -mShift[c] );
+		return result;
+	}
+
+	void add( int8_t src, int8_t dst )
+	{
+		mKeep &= ~( 0xFFu << ( dst * 8 ) ); // bytes of the target which aren't written keep their current value
+		// channels which move by the same amount share a single mask and shift
+		int32_t shift = ( dst - src ) * 8;
+		for( int c = 0; c < mNumChannels; ++c ) {
+			if( mShift[c] == shift ) {
+				mMask[c] |= 0xFFu << ( src * 8 );
+				return;
+			}
+		}
+		mMask[mNumChannels] = 0xFFu << ( src * 8 );
+		mShift[mNumChannels] = shift;
+		++mNumChannels;
+	}
+
+	uint32_t	mMask[4];
+	int32_t		mShift[4];
+	int32_t		mNumChannels;
+	uint32_t	mKeep;
+};
+
+#if defined( CINDER_SSE2 )
+// Swizzles the first pixels of \a src into \a dst, returning the number of pixels processed
+int32_t swizzlePixelsSse2( const Swizzle8u &swizzle, const uint8_t *src, uint8_t *dst, int32_t width )
+{
+	__m128i masks[4], shifts[4];
+	bool left[4];
+	for( int c = 0; c < swizzle.mNumChannels; ++c ) {
+		masks[c] = _mm_set1_epi32( (int)swizzle.mMask[c] );
+		left[c] = swizzle.mShift[c] >= 0;
+		shifts[c] = _mm_cvtsi32_si128( left[c] ? swizzle.mShift[c] : -swizzle.mShift[c] );
+	}
+	const __m128i keep = _mm_set1_epi32( (int)swizzle.mKeep );
+
+	int32_t x = 0;
+	for( ; x + 4 <= width; x += 4 ) {
+		__m128i s = _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + x * 4 ) );
+		__m128i result = ( swizzle.mKeep ) ? _mm_and_si128( _mm_loadu_si128( reinterpret_cast<const __m128i*>( dst + x * 4 ) ), keep ) : _mm_setzero_si128();
+		for( int c = 0; c < swizzle.mNumChannels; ++c ) {
+			__m128i v = _mm_and_si128( s, masks[c] );
+			result = _mm_or_si128( result, left[c] ? _mm_sll_epi32( v, shifts[c] ) : _mm_srl_epi32( v, shifts[c] ) );
+		}
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( dst + x * 4 ), result );
+	}
+	return x;
+}
+#endif
+
+} // anonymous namespace
+
+// Source and target share a layout and data type, so rows can be copied wholesale
+template<typename T>
+void ImageSource::rowFuncCopy( ImageTargetRef target, int32_t row, const void *data )
+{
+	memcpy( target->getRowPointer( row ), data, getWidth() * mRowFuncSourceInc * sizeof(T) );
+}
+
+// Source and target share a layout, so values are converted in a single pass without regard to channel
+template<typename SD, typename TD>
+void ImageSource::rowFuncConvert( ImageTargetRef target, int32_t row, const void *data )
+{
+	static const bool useSse2 = System::hasSse2();
+
+	const SD *sourceData = reinterpret_cast<const SD*>( data );
+	TD *targetData = reinterpret_cast<TD*>( target->getRowPointer( row ) );
+	const int32_t count = getWidth() * mRowFuncSourceInc;
+
+	int32_t i = ( useSse2 ) ? convertValuesSimd<SD,TD>( sourceData, targetData, count ) : 0;
+	for( ; i < count; ++i )
+		targetData[i] = CHANTRAIT<TD>::convert( sourceData[i] );
+}
+
+// Both source and target are 4-channel uint8 RGB(A) which differ only by channel order
+void ImageSource::rowFuncSwizzle8u( ImageTargetRef target, int32_t row, const void *data )
+{
+	const uint8_t *sourceData = reinterpret_cast<const uint8_t*>( data );
+	uint8_t *targetData = reinterpret_cast<uint8_t*>( target->getRowPointer( row ) );
+	const int32_t width = getWidth();
+	const Swizzle8u swizzle( mRowFuncSourceRed, mRowFuncSourceGreen, mRowFuncSourceBlue, mRowFuncSourceAlpha, mRowFuncTargetRed, mRowFuncTargetGreen, mRowFuncTargetBlue, mRowFuncTargetAlpha );
+
+	int32_t x = 0;
+#if defined( CINDER_SSE2 )
+	static const bool useSse2 = System::hasSse2();
+	if( useSse2 )
+		x = swizzlePixelsSse2( swizzle, sourceData, targetData, width );
+#endif
+	for( ; x < width; ++x ) {
+		uint32_t s, d;
+		memcpy( &s, sourceData + x * 4, 4 );
+		memcpy( &d, targetData + x * 4, 4 );
+		d = swizzle.apply( s, d );
+		memcpy( targetData + x * 4, &d, 4 );
+	}
+}
+
 void ImageSource::setupRowFuncRgbSource( ImageTargetRef target )
 {
 	translateRgbColorModelToOffsets( mChannelOrder, &mRowFuncSourceRed, &mRowFuncSourceGreen, &mRowFuncSourceBlue, &mRowFuncSourceAlpha, &mRowFuncSourceInc );
@@ -272,12 +453,33 @@ void ImageSource::setupRowFuncGraySource( ImageTargetRef target )
 		translateGrayColorModelToOffsets( target->getChannelOrder(), &mRowFuncTargetGray, &mRowFuncTargetAlpha, &mRowFuncTargetInc );
 }
 
+template<typename SD, typename TD, ImageIo::ColorModel TCM>
+ImageSource::RowFunc ImageSource::setupRowFuncFastPath( ImageTargetRef target )
+{
+	// identical layouts need no per-channel work; X channels are ignored so they may be overwritten
+	if( ( mColorModel == TCM ) && ( mChannelOrder == target->getChannelOrder() ) ) {
+		if( boost::is_same<SD,TD>::value )
+			return &ImageSource::rowFuncCopy<SD>;
+		else
+			return &ImageSource::rowFuncConvert<SD,TD>;
+	}
+	
+	// 4-channel uint8 layouts which differ only by channel order
+	if( boost::is_same<SD,uint8_t>::value && boost::is_same<TD,uint8_t>::value && ( mColorModel == CM_RGB ) && ( TCM == CM_RGB )
+			&& ( mRowFuncSourceInc == 4 ) && ( mRowFuncTargetInc == 4 ) )
+		return &ImageSource::rowFuncSwizzle8u;
+
+	return 0;
+}
+
 template<typename SD, typename TD, ImageIo::ColorModel TCM>
 ImageSource::RowFunc ImageSource::setupRowFuncForTypesAndTargetColorModel( ImageTargetRef target )
 {
 	switch( mColorModel ) {
 		case CM_RGB: {
 			setupRowFuncRgbSource( target );
+			if( RowFunc fastFunc = setupRowFuncFastPath<SD,TD,TCM>( target ) )
+				return fastFunc;
 			bool alpha = ( mRowFuncSourceAlpha != -1 ) && ( mRowFuncTargetAlpha != -1 );
 			if( alpha )
 				return &ImageSource::rowFuncSourceRgb<SD,TD,TCM,true>;
@@ -287,6 +489,8 @@ ImageSource::RowFunc ImageSource::setupRowFuncForTypesAndTargetColorModel( Image
 		break;
 		case CM_GRAY: {
 			setupRowFuncGraySource( target );
+			if( RowFunc fastFunc = setupRowFuncFastPath<SD,TD,TCM>( target ) )
+				return fastFunc;
 			bool alpha = ( mRowFuncSourceAlpha != -1 ) && ( mRowFuncTargetAlpha != -1 );
 			if( alpha )
 				return &ImageSource::rowFuncSourceGray<SD,TD,TCM,true>;
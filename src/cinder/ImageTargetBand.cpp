@@ -0,0 +1,128 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cinder/ImageTargetBand.h"
+#include "cinder/ip/Fill.h"
+
+#include <boost/type_traits/is_same.hpp>
+#include <boost/preprocessor/seq.hpp>
+#include <algorithm>
+
+namespace cinder {
+
+template<typename T>
+ImageTargetBandT<T>::ImageTargetBandT( ImageSourceRef imageSource, int32_t bandHeight, BandFn bandFn, const SurfaceConstraints &constraints, boost::tribool alpha )
+	: ImageTarget(), mBandFn( bandFn ), mBandStart( 0 ), mBandEnd( 0 )
+{
+	if( bandHeight < 1 )
+		throw ImageTargetBandException();
+
+	bool hasAlpha;
+	if( alpha )
+		hasAlpha = true;
+	else if( ! alpha )
+		hasAlpha = false;
+	else
+		hasAlpha = imageSource->hasAlpha();
+	// if the image doesn't have alpha but we do, each band needs to be set to full alpha before it is handed off
+	mFillAlpha = hasAlpha && ( ! imageSource->hasAlpha() );
+
+	mBand = SurfaceT<T>( imageSource->getWidth(), std::min( bandHeight, std::max<int32_t>( imageSource->getHeight(), 1 ) ), hasAlpha, constraints );
+	mBand.setPremultiplied( imageSource->isPremultiplied() );
+
+	if( boost::is_same<T,float>::value )
+		setDataType( ImageIo::FLOAT32 );
+	else if( boost::is_same<T,uint8_t>::value )
+		setDataType( ImageIo::UINT8 );
+	else 
+		throw; // what is this?
+
+	setSize( mBand.getWidth(), imageSource->getHeight() );
+	setColorModel( ImageIo::CM_RGB );
+	setChannelOrder( ImageIo::ChannelOrder( mBand.getChannelOrder().getImageIoChannelOrder() ) );
+}
+
+template<typename T>
+bool ImageTargetBandT<T>::hasAlpha() const
+{
+	return mBand.hasAlpha();
+}
+
+template<typename T>
+void* ImageTargetBandT<T>::getRowPointer( int32_t row )
+{
+	// the previous band is complete once a row beyond it is requested
+	if( row >= mBandStart + mBand.getHeight() ) {
+		flush();
+		mBandStart = row;
+	}
+	else if( row < mBandStart ) // rows have already been handed off; this target can't service out-of-order sources
+		throw ImageTargetBandException();
+
+	mBandEnd = std::max( mBandEnd, row + 1 );
+	return reinterpret_cast<void*>( mBand.getData( Vec2i( 0, row - mBandStart ) ) );
+}
+
+template<typename T>
+void ImageTargetBandT<T>::finalize()
+{
+	flush();
+}
+
+template<typename T>
+void ImageTargetBandT<T>::flush()
+{
+	int32_t numRows = mBandEnd - mBandStart;
+	if( numRows <= 0 )
+		return;
+
+	if( numRows == mBand.getHeight() ) {
+		if( mFillAlpha )
+			ip::fill( &mBand.getChannelAlpha(), CHANTRAIT<T>::max() );
+		mBandFn( mBand, mBandStart );
+	}
+	else { // the final band is short; hand off a Surface which refers to just its rows
+		SurfaceT<T> partial( mBand.getData(), mBand.getWidth(), numRows, mBand.getRowBytes(), mBand.getChannelOrder() );
+		partial.setPremultiplied( mBand.isPremultiplied() );
+		if( mFillAlpha )
+			ip::fill( &partial.getChannelAlpha(), CHANTRAIT<T>::max() );
+		mBandFn( partial, mBandStart );
+	}
+
+	mBandStart = mBandEnd;
+}
+
+template<typename T>
+void loadImageBands( ImageSourceRef imageSource, int32_t bandHeight, typename ImageTargetBandT<T>::BandFn bandFn, const SurfaceConstraints &constraints, boost::tribool alpha )
+{
+	std::shared_ptr<ImageTargetBandT<T> > target = ImageTargetBandT<T>::createRef( imageSource, bandHeight, bandFn, constraints, alpha );
+	imageSource->load( target );
+	target->finalize();
+}
+
+#define IMAGE_TARGET_BAND_PROTOTYPES(r,data,T)\
+	template class ImageTargetBandT<T>;\
+	template void loadImageBands<T>( ImageSourceRef imageSource, int32_t bandHeight, ImageTargetBandT<T>::BandFn bandFn, const SurfaceConstraints &constraints, boost::tribool alpha );
+
+BOOST_PP_SEQ_FOR_EACH( IMAGE_TARGET_BAND_PROTOTYPES, ~, CHANNEL_TYPES )
+
+} // namespace cinder
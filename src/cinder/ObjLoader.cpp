@@ -21,142 +21,594 @@
 */
 
 #include "cinder/ObjLoader.h"
+#include "cinder/ip/Parallel.h"
 
 #include <boost/lexical_cast.hpp>
 using boost::lexical_cast;
 #include <sstream>
 using std::ostringstream;
 
-#include <sstream>
+#include <cfloat>
 using namespace std;
-using boost::make_tuple;
 
 namespace cinder {
 
-ObjLoader::ObjLoader( shared_ptr<IStream> stream, bool includeUVs )
-	: mStream( stream )
+namespace {
+
+// Files are split into chunks of at least this many bytes, one per core, which are parsed concurrently
+const size_t MIN_CHUNK_SIZE = 4 * 1024 * 1024;
+
+// Per-face bits that let mergeObjChunks() reproduce mHasTexCoords and mHasNormals once it knows which group a face landed in
+enum {	FACE_LAST_HAS_TEX_COORD = 1, FACE_ANY_EMPTY_TEX_COORD = 2, FACE_LAST_HAS_NORMAL = 4, FACE_ANY_HAS_NORMAL = 8 };
+
+// The vertices, faces and groups parsed from a newline-aligned span of the file. Faces are kept as flat index arrays, since copying
+// ObjLoader::Face as a vector grows would copy its vectors too. Indices are final except for negative (relative) indices, which depend
+// on the base offsets of the enclosing group and are recorded as fixups until the merge.
+struct ObjChunk {
+	struct FaceSize {
+		int			mNumVertices, mNumTexCoords, mNumNormals;
+		uint8_t		mFlags;
+	};
+
+	struct GroupStart {
+		size_t		mFace;
+		size_t		mNumVertices, mNumTexCoords, mNumNormals;
+		string		mName;
+	};
+	
+	struct Fixup {
+		size_t		mFace;
+		int			mIndexArray; // 0 for vertex, 1 for tex coord, 2 for normal indices
+		size_t		mIndex;
+		int			mRelativeIndex;
+	};
+
+	ObjChunk() : mFailed( false ) {}
+
+	vector<Vec3f>				mVertices, mNormals;
+	vector<Vec2f>				mTexCoords;
+	vector<FaceSize>			mFaces;
+	vector<int>					mIndices[3];
+	vector<GroupStart>			mGroupStarts;
+	vector<Fixup>				mFixups;
+	bool						mFailed;
+};
+
+inline bool isObjSpace( char c )
 {
-	parse( includeUVs );
+	return ( c == ' ' ) || ( c == '\t' ) || ( c == '\v' ) || ( c == '\f' );
 }
 
-ObjLoader::ObjLoader( DataSourceRef dataSource, bool includeUVs )
-	: mStream( dataSource->createStream() )
+inline bool isDigit( char c )
 {
-	parse( includeUVs );
+	return ( c >= '0' ) && ( c <= '9' );
 }
 
-ObjLoader::~ObjLoader()
+// Parses a float token at \a p, stopping at whitespace or \a end, with the same result as operator>> would give. Returns false
+// for anything it can't guarantee to round identically, such as long mantissas, large exponents or denormals, leaving the caller to fall back.
+bool parseObjFloat( const char *&p, const char *end, float *result )
+{
+	static const double sPowersOf10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+											1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	const char *s = p;
+	while( ( s < end ) && isObjSpace( *s ) )
+		++s;
+
+	bool negative = false;
+	if( ( s < end ) && ( ( *s == '-' ) || ( *s == '+' ) ) )
+		negative = ( *s++ == '-' );
+
+	uint64_t mantissa = 0;
+	int numDigits = 0, numSignificantDigits = 0, exponent = 0;
+	for( ; ( s < end ) && isDigit( *s ); ++s, ++numDigits ) {
+		mantissa = mantissa * 10 + ( *s - '0' );
+		if( mantissa )
+			++numSignificantDigits;
+	}
+	if( ( s < end ) && ( *s == '.' ) ) {
+		for( ++s; ( s < end ) && isDigit( *s ); ++s, ++numDigits, --exponent ) {
+			mantissa = mantissa * 10 + ( *s - '0' );
+			if( mantissa )
+				++numSignificantDigits;
+		}
+	}
+	if( ( numDigits == 0 ) || ( numSignificantDigits > 19 ) )
+		return false;
+
+	if( ( s < end ) && ( ( *s == 'e' ) || ( *s == 'E' ) ) ) {
+		++s;
+		bool negativeExponent = false;
+		if( ( s < end ) && ( ( *s == '-' ) || ( *s == '+' ) ) )
+			negativeExponent = ( *s++ == '-' );
+		if( ( s == end ) || ( ! isDigit( *s ) ) )
+			return false;
+		int explicitExponent = 0;
+		for( ; ( s < end ) && isDigit( *s ); ++s ) {
+			if( explicitExponent < 10000 )
+				explicitExponent = explicitExponent * 10 + ( *s - '0' );
+		}
+		exponent += ( negativeExponent ) ? -explicitExponent : explicitExponent;
+	}
+	if( ( s < end ) && ( ! isObjSpace( *s ) ) )
+		return false;
+
+	if( mantissa == 0 ) {
+		*result = ( negative ) ? -0.0f : 0.0f;
+		p = s;
+		return true;
+	}
+
+	// both operands are exact, so a single multiply or divide gives the correctly rounded double
+	if( ( mantissa > ( uint64_t( 1 ) << 53 ) ) || ( exponent < -22 ) || ( exponent > 22 ) )
+		return false;
+	double value = static_cast<double>( mantissa );
+	if( exponent < 0 )
+		value /= sPowersOf10[-exponent];
+	else
+		value *= sPowersOf10[exponent];
+	if( ( value < FLT_MIN ) || ( value > FLT_MAX ) )
+		return false;
+
+	// narrowing is only ambiguous when the double lands exactly halfway between two floats
+	uint64_t bits;
+	memcpy( &bits, &value, sizeof( bits ) );
+	if( ( bits & 0x1FFFFFFF ) == 0x10000000 )
+		return false;
+
+	*result = ( negative ) ? -static_cast<float>( value ) : static_cast<float>( value );
+	p = s;
+	return true;
+}
+
+// Parses the face index in [\a begin, \a end), throwing boost::bad_lexical_cast for the same input as lexical_cast<int>
+int parseObjIndex( const char *begin, const char *end )
 {
+	const char *s = begin;
+	bool negative = ( s < end ) && ( *s == '-' );
+	if( negative )
+		++s;
+	if( ( s < end ) && ( end - s <= 9 ) ) {
+		int result = 0;
+		for( ; ( s < end ) && isDigit( *s ); ++s )
+			result = result * 10 + ( *s - '0' );
+		if( s == end )
+			return ( negative ) ? -result : result;
+	}
+
+	return lexical_cast<int>( string( begin, end ) );
 }
 
-void ObjLoader::parse( bool includeUVs )
+inline const char* findObjChar( const char *begin, const char *end, char c )
 {
-	Group *currentGroup;
-	mGroups.push_back( Group() );
-	currentGroup = &mGroups[mGroups.size()-1];
-	currentGroup->mBaseVertexOffset = currentGroup->mBaseTexCoordOffset = currentGroup->mBaseNormalOffset = 0;
+	const char *result = reinterpret_cast<const char*>( memchr( begin, c, end - begin ) );
+	return ( result ) ? result : end;
+}
+
+// Parses the indices of face line [\a begin, \a end) into \a chunk, treating each "v/vt/vn" triple exactly as the original std::string based parser did
+void parseObjFace( const char *begin, const char *end, bool includeUVs, ObjChunk *chunk )
+{
+	const size_t faceIndex = chunk->mFaces.size();
+	vector<int> &vertexIndices = chunk->mIndices[0], &texCoordIndices = chunk->mIndices[1], &normalIndices = chunk->mIndices[2];
+	ObjChunk::FaceSize face = { 0, 0, 0, 0 };
+
+	const char *triple = begin + 2; // account for "f "
+	while( triple < end ) {
+		const char *endOfTriple = findObjChar( triple, end, ' ' );
+		const char *firstSlash = findObjChar( triple, endOfTriple, '/' );
+		const char *secondSlash = ( firstSlash != endOfTriple ) ? findObjChar( firstSlash + 1, endOfTriple, '/' ) : endOfTriple;
+
+		// process the vertex index
+		int vertexIndex = parseObjIndex( triple, firstSlash );
+		if( vertexIndex < 0 ) {
+			ObjChunk::Fixup fixup = { faceIndex, 0, vertexIndices.size(), vertexIndex };
+			chunk->mFixups.push_back( fixup );
+		}
+		vertexIndices.push_back( vertexIndex - 1 );
+
+		// process the tex coord index
+		face.mFlags &= ~FACE_LAST_HAS_TEX_COORD;
+		if( includeUVs && ( firstSlash != endOfTriple ) ) {
+			if( secondSlash - firstSlash > 1 ) {
+				int texCoordIndex = parseObjIndex( firstSlash + 1, secondSlash );
+				if( texCoordIndex < 0 ) {
+					ObjChunk::Fixup fixup = { faceIndex, 1, texCoordIndices.size(), texCoordIndex };
+					chunk->mFixups.push_back( fixup );
+				}
+				texCoordIndices.push_back( texCoordIndex - 1 );
+				face.mNumTexCoords++;
+				face.mFlags |= FACE_LAST_HAS_TEX_COORD;
+			}
+			else
+				face.mFlags |= FACE_ANY_EMPTY_TEX_COORD;
+		}
+
+		// process the normal index
+		face.mFlags &= ~FACE_LAST_HAS_NORMAL;
+		if( secondSlash != endOfTriple ) {
+			int normalIndex = parseObjIndex( secondSlash + 1, endOfTriple );
+			if( normalIndex < 0 ) {
+				ObjChunk::Fixup fixup = { faceIndex, 2, normalIndices.size(), normalIndex };
+				chunk->mFixups.push_back( fixup );
+			}
+			normalIndices.push_back( normalIndex - 1 );
+			face.mNumNormals++;
+			face.mFlags |= FACE_LAST_HAS_NORMAL | FACE_ANY_HAS_NORMAL;
+		}
 
-	size_t lineNumber = 0;
-	while( ! mStream->isEof() ) {
-		lineNumber++;
-		string line = mStream->readLine(), tag;
-		stringstream ss( line );
-		ss >> tag;
-		if( tag == "v" ) { // vertex
+		triple = endOfTriple + 1;
+		face.mNumVertices++;
+	}
+
+	chunk->mFaces.push_back( face );
+}
+
+// Parses the lines in [\a begin, \a end) into \a chunk. Lines the fast paths can't handle go through std::stringstream as before.
+void parseObjChunk( const char *begin, const char *end, bool includeUVs, ObjChunk *chunk )
+{
+	const char *line = begin;
+	while( line < end ) {
+		const char *endOfLine = line;
+		while( ( endOfLine < end ) && ( *endOfLine != 0x0A ) && ( *endOfLine != 0x0D ) )
+			++endOfLine;
+
+		const char *tag = line;
+		while( ( tag < endOfLine ) && isObjSpace( *tag ) )
+			++tag;
+		const char *endOfTag = tag;
+		while( ( endOfTag < endOfLine ) && ( ! isObjSpace( *endOfTag ) ) )
+			++endOfTag;
+		const size_t tagLength = endOfTag - tag;
+
+		if( ( tagLength == 1 ) && ( tag[0] == 'v' ) ) { // vertex
 			Vec3f v;
-			ss >> v.x >> v.y >> v.z;
-			mVertices.push_back( v );
+			const char *p = endOfTag;
+			if( ! ( parseObjFloat( p, endOfLine, &v.x ) && parseObjFloat( p, endOfLine, &v.y ) && parseObjFloat( p, endOfLine, &v.z ) ) ) {
+				string tagStr;
+				stringstream ss( string( line, endOfLine ) );
+				ss >> tagStr >> v.x >> v.y >> v.z;
+			}
+			chunk->mVertices.push_back( v );
 		}
-		else if( tag == "vt" ) { // vertex texture coordinates
+		else if( ( tagLength == 2 ) && ( tag[0] == 'v' ) && ( tag[1] == 't' ) ) { // vertex texture coordinates
 			if( includeUVs ) {
 				Vec2f tex;
-				ss >> tex.x >> tex.y;
-				mTexCoords.push_back( tex );
+				const char *p = endOfTag;
+				if( ! ( parseObjFloat( p, endOfLine, &tex.x ) && parseObjFloat( p, endOfLine, &tex.y ) ) ) {
+					string tagStr;
+					stringstream ss( string( line, endOfLine ) );
+					ss >> tagStr >> tex.x >> tex.y;
+				}
+				chunk->mTexCoords.push_back( tex );
 			}
 		}
-		else if( tag == "vn" ) { // vertex normals
+		else if( ( tagLength == 2 ) && ( tag[0] == 'v' ) && ( tag[1] == 'n' ) ) { // vertex normals
 			Vec3f v;
-			ss >> v.x >> v.y >> v.z;
-			mNormals.push_back( v.normalized() );
+			const char *p = endOfTag;
+			if( ! ( parseObjFloat( p, endOfLine, &v.x ) && parseObjFloat( p, endOfLine, &v.y ) && parseObjFloat( p, endOfLine, &v.z ) ) ) {
+				string tagStr;
+				stringstream ss( string( line, endOfLine ) );
+				ss >> tagStr >> v.x >> v.y >> v.z;
+			}
+			chunk->mNormals.push_back( v.normalized() );
 		}
-		else if( tag == "f" ) { // face
-			parseFace( currentGroup, line, includeUVs );
+		else if( ( tagLength == 1 ) && ( tag[0] == 'f' ) ) { // face
+			parseObjFace( line, endOfLine, includeUVs, chunk );
 		}
-		else if( tag == "g" ) { // group
-			if( ! currentGroup->mFaces.empty() )
-				mGroups.push_back( Group() );
-			currentGroup = &mGroups[mGroups.size()-1];
-			currentGroup->mBaseVertexOffset = mVertices.size();
-			currentGroup->mBaseTexCoordOffset = mTexCoords.size();
-			currentGroup->mBaseNormalOffset = mNormals.size();
-			currentGroup->mName = line.substr( line.find( ' ' ) + 1 );
+		else if( ( tagLength == 1 ) && ( tag[0] == 'g' ) ) { // group
+			ObjChunk::GroupStart groupStart;
+			groupStart.mFace = chunk->mFaces.size();
+			groupStart.mNumVertices = chunk->mVertices.size();
+			groupStart.mNumTexCoords = chunk->mTexCoords.size();
+			groupStart.mNumNormals = chunk->mNormals.size();
+			const char *space = findObjChar( line, endOfLine, ' ' );
+			groupStart.mName.assign( ( space != endOfLine ) ? space + 1 : line, endOfLine );
+			chunk->mGroupStarts.push_back( groupStart );
 		}
+
+		// CR, LF and CRLF all end a line, as with IStream::readLine()
+		if( ( endOfLine + 1 < end ) && ( endOfLine[0] == 0x0D ) && ( endOfLine[1] == 0x0A ) )
+			line = endOfLine + 2;
+		else
+			line = endOfLine + 1;
 	}
 }
 
-void ObjLoader::parseFace( Group *group, const std::string &s, bool includeUVs )
+struct ParseObjChunks {
+	ParseObjChunks( const char *data, const vector<size_t> &splits, bool includeUVs, vector<ObjChunk> *chunks )
+		: mData( data ), mSplits( splits ), mIncludeUVs( includeUVs ), mChunks( chunks )
+	{}
+
+	void operator()( int32_t begin, int32_t end ) const
+	{
+		for( int32_t c = begin; c < end; ++c ) {
+			try {
+				parseObjChunk( mData + mSplits[c], mData + mSplits[c + 1], mIncludeUVs, &(*mChunks)[c] );
+			}
+			catch( ... ) { // rethrown in order by reparsing on the calling thread
+				(*mChunks)[c].mFailed = true;
+			}
+		}
+	}
+
+	const char				*mData;
+	const vector<size_t>	&mSplits;
+	bool					mIncludeUVs;
+	vector<ObjChunk>		*mChunks;
+};
+
+// Replays the group logic of the original sequential parser over \a chunks in file order, moving their contents into the ObjLoader's arrays
+void mergeObjChunks( vector<ObjChunk> &chunks, vector<Vec3f> *vertices, vector<Vec2f> *texCoords, vector<Vec3f> *normals, vector<ObjLoader::Group> *groups )
 {
-	ObjLoader::Face result;
-	result.mNumVertices = 0;
+	// count the faces of each group up front so that faces are never copied by a reallocation
+	vector<size_t> groupSizes( 1, 0 );
+	size_t numVertices = 0, numTexCoords = 0, numNormals = 0;
+	for( vector<ObjChunk>::const_iterator chunkIt = chunks.begin(); chunkIt != chunks.end(); ++chunkIt ) {
+		size_t face = 0;
+		for( vector<ObjChunk::GroupStart>::const_iterator startIt = chunkIt->mGroupStarts.begin(); startIt != chunkIt->mGroupStarts.end(); ++startIt ) {
+			groupSizes.back() += startIt->mFace - face;
+			face = startIt->mFace;
+			if( groupSizes.back() )
+				groupSizes.push_back( 0 );
+		}
+		groupSizes.back() += chunkIt->mFaces.size() - face;
+		numVertices += chunkIt->mVertices.size();
+		numTexCoords += chunkIt->mTexCoords.size();
+		numNormals += chunkIt->mNormals.size();
+	}
+	vertices->reserve( numVertices );
+	texCoords->reserve( numTexCoords );
+	normals->reserve( numNormals );
+	groups->reserve( groupSizes.size() );
 
-	size_t offset = 2; // account for "f "
-	size_t length = s.length();
-	while( offset < length ) {
-		size_t endOfTriple, firstSlashOffset, secondSlashOffset;
-	
-		// find the end of this triple "v/vt/vn"
-		endOfTriple = s.find( ' ', offset );
-		if( endOfTriple == string::npos ) endOfTriple = length;
-		firstSlashOffset = s.find( '/', offset );
-		if( firstSlashOffset != string::npos ) {
-			secondSlashOffset = s.find( '/', firstSlashOffset + 1 );
-			if( secondSlashOffset > endOfTriple ) secondSlashOffset = string::npos;
+	groups->push_back( ObjLoader::Group() );
+	ObjLoader::Group *currentGroup = &groups->back();
+	currentGroup->mBaseVertexOffset = currentGroup->mBaseTexCoordOffset = currentGroup->mBaseNormalOffset = 0;
+	currentGroup->mFaces.reserve( groupSizes[0] );
+
+	for( vector<ObjChunk>::iterator chunkIt = chunks.begin(); chunkIt != chunks.end(); ++chunkIt ) {
+		vector<ObjChunk::GroupStart>::iterator startIt = chunkIt->mGroupStarts.begin();
+		vector<ObjChunk::Fixup>::const_iterator fixupIt = chunkIt->mFixups.begin();
+		const int *indices[3] = { 0, 0, 0 };
+		for( int i = 0; i < 3; ++i )
+			indices[i] = ( chunkIt->mIndices[i].empty() ) ? 0 : &chunkIt->mIndices[i][0];
+		for( size_t f = 0; ; ++f ) {
+			for( ; ( startIt != chunkIt->mGroupStarts.end() ) && ( startIt->mFace == f ); ++startIt ) {
+				if( ! currentGroup->mFaces.empty() ) {
+					groups->push_back( ObjLoader::Group() );
+					currentGroup = &groups->back();
+					currentGroup->mFaces.reserve( groupSizes[groups->size() - 1] );
+				}
+				currentGroup->mBaseVertexOffset = vertices->size() + startIt->mNumVertices;
+				currentGroup->mBaseTexCoordOffset = texCoords->size() + startIt->mNumTexCoords;
+				currentGroup->mBaseNormalOffset = normals->size() + startIt->mNumNormals;
+				currentGroup->mName.swap( startIt->mName );
+			}
+			if( f == chunkIt->mFaces.size() )
+				break;
+
+			const int groupBases[3] = { currentGroup->mBaseVertexOffset, currentGroup->mBaseTexCoordOffset, currentGroup->mBaseNormalOffset };
+			for( ; ( fixupIt != chunkIt->mFixups.end() ) && ( fixupIt->mFace == f ); ++fixupIt )
+				chunkIt->mIndices[fixupIt->mIndexArray][fixupIt->mIndex] = groupBases[fixupIt->mIndexArray] + fixupIt->mRelativeIndex;
+
+			const ObjChunk::FaceSize &size = chunkIt->mFaces[f];
+			if( ( size.mNumVertices > 0 ) && currentGroup->mFaces.empty() ) { // the first face of a group decides, by its last vertex
+				currentGroup->mHasTexCoords = ( size.mFlags & FACE_LAST_HAS_TEX_COORD ) != 0;
+				currentGroup->mHasNormals = ( size.mFlags & FACE_LAST_HAS_NORMAL ) != 0;
+			}
+			else if( size.mNumVertices > 0 ) {
+				if( size.mFlags & FACE_ANY_EMPTY_TEX_COORD )
+					currentGroup->mHasTexCoords = false;
+				if( size.mFlags & FACE_ANY_HAS_NORMAL )
+					currentGroup->mHasNormals = true;
+			}
+
+			currentGroup->mFaces.push_back( ObjLoader::Face() );
+			ObjLoader::Face &face = currentGroup->mFaces.back();
+			face.mNumVertices = size.mNumVertices;
+			face.mVertexIndices.assign( indices[0], indices[0] + size.mNumVertices );
+			face.mTexCoordIndices.assign( indices[1], indices[1] + size.mNumTexCoords );
+			face.mNormalIndices.assign( indices[2], indices[2] + size.mNumNormals );
+			indices[0] += size.mNumVertices;
+			indices[1] += size.mNumTexCoords;
+			indices[2] += size.mNumNormals;
 		}
-		else
-			secondSlashOffset = string::npos;
-		
-		// process the vertex index
-		int vertexIndex = lexical_cast<int>( s.substr( offset, firstSlashOffset - offset ) );
-		if( vertexIndex < 0 )
-			result.mVertexIndices.push_back( group->mBaseVertexOffset + vertexIndex );
-		else
-			result.mVertexIndices.push_back( vertexIndex - 1 );
-			
-		// process the tex coord index
-		if( includeUVs && ( firstSlashOffset != string::npos ) ) {
-			size_t numSize = ( secondSlashOffset == string::npos ) ? ( endOfTriple - firstSlashOffset - 1 ) : secondSlashOffset - firstSlashOffset - 1;
-			if( numSize > 0 ) {
-				int texCoordIndex = lexical_cast<int>( s.substr( firstSlashOffset + 1, numSize ) );
-				if( texCoordIndex < 0 )
-					result.mTexCoordIndices.push_back( group->mBaseTexCoordOffset + texCoordIndex );
-				else
-					result.mTexCoordIndices.push_back( texCoordIndex - 1 );
-				if( group->mFaces.empty() )
-					group->mHasTexCoords = true;
+
+		vertices->insert( vertices->end(), chunkIt->mVertices.begin(), chunkIt->mVertices.end() );
+		texCoords->insert( texCoords->end(), chunkIt->mTexCoords.begin(), chunkIt->mTexCoords.end() );
+		normals->insert( normals->end(), chunkIt->mNormals.begin(), chunkIt->mNormals.end() );
+		*chunkIt = ObjChunk();
+	}
+}
+
+// Estimates the number of unique vertices in \a group, which can't exceed its number of corners and is usually close to the size of the largest attribute array
+size_t estimateUniqueVertices( const ObjLoader::Group &group, size_t numVertices, size_t numTexCoords, size_t numNormals )
+{
+	size_t numCorners = 0;
+	for( vector<ObjLoader::Face>::const_iterator faceIt = group.mFaces.begin(); faceIt != group.mFaces.end(); ++faceIt )
+		numCorners += faceIt->mNumVertices;
+	return std::min( numCorners, std::max( numVertices, std::max( numTexCoords, numNormals ) ) );
+}
+
+} // anonymous namespace
+
+//! Open addressing hash table from a vertex's (position, tex coord, normal) indices to its index in the destination TriMesh
+class ObjLoader::VertexTable {
+  public:
+	struct Entry {
+		int		mKey[3];
+		int		mValue; // negative for an empty slot
+	};
+
+	//! Sizes the table to hold \a expectedSize entries without growing
+	explicit VertexTable( size_t expectedSize = 0 )
+		: mSize( 0 )
+	{
+		size_t capacity = 16;
+		while( capacity < expectedSize * 2 )
+			capacity *= 2;
+		allocate( capacity );
+	}
+
+	//! Returns the value for the key ( \a a, \a b, \a c ). If the key is new \a value is inserted and returned and \a inserted is set to \c true.
+	int insert( int a, int b, int c, int value, bool *inserted )
+	{
+		if( ( mSize + 1 ) * 2 > mEntries.size() )
+			grow();
+
+		size_t slot = hash( a, b, c ) & mMask;
+		while( true ) {
+			Entry &entry = mEntries[slot];
+			if( entry.mValue < 0 ) {
+				entry.mKey[0] = a; entry.mKey[1] = b; entry.mKey[2] = c;
+				entry.mValue = value;
+				++mSize;
+				*inserted = true;
+				return value;
 			}
-			else
-				group->mHasTexCoords = false;
+			else if( ( entry.mKey[0] == a ) && ( entry.mKey[1] == b ) && ( entry.mKey[2] == c ) ) {
+				*inserted = false;
+				return entry.mValue;
+			}
+			slot = ( slot + 1 ) & mMask;
 		}
-		else if( group->mFaces.empty() ) // if this is the first face, let's note that this group has no tex coords
-			group->mHasTexCoords = false;
-			
-		// process the normal index
-		if( secondSlashOffset != string::npos ) {
-			int normalIndex = lexical_cast<int>( s.substr( secondSlashOffset + 1, endOfTriple - secondSlashOffset - 1 ) );
-			if( normalIndex < 0 )
-				result.mNormalIndices.push_back( group->mBaseNormalOffset + normalIndex );
-			else
-				result.mNormalIndices.push_back( normalIndex - 1 );
-			group->mHasNormals = true;
+	}
+
+	int insert( const int key[3], int value, bool *inserted ) { return insert( key[0], key[1], key[2], value, inserted ); }
+
+	size_t	size() const { return mSize; }
+
+	//! Sets \a entriesByValue[value] to the entry holding each value. \a entriesByValue must have room for the largest value.
+	void getEntries( const Entry **entriesByValue ) const
+	{
+		for( vector<Entry>::const_iterator entryIt = mEntries.begin(); entryIt != mEntries.end(); ++entryIt ) {
+			if( entryIt->mValue >= 0 )
+				entriesByValue[entryIt->mValue] = &*entryIt;
 		}
-		else if( group->mFaces.empty() ) // if this is the first face, let's note that this group has no normals
-			group->mHasNormals = false;
-		
-		offset = endOfTriple + 1;
-		result.mNumVertices++;
 	}
-	
-	group->mFaces.push_back( result );
+
+  private:
+	static size_t hash( int a, int b, int c )
+	{
+		uint32_t h = static_cast<uint32_t>( a ) * 0x9E3779B1U ^ static_cast<uint32_t>( b ) * 0x85EBCA77U ^ static_cast<uint32_t>( c ) * 0xC2B2AE3DU;
+		h ^= h >> 16;
+		h *= 0x85EBCA6BU;
+		h ^= h >> 13;
+		h *= 0xC2B2AE35U;
+		h ^= h >> 16;
+		return h;
+	}
+
+	void allocate( size_t capacity )
+	{
+		Entry empty = { { 0, 0, 0 }, -1 };
+		mEntries.assign( capacity, empty );
+		mMask = capacity - 1;
+	}
+
+	void grow()
+	{
+		vector<Entry> entries;
+		entries.swap( mEntries );
+		allocate( entries.size() * 2 );
+		mSize = 0;
+		bool inserted;
+		for( vector<Entry>::const_iterator entryIt = entries.begin(); entryIt != entries.end(); ++entryIt ) {
+			if( entryIt->mValue >= 0 )
+				insert( entryIt->mKey, entryIt->mValue, &inserted );
+		}
+	}
+
+	vector<Entry>	mEntries;
+	size_t			mMask, mSize;
+};
+
+//! Optimizes the groups of a band into their own TriMesh and VertexTable, for ObjLoader::loadParallelOptimize()
+struct ObjLoader::GroupLoader {
+	GroupLoader( ObjLoader *loader, bool texCoords, bool normals, vector<TriMesh> *groupMeshes, vector<VertexTable> *groupVerts )
+		: mLoader( loader ), mTexCoords( texCoords ), mNormals( normals ), mGroupMeshes( groupMeshes ), mGroupVerts( groupVerts )
+	{}
+
+	void operator()( int32_t begin, int32_t end ) const
+	{
+		for( int32_t g = begin; g < end; ++g ) {
+			const Group &group = mLoader->mGroups[g];
+			(*mGroupVerts)[g] = VertexTable( estimateUniqueVertices( group, mLoader->mVertices.size(), ( mTexCoords ) ? mLoader->mTexCoords.size() : 0,
+																		( mNormals ) ? mLoader->mNormals.size() : 0 ) );
+			mLoader->loadInternalOptimize( group, (*mGroupVerts)[g], &(*mGroupMeshes)[g], mTexCoords, mNormals );
+		}
+	}
+
+	ObjLoader				*mLoader;
+	bool					mTexCoords, mNormals;
+	vector<TriMesh>			*mGroupMeshes;
+	vector<VertexTable>		*mGroupVerts;
+};
+
+ObjLoader::ObjLoader( shared_ptr<IStream> stream, bool includeUVs )
+	: mStream( stream )
+{
+	parse( includeUVs );
+}
+
+ObjLoader::ObjLoader( DataSourceRef dataSource, bool includeUVs )
+	: mStream( dataSource->createStream() )
+{
+	parse( includeUVs );
+}
+
+ObjLoader::~ObjLoader()
+{
+}
+
+void ObjLoader::parse( bool includeUVs )
+{
+	// memory streams, including mapped files, are parsed in place; anything else is read into memory first
+	const char *data;
+	size_t dataSize;
+	vector<char> buffer;
+	if( IStreamMem *memStream = dynamic_cast<IStreamMem*>( mStream.get() ) ) {
+		data = reinterpret_cast<const char*>( memStream->getData() ) + memStream->tell();
+		dataSize = static_cast<size_t>( memStream->size() - memStream->tell() );
+		memStream->seekAbsolute( memStream->size() );
+	}
+	else {
+		const size_t blockSize = 1024 * 1024;
+		for( size_t bytesRead = blockSize; bytesRead == blockSize; ) {
+			size_t offset = buffer.size();
+			buffer.resize( offset + blockSize );
+			bytesRead = mStream->readDataAvailable( &buffer[offset], blockSize );
+			buffer.resize( offset + bytesRead );
+		}
+		data = ( buffer.empty() ) ? 0 : &buffer[0];
+		dataSize = buffer.size();
+	}
+
+	// split into chunks that each begin at the start of a line; a CRLF straddling a split only adds an empty line
+	const size_t numChunks = std::max<size_t>( 1, std::min<size_t>( ip::resolveNumThreads( 0 ), dataSize / MIN_CHUNK_SIZE ) );
+	vector<size_t> splits( 1, 0 );
+	for( size_t c = 1; c < numChunks; ++c ) {
+		size_t split = std::max( splits.back(), static_cast<size_t>( static_cast<uint64_t>( dataSize ) * c / numChunks ) );
+		while( ( split < dataSize ) && ( data[split] != 0x0A ) && ( data[split] != 0x0D ) )
+			++split;
+		splits.push_back( std::min( split + 1, dataSize ) );
+	}
+	splits.push_back( dataSize );
+
+	vector<ObjChunk> chunks( numChunks );
+	if( numChunks == 1 )
+		parseObjChunk( data, data + dataSize, includeUVs, &chunks[0] );
+	else {
+		ip::parallelRows( 0, (int32_t)numChunks, (int32_t)numChunks, ParseObjChunks( data, splits, includeUVs, &chunks ) );
+		for( size_t c = 0; c < numChunks; ++c ) {
+			if( chunks[c].mFailed ) { // the first failure in file order is the one the sequential parser would have thrown
+				chunks[c] = ObjChunk();
+				parseObjChunk( data + splits[c], data + splits[c + 1], includeUVs, &chunks[c] );
+			}
+		}
+	}
+
+	mergeObjChunks( chunks, &mVertices, &mTexCoords, &mNormals, &mGroups );
 }
 
 void ObjLoader::load( size_t groupIndex, TriMesh *destTriMesh, boost::tribool loadNormals, boost::tribool loadTexCoords, bool optimizeVertices )
@@ -176,23 +628,10 @@ void ObjLoader::load( size_t groupIndex, TriMesh *destTriMesh, boost::tribool lo
 	if( ! optimizeVertices ) {
 		loadInternalNoOptimize( mGroups[groupIndex], destTriMesh, texCoords, normals );
 	}
-	else if( normals && texCoords ) {
-		map<VertexTriple,int> uniqueVerts;
-		loadInternalNormalsTextures( mGroups[groupIndex], uniqueVerts, destTriMesh );
-	}
-	else if( normals ) {
-		map<VertexPair,int> uniqueVerts;
-		loadInternalNormals( mGroups[groupIndex], uniqueVerts, destTriMesh );
-	}
-	else if( texCoords ) {
-		map<VertexPair,int> uniqueVerts;
-		loadInternalTextures( mGroups[groupIndex], uniqueVerts, destTriMesh );
-	}
 	else {
-		map<int,int> uniqueVerts;
-		loadInternal( mGroups[groupIndex], uniqueVerts, destTriMesh );
+		VertexTable uniqueVerts( estimateUniqueVertices( mGroups[groupIndex], mVertices.size(), ( texCoords ) ? mTexCoords.size() : 0, ( normals ) ? mNormals.size() : 0 ) );
+		loadInternalOptimize( mGroups[groupIndex], uniqueVerts, destTriMesh, texCoords, normals );
 	}
-
 }
 
 void ObjLoader::load( TriMesh *destTriMesh, boost::tribool loadNormals, boost::tribool loadTexCoords, bool optimizeVertices )
@@ -229,25 +668,75 @@ void ObjLoader::load( TriMesh *destTriMesh, boost::tribool loadNormals, boost::t
 			loadInternalNoOptimize( *groupIt, destTriMesh, texCoords, normals );
 		}	
 	}
-	else if( normals && texCoords ) {
-		map<VertexTriple,int> uniqueVerts;
-		for( vector<Group>::const_iterator groupIt = mGroups.begin(); groupIt != mGroups.end(); ++groupIt )
-			loadInternalNormalsTextures( *groupIt, uniqueVerts, destTriMesh );
+	else if( ( mGroups.size() > 1 ) && ( ip::resolveNumThreads( 0 ) > 1 ) ) {
+		loadParallelOptimize( destTriMesh, texCoords, normals );
 	}
-	else if( normals ) {
-		map<VertexPair,int> uniqueVerts;
+	else {
+		size_t expectedSize = 0;
 		for( vector<Group>::const_iterator groupIt = mGroups.begin(); groupIt != mGroups.end(); ++groupIt )
-			loadInternalNormals( *groupIt, uniqueVerts, destTriMesh );
-	}
-	else if( texCoords ) {
-		map<VertexPair,int> uniqueVerts;
+			expectedSize += estimateUniqueVertices( *groupIt, mVertices.size(), ( texCoords ) ? mTexCoords.size() : 0, ( normals ) ? mNormals.size() : 0 );
+		VertexTable uniqueVerts( expectedSize );
 		for( vector<Group>::const_iterator groupIt = mGroups.begin(); groupIt != mGroups.end(); ++groupIt )
-			loadInternalTextures( *groupIt, uniqueVerts, destTriMesh );
+			loadInternalOptimize( *groupIt, uniqueVerts, destTriMesh, texCoords, normals );
 	}
-	else {
-		map<int,int> uniqueVerts;
-		for( vector<Group>::const_iterator groupIt = mGroups.begin(); groupIt != mGroups.end(); ++groupIt )
-			loadInternal( *groupIt, uniqueVerts, destTriMesh );
+}
+
+void ObjLoader::loadInternalOptimize( const Group &group, VertexTable &uniqueVerts, TriMesh *destTriMesh, bool texCoords, bool normals )
+{
+	if( normals && texCoords )
+		loadInternalNormalsTextures( group, uniqueVerts, destTriMesh );
+	else if( normals )
+		loadInternalNormals( group, uniqueVerts, destTriMesh );
+	else if( texCoords )
+		loadInternalTextures( group, uniqueVerts, destTriMesh );
+	else
+		loadInternal( group, uniqueVerts, destTriMesh );
+}
+
+// Optimizes each group into its own TriMesh concurrently, then merges them in order. Only each group's unique vertices go through the
+// shared table, which assigns the same indices a sequential load would have, since a group's vertices are numbered in order of first use.
+void ObjLoader::loadParallelOptimize( TriMesh *destTriMesh, bool texCoords, bool normals )
+{
+	const size_t numGroups = mGroups.size();
+	vector<TriMesh> groupMeshes( numGroups );
+	vector<VertexTable> groupVerts( numGroups );
+	ip::parallelRows( 0, (int32_t)numGroups, 0, GroupLoader( this, texCoords, normals, &groupMeshes, &groupVerts ) );
+
+	size_t expectedSize = 0;
+	for( size_t g = 0; g < numGroups; ++g )
+		expectedSize += groupVerts[g].size();
+	VertexTable uniqueVerts( expectedSize );
+
+	vector<const VertexTable::Entry*> entries;
+	vector<size_t> remap;
+	for( size_t g = 0; g < numGroups; ++g ) {
+		const TriMesh &groupMesh = groupMeshes[g];
+		const size_t numVertices = groupMesh.getNumVertices();
+		entries.assign( numVertices, 0 );
+		if( numVertices > 0 )
+			groupVerts[g].getEntries( &entries[0] );
+		remap.resize( numVertices );
+		for( size_t v = 0; v < numVertices; ++v ) {
+			bool inserted = true;
+			if( entries[v] ) // vertices without an entry were forced to be unique
+				remap[v] = uniqueVerts.insert( entries[v]->mKey, (int)destTriMesh->getNumVertices(), &inserted );
+			else
+				remap[v] = destTriMesh->getNumVertices();
+			if( inserted ) {
+				destTriMesh->appendVertex( groupMesh.getVertices()[v] );
+				if( normals )
+					destTriMesh->appendNormal( groupMesh.getNormals()[v] );
+				if( texCoords )
+					destTriMesh->appendTexCoord( groupMesh.getTexCoords()[v] );
+			}
+		}
+
+		const vector<size_t> &indices = groupMesh.getIndices();
+		for( size_t i = 0; i + 2 < indices.size(); i += 3 )
+			destTriMesh->appendTriangle( remap[indices[i]], remap[indices[i + 1]], remap[indices[i + 2]] );
+
+		groupMeshes[g].clear();
+		groupVerts[g] = VertexTable();
 	}
 }
 
@@ -285,7 +774,7 @@ void ObjLoader::loadInternalNoOptimize( const Group &group, TriMesh *destTriMesh
 	}	
 }
 
-void ObjLoader::loadInternalNormalsTextures( const Group &group, map<VertexTriple,int> &uniqueVerts, TriMesh *destTriMesh )
+void ObjLoader::loadInternalNormalsTextures( const Group &group, VertexTable &uniqueVerts, TriMesh *destTriMesh )
 {
 	for( size_t f = 0; f < group.mFaces.size(); ++f ) {
 		Vec3f inferredNormal;
@@ -304,15 +793,15 @@ void ObjLoader::loadInternalNormalsTextures( const Group &group, map<VertexTripl
 		faceIndices.reserve( group.mFaces[f].mNumVertices );
 		for( int v = 0; v < group.mFaces[f].mNumVertices; ++v ) {
 			if( ! forceUnique ) {
-				VertexTriple triple = make_tuple( group.mFaces[f].mVertexIndices[v], group.mFaces[f].mTexCoordIndices[v], group.mFaces[f].mNormalIndices[v] );
-				pair<map<VertexTriple,int>::iterator,bool> result = uniqueVerts.insert( make_pair( triple, destTriMesh->getVertices().size() ) );
-				if( result.second ) { // we've got a new, unique vertex here, so let's append it
+				bool inserted;
+				int vertex = uniqueVerts.insert( group.mFaces[f].mVertexIndices[v], group.mFaces[f].mTexCoordIndices[v], group.mFaces[f].mNormalIndices[v], (int)destTriMesh->getVertices().size(), &inserted );
+				if( inserted ) { // we've got a new, unique vertex here, so let's append it
 					destTriMesh->appendVertex( mVertices[group.mFaces[f].mVertexIndices[v]] );
 					destTriMesh->appendNormal( mNormals[group.mFaces[f].mNormalIndices[v]] );
 					destTriMesh->appendTexCoord( mTexCoords[group.mFaces[f].mTexCoordIndices[v]] );
 				}
 				// the unique ID of the vertex is appended for this vert
-				faceIndices.push_back( result.first->second );
+				faceIndices.push_back( vertex );
 			}
 			else { // have to force unique because this group lacks either normals or texCoords
 				faceIndices.push_back( destTriMesh->getVertices().size() );
@@ -336,7 +825,7 @@ void ObjLoader::loadInternalNormalsTextures( const Group &group, map<VertexTripl
 	}	
 }
 
-void ObjLoader::loadInternalNormals( const Group &group, map<VertexPair,int> &uniqueVerts, TriMesh *destTriMesh )
+void ObjLoader::loadInternalNormals( const Group &group, VertexTable &uniqueVerts, TriMesh *destTriMesh )
 {
 	for( size_t f = 0; f < group.mFaces.size(); ++f ) {
 		Vec3f inferredNormal;
@@ -352,14 +841,14 @@ void ObjLoader::loadInternalNormals( const Group &group, map<VertexPair,int> &un
 		faceIndices.reserve( group.mFaces[f].mNumVertices );
 		for( int v = 0; v < group.mFaces[f].mNumVertices; ++v ) {
 			if( ! forceUnique ) {
-				VertexPair triple = make_tuple( group.mFaces[f].mVertexIndices[v], group.mFaces[f].mNormalIndices[v] );
-				pair<map<VertexPair,int>::iterator,bool> result = uniqueVerts.insert( make_pair( triple, destTriMesh->getVertices().size() ) );
-				if( result.second ) { // we've got a new, unique vertex here, so let's append it
+				bool inserted;
+				int vertex = uniqueVerts.insert( group.mFaces[f].mVertexIndices[v], 0, group.mFaces[f].mNormalIndices[v], (int)destTriMesh->getVertices().size(), &inserted );
+				if( inserted ) { // we've got a new, unique vertex here, so let's append it
 					destTriMesh->appendVertex( mVertices[group.mFaces[f].mVertexIndices[v]] );
 					destTriMesh->appendNormal( mNormals[group.mFaces[f].mNormalIndices[v]] );
 				}
 				// the unique ID of the vertex is appended for this vert
-				faceIndices.push_back( result.first->second );
+				faceIndices.push_back( vertex );
 			}
 			else { // have to force unique because this group lacks normals
 				faceIndices.push_back( destTriMesh->getVertices().size() );
@@ -379,7 +868,7 @@ void ObjLoader::loadInternalNormals( const Group &group, map<VertexPair,int> &un
 	}	
 }
 
-void ObjLoader::loadInternalTextures( const Group &group, map<VertexPair,int> &uniqueVerts, TriMesh *destTriMesh )
+void ObjLoader::loadInternalTextures( const Group &group, VertexTable &uniqueVerts, TriMesh *destTriMesh )
 {
 	for( size_t f = 0; f < group.mFaces.size(); ++f ) {
 		bool forceUnique = false;
@@ -390,14 +879,14 @@ void ObjLoader::loadInternalTextures( const Group &group, map<VertexPair,int> &u
 		faceIndices.reserve( group.mFaces[f].mNumVertices );
 		for( int v = 0; v < group.mFaces[f].mNumVertices; ++v ) {
 			if( ! forceUnique ) {
-				VertexPair triple = make_tuple( group.mFaces[f].mVertexIndices[v], group.mFaces[f].mTexCoordIndices[v] );
-				pair<map<VertexPair,int>::iterator,bool> result = uniqueVerts.insert( make_pair( triple, destTriMesh->getVertices().size() ) );
-				if( result.second ) { // we've got a new, unique vertex here, so let's append it
+				bool inserted;
+				int vertex = uniqueVerts.insert( group.mFaces[f].mVertexIndices[v], group.mFaces[f].mTexCoordIndices[v], 0, (int)destTriMesh->getVertices().size(), &inserted );
+				if( inserted ) { // we've got a new, unique vertex here, so let's append it
 					destTriMesh->appendVertex( mVertices[group.mFaces[f].mVertexIndices[v]] );
 					destTriMesh->appendTexCoord( mTexCoords[group.mFaces[f].mTexCoordIndices[v]] );
 				}
 				// the unique ID of the vertex is appended for this vert
-				faceIndices.push_back( result.first->second );
+				faceIndices.push_back( vertex );
 			}
 			else { // have to force unique because this group lacks texCoords
 				faceIndices.push_back( destTriMesh->getVertices().size() );
@@ -417,18 +906,19 @@ void ObjLoader::loadInternalTextures( const Group &group, map<VertexPair,int> &u
 	}	
 }
 
-void ObjLoader::loadInternal( const Group &group, map<int,int> &uniqueVerts, TriMesh *destTriMesh )
+void ObjLoader::loadInternal( const Group &group, VertexTable &uniqueVerts, TriMesh *destTriMesh )
 {
 	for( size_t f = 0; f < group.mFaces.size(); ++f ) {
 		vector<int> faceIndices;
 		faceIndices.reserve( group.mFaces[f].mNumVertices );
 		for( int v = 0; v < group.mFaces[f].mNumVertices; ++v ) {
-			pair<map<int,int>::iterator,bool> result = uniqueVerts.insert( make_pair( group.mFaces[f].mVertexIndices[v], destTriMesh->getVertices().size() ) );
-			if( result.second ) { // we've got a new, unique vertex here, so let's append it
+			bool inserted;
+			int vertex = uniqueVerts.insert( group.mFaces[f].mVertexIndices[v], 0, 0, (int)destTriMesh->getVertices().size(), &inserted );
+			if( inserted ) { // we've got a new, unique vertex here, so let's append it
 				destTriMesh->appendVertex( mVertices[group.mFaces[f].mVertexIndices[v]] );
 			}
 			// the unique ID of the vertex is appended for this vert
-			faceIndices.push_back( result.first->second );
+			faceIndices.push_back( vertex );
 		}
 
 		int triangles = faceIndices.size() - 2;
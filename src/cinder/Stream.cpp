@@ -29,6 +29,14 @@
 #include <boost/scoped_array.hpp>
 #include <iostream>
 #include <boost/preprocessor/seq/for_each.hpp>
+#if defined( CINDER_MSW )
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
 using std::string;
 
 namespace cinder {
@@ -75,7 +83,7 @@ void IStream::readBig( T *t )
 #ifdef BOOST_BIG_ENDIAN
 	read( t );
 #else
-	IORead( &t, sizeof(T) );
+	IORead( t, sizeof(T) );
 	*t = swapEndian( *t );
 #endif
 }
@@ -86,7 +94,7 @@ void IStream::readLittle( T *t )
 #ifdef CINDER_LITTLE_ENDIAN
 	read( t );
 #else
-	IORead( &t, sizeof(T) );
+	IORead( t, sizeof(T) );
 	*t = swapEndian( *t );
 #endif
 }
@@ -461,6 +469,114 @@ void IStreamMem::IORead( void *t, size_t size )
 	mOffset += size;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////
+// IStreamMapped
+struct IStreamMapped::Mapping {
+	Mapping( const std::string &path );
+	~Mapping();
+
+	const uint8_t	*mData;
+	size_t			mDataSize;
+#if defined( CINDER_MSW )
+	HANDLE			mFile, mFileMapping;
+#endif
+};
+
+#if defined( CINDER_MSW )
+IStreamMapped::Mapping::Mapping( const std::string &path )
+	: mData( 0 ), mDataSize( 0 ), mFileMapping( NULL )
+{
+	mFile = ::CreateFileA( path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+	if( mFile == INVALID_HANDLE_VALUE )
+		throw StreamExc();
+
+	LARGE_INTEGER fileSize;
+	if( ( ! ::GetFileSizeEx( mFile, &fileSize ) ) || ( (uint64_t)fileSize.QuadPart > std::numeric_limits<size_t>::max() ) ) {
+		::CloseHandle( mFile );
+		throw StreamExc();
+	}
+	mDataSize = static_cast<size_t>( fileSize.QuadPart );
+	if( mDataSize == 0 ) // empty files can't be mapped, but they are valid streams
+		return;
+
+	mFileMapping = ::CreateFileMapping( mFile, NULL, PAGE_READONLY, 0, 0, NULL );
+	if( mFileMapping )
+		mData = reinterpret_cast<const uint8_t*>( ::MapViewOfFile( mFileMapping, FILE_MAP_READ, 0, 0, 0 ) );
+	if( ! mData ) {
+		if( mFileMapping )
+			::CloseHandle( mFileMapping );
+		::CloseHandle( mFile );
+		throw StreamExc();
+	}
+}
+
+IStreamMapped::Mapping::~Mapping()
+{
+	if( mData )
+		::UnmapViewOfFile( mData );
+	if( mFileMapping )
+		::CloseHandle( mFileMapping );
+	::CloseHandle( mFile );
+}
+#else
+IStreamMapped::Mapping::Mapping( const std::string &path )
+	: mData( 0 ), mDataSize( 0 )
+{
+	int fd = ::open( path.c_str(), O_RDONLY );
+	if( fd < 0 )
+		throw StreamExc();
+
+	struct stat info;
+	if( ( ::fstat( fd, &info ) != 0 ) || ( (uint64_t)info.st_size > std::numeric_limits<size_t>::max() ) ) {
+		::close( fd );
+		throw StreamExc();
+	}
+	mDataSize = static_cast<size_t>( info.st_size );
+
+	if( mDataSize > 0 ) { // empty files can't be mapped, but they are valid streams
+		void *data = ::mmap( 0, mDataSize, PROT_READ, MAP_PRIVATE, fd, 0 );
+		if( data == MAP_FAILED ) {
+			::close( fd );
+			throw StreamExc();
+		}
+		::madvise( data, mDataSize, MADV_SEQUENTIAL );
+		mData = reinterpret_cast<const uint8_t*>( data );
+	}
+
+	// the mapping keeps its own reference to the file
+	::close( fd );
+}
+
+IStreamMapped::Mapping::~Mapping()
+{
+	if( mData )
+		::munmap( const_cast<uint8_t*>( mData ), mDataSize );
+}
+#endif
+
+IStreamMappedRef IStreamMapped::createRef( const std::string &path )
+{
+	IStreamMappedRef result( new IStreamMapped( std::shared_ptr<Mapping>( new Mapping( path ) ) ) );
+	result->setFileName( path );
+	return result;
+}
+
+IStreamMappedRef IStreamMapped::createRef( const IStreamMappedRef &stream )
+{
+	IStreamMappedRef result( new IStreamMapped( stream->mMapping ) );
+	result->setFileName( stream->getFileName() );
+	return result;
+}
+
+IStreamMapped::IStreamMapped( const std::shared_ptr<Mapping> &mapping )
+	: IStreamMem( mapping->mData, mapping->mDataSize ), mMapping( mapping )
+{
+}
+
+IStreamMapped::~IStreamMapped()
+{
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////
 // OStreamMem
 OStreamMem::OStreamMem( size_t bufferSizeHint )
@@ -515,6 +631,11 @@ IStreamFileRef loadFileStream( const std::string &path )
 		return IStreamFileRef();
 }
 
+IStreamMappedRef loadFileStreamMapped( const std::string &path )
+{
+	return IStreamMapped::createRef( path );
+}
+
 std::shared_ptr<OStreamFile> writeFileStream( const std::string &path, bool createParents )
 {
 	if( createParents ) {
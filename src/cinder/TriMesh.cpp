@@ -21,6 +21,11 @@
 */
 
 #include "cinder/TriMesh.h"
+#include "cinder/CinderMath.h"
+#include "cinder/Utilities.h"
+
+#include <boost/static_assert.hpp>
+#include <limits>
 
 using std::vector;
 
@@ -107,72 +112,416 @@ AxisAlignedBox3f TriMesh::calcBoundingBox( const Matrix44f &transform ) const
 }
 
 
+// attribute blocks are read and written directly as arrays of these
+BOOST_STATIC_ASSERT( sizeof( Vec3f ) == 3 * sizeof( float ) && sizeof( Vec2f ) == 2 * sizeof( float ) );
+
+namespace {
+
+// Version 2 begins with this 64 byte header, followed by the vertex, normal, tex coord and index blocks, each starting on a 16 byte boundary.
+// Every multibyte value, in the header and the blocks, is little-endian.
+struct TriMeshHeader {
+	uint8_t		mVersion;
+	uint8_t		mFlags;
+	uint8_t		mIndexSize;
+	uint8_t		mReserved;
+	uint32_t	mNumVertices, mNumNormals, mNumTexCoords, mNumIndices;
+	float		mTexCoordMin[2], mTexCoordMax[2];
+	uint8_t		mPadding[28];
+};
+
+BOOST_STATIC_ASSERT( sizeof( TriMeshHeader ) == 64 );
+
+enum { QUANTIZED_NORMALS = 0x01, QUANTIZED_TEX_COORDS = 0x02 };
+
+// Byte offsets of each block from the start of the header, and of the end of the last one
+struct TriMeshLayout {
+	TriMeshLayout( const TriMeshHeader &header )
+	{
+		mVertices = sizeof( TriMeshHeader );
+		mNormals = align( mVertices + uint64_t( header.mNumVertices ) * sizeof( Vec3f ) );
+		mTexCoords = align( mNormals + uint64_t( header.mNumNormals ) * ( ( header.mFlags & QUANTIZED_NORMALS ) ? 2 * sizeof( int16_t ) : sizeof( Vec3f ) ) );
+		mIndices = align( mTexCoords + uint64_t( header.mNumTexCoords ) * ( ( header.mFlags & QUANTIZED_TEX_COORDS ) ? 2 * sizeof( uint16_t ) : sizeof( Vec2f ) ) );
+		mEnd = mIndices + uint64_t( header.mNumIndices ) * header.mIndexSize;
+	}
+
+	static uint64_t align( uint64_t offset ) { return ( offset + 15 ) & ~uint64_t( 15 ); }
+
+	uint64_t	mVertices, mNormals, mTexCoords, mIndices, mEnd;
+};
+
+#if ! defined( CINDER_LITTLE_ENDIAN )
+// Converts the multibyte fields of \a header between little-endian and the host's byte order
+void swapHeader( TriMeshHeader *header )
+{
+	header->mNumVertices = swapEndian( header->mNumVertices );
+	header->mNumNormals = swapEndian( header->mNumNormals );
+	header->mNumTexCoords = swapEndian( header->mNumTexCoords );
+	header->mNumIndices = swapEndian( header->mNumIndices );
+	for( int i = 0; i < 2; ++i ) {
+		header->mTexCoordMin[i] = swapEndian( header->mTexCoordMin[i] );
+		header->mTexCoordMax[i] = swapEndian( header->mTexCoordMax[i] );
+	}
+}
+#endif
+
+// Reads the header at \a data, throwing TriMeshExc if it isn't version 2 or its index size is invalid. The counts are not checked against anything.
+TriMeshHeader readHeader( const uint8_t *data )
+{
+	TriMeshHeader header;
+	memcpy( &header, data, sizeof( header ) );
+#if ! defined( CINDER_LITTLE_ENDIAN )
+	swapHeader( &header );
+#endif
+	if( ( header.mVersion != 2 ) || ( ( header.mIndexSize != 2 ) && ( header.mIndexSize != 4 ) ) )
+		throw TriMeshExc();
+	return header;
+}
+
+// Reads and validates the header at \a data, throwing TriMeshExc if it isn't version 2 or the blocks it describes don't fit in \a dataSize bytes
+TriMeshHeader readHeader( const uint8_t *data, size_t dataSize )
+{
+	if( dataSize < sizeof( TriMeshHeader ) )
+		throw TriMeshExc();
+	TriMeshHeader header = readHeader( data );
+	if( TriMeshLayout( header ).mEnd > dataSize )
+		throw TriMeshExc();
+	return header;
+}
+
+// Returns the little-endian T at \a data, which need not be aligned
+template<typename T>
+inline T loadLittle( const uint8_t *data )
+{
+	T result;
+	memcpy( &result, data, sizeof( T ) );
+#if ! defined( CINDER_LITTLE_ENDIAN )
+	result = swapEndian( result );
+#endif
+	return result;
+}
+
+#if ! defined( CINDER_LITTLE_ENDIAN )
+template<>
+inline Vec3f loadLittle<Vec3f>( const uint8_t *data )
+{
+	return Vec3f( loadLittle<float>( data ), loadLittle<float>( data + sizeof( float ) ), loadLittle<float>( data + 2 * sizeof( float ) ) );
+}
+
+template<>
+inline Vec2f loadLittle<Vec2f>( const uint8_t *data )
+{
+	return Vec2f( loadLittle<float>( data ), loadLittle<float>( data + sizeof( float ) ) );
+}
+
+template<typename T>
+inline void readLittle( IStreamRef &in, T *result )
+{
+	in->readLittle( result );
+}
+
+inline void readLittle( IStreamRef &in, Vec3f *result )
+{
+	in->readLittle( &result->x );
+	in->readLittle( &result->y );
+	in->readLittle( &result->z );
+}
+
+inline void readLittle( IStreamRef &in, Vec2f *result )
+{
+	in->readLittle( &result->x );
+	in->readLittle( &result->y );
+}
+
+template<typename T>
+inline void writeLittle( OStreamRef &out, T t )
+{
+	out->writeLittle( t );
+}
+
+inline void writeLittle( OStreamRef &out, const Vec3f &v )
+{
+	out->writeLittle( v.x );
+	out->writeLittle( v.y );
+	out->writeLittle( v.z );
+}
+
+inline void writeLittle( OStreamRef &out, const Vec2f &v )
+{
+	out->writeLittle( v.x );
+	out->writeLittle( v.y );
+}
+#endif
+
+// Assigns \a result the \a count little-endian T at \a data, copying them in bulk when the host is little-endian too
+template<typename T, typename R>
+void loadLittleBlock( const uint8_t *data, size_t count, vector<R> *result )
+{
+#if defined( CINDER_LITTLE_ENDIAN )
+	const T *values = reinterpret_cast<const T*>( data );
+	result->assign( values, values + count );
+#else
+	result->resize( count );
+	for( size_t i = 0; i < count; ++i )
+		(*result)[i] = loadLittle<T>( data + i * sizeof( T ) );
+#endif
+}
+
+// Reads \a count little-endian T from \a in into \a result, in bulk when the host is little-endian too
+template<typename T>
+void readLittleBlock( IStreamRef &in, size_t count, vector<T> *result )
+{
+	result->resize( count );
+#if defined( CINDER_LITTLE_ENDIAN )
+	if( count )
+		in->readData( &(*result)[0], count * sizeof( T ) );
+#else
+	for( size_t i = 0; i < count; ++i )
+		readLittle( in, &(*result)[i] );
+#endif
+}
+
+inline float signNotZero( float v )
+{
+	return ( v >= 0 ) ? 1.0f : -1.0f;
+}
+
+// Octahedral encoding: projects \a n onto the octahedron |x| + |y| + |z| = 1 and folds the lower half over the upper one
+void encodeNormal( const Vec3f &n, int16_t *result )
+{
+	float length = math<float>::abs( n.x ) + math<float>::abs( n.y ) + math<float>::abs( n.z );
+	float x = 0, y = 0;
+	if( length > 0 ) {
+		x = n.x / length;
+		y = n.y / length;
+		if( n.z < 0 ) {
+			float foldedX = ( 1 - math<float>::abs( y ) ) * signNotZero( x );
+			y = ( 1 - math<float>::abs( x ) ) * signNotZero( y );
+			x = foldedX;
+		}
+	}
+	result[0] = static_cast<int16_t>( math<float>::floor( math<float>::clamp( x, -1, 1 ) * 32767 + 0.5f ) );
+	result[1] = static_cast<int16_t>( math<float>::floor( math<float>::clamp( y, -1, 1 ) * 32767 + 0.5f ) );
+}
+
+Vec3f decodeNormal( const int16_t *encoded )
+{
+	Vec3f n( encoded[0] / 32767.0f, encoded[1] / 32767.0f, 0 );
+	n.z = 1 - math<float>::abs( n.x ) - math<float>::abs( n.y );
+	if( n.z < 0 ) {
+		float unfoldedX = ( 1 - math<float>::abs( n.y ) ) * signNotZero( n.x );
+		n.y = ( 1 - math<float>::abs( n.x ) ) * signNotZero( n.y );
+		n.x = unfoldedX;
+	}
+	return n.normalized();
+}
+
+inline uint16_t encodeTexCoord( float v, float min, float scale )
+{
+	return static_cast<uint16_t>( math<float>::floor( math<float>::clamp( ( v - min ) * scale, 0, 65535 ) + 0.5f ) );
+}
+
+// Writes \a values little-endian as the block at \a offset, in bulk when the host is little-endian too, followed by zeros up to \a nextOffset
+template<typename T>
+void writeLittleBlock( OStreamRef &out, const vector<T> &values, uint64_t offset, uint64_t nextOffset )
+{
+	static const uint8_t padding[16] = { 0 };
+	const uint64_t size = values.size() * sizeof( T );
+#if defined( CINDER_LITTLE_ENDIAN )
+	if( size )
+		out->writeData( &values[0], static_cast<size_t>( size ) );
+#else
+	for( typename vector<T>::const_iterator it = values.begin(); it != values.end(); ++it )
+		writeLittle( out, *it );
+#endif
+	if( nextOffset > offset + size )
+		out->writeData( padding, static_cast<size_t>( nextOffset - offset - size ) );
+}
+
+} // anonymous namespace
+
 void TriMesh::read( DataSourceRef dataSource )
 {
 	IStreamRef in = dataSource->createStream();
 	clear();
 
+	const off_t start = in->tell();
 	uint8_t versionNumber;
 	in->read( &versionNumber );
-	
+
+	if( versionNumber == 1 )
+		readVersion1( in );
+	else if( versionNumber != 2 )
+		throw TriMeshExc();
+	else if( IStreamMem *memStream = dynamic_cast<IStreamMem*>( in.get() ) ) // decode straight out of memory, including mapped files
+		readVersion2( reinterpret_cast<const uint8_t*>( memStream->getData() ) + start, static_cast<size_t>( memStream->size() - start ) );
+	else { // the header gives the size of everything else, which is read in one go
+		vector<uint8_t> data( sizeof( TriMeshHeader ) );
+		data[0] = versionNumber;
+		in->readData( &data[1], data.size() - 1 );
+		// validate the index size before the layout depends on it
+		const uint64_t dataSize = TriMeshLayout( readHeader( &data[0] ) ).mEnd;
+		if( dataSize > std::numeric_limits<size_t>::max() )
+			throw TriMeshExc();
+		data.resize( static_cast<size_t>( dataSize ) );
+		if( data.size() > sizeof( TriMeshHeader ) )
+			in->readData( &data[sizeof( TriMeshHeader )], data.size() - sizeof( TriMeshHeader ) );
+		readVersion2( &data[0], data.size() );
+	}
+}
+
+// The original format: after the version byte of 1, the four counts followed by unpadded little-endian floats and uint32_t indices
+void TriMesh::readVersion1( IStreamRef in )
+{
 	uint32_t numVertices, numNormals, numTexCoords, numIndices;
 	in->readLittle( &numVertices );
 	in->readLittle( &numNormals );
 	in->readLittle( &numTexCoords );
 	in->readLittle( &numIndices );
-	
-	for( size_t idx = 0; idx < numVertices; ++idx ) {
-		Vec3f v;
-		in->readLittle( &v.x ); in->readLittle( &v.y ); in->readLittle( &v.z );
-		mVertices.push_back( v );
-	}
 
-	for( size_t idx = 0; idx < numNormals; ++idx ) {
-		Vec3f v;
-		in->readLittle( &v.x ); in->readLittle( &v.y ); in->readLittle( &v.z );
-		mNormals.push_back( v );
-	}
+	readLittleBlock( in, numVertices, &mVertices );
+	readLittleBlock( in, numNormals, &mNormals );
+	readLittleBlock( in, numTexCoords, &mTexCoords );
+
+	vector<uint32_t> indices;
+	readLittleBlock( in, numIndices, &indices );
+	mIndices.assign( indices.begin(), indices.end() );
+}
 
-	for( size_t idx = 0; idx < numTexCoords; ++idx ) {
-		Vec2f v;
-		in->readLittle( &v.x ); in->readLittle( &v.y );
-		mTexCoords.push_back( v );
+void TriMesh::readVersion2( const uint8_t *data, size_t dataSize )
+{
+	const TriMeshHeader header = readHeader( data, dataSize );
+	const TriMeshLayout layout( header );
+
+	loadLittleBlock<Vec3f>( data + layout.mVertices, header.mNumVertices, &mVertices );
+
+	if( header.mFlags & QUANTIZED_NORMALS ) {
+		mNormals.resize( header.mNumNormals );
+		const uint8_t *normals = data + layout.mNormals;
+		for( size_t n = 0; n < header.mNumNormals; ++n ) {
+			const int16_t encoded[2] = { loadLittle<int16_t>( normals + n * 4 ), loadLittle<int16_t>( normals + n * 4 + 2 ) };
+			mNormals[n] = decodeNormal( encoded );
+		}
 	}
+	else
+		loadLittleBlock<Vec3f>( data + layout.mNormals, header.mNumNormals, &mNormals );
 
-	for( size_t idx = 0; idx < numIndices; ++idx ) {
-		uint32_t v;
-		in->readLittle( &v );
-		mIndices.push_back( v );
+	if( header.mFlags & QUANTIZED_TEX_COORDS ) {
+		mTexCoords.resize( header.mNumTexCoords );
+		const uint8_t *texCoords = data + layout.mTexCoords;
+		const Vec2f min( header.mTexCoordMin[0], header.mTexCoordMin[1] );
+		const Vec2f scale( ( header.mTexCoordMax[0] - min.x ) / 65535, ( header.mTexCoordMax[1] - min.y ) / 65535 );
+		for( size_t t = 0; t < header.mNumTexCoords; ++t )
+			mTexCoords[t] = Vec2f( min.x + loadLittle<uint16_t>( texCoords + t * 4 ) * scale.x, min.y + loadLittle<uint16_t>( texCoords + t * 4 + 2 ) * scale.y );
 	}
+	else
+		loadLittleBlock<Vec2f>( data + layout.mTexCoords, header.mNumTexCoords, &mTexCoords );
+
+	if( header.mIndexSize == 2 )
+		loadLittleBlock<uint16_t>( data + layout.mIndices, header.mNumIndices, &mIndices );
+	else
+		loadLittleBlock<uint32_t>( data + layout.mIndices, header.mNumIndices, &mIndices );
 }
 
-void TriMesh::write( DataTargetRef dataTarget ) const
+void TriMesh::write( DataTargetRef dataTarget, const WriteOptions &options ) const
 {
 	OStreamRef out = dataTarget->getStream();
-	
-	const uint8_t versionNumber = 1;
-	out->write( versionNumber );
-	
-	out->writeLittle( static_cast<uint32_t>( mVertices.size() ) );
-	out->writeLittle( static_cast<uint32_t>( mNormals.size() ) );
-	out->writeLittle( static_cast<uint32_t>( mTexCoords.size() ) );
-	out->writeLittle( static_cast<uint32_t>( mIndices.size() ) );
-	
-	for( vector<Vec3f>::const_iterator it = mVertices.begin(); it != mVertices.end(); ++it ) {
-		out->writeLittle( it->x ); out->writeLittle( it->y ); out->writeLittle( it->z );
-	}
 
-	for( vector<Vec3f>::const_iterator it = mNormals.begin(); it != mNormals.end(); ++it ) {
-		out->writeLittle( it->x ); out->writeLittle( it->y ); out->writeLittle( it->z );
+	size_t maxIndex = 0;
+	for( vector<size_t>::const_iterator it = mIndices.begin(); it != mIndices.end(); ++it )
+		maxIndex = std::max( maxIndex, *it );
+
+	TriMeshHeader header;
+	memset( &header, 0, sizeof( header ) );
+	header.mVersion = 2;
+	header.mFlags = ( ( options.getQuantizeNormals() ) ? QUANTIZED_NORMALS : 0 ) | ( ( options.getQuantizeTexCoords() ) ? QUANTIZED_TEX_COORDS : 0 );
+	header.mIndexSize = ( maxIndex <= 0xFFFF ) ? 2 : 4;
+	header.mNumVertices = static_cast<uint32_t>( mVertices.size() );
+	header.mNumNormals = static_cast<uint32_t>( mNormals.size() );
+	header.mNumTexCoords = static_cast<uint32_t>( mTexCoords.size() );
+	header.mNumIndices = static_cast<uint32_t>( mIndices.size() );
+	if( options.getQuantizeTexCoords() && ( ! mTexCoords.empty() ) ) {
+		Vec2f min = mTexCoords[0], max = mTexCoords[0];
+		for( vector<Vec2f>::const_iterator it = mTexCoords.begin(); it != mTexCoords.end(); ++it ) {
+			min.x = std::min( min.x, it->x ); min.y = std::min( min.y, it->y );
+			max.x = std::max( max.x, it->x ); max.y = std::max( max.y, it->y );
+		}
+		header.mTexCoordMin[0] = min.x; header.mTexCoordMin[1] = min.y;
+		header.mTexCoordMax[0] = max.x; header.mTexCoordMax[1] = max.y;
 	}
+	const TriMeshLayout layout( header );
 
-	for( vector<Vec2f>::const_iterator it = mTexCoords.begin(); it != mTexCoords.end(); ++it ) {
-		out->writeLittle( it->x ); out->writeLittle( it->y );
+#if defined( CINDER_LITTLE_ENDIAN )
+	out->writeData( &header, sizeof( header ) );
+#else
+	TriMeshHeader littleHeader( header );
+	swapHeader( &littleHeader );
+	out->writeData( &littleHeader, sizeof( littleHeader ) );
+#endif
+	writeLittleBlock( out, mVertices, layout.mVertices, layout.mNormals );
+
+	if( options.getQuantizeNormals() ) {
+		vector<int16_t> normals( mNormals.size() * 2 );
+		for( size_t n = 0; n < mNormals.size(); ++n )
+			encodeNormal( mNormals[n], &normals[n * 2] );
+		writeLittleBlock( out, normals, layout.mNormals, layout.mTexCoords );
 	}
+	else
+		writeLittleBlock( out, mNormals, layout.mNormals, layout.mTexCoords );
 
-	for( vector<size_t>::const_iterator it = mIndices.begin(); it != mIndices.end(); ++it ) {
-		out->writeLittle( static_cast<uint32_t>( *it) );
+	if( options.getQuantizeTexCoords() ) {
+		const float scaleX = ( header.mTexCoordMax[0] > header.mTexCoordMin[0] ) ? 65535 / ( header.mTexCoordMax[0] - header.mTexCoordMin[0] ) : 0;
+		const float scaleY = ( header.mTexCoordMax[1] > header.mTexCoordMin[1] ) ? 65535 / ( header.mTexCoordMax[1] - header.mTexCoordMin[1] ) : 0;
+		vector<uint16_t> texCoords( mTexCoords.size() * 2 );
+		for( size_t t = 0; t < mTexCoords.size(); ++t ) {
+			texCoords[t * 2] = encodeTexCoord( mTexCoords[t].x, header.mTexCoordMin[0], scaleX );
+			texCoords[t * 2 + 1] = encodeTexCoord( mTexCoords[t].y, header.mTexCoordMin[1], scaleY );
+		}
+		writeLittleBlock( out, texCoords, layout.mTexCoords, layout.mIndices );
 	}
+	else
+		writeLittleBlock( out, mTexCoords, layout.mTexCoords, layout.mIndices );
+
+	if( header.mIndexSize == 2 )
+		writeLittleBlock( out, vector<uint16_t>( mIndices.begin(), mIndices.end() ), layout.mIndices, layout.mEnd );
+	else
+		writeLittleBlock( out, vector<uint32_t>( mIndices.begin(), mIndices.end() ), layout.mIndices, layout.mEnd );
+}
+
+TriMeshMappedRef TriMeshMapped::createRef( DataSourceMappedRef dataSource )
+{
+	return TriMeshMappedRef( new TriMeshMapped( dataSource ) );
+}
+
+TriMeshMapped::TriMeshMapped( DataSourceMappedRef dataSource )
+	: mDataSource( dataSource ), mNormals( 0 ), mQuantizedNormals( 0 ), mTexCoords( 0 ), mQuantizedTexCoords( 0 ), mIndices16( 0 ), mIndices32( 0 )
+{
+#if ! defined( CINDER_LITTLE_ENDIAN )
+	// the blocks are exposed as they are stored, which is little-endian
+	throw TriMeshExc();
+#endif
+	const uint8_t *data = reinterpret_cast<const uint8_t*>( mDataSource->getData() );
+	const TriMeshHeader header = readHeader( data, mDataSource->getDataSize() );
+	const TriMeshLayout layout( header );
+
+	mNumVertices = header.mNumVertices;
+	mNumNormals = header.mNumNormals;
+	mNumTexCoords = header.mNumTexCoords;
+	mNumIndices = header.mNumIndices;
+	mVertices = reinterpret_cast<const Vec3f*>( data + layout.mVertices );
+	if( header.mFlags & QUANTIZED_NORMALS )
+		mQuantizedNormals = reinterpret_cast<const int16_t*>( data + layout.mNormals );
+	else
+		mNormals = reinterpret_cast<const Vec3f*>( data + layout.mNormals );
+	if( header.mFlags & QUANTIZED_TEX_COORDS )
+		mQuantizedTexCoords = reinterpret_cast<const uint16_t*>( data + layout.mTexCoords );
+	else
+		mTexCoords = reinterpret_cast<const Vec2f*>( data + layout.mTexCoords );
+	mTexCoordMin = Vec2f( header.mTexCoordMin[0], header.mTexCoordMin[1] );
+	mTexCoordMax = Vec2f( header.mTexCoordMax[0], header.mTexCoordMax[1] );
+	if( header.mIndexSize == 2 )
+		mIndices16 = reinterpret_cast<const uint16_t*>( data + layout.mIndices );
+	else
+		mIndices32 = reinterpret_cast<const uint32_t*>( data + layout.mIndices );
 }
 
 } // namespace cinder
@@ -0,0 +1,730 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cinder/TriMeshBvh.h"
+#include "cinder/CinderMath.h"
+#include "cinder/System.h"
+#include "cinder/Thread.h"
+#include "cinder/ip/Parallel.h"
+
+#if defined( CINDER_SSE2 )
+	#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+
+namespace cinder {
+
+namespace {
+
+const int32_t MAX_LEAF_SIZE = 64;
+const int32_t MAX_BINS = 64;
+// below this many triangles a subtree isn't worth a thread of its own
+const uint32_t MIN_PARALLEL_TRIANGLES = 4096;
+// past this depth nodes are split at their median rather than by the SAH, which bounds the depth of the tree by this plus log2 of the triangle count
+const int32_t MAX_SAH_DEPTH = 64;
+const int32_t STACK_SIZE = 128;
+
+struct Bounds {
+	Bounds() : mMin( std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() ),
+		mMax( -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() ) {}
+
+	void include( const Vec3f &point )
+	{
+		mMin.x = std::min( mMin.x, point.x ); mMin.y = std::min( mMin.y, point.y ); mMin.z = std::min( mMin.z, point.z );
+		mMax.x = std::max( mMax.x, point.x ); mMax.y = std::max( mMax.y, point.y ); mMax.z = std::max( mMax.z, point.z );
+	}
+
+	void include( const Bounds &bounds )
+	{
+		include( bounds.mMin );
+		include( bounds.mMax );
+	}
+
+	// half of the surface area, which is all the SAH needs
+	float calcHalfArea() const
+	{
+		Vec3f size = mMax - mMin;
+		return size.x * size.y + size.y * size.z + size.z * size.x;
+	}
+
+	Vec3f	mMin, mMax;
+};
+
+struct Bin {
+	Bin() : mCount( 0 ) {}
+
+	Bounds		mBounds;
+	uint32_t	mCount;
+};
+
+struct CentroidLess {
+	CentroidLess( int32_t axis ) : mAxis( axis ) {}
+
+	template<typename REF>
+	bool operator()( const REF &a, const REF &b ) const { return a.mCentroid[mAxis] < b.mCentroid[mAxis]; }
+
+	int32_t		mAxis;
+};
+
+void appendNodes( std::vector<TriMeshBvh::Node> *nodes, const std::vector<TriMeshBvh::Node> &subtree )
+{
+	const uint32_t base = (uint32_t)nodes->size();
+	nodes->insert( nodes->end(), subtree.begin(), subtree.end() );
+	for( size_t n = base; n < nodes->size(); ++n ) {
+		if( (*nodes)[n].mNumBlocks == 0 )
+			(*nodes)[n].mOffset += base;
+	}
+}
+
+// Returns the distance at which the ray enters \a node, or a negative value if it misses it or enters beyond \a maxDistance
+inline float intersectNode( const TriMeshBvh::Node &node, const float origin[3], const float invDirection[3], float maxDistance )
+{
+	float nearDistance = 0, farDistance = maxDistance;
+	for( int axis = 0; axis < 3; ++axis ) {
+		float t0 = ( node.mMin[axis] - origin[axis] ) * invDirection[axis];
+		float t1 = ( node.mMax[axis] - origin[axis] ) * invDirection[axis];
+		nearDistance = std::max( nearDistance, std::min( t0, t1 ) );
+		farDistance = std::min( farDistance, std::max( t0, t1 ) );
+	}
+	return ( nearDistance <= farDistance ) ? nearDistance : -1.0f;
+}
+
+// Tests one ray against entry \a lane of \a block with the algorithm from "Fast, Minimum Storage Ray-Triangle Intersection",
+// as in Ray::calcTriangleIntersection() but accepting only hits in front of the ray and closer than \a maxDistance
+inline bool intersectTriangle( const TriMeshBvh::TriangleBlock &block, int lane, const Vec3f &origin, const Vec3f &direction, float maxDistance, float *distance, float *u, float *v )
+{
+	Vec3f vert0( block.mVert0[0][lane], block.mVert0[1][lane], block.mVert0[2][lane] );
+	Vec3f edge1( block.mEdge1[0][lane], block.mEdge1[1][lane], block.mEdge1[2][lane] );
+	Vec3f edge2( block.mEdge2[0][lane], block.mEdge2[1][lane], block.mEdge2[2][lane] );
+
+	Vec3f pvec = direction.cross( edge2 );
+	float det = edge1.dot( pvec );
+	if( det == 0 )
+		return false;
+	float invDet = 1.0f / det;
+	Vec3f tvec = origin - vert0;
+	*u = tvec.dot( pvec ) * invDet;
+	if( *u < 0 || *u > 1 )
+		return false;
+	Vec3f qvec = tvec.cross( edge1 );
+	*v = direction.dot( qvec ) * invDet;
+	if( *v < 0 || *u + *v > 1 )
+		return false;
+	*distance = edge2.dot( qvec ) * invDet;
+	return ( *distance > 0 ) && ( *distance < maxDistance );
+}
+
+#if defined( CINDER_SSE2 )
+inline __m128 dot4( const __m128 a[3], const __m128 b[3] )
+{
+	return _mm_add_ps( _mm_add_ps( _mm_mul_ps( a[0], b[0] ), _mm_mul_ps( a[1], b[1] ) ), _mm_mul_ps( a[2], b[2] ) );
+}
+
+inline void cross4( const __m128 a[3], const __m128 b[3], __m128 result[3] )
+{
+	result[0] = _mm_sub_ps( _mm_mul_ps( a[1], b[2] ), _mm_mul_ps( a[2], b[1] ) );
+	result[1] = _mm_sub_ps( _mm_mul_ps( a[2], b[0] ), _mm_mul_ps( a[0], b[2] ) );
+	result[2] = _mm_sub_ps( _mm_mul_ps( a[0], b[1] ), _mm_mul_ps( a[1], b[0] ) );
+}
+
+// The same test as intersectTriangle() for four ray / triangle pairs at once. Either the rays or the triangles may be the same in every lane.
+// Returns a mask of the lanes hit; degenerate triangles have a zero determinant and are never hit.
+inline __m128 intersectTriangles4( const __m128 origin[3], const __m128 direction[3], const __m128 vert0[3], const __m128 edge1[3], const __m128 edge2[3],
+									__m128 maxDistance, __m128 *distance, __m128 *u, __m128 *v )
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps( 1.0f );
+
+	__m128 pvec[3], tvec[3], qvec[3];
+	cross4( direction, edge2, pvec );
+	__m128 det = dot4( edge1, pvec );
+	__m128 invDet = _mm_div_ps( one, det );
+	for( int axis = 0; axis < 3; ++axis )
+		tvec[axis] = _mm_sub_ps( origin[axis], vert0[axis] );
+	*u = _mm_mul_ps( dot4( tvec, pvec ), invDet );
+	cross4( tvec, edge1, qvec );
+	*v = _mm_mul_ps( dot4( direction, qvec ), invDet );
+	*distance = _mm_mul_ps( dot4( edge2, qvec ), invDet );
+
+	__m128 mask = _mm_cmpneq_ps( det, zero );
+	mask = _mm_and_ps( mask, _mm_cmpge_ps( *u, zero ) );
+	mask = _mm_and_ps( mask, _mm_cmpge_ps( *v, zero ) );
+	mask = _mm_and_ps( mask, _mm_cmple_ps( _mm_add_ps( *u, *v ), one ) );
+	mask = _mm_and_ps( mask, _mm_cmpgt_ps( *distance, zero ) );
+	return _mm_and_ps( mask, _mm_cmplt_ps( *distance, maxDistance ) );
+}
+
+inline void loadBlock( const TriMeshBvh::TriangleBlock &block, __m128 vert0[3], __m128 edge1[3], __m128 edge2[3] )
+{
+	for( int axis = 0; axis < 3; ++axis ) {
+		vert0[axis] = _mm_loadu_ps( block.mVert0[axis] );
+		edge1[axis] = _mm_loadu_ps( block.mEdge1[axis] );
+		edge2[axis] = _mm_loadu_ps( block.mEdge2[axis] );
+	}
+}
+#endif // defined( CINDER_SSE2 )
+
+struct BuildRef {
+	Bounds		mBounds;
+	Vec3f		mCentroid;
+	uint32_t	mTriangle;
+};
+
+void calcBounds( const BuildRef *refs, uint32_t begin, uint32_t end, Bounds *bounds, Bounds *centroidBounds )
+{
+	for( uint32_t r = begin; r < end; ++r ) {
+		bounds->include( refs[r].mBounds );
+		centroidBounds->include( refs[r].mCentroid );
+	}
+}
+
+// The cheapest division of a node's refs found by the SAH, between the bins \a mBin and \a mBin + 1 along \a mAxis
+struct Split {
+	Split() : mAxis( -1 ), mBin( 0 ), mCost( std::numeric_limits<float>::max() ) {}
+
+	int32_t		mAxis, mBin;
+	float		mCost;
+	Bounds		mLeftBounds, mRightBounds;
+};
+
+// Builds the nodes of a TriMeshBvh over an array of BuildRefs, reordering them so that the refs of each leaf are contiguous
+class BvhBuilder {
+  public:
+	BvhBuilder( BuildRef *refs, int32_t maxLeafSize, int32_t numBins, int32_t parallelDepth )
+		: mRefs( refs ), mMaxLeafSize( maxLeafSize ), mNumBins( numBins ), mParallelDepth( parallelDepth ) {}
+
+	// Appends the subtree over the refs [begin, end), whose bounds and centroid bounds are given, to \a nodes in depth-first order.
+	// Leaves store their first ref in mOffset and their number of refs in mNumBlocks, for the TriMeshBvh to replace with its blocks.
+	void build( uint32_t begin, uint32_t end, const Bounds &bounds, const Bounds &centroidBounds, int32_t depth, std::vector<TriMeshBvh::Node> *nodes ) const;
+
+  private:
+	// kept out of build() so the bins don't occupy the stack of every level of recursion
+	Split findSplit( uint32_t begin, uint32_t end, const Bounds &centroidBounds ) const;
+
+	BuildRef	*mRefs;
+	int32_t		mMaxLeafSize, mNumBins, mParallelDepth;
+};
+
+// Builds a subtree on its own thread into its own array of nodes
+struct BuildTask {
+	BuildTask( const BvhBuilder *builder, uint32_t begin, uint32_t end, const Bounds &bounds, const Bounds &centroidBounds, int32_t depth, std::vector<TriMeshBvh::Node> *nodes )
+		: mBuilder( builder ), mBegin( begin ), mEnd( end ), mBounds( bounds ), mCentroidBounds( centroidBounds ), mDepth( depth ), mNodes( nodes ) {}
+
+	void operator()() const { mBuilder->build( mBegin, mEnd, mBounds, mCentroidBounds, mDepth, mNodes ); }
+
+	const BvhBuilder				*mBuilder;
+	uint32_t						mBegin, mEnd;
+	Bounds							mBounds, mCentroidBounds;
+	int32_t							mDepth;
+	std::vector<TriMeshBvh::Node>	*mNodes;
+};
+
+Split BvhBuilder::findSplit( uint32_t begin, uint32_t end, const Bounds &centroidBounds ) const
+{
+	const uint32_t count = end - begin;
+	const Vec3f centroidSize = centroidBounds.mMax - centroidBounds.mMin;
+	float binScales[3];
+	for( int axis = 0; axis < 3; ++axis )
+		binScales[axis] = ( centroidSize[axis] > 0 ) ? mNumBins / centroidSize[axis] : 0;
+
+	// bin the refs along every axis in a single pass
+	Bin bins[3][MAX_BINS];
+	for( uint32_t r = begin; r < end; ++r ) {
+		const BuildRef &ref = mRefs[r];
+		for( int axis = 0; axis < 3; ++axis ) {
+			int32_t bin = std::min<int32_t>( mNumBins - 1, (int32_t)( ( ref.mCentroid[axis] - centroidBounds.mMin[axis] ) * binScales[axis] ) );
+			bins[axis][bin].mBounds.include( ref.mBounds );
+			++bins[axis][bin].mCount;
+		}
+	}
+
+	// a side of a split costs the number of its refs times its area
+	Split best;
+	for( int axis = 0; axis < 3; ++axis ) {
+		if( binScales[axis] == 0 )
+			continue;
+		Bounds rightBounds[MAX_BINS];
+		uint32_t rightCounts[MAX_BINS];
+		Bounds side;
+		uint32_t sideCount = 0;
+		for( int32_t bin = mNumBins - 1; bin > 0; --bin ) {
+			side.include( bins[axis][bin].mBounds );
+			sideCount += bins[axis][bin].mCount;
+			rightBounds[bin] = side;
+			rightCounts[bin] = sideCount;
+		}
+		side = Bounds();
+		sideCount = 0;
+		for( int32_t bin = 0; bin < mNumBins - 1; ++bin ) {
+			side.include( bins[axis][bin].mBounds );
+			sideCount += bins[axis][bin].mCount;
+			if( ( sideCount == 0 ) || ( sideCount == count ) )
+				continue;
+			float cost = sideCount * side.calcHalfArea() + rightCounts[bin + 1] * rightBounds[bin + 1].calcHalfArea();
+			if( cost < best.mCost ) {
+				best.mAxis = axis;
+				best.mBin = bin;
+				best.mCost = cost;
+				best.mLeftBounds = side;
+				best.mRightBounds = rightBounds[bin + 1];
+			}
+		}
+	}
+
+	return best;
+}
+
+void BvhBuilder::build( uint32_t begin, uint32_t end, const Bounds &bounds, const Bounds &centroidBounds, int32_t depth, std::vector<TriMeshBvh::Node> *nodes ) const
+{
+	const uint32_t count = end - begin;
+	const size_t nodeIndex = nodes->size();
+	TriMeshBvh::Node node;
+	for( int axis = 0; axis < 3; ++axis ) {
+		node.mMin[axis] = bounds.mMin[axis];
+		node.mMax[axis] = bounds.mMax[axis];
+	}
+	node.mOffset = begin;
+	node.mNumBlocks = 0;
+	node.mAxis = 0;
+	node.mPadding = 0;
+
+	if( count <= (uint32_t)mMaxLeafSize ) {
+		node.mNumBlocks = (uint16_t)count;
+		nodes->push_back( node );
+		return;
+	}
+
+	Split split;
+	if( depth < MAX_SAH_DEPTH )
+		split = findSplit( begin, end, centroidBounds );
+
+	uint32_t mid;
+	Bounds leftBounds, rightBounds, leftCentroidBounds, rightCentroidBounds;
+	if( split.mAxis >= 0 ) {
+		// partition the refs by their bin, gathering the centroid bounds of each side along the way
+		const int32_t axis = split.mAxis;
+		const float binMin = centroidBounds.mMin[axis], binScale = mNumBins / ( centroidBounds.mMax[axis] - binMin );
+		uint32_t left = begin, right = end;
+		while( true ) {
+			while( ( left < right ) && ( std::min<int32_t>( mNumBins - 1, (int32_t)( ( mRefs[left].mCentroid[axis] - binMin ) * binScale ) ) <= split.mBin ) )
+				leftCentroidBounds.include( mRefs[left++].mCentroid );
+			while( ( left < right ) && ( std::min<int32_t>( mNumBins - 1, (int32_t)( ( mRefs[right - 1].mCentroid[axis] - binMin ) * binScale ) ) > split.mBin ) )
+				rightCentroidBounds.include( mRefs[--right].mCentroid );
+			if( left >= right )
+				break;
+			std::swap( mRefs[left], mRefs[right - 1] );
+		}
+		mid = left;
+		leftBounds = split.mLeftBounds;
+		rightBounds = split.mRightBounds;
+		node.mAxis = (uint8_t)axis;
+	}
+	else {
+		// every centroid coincides or the tree is too deep; split at the median along the longest axis
+		const Vec3f centroidSize = centroidBounds.mMax - centroidBounds.mMin;
+		int32_t axis = 0;
+		if( centroidSize.y > centroidSize[axis] )
+			axis = 1;
+		if( centroidSize.z > centroidSize[axis] )
+			axis = 2;
+		mid = begin + count / 2;
+		std::nth_element( mRefs + begin, mRefs + mid, mRefs + end, CentroidLess( axis ) );
+		calcBounds( mRefs, begin, mid, &leftBounds, &leftCentroidBounds );
+		calcBounds( mRefs, mid, end, &rightBounds, &rightCentroidBounds );
+		node.mAxis = (uint8_t)axis;
+	}
+
+	nodes->push_back( node );
+	if( ( depth < mParallelDepth ) && ( count >= MIN_PARALLEL_TRIANGLES ) ) {
+		std::vector<TriMeshBvh::Node> leftNodes, rightNodes;
+		std::thread thread( BuildTask( this, begin, mid, leftBounds, leftCentroidBounds, depth + 1, &leftNodes ) );
+		build( mid, end, rightBounds, rightCentroidBounds, depth + 1, &rightNodes );
+		thread.join();
+		appendNodes( nodes, leftNodes );
+		(*nodes)[nodeIndex].mOffset = (uint32_t)nodes->size();
+		appendNodes( nodes, rightNodes );
+	}
+	else {
+		build( begin, mid, leftBounds, leftCentroidBounds, depth + 1, nodes );
+		(*nodes)[nodeIndex].mOffset = (uint32_t)nodes->size();
+		build( mid, end, rightBounds, rightCentroidBounds, depth + 1, nodes );
+	}
+}
+
+} // anonymous namespace
+
+// Traces the packets [begin, end) for TriMeshBvh::intersect() on one band of ip::parallelRows()
+struct TriMeshBvh::PacketTask {
+	PacketTask( const TriMeshBvh *bvh, const Ray *rays, size_t numRays, Hit *results )
+		: mBvh( bvh ), mRays( rays ), mNumRays( numRays ), mResults( results ) {}
+
+	void operator()( int32_t begin, int32_t end ) const
+	{
+		size_t first = (size_t)begin * 4;
+		size_t last = std::min( mNumRays, (size_t)end * 4 );
+		mBvh->intersectPackets( mRays + first, last - first, mResults + first );
+	}
+
+	const TriMeshBvh	*mBvh;
+	const Ray			*mRays;
+	size_t				mNumRays;
+	Hit					*mResults;
+};
+
+TriMeshBvh::TriMeshBvh( const TriMesh &mesh, const Options &options )
+	: mNumTriangles( mesh.getNumTriangles() )
+{
+	// one level more than strictly needed to occupy every thread, as SAH splits are rarely even
+	const int32_t numThreads = ip::resolveNumThreads( options.getNumThreads() );
+	int32_t parallelDepth = 0;
+	while( ( 1 << parallelDepth ) < numThreads )
+		++parallelDepth;
+	if( numThreads > 1 )
+		++parallelDepth;
+
+	if( mNumTriangles == 0 )
+		return;
+
+	const std::vector<Vec3f> &vertices = mesh.getVertices();
+	const std::vector<size_t> &indices = mesh.getIndices();
+	std::vector<BuildRef> refs( mNumTriangles );
+	for( size_t t = 0; t < mNumTriangles; ++t ) {
+		BuildRef &ref = refs[t];
+		for( int corner = 0; corner < 3; ++corner )
+			ref.mBounds.include( vertices[indices[t * 3 + corner]] );
+		ref.mCentroid = ( ref.mBounds.mMin + ref.mBounds.mMax ) * 0.5f;
+		ref.mTriangle = (uint32_t)t;
+	}
+
+	Bounds bounds, centroidBounds;
+	calcBounds( &refs[0], 0, (uint32_t)mNumTriangles, &bounds, &centroidBounds );
+	BvhBuilder builder( &refs[0], constrain<int32_t>( options.getMaxLeafSize(), 1, MAX_LEAF_SIZE ), constrain<int32_t>( options.getNumBins(), 2, MAX_BINS ), parallelDepth );
+	builder.build( 0, (uint32_t)mNumTriangles, bounds, centroidBounds, 0, &mNodes );
+
+	// leaves refer to their range of refs until now; replace that with the blocks holding their triangles
+	size_t numBlocks = 0;
+	for( size_t n = 0; n < mNodes.size(); ++n )
+		numBlocks += ( mNodes[n].mNumBlocks + 3 ) / 4;
+	mBlocks.resize( numBlocks );
+
+	uint32_t block = 0;
+	for( size_t n = 0; n < mNodes.size(); ++n ) {
+		Node &node = mNodes[n];
+		if( node.mNumBlocks == 0 )
+			continue;
+		const uint32_t first = node.mOffset, count = node.mNumBlocks;
+		node.mOffset = block;
+		node.mNumBlocks = (uint16_t)( ( count + 3 ) / 4 );
+		for( uint32_t i = 0; i < node.mNumBlocks * 4; ++i ) {
+			TriangleBlock &dest = mBlocks[block + i / 4];
+			const int lane = i % 4;
+			Vec3f vert0, edge1, edge2;
+			if( i < count ) {
+				const uint32_t triangle = refs[first + i].mTriangle;
+				vert0 = vertices[indices[triangle * 3 + 0]];
+				edge1 = vertices[indices[triangle * 3 + 1]] - vert0;
+				edge2 = vertices[indices[triangle * 3 + 2]] - vert0;
+				dest.mTriangles[lane] = triangle;
+			}
+			else {
+				vert0 = edge1 = edge2 = Vec3f::zero();
+				dest.mTriangles[lane] = NO_TRIANGLE;
+			}
+			for( int axis = 0; axis < 3; ++axis ) {
+				dest.mVert0[axis][lane] = vert0[axis];
+				dest.mEdge1[axis][lane] = edge1[axis];
+				dest.mEdge2[axis][lane] = edge2[axis];
+			}
+		}
+		block += node.mNumBlocks;
+	}
+}
+
+AxisAlignedBox3f TriMeshBvh::getBoundingBox() const
+{
+	if( mNodes.empty() )
+		return AxisAlignedBox3f( Vec3f::zero(), Vec3f::zero() );
+	const Node &root = mNodes[0];
+	return AxisAlignedBox3f( Vec3f( root.mMin[0], root.mMin[1], root.mMin[2] ), Vec3f( root.mMax[0], root.mMax[1], root.mMax[2] ) );
+}
+
+bool TriMeshBvh::intersect( const Ray &ray, Hit *result, float maxDistance ) const
+{
+	if( mNodes.empty() )
+		return false;
+
+	const Vec3f &origin = ray.getOrigin(), &direction = ray.getDirection();
+	const float originArray[3] = { origin.x, origin.y, origin.z };
+	const float invDirection[3] = { ray.getInverseDirection().x, ray.getInverseDirection().y, ray.getInverseDirection().z };
+#if defined( CINDER_SSE2 )
+	static const bool useSse2 = System::hasSse2();
+	__m128 origin4[3], direction4[3];
+	for( int axis = 0; axis < 3; ++axis ) {
+		origin4[axis] = _mm_set1_ps( origin[axis] );
+		direction4[axis] = _mm_set1_ps( direction[axis] );
+	}
+#endif
+
+	Hit hit;
+	hit.mDistance = maxDistance;
+	uint32_t stack[STACK_SIZE];
+	float stackDistances[STACK_SIZE];
+	int32_t stackSize = 0;
+	if( intersectNode( mNodes[0], originArray, invDirection, maxDistance ) < 0 )
+		return false;
+	stack[stackSize] = 0;
+	stackDistances[stackSize++] = 0;
+
+	while( stackSize > 0 ) {
+		--stackSize;
+		// a closer hit may have been found since this node was pushed
+		if( stackDistances[stackSize] > hit.mDistance )
+			continue;
+		uint32_t nodeIndex = stack[stackSize];
+		while( true ) {
+			const Node &node = mNodes[nodeIndex];
+			if( node.mNumBlocks > 0 ) {
+				for( uint32_t b = node.mOffset; b < node.mOffset + node.mNumBlocks; ++b ) {
+					const TriangleBlock &block = mBlocks[b];
+#if defined( CINDER_SSE2 )
+					if( useSse2 ) {
+						__m128 vert0[3], edge1[3], edge2[3], distance, u, v;
+						loadBlock( block, vert0, edge1, edge2 );
+						int mask = _mm_movemask_ps( intersectTriangles4( origin4, direction4, vert0, edge1, edge2, _mm_set1_ps( hit.mDistance ), &distance, &u, &v ) );
+						if( mask ) {
+							float distances[4], us[4], vs[4];
+							_mm_storeu_ps( distances, distance );
+							_mm_storeu_ps( us, u );
+							_mm_storeu_ps( vs, v );
+							for( int lane = 0; lane < 4; ++lane ) {
+								if( ( mask & ( 1 << lane ) ) && ( distances[lane] < hit.mDistance ) ) {
+									hit.mTriangle = block.mTriangles[lane];
+									hit.mDistance = distances[lane];
+									hit.mU = us[lane];
+									hit.mV = vs[lane];
+								}
+							}
+						}
+						continue;
+					}
+#endif
+					for( int lane = 0; lane < 4; ++lane ) {
+						float distance, u, v;
+						if( intersectTriangle( block, lane, origin, direction, hit.mDistance, &distance, &u, &v ) ) {
+							hit.mTriangle = block.mTriangles[lane];
+							hit.mDistance = distance;
+							hit.mU = u;
+							hit.mV = v;
+						}
+					}
+				}
+				break;
+			}
+
+			// descend into the nearer child and come back for the other later
+			const uint32_t left = nodeIndex + 1, right = node.mOffset;
+			const float leftDistance = intersectNode( mNodes[left], originArray, invDirection, hit.mDistance );
+			const float rightDistance = intersectNode( mNodes[right], originArray, invDirection, hit.mDistance );
+			if( leftDistance >= 0 && rightDistance >= 0 ) {
+				const bool leftFirst = leftDistance <= rightDistance;
+				stack[stackSize] = leftFirst ? right : left;
+				stackDistances[stackSize++] = leftFirst ? rightDistance : leftDistance;
+				nodeIndex = leftFirst ? left : right;
+			}
+			else if( leftDistance >= 0 )
+				nodeIndex = left;
+			else if( rightDistance >= 0 )
+				nodeIndex = right;
+			else
+				break;
+		}
+	}
+
+	if( ! hit.isValid() )
+		return false;
+	*result = hit;
+	return true;
+}
+
+bool TriMeshBvh::intersects( const Ray &ray, float maxDistance ) const
+{
+	if( mNodes.empty() )
+		return false;
+
+	const Vec3f &origin = ray.getOrigin(), &direction = ray.getDirection();
+	const float originArray[3] = { origin.x, origin.y, origin.z };
+	const float invDirection[3] = { ray.getInverseDirection().x, ray.getInverseDirection().y, ray.getInverseDirection().z };
+#if defined( CINDER_SSE2 )
+	static const bool useSse2 = System::hasSse2();
+	__m128 origin4[3], direction4[3];
+	for( int axis = 0; axis < 3; ++axis ) {
+		origin4[axis] = _mm_set1_ps( origin[axis] );
+		direction4[axis] = _mm_set1_ps( direction[axis] );
+	}
+	const __m128 maxDistance4 = _mm_set1_ps( maxDistance );
+#endif
+
+	// any hit will do, so children are visited in order without sorting
+	uint32_t stack[STACK_SIZE];
+	int32_t stackSize = 0;
+	stack[stackSize++] = 0;
+	while( stackSize > 0 ) {
+		const uint32_t nodeIndex = stack[--stackSize];
+		const Node &node = mNodes[nodeIndex];
+		if( intersectNode( node, originArray, invDirection, maxDistance ) < 0 )
+			continue;
+		if( node.mNumBlocks == 0 ) {
+			stack[stackSize++] = node.mOffset;
+			stack[stackSize++] = nodeIndex + 1;
+			continue;
+		}
+
+		for( uint32_t b = node.mOffset; b < node.mOffset + node.mNumBlocks; ++b ) {
+			const TriangleBlock &block = mBlocks[b];
+#if defined( CINDER_SSE2 )
+			if( useSse2 ) {
+				__m128 vert0[3], edge1[3], edge2[3], distance, u, v;
+				loadBlock( block, vert0, edge1, edge2 );
+				if( _mm_movemask_ps( intersectTriangles4( origin4, direction4, vert0, edge1, edge2, maxDistance4, &distance, &u, &v ) ) )
+					return true;
+				continue;
+			}
+#endif
+			for( int lane = 0; lane < 4; ++lane ) {
+				float distance, u, v;
+				if( intersectTriangle( block, lane, origin, direction, maxDistance, &distance, &u, &v ) )
+					return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void TriMeshBvh::intersect( const Ray *rays, size_t numRays, Hit *results, int32_t numThreads ) const
+{
+	const int32_t numPackets = (int32_t)( ( numRays + 3 ) / 4 );
+	ip::parallelRows( 0, numPackets, numThreads, PacketTask( this, rays, numRays, results ), 64 );
+}
+
+// Traces \a rays four at a time, descending into a node when any ray of the packet hits it
+void TriMeshBvh::intersectPackets( const Ray *rays, size_t numRays, Hit *results ) const
+{
+#if defined( CINDER_SSE2 )
+	static const bool useSse2 = System::hasSse2();
+	if( useSse2 && ( ! mNodes.empty() ) ) {
+		for( size_t first = 0; first < numRays; first += 4 ) {
+			const size_t packetSize = std::min<size_t>( 4, numRays - first );
+			// unused lanes repeat the first ray, with a negative maximum distance so they never hit anything
+			float origins[3][4], directions[3][4], invDirections[3][4], maxDistances[4];
+			for( size_t lane = 0; lane < 4; ++lane ) {
+				const Ray &ray = rays[first + ( ( lane < packetSize ) ? lane : 0 )];
+				for( int axis = 0; axis < 3; ++axis ) {
+					origins[axis][lane] = ray.getOrigin()[axis];
+					directions[axis][lane] = ray.getDirection()[axis];
+					invDirections[axis][lane] = ray.getInverseDirection()[axis];
+				}
+				maxDistances[lane] = ( lane < packetSize ) ? std::numeric_limits<float>::max() : -1.0f;
+				results[first + std::min( lane, packetSize - 1 )] = Hit();
+			}
+			__m128 origin4[3], direction4[3], invDirection4[3];
+			for( int axis = 0; axis < 3; ++axis ) {
+				origin4[axis] = _mm_loadu_ps( origins[axis] );
+				direction4[axis] = _mm_loadu_ps( directions[axis] );
+				invDirection4[axis] = _mm_loadu_ps( invDirections[axis] );
+			}
+			__m128 maxDistance4 = _mm_loadu_ps( maxDistances );
+
+			uint32_t stack[STACK_SIZE];
+			int32_t stackSize = 0;
+			stack[stackSize++] = 0;
+			while( stackSize > 0 ) {
+				const uint32_t nodeIndex = stack[--stackSize];
+				const Node &node = mNodes[nodeIndex];
+				__m128 nearDistance = _mm_setzero_ps(), farDistance = maxDistance4;
+				for( int axis = 0; axis < 3; ++axis ) {
+					__m128 t0 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( node.mMin[axis] ), origin4[axis] ), invDirection4[axis] );
+					__m128 t1 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( node.mMax[axis] ), origin4[axis] ), invDirection4[axis] );
+					nearDistance = _mm_max_ps( nearDistance, _mm_min_ps( t0, t1 ) );
+					farDistance = _mm_min_ps( farDistance, _mm_max_ps( t0, t1 ) );
+				}
+				if( ! _mm_movemask_ps( _mm_cmple_ps( nearDistance, farDistance ) ) )
+					continue;
+
+				if( node.mNumBlocks == 0 ) {
+					// push the far child first so the near one, by the first ray's direction, is visited first
+					if( directions[node.mAxis][0] < 0 ) {
+						stack[stackSize++] = nodeIndex + 1;
+						stack[stackSize++] = node.mOffset;
+					}
+					else {
+						stack[stackSize++] = node.mOffset;
+						stack[stackSize++] = nodeIndex + 1;
+					}
+					continue;
+				}
+
+				for( uint32_t b = node.mOffset; b < node.mOffset + node.mNumBlocks; ++b ) {
+					const TriangleBlock &block = mBlocks[b];
+					for( int triangle = 0; triangle < 4; ++triangle ) {
+						if( block.mTriangles[triangle] == NO_TRIANGLE )
+							break;
+						__m128 vert0[3], edge1[3], edge2[3], distance, u, v;
+						for( int axis = 0; axis < 3; ++axis ) {
+							vert0[axis] = _mm_set1_ps( block.mVert0[axis][triangle] );
+							edge1[axis] = _mm_set1_ps( block.mEdge1[axis][triangle] );
+							edge2[axis] = _mm_set1_ps( block.mEdge2[axis][triangle] );
+						}
+						__m128 mask = intersectTriangles4( origin4, direction4, vert0, edge1, edge2, maxDistance4, &distance, &u, &v );
+						int lanes = _mm_movemask_ps( mask );
+						if( ! lanes )
+							continue;
+						maxDistance4 = _mm_or_ps( _mm_and_ps( mask, distance ), _mm_andnot_ps( mask, maxDistance4 ) );
+						float distances[4], us[4], vs[4];
+						_mm_storeu_ps( distances, distance );
+						_mm_storeu_ps( us, u );
+						_mm_storeu_ps( vs, v );
+						for( int lane = 0; lane < 4; ++lane ) {
+							if( lanes & ( 1 << lane ) ) {
+								Hit &hit = results[first + lane];
+								hit.mTriangle = block.mTriangles[triangle];
+								hit.mDistance = distances[lane];
+								hit.mU = us[lane];
+								hit.mV = vs[lane];
+							}
+						}
+					}
+				}
+			}
+		}
+		return;
+	}
+#endif
+
+	for( size_t r = 0; r < numRays; ++r ) {
+		results[r] = Hit();
+		intersect( rays[r], &results[r] );
+	}
+}
+
+} // namespace cinder
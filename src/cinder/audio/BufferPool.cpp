@@ -0,0 +1,178 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cinder/audio/BufferPool.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace cinder { namespace audio {
+
+namespace {
+
+// Precedes every block. Padded so that the data which follows keeps malloc()'s alignment.
+struct BlockHeader {
+	BufferPool	*mPool;
+	uint32_t	mSizeClass;
+	char		mPad[16 - sizeof(BufferPool*) - sizeof(uint32_t)];
+};
+
+} // anonymous namespace
+
+BufferPoolRef BufferPool::createRef( uint32_t maxFreeBlocks )
+{
+	return BufferPoolRef( new BufferPool( maxFreeBlocks ) );
+}
+
+BufferPoolRef BufferPool::getDefault()
+{
+	// leaked deliberately, so that blocks can still be released during static destruction
+	static BufferPoolRef *sDefault = new BufferPoolRef( new BufferPool( 64 ) );
+	return *sDefault;
+}
+
+BufferPool::BufferPool( uint32_t maxFreeBlocks )
+	: mMaxFreeBlocks( maxFreeBlocks )
+{
+	// reserving the free lists up front means releasing a block never allocates
+	for( uint32_t c = 0; c < NUM_SIZE_CLASSES; ++c )
+		mFreeBlocks[c].reserve( mMaxFreeBlocks );
+	resetStats();
+	mStats.mCachedBytes = 0;
+}
+
+BufferPool::~BufferPool()
+{
+	trim();
+}
+
+uint32_t BufferPool::sizeClass( size_t byteSize )
+{
+	uint32_t result = 0;
+	while( ( result < NUM_SIZE_CLASSES ) && ( ( (size_t)1 << ( result + MIN_SIZE_CLASS_SHIFT ) ) < byteSize ) )
+		++result;
+	return result;
+}
+
+void* BufferPool::allocate( size_t byteSize )
+{
+	uint32_t c = sizeClass( byteSize );
+	BlockHeader *block = 0;
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		if( ( c < NUM_SIZE_CLASSES ) && ( ! mFreeBlocks[c].empty() ) ) {
+			block = static_cast<BlockHeader*>( mFreeBlocks[c].back() );
+			mFreeBlocks[c].pop_back();
+			mStats.mCachedBytes -= (size_t)1 << ( c + MIN_SIZE_CLASS_SHIFT );
+			++mStats.mHits;
+		}
+		else
+			++mStats.mMisses;
+	}
+
+	if( ! block ) {
+		size_t blockSize = ( c < NUM_SIZE_CLASSES ) ? ( (size_t)1 << ( c + MIN_SIZE_CLASS_SHIFT ) ) : byteSize;
+		block = static_cast<BlockHeader*>( malloc( sizeof(BlockHeader) + blockSize ) );
+		if( ! block )
+			throw std::bad_alloc();
+		block->mPool = this;
+		block->mSizeClass = c;
+	}
+
+	return block + 1;
+}
+
+void BufferPool::release( void *data )
+{
+	if( ! data )
+		return;
+
+	BlockHeader *block = static_cast<BlockHeader*>( data ) - 1;
+	block->mPool->release( block, block->mSizeClass );
+}
+
+void BufferPool::release( void *block, uint32_t sizeClass )
+{
+	if( sizeClass < NUM_SIZE_CLASSES ) {
+		std::lock_guard<std::mutex> lock( mMutex );
+		if( mFreeBlocks[sizeClass].size() < mMaxFreeBlocks ) {
+			mFreeBlocks[sizeClass].push_back( block );
+			mStats.mCachedBytes += (size_t)1 << ( sizeClass + MIN_SIZE_CLASS_SHIFT );
+			return;
+		}
+		++mStats.mDiscards;
+	}
+
+	free( block );
+}
+
+void BufferPool::reserve( size_t byteSize, uint32_t count )
+{
+	uint32_t c = sizeClass( byteSize );
+	if( c == NUM_SIZE_CLASSES )
+		return;
+
+	uint32_t needed;
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		count = std::min( count, mMaxFreeBlocks );
+		needed = ( mFreeBlocks[c].size() < count ) ? ( count - (uint32_t)mFreeBlocks[c].size() ) : 0;
+	}
+
+	const size_t blockSize = (size_t)1 << ( c + MIN_SIZE_CLASS_SHIFT );
+	for( uint32_t i = 0; i < needed; ++i ) {
+		BlockHeader *block = static_cast<BlockHeader*>( malloc( sizeof(BlockHeader) + blockSize ) );
+		if( ! block )
+			throw std::bad_alloc();
+		block->mPool = this;
+		block->mSizeClass = c;
+		release( block, c );
+	}
+}
+
+void BufferPool::trim()
+{
+	std::lock_guard<std::mutex> lock( mMutex );
+	for( uint32_t c = 0; c < NUM_SIZE_CLASSES; ++c ) {
+		for( std::vector<void*>::iterator blockIt = mFreeBlocks[c].begin(); blockIt != mFreeBlocks[c].end(); ++blockIt )
+			free( *blockIt );
+		mFreeBlocks[c].clear();
+	}
+	mStats.mCachedBytes = 0;
+}
+
+BufferPool::Stats BufferPool::getStats() const
+{
+	std::lock_guard<std::mutex> lock( mMutex );
+	return mStats;
+}
+
+void BufferPool::resetStats()
+{
+	std::lock_guard<std::mutex> lock( mMutex );
+	mStats.mHits = 0;
+	mStats.mMisses = 0;
+	mStats.mDiscards = 0;
+}
+
+}} //namespace
@@ -25,6 +25,9 @@
 #if defined( CINDER_MAC )
 	#include "cinder/audio/FftProcessorImplAccelerate.h"
 	typedef cinder::audio::FftProcessorImplAccelerate	FftProcessorPlatformImpl;
+#else
+	#include "cinder/audio/FftProcessorImplPortable.h"
+	typedef cinder::audio::FftProcessorImplPortable		FftProcessorPlatformImpl;
 #endif
 
 namespace cinder { namespace audio {
@@ -51,20 +51,44 @@ FftProcessorImplAccelerate::~FftProcessorImplAccelerate()
 	vDSP_destroy_fftsetup( mFftSetup );
 }
 
-std::shared_ptr<float> FftProcessorImplAccelerate::process( const float * inData )
+void FftProcessorImplAccelerate::transform( const float * inData )
 {
-	mFftComplexBuffer.realp = (float *)memset( mFftComplexBuffer.realp, 0, mBandCount );
-	mFftComplexBuffer.imagp = (float *)memset( mFftComplexBuffer.imagp, 0, mBandCount );
-	
 	vDSP_ctoz( (DSPComplex *)inData, 2 * sStride, &mFftComplexBuffer, 1, mBandCount );
 	vDSP_fft_zrip( mFftSetup, &mFftComplexBuffer, 1, mLog2Size, FFT_FORWARD );
-	
-	float * outData = new float[mBandCount];
+}
+
+void FftProcessorImplAccelerate::process( const float * inData, float * outMagnitudes )
+{
+	transform( inData );
 	for( int i = 0; i < mBandCount; i++ ) {
-		outData[i] = sqrt( ( mFftComplexBuffer.realp[i] * mFftComplexBuffer.realp[i] ) + ( mFftComplexBuffer.imagp[i] * mFftComplexBuffer.imagp[i] ) );
+		outMagnitudes[i] = sqrt( ( mFftComplexBuffer.realp[i] * mFftComplexBuffer.realp[i] ) + ( mFftComplexBuffer.imagp[i] * mFftComplexBuffer.imagp[i] ) );
 	}
+}
+
+void FftProcessorImplAccelerate::processComplex( const float * inData, float * outReal, float * outImag )
+{
+	transform( inData );
+	memcpy( outReal, mFftComplexBuffer.realp, mBandCount * sizeof( float ) );
+	memcpy( outImag, mFftComplexBuffer.imagp, mBandCount * sizeof( float ) );
+}
+
+void FftProcessorImplAccelerate::processInverse( const float * inReal, const float * inImag, float * outData )
+{
+	memcpy( mFftComplexBuffer.realp, inReal, mBandCount * sizeof( float ) );
+	memcpy( mFftComplexBuffer.imagp, inImag, mBandCount * sizeof( float ) );
+	vDSP_fft_zrip( mFftSetup, &mFftComplexBuffer, 1, mLog2Size, FFT_INVERSE );
+	vDSP_ztoc( &mFftComplexBuffer, 1, (DSPComplex *)outData, 2 * sStride, mBandCount );
 	
-	return std::shared_ptr<float>( outData, deleteFftBuffer );;
+	// a forward and inverse vDSP_fft_zrip() scale the input by twice the sample count
+	float scale = 1.0f / ( 4 * mBandCount );
+	vDSP_vsmul( outData, 1, &scale, outData, 1, mBandCount * 2 );
+}
+
+std::shared_ptr<float> FftProcessorImplAccelerate::process( const float * inData )
+{
+	float * outData = new float[mBandCount];
+	process( inData, outData );
+	return std::shared_ptr<float>( outData, deleteFftBuffer );
 }
 
 }} //namespace
\ No newline at end of file
@@ -0,0 +1,287 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cinder/audio/FftProcessorImplPortable.h"
+#include "cinder/System.h"
+#include "cinder/Thread.h"
+#include "cinder/CinderMath.h"
+
+#include <map>
+#include <cmath>
+
+#if defined( CINDER_SSE2 )
+	#include <emmintrin.h>
+#endif
+
+namespace cinder { namespace audio {
+
+// The input of 2N real samples is treated as N complex samples z[n] = x[2n] + i x[2n+1]. Their FFT Z is computed with iterative
+// radix-2 butterflies, and the real spectrum recovered as X[k] = ( Z[k] + Z*[N-k] ) / 2 - i w^k ( Z[k] - Z*[N-k] ) / 2, where w = e^(-i pi / N).
+struct FftProcessorImplPortable::Plan {
+	Plan( uint16_t bandCount );
+
+	uint32_t				mSize; // N, the length of the complex FFT, which is the band count
+	std::vector<uint32_t>	mBitReverse;
+	// twiddles for the butterfly stage of half-length h are at [h, 2h)
+	std::vector<float>		mStageReal, mStageImag;
+	// w^k for splitting the complex FFT into the real spectrum, k in [0, N/2]
+	std::vector<float>		mSplitReal, mSplitImag;
+};
+
+FftProcessorImplPortable::Plan::Plan( uint16_t bandCount )
+	: mSize( bandCount ), mBitReverse( bandCount ), mStageReal( bandCount ), mStageImag( bandCount ), mSplitReal( bandCount / 2 + 1 ), mSplitImag( bandCount / 2 + 1 )
+{
+	uint32_t log2Size = 0;
+	while( ( 1u << log2Size ) < mSize )
+		++log2Size;
+	for( uint32_t i = 0; i < mSize; ++i ) {
+		uint32_t r = 0;
+		for( uint32_t b = 0; b < log2Size; ++b )
+			r |= ( ( i >> b ) & 1 ) << ( log2Size - 1 - b );
+		mBitReverse[i] = r;
+	}
+
+	// twiddles are calculated in double precision so that their error doesn't accumulate across stages
+	for( uint32_t half = 1; half < mSize; half *= 2 ) {
+		for( uint32_t j = 0; j < half; ++j ) {
+			double angle = -M_PI * j / half;
+			mStageReal[half + j] = (float)cos( angle );
+			mStageImag[half + j] = (float)sin( angle );
+		}
+	}
+
+	for( uint32_t k = 0; k <= mSize / 2; ++k ) {
+		double angle = -M_PI * k / mSize;
+		mSplitReal[k] = (float)cos( angle );
+		mSplitImag[k] = (float)sin( angle );
+	}
+}
+
+namespace {
+
+std::mutex																sPlanMutex;
+std::map<uint16_t,std::shared_ptr<const FftProcessorImplPortable::Plan> >	sPlans;
+
+// Performs the butterflies of the stage whose half-length is \a half, for \a size complex values
+void butterflyStage( float *re, float *im, uint32_t size, uint32_t half, const float *twRe, const float *twIm )
+{
+	for( uint32_t start = 0; start < size; start += half * 2 ) {
+		float *aRe = re + start, *aIm = im + start;
+		float *bRe = aRe + half, *bIm = aIm + half;
+		for( uint32_t j = 0; j < half; ++j ) {
+			float tRe = bRe[j] * twRe[j] - bIm[j] * twIm[j];
+			float tIm = bRe[j] * twIm[j] + bIm[j] * twRe[j];
+			bRe[j] = aRe[j] - tRe;
+			bIm[j] = aIm[j] - tIm;
+			aRe[j] += tRe;
+			aIm[j] += tIm;
+		}
+	}
+}
+
+#if defined( CINDER_SSE2 )
+// SSE2 version of butterflyStage(), which requires \a half to be a multiple of 4
+void butterflyStageSse2( float *re, float *im, uint32_t size, uint32_t half, const float *twRe, const float *twIm )
+{
+	for( uint32_t start = 0; start < size; start += half * 2 ) {
+		float *aRe = re + start, *aIm = im + start;
+		float *bRe = aRe + half, *bIm = aIm + half;
+		for( uint32_t j = 0; j < half; j += 4 ) {
+			__m128 wr = _mm_loadu_ps( twRe + j ), wi = _mm_loadu_ps( twIm + j );
+			__m128 br = _mm_loadu_ps( bRe + j ), bi = _mm_loadu_ps( bIm + j );
+			__m128 ar = _mm_loadu_ps( aRe + j ), ai = _mm_loadu_ps( aIm + j );
+			__m128 tr = _mm_sub_ps( _mm_mul_ps( br, wr ), _mm_mul_ps( bi, wi ) );
+			__m128 ti = _mm_add_ps( _mm_mul_ps( br, wi ), _mm_mul_ps( bi, wr ) );
+			_mm_storeu_ps( bRe + j, _mm_sub_ps( ar, tr ) );
+			_mm_storeu_ps( bIm + j, _mm_sub_ps( ai, ti ) );
+			_mm_storeu_ps( aRe + j, _mm_add_ps( ar, tr ) );
+			_mm_storeu_ps( aIm + j, _mm_add_ps( ai, ti ) );
+		}
+	}
+}
+#endif
+
+} // anonymous namespace
+
+std::shared_ptr<const FftProcessorImplPortable::Plan> FftProcessorImplPortable::getPlan( uint16_t bandCount )
+{
+	std::lock_guard<std::mutex> lock( sPlanMutex );
+	std::shared_ptr<const Plan> &plan = sPlans[bandCount];
+	if( ! plan )
+		plan = std::shared_ptr<const Plan>( new Plan( bandCount ) );
+	return plan;
+}
+
+FftProcessorImplPortable::FftProcessorImplPortable( uint16_t aBandCount )
+	: FftProcessorImpl( aBandCount )
+{
+	if( ( mBandCount == 0 ) || ( mBandCount & ( mBandCount - 1 ) ) )
+		throw FftProcessorExceptionInvalidBandCount();
+
+	mPlan = getPlan( mBandCount );
+	mReal.resize( mBandCount );
+	mImag.resize( mBandCount );
+	mOutReal.resize( mBandCount );
+	mOutImag.resize( mBandCount );
+}
+
+FftProcessorImplPortable::~FftProcessorImplPortable()
+{
+}
+
+void FftProcessorImplPortable::transform( const float * inBuffer )
+{
+	const uint32_t size = mPlan->mSize;
+	const uint32_t *bitReverse = &mPlan->mBitReverse[0];
+	float *re = &mReal[0], *im = &mImag[0];
+
+	// deinterleave the even and odd samples straight into bit-reversed order
+	for( uint32_t n = 0; n < size; ++n ) {
+		re[bitReverse[n]] = inBuffer[n * 2];
+		im[bitReverse[n]] = inBuffer[n * 2 + 1];
+	}
+
+	butterflies();
+}
+
+void FftProcessorImplPortable::butterflies()
+{
+	static const bool useSse2 = System::hasSse2();
+
+	const uint32_t size = mPlan->mSize;
+	float *re = &mReal[0], *im = &mImag[0];
+
+	// the first two stages need no multiplications
+	if( size >= 2 ) {
+		for( uint32_t a = 0; a < size; a += 2 ) {
+			float tRe = re[a + 1], tIm = im[a + 1];
+			re[a + 1] = re[a] - tRe;	im[a + 1] = im[a] - tIm;
+			re[a] += tRe;				im[a] += tIm;
+		}
+	}
+	if( size >= 4 ) {
+		for( uint32_t a = 0; a < size; a += 4 ) {
+			float tRe = re[a + 2], tIm = im[a + 2];
+			re[a + 2] = re[a] - tRe;	im[a + 2] = im[a] - tIm;
+			re[a] += tRe;				im[a] += tIm;
+			// multiplied by the twiddle -i
+			tRe = im[a + 3];			tIm = -re[a + 3];
+			re[a + 3] = re[a + 1] - tRe;	im[a + 3] = im[a + 1] - tIm;
+			re[a + 1] += tRe;			im[a + 1] += tIm;
+		}
+	}
+
+	for( uint32_t half = 4; half < size; half *= 2 ) {
+#if defined( CINDER_SSE2 )
+		if( useSse2 ) {
+			butterflyStageSse2( re, im, size, half, &mPlan->mStageReal[half], &mPlan->mStageImag[half] );
+			continue;
+		}
+#endif
+		butterflyStage( re, im, size, half, &mPlan->mStageReal[half], &mPlan->mStageImag[half] );
+	}
+}
+
+void FftProcessorImplPortable::processComplex( const float * inBuffer, float * outReal, float * outImag )
+{
+	transform( inBuffer );
+
+	const uint32_t size = mPlan->mSize;
+	const float *re = &mReal[0], *im = &mImag[0];
+	const float *wRe = &mPlan->mSplitReal[0], *wIm = &mPlan->mSplitImag[0];
+
+	// DC and Nyquist are both real, and are packed together into band 0
+	outReal[0] = 2 * ( re[0] + im[0] );
+	outImag[0] = 2 * ( re[0] - im[0] );
+
+	// bands k and N - k are built from the same pair of complex values; results are 2X[k] to match vDSP
+	for( uint32_t k = 1; k <= size / 2; ++k ) {
+		const uint32_t m = size - k;
+		float sumRe = re[k] + re[m], sumIm = im[k] - im[m];		// Z[k] + Z*[N-k]
+		float difRe = re[k] - re[m], difIm = im[k] + im[m];		// Z[k] - Z*[N-k]
+		// -i w^k ( Z[k] - Z*[N-k] )
+		float oddRe = difRe * wIm[k] + difIm * wRe[k];
+		float oddIm = difIm * wIm[k] - difRe * wRe[k];
+		outReal[k] = sumRe + oddRe;
+		outImag[k] = sumIm + oddIm;
+		if( m != k ) {
+			// by symmetry X[N-k] = ( Z[N-k] + Z*[k] ) / 2 - i w^(N-k) ( Z[N-k] - Z*[k] ) / 2, where w^(N-k) = -conj( w^k )
+			outReal[m] = sumRe - oddRe;
+			outImag[m] = oddIm - sumIm;
+		}
+	}
+}
+
+void FftProcessorImplPortable::processInverse( const float * inReal, const float * inImag, float * outBuffer )
+{
+	const uint32_t size = mPlan->mSize;
+	const uint32_t *bitReverse = &mPlan->mBitReverse[0];
+	float *re = &mReal[0], *im = &mImag[0];
+	const float *wRe = &mPlan->mSplitReal[0], *wIm = &mPlan->mSplitImag[0];
+
+	// Undoing the split gives Z[k] = E[k] + i O[k], where E[k] = ( X[k] + X*[N-k] ) / 2 and O[k] = conj( w^k ) ( X[k] - X*[N-k] ) / 2.
+	// The inverse FFT of Z is computed with the forward butterflies by swapping real and imaginary parts on the way in and out.
+	// The input is 2X, so 4Z is stored and the factor of 4 is folded into the final 1 / N scale.
+	re[0] = inReal[0] - inImag[0];
+	im[0] = inReal[0] + inImag[0];
+	for( uint32_t k = 1; k <= size / 2; ++k ) {
+		const uint32_t m = size - k;
+		float sumRe = inReal[k] + inReal[m], sumIm = inImag[k] - inImag[m];	// X[k] + X*[N-k]
+		float difRe = inReal[k] - inReal[m], difIm = inImag[k] + inImag[m];	// X[k] - X*[N-k]
+		// conj( w^k ) ( X[k] - X*[N-k] )
+		float oddRe = difRe * wRe[k] + difIm * wIm[k];
+		float oddIm = difIm * wRe[k] - difRe * wIm[k];
+		// Z[k] = E[k] + i O[k], stored swapped
+		re[bitReverse[k]] = sumIm + oddRe;
+		im[bitReverse[k]] = sumRe - oddIm;
+		if( m != k ) {
+			// E[N-k] = conj( E[k] ) and O[N-k] = conj( O[k] )
+			re[bitReverse[m]] = oddRe - sumIm;
+			im[bitReverse[m]] = sumRe + oddIm;
+		}
+	}
+
+	butterflies();
+
+	const float scale = 1.0f / ( 4 * size );
+	for( uint32_t n = 0; n < size; ++n ) {
+		outBuffer[n * 2] = im[n] * scale;
+		outBuffer[n * 2 + 1] = re[n] * scale;
+	}
+}
+
+void FftProcessorImplPortable::process( const float * inBuffer, float * outMagnitudes )
+{
+	float *outRe = &mOutReal[0], *outIm = &mOutImag[0];
+	processComplex( inBuffer, outRe, outIm );
+	for( uint16_t i = 0; i < mBandCount; ++i )
+		outMagnitudes[i] = math<float>::sqrt( outRe[i] * outRe[i] + outIm[i] * outIm[i] );
+}
+
+std::shared_ptr<float> FftProcessorImplPortable::process( const float * inBuffer )
+{
+	std::shared_ptr<float> result( new float[mBandCount], checked_array_deleter<float>() );
+	process( inBuffer, result.get() );
+	return result;
+}
+
+}} //namespace
@@ -28,6 +28,10 @@
 #elif defined( CINDER_MSW )
 	#include "cinder/audio/OutputImplXAudio.h"
 	typedef cinder::audio::OutputImplXAudio	OutputPlatformImpl;
+#else
+	// without an audio device backend tracks only play when rendered
+	#include "cinder/audio/OutputImplOffline.h"
+	typedef cinder::audio::OutputImplOffline	OutputPlatformImpl;
 #endif
 
 
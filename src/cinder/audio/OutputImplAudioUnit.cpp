@@ -147,7 +147,7 @@ void OutputImplAudioUnit::Track::setTime( double aTime )
 
 PcmBuffer32fRef OutputImplAudioUnit::Track::getPcmBuffer()
 {
-	boost::mutex::scoped_lock( mPcmBufferMutex );
+	boost::mutex::scoped_lock lock( mPcmBufferMutex );
 	return mLoadedPcmBuffer;
 }
 
@@ -167,7 +167,7 @@ OSStatus OutputImplAudioUnit::Track::renderCallback( void * audioTrack, AudioUni
 	} else {
 		BufferList bufferList;
 		bufferList.mNumberBuffers = ioData->mNumberBuffers;
-		bufferList.mBuffers = new BufferGeneric[bufferList.mNumberBuffers];
+		bufferList.mBuffers = BufferPool::getDefault()->allocate<BufferGeneric>( bufferList.mNumberBuffers );
 		for( int i = 0; i < bufferList.mNumberBuffers; i++ ) {
 			bufferList.mBuffers[i].mNumberChannels = ioData->mBuffers[i].mNumberChannels;
 			bufferList.mBuffers[i].mDataByteSize = ioData->mBuffers[i].mDataByteSize;
@@ -184,7 +184,7 @@ OSStatus OutputImplAudioUnit::Track::renderCallback( void * audioTrack, AudioUni
 			ioData->mBuffers[i].mData = bufferList.mBuffers[i].mData;
 		}
 		
-		delete [] bufferList.mBuffers;
+		BufferPool::release( bufferList.mBuffers );
 		
 	}
 	
@@ -193,8 +193,18 @@ OSStatus OutputImplAudioUnit::Track::renderCallback( void * audioTrack, AudioUni
 		if( ! theTrack->mLoadingPcmBuffer || ( theTrack->mLoadingPcmBuffer->getSampleCount() + ( ioData->mBuffers[0].mDataByteSize / sizeof(float) ) > theTrack->mLoadingPcmBuffer->getMaxSampleCount() ) ) {
 			boost::mutex::scoped_lock lock( theTrack->mPcmBufferMutex );
 			uint32_t bufferSampleCount = 1470; //TODO: make this settable, 1470 ~= 44100(samples/sec)/30(frmaes/second)
+			//reuse the previously loaded buffer if nobody else holds it anymore, so that steady playback doesn't allocate
+			PcmBuffer32fRef recycledBuffer;
+			if( theTrack->mLoadedPcmBuffer && theTrack->mLoadedPcmBuffer.unique() ) {
+				recycledBuffer = theTrack->mLoadedPcmBuffer;
+				recycledBuffer->clear();
+			}
 			theTrack->mLoadedPcmBuffer = theTrack->mLoadingPcmBuffer;
-			theTrack->mLoadingPcmBuffer = PcmBuffer32fRef( new PcmBuffer32f( bufferSampleCount, theTrack->mTarget->getChannelCount(), theTrack->mTarget->isInterleaved() ) );
+			if( recycledBuffer ) {
+				theTrack->mLoadingPcmBuffer = recycledBuffer;
+			} else {
+				theTrack->mLoadingPcmBuffer = PcmBuffer32fRef( new PcmBuffer32f( bufferSampleCount, theTrack->mTarget->getChannelCount(), theTrack->mTarget->isInterleaved() ) );
+			}
 		}
 		
 		for( int i = 0; i < ioData->mNumberBuffers; i++ ) {
@@ -0,0 +1,300 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cinder/audio/OutputImplOffline.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace cinder { namespace audio {
+
+namespace {
+
+bool isMixableDataType( Io::DataType dataType )
+{
+	return ( dataType == Io::UINT8 ) || ( dataType == Io::INT16 ) || ( dataType == Io::INT32 ) || ( dataType == Io::FLOAT32 );
+}
+
+} // anonymous namespace
+
+//tracks load their source's own sample type and channel count, which Track::mix() converts and mixes itself
+TargetOutputImplOffline::TargetOutputImplOffline( const Source *aSource, int32_t aSampleRate )
+	: Target()
+{
+	if( ! isMixableDataType( aSource->getDataType() ) ) {
+		throw IoExceptionUnsupportedDataType();
+	}
+	
+	mSampleRate = aSampleRate;
+	mChannelCount = aSource->getChannelCount();
+	mDataType = aSource->getDataType();
+	mBitsPerSample = ( mDataType == Io::UINT8 ) ? 8 : ( ( mDataType == Io::INT16 ) ? 16 : 32 );
+	mBlockAlign = ( mBitsPerSample / 8 ) * mChannelCount;
+	mIsInterleaved = true;
+	mIsPcm = true;
+	mIsBigEndian = false;
+}
+
+OutputImplOffline::Track::Track( SourceRef source, OutputImplOffline *output )
+	: cinder::audio::Track(), mSource( source ), mOutput( output ), mIsPlaying( false ), mIsLooping( false ), mIsPcmBuffering( false ), mVolume( 1.0f )
+{
+	const Format &format = mOutput->getFormat();
+	if( mSource->getSampleRate() != format.getSampleRate() ) {
+		//there's no resampling, so the source would play at the wrong speed
+		throw IoExceptionUnsupportedDataFormat();
+	}
+	if( ( mSource->getChannelCount() != format.getChannelCount() ) && ( mSource->getChannelCount() != 1 ) ) {
+		throw IoExceptionUnsupportedDataFormat();
+	}
+	
+	mTrackId = mOutput->availableTrackId();
+	mTarget = TargetOutputImplOffline::createRef( mSource.get(), format.getSampleRate() );
+	mLoader = mSource->createLoader( mTarget.get() );
+	
+	mLoadData.resize( format.getBlockSize() * mTarget->getBlockAlign() );
+	if( mTarget->getDataType() != Io::FLOAT32 ) {
+		mFloatData.resize( format.getBlockSize() * mTarget->getChannelCount() );
+	}
+}
+
+void OutputImplOffline::Track::setTime( double aTime )
+{
+	mLoader->setSampleOffset( static_cast<uint64_t>( aTime * mSource->getSampleRate() ) );
+}
+
+PcmBuffer32fRef OutputImplOffline::Track::getPcmBuffer()
+{
+	boost::mutex::scoped_lock lock( mPcmBufferMutex );
+	return mLoadedPcmBuffer;
+}
+
+const float* OutputImplOffline::Track::toFloat( const void *data, uint32_t sampleCount )
+{
+	size_t count = (size_t)sampleCount * mTarget->getChannelCount();
+	switch( mTarget->getDataType() ) {
+		case Io::UINT8: convertSamples( reinterpret_cast<const uint8_t*>( data ), &mFloatData[0], count ); break;
+		case Io::INT16: convertSamples( reinterpret_cast<const int16_t*>( data ), &mFloatData[0], count ); break;
+		case Io::INT32: convertSamples( reinterpret_cast<const int32_t*>( data ), &mFloatData[0], count ); break;
+		default: return reinterpret_cast<const float*>( data );
+	}
+	return &mFloatData[0];
+}
+
+void OutputImplOffline::Track::appendToPcmBuffer( const float *data, uint32_t sampleCount )
+{
+	if( ! mLoadingPcmBuffer || ( mLoadingPcmBuffer->getSampleCount() + sampleCount > mLoadingPcmBuffer->getMaxSampleCount() ) ) {
+		boost::mutex::scoped_lock lock( mPcmBufferMutex );
+		//a buffer's worth of samples is at least a block, and ~1/30th of a second like the realtime outputs
+		uint32_t bufferSampleCount = std::max<uint32_t>( mOutput->getFormat().getBlockSize(), mSource->getSampleRate() / 30 );
+		//reuse the previously loaded buffer if nobody else holds it anymore, so that steady rendering doesn't allocate
+		PcmBuffer32fRef recycledBuffer;
+		if( mLoadedPcmBuffer && mLoadedPcmBuffer.unique() ) {
+			recycledBuffer = mLoadedPcmBuffer;
+			recycledBuffer->clear();
+		}
+		if( mLoadingPcmBuffer ) {
+			mLoadedPcmBuffer = mLoadingPcmBuffer;
+		}
+		if( recycledBuffer ) {
+			mLoadingPcmBuffer = recycledBuffer;
+		} else {
+			mLoadingPcmBuffer = PcmBuffer32fRef( new PcmBuffer32f( bufferSampleCount, mTarget->getChannelCount(), true ) );
+		}
+	}
+	
+	mLoadingPcmBuffer->appendInterleavedData( const_cast<float*>( data ), sampleCount );
+}
+
+void OutputImplOffline::Track::mix( float *mixData, uint32_t sampleCount, float gain )
+{
+	const uint16_t channelCount = mOutput->getFormat().getChannelCount();
+	const uint16_t sourceChannelCount = mTarget->getChannelCount();
+	gain *= mVolume;
+	
+	uint32_t mixed = 0;
+	bool rewound = false;
+	while( mIsPlaying && ( mixed < sampleCount ) ) {
+		BufferGeneric buffer;
+		buffer.mNumberChannels = sourceChannelCount;
+		buffer.mSampleCount = sampleCount - mixed;
+		buffer.mDataByteSize = buffer.mSampleCount * mTarget->getBlockAlign();
+		buffer.mData = &mLoadData[0];
+		BufferList bufferList;
+		bufferList.mNumberBuffers = 1;
+		bufferList.mBuffers = &buffer;
+		
+		mLoader->loadData( &bufferList );
+		
+		uint32_t loaded = std::min( buffer.mSampleCount, sampleCount - mixed );
+		if( loaded == 0 ) {
+			//rewinding twice in a row means the source is empty
+			if( mIsLooping && ! rewound ) {
+				mLoader->setSampleOffset( 0 );
+				rewound = true;
+				continue;
+			}
+			mIsPlaying = false;
+			break;
+		}
+		rewound = false;
+		
+		//loaders may hand back their own buffer rather than filling ours
+		const float *samples = toFloat( buffer.mData, loaded );
+		if( mIsPcmBuffering ) {
+			appendToPcmBuffer( samples, loaded );
+		}
+		
+		float *dst = mixData + (size_t)mixed * channelCount;
+		if( sourceChannelCount == channelCount ) {
+			mixSamples( samples, dst, (size_t)loaded * channelCount, gain );
+		} else {
+			//mono sources are mixed into every channel
+			for( uint32_t i = 0; i < loaded; i++ ) {
+				float sample = samples[i] * gain;
+				for( uint16_t c = 0; c < channelCount; c++ ) {
+					dst[i * channelCount + c] += sample;
+				}
+			}
+		}
+		mixed += loaded;
+	}
+}
+
+OutputImplOffline::OutputImplOffline( const Format &format )
+	: OutputImpl(), mFormat( format ), mVolume( 1.0f ), mSampleOffset( 0 )
+{
+	if( ( mFormat.getSampleRate() <= 0 ) || ( mFormat.getChannelCount() == 0 ) || ( mFormat.getBlockSize() == 0 ) ) {
+		throw OutputException();
+	}
+}
+
+OutputImplOffline::~OutputImplOffline()
+{
+}
+
+TrackRef OutputImplOffline::addTrack( SourceRef aSource, bool autoplay )
+{
+	std::shared_ptr<OutputImplOffline::Track> track( new OutputImplOffline::Track( aSource, this ) );
+	mTracks.insert( std::pair<TrackId,std::shared_ptr<OutputImplOffline::Track> >( track->getTrackId(), track ) );
+	if( autoplay ) {
+		track->play();
+	}
+	return track;
+}
+
+void OutputImplOffline::removeTrack( TrackId trackId )
+{
+	mTracks.erase( trackId );
+}
+
+void OutputImplOffline::render( float *interleavedData, uint32_t sampleCount )
+{
+	const uint16_t channelCount = mFormat.getChannelCount();
+	for( uint32_t rendered = 0; rendered < sampleCount; ) {
+		uint32_t blockSize = std::min( mFormat.getBlockSize(), sampleCount - rendered );
+		float *block = interleavedData + (size_t)rendered * channelCount;
+		memset( block, 0, (size_t)blockSize * channelCount * sizeof(float) );
+		
+		for( std::map<TrackId,std::shared_ptr<OutputImplOffline::Track> >::iterator trackIt = mTracks.begin(); trackIt != mTracks.end(); ++trackIt ) {
+			if( trackIt->second->isPlaying() ) {
+				trackIt->second->mix( block, blockSize, mVolume );
+			}
+		}
+		
+		rendered += blockSize;
+		mSampleOffset += blockSize;
+	}
+}
+
+PcmBuffer32fRef OutputImplOffline::render( uint32_t sampleCount )
+{
+	PcmBuffer32fRef result( new PcmBuffer32f( sampleCount, mFormat.getChannelCount(), true ) );
+	float *data = BufferPool::getDefault()->allocate<float>( (size_t)sampleCount * mFormat.getChannelCount() );
+	render( data, sampleCount );
+	result->appendInterleavedData( data, sampleCount );
+	BufferPool::release( data );
+	return result;
+}
+
+void OutputImplOffline::renderToWav( OStreamRef stream, uint64_t sampleCount, Io::DataType dataType )
+{
+	if( ( dataType != Io::INT16 ) && ( dataType != Io::FLOAT32 ) ) {
+		throw IoExceptionUnsupportedDataType();
+	}
+	
+	const uint16_t channelCount = mFormat.getChannelCount();
+	const uint16_t bitsPerSample = ( dataType == Io::INT16 ) ? 16 : 32;
+	const uint16_t blockAlign = ( bitsPerSample / 8 ) * channelCount;
+	//the data chunk's size has to fit in 32 bits along with the rest of the RIFF chunk
+	if( sampleCount * blockAlign > std::numeric_limits<uint32_t>::max() - 36 ) {
+		throw IoExceptionUnsupportedDataFormat();
+	}
+	const uint32_t dataLength = static_cast<uint32_t>( sampleCount * blockAlign );
+	
+	//sampleCount is known up front, so the header is written complete and the stream is never rewound
+	stream->writeData( "RIFF", 4 );
+	stream->writeLittle( (uint32_t)( 36 + dataLength ) );
+	stream->writeData( "WAVE", 4 );
+	stream->writeData( "fmt ", 4 );
+	stream->writeLittle( (uint32_t)16 );
+	stream->writeLittle( (uint16_t)( ( dataType == Io::INT16 ) ? 0x0001 : 0x0003 ) ); // PCM or IEEE float
+	stream->writeLittle( channelCount );
+	stream->writeLittle( (uint32_t)mFormat.getSampleRate() );
+	stream->writeLittle( (uint32_t)( mFormat.getSampleRate() * blockAlign ) );
+	stream->writeLittle( blockAlign );
+	stream->writeLittle( bitsPerSample );
+	stream->writeData( "data", 4 );
+	stream->writeLittle( dataLength );
+	
+	const uint32_t blockSize = mFormat.getBlockSize();
+	float *mixData = BufferPool::getDefault()->allocate<float>( (size_t)blockSize * channelCount );
+	int16_t *fileData = ( dataType == Io::INT16 ) ? BufferPool::getDefault()->allocate<int16_t>( (size_t)blockSize * channelCount ) : 0;
+	try {
+		for( uint64_t rendered = 0; rendered < sampleCount; ) {
+			uint32_t count = (uint32_t)std::min<uint64_t>( blockSize, sampleCount - rendered );
+			size_t samples = (size_t)count * channelCount;
+			render( mixData, count );
+			if( fileData ) {
+				convertSamples( mixData, fileData, samples, &mDither );
+#if ! defined( CINDER_LITTLE_ENDIAN )
+				swapSampleBytes( fileData, samples );
+#endif
+				stream->writeData( fileData, samples * sizeof(int16_t) );
+			} else {
+#if ! defined( CINDER_LITTLE_ENDIAN )
+				swapSampleBytes( mixData, samples );
+#endif
+				stream->writeData( mixData, samples * sizeof(float) );
+			}
+			rendered += count;
+		}
+	}
+	catch( ... ) {
+		BufferPool::release( mixData );
+		BufferPool::release( fileData );
+		throw;
+	}
+	BufferPool::release( mixData );
+	BufferPool::release( fileData );
+}
+
+}} //namespace
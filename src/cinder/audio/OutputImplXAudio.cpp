@@ -21,6 +21,7 @@
 */
 
 #include "cinder/audio/OutputImplXAudio.h"
+#include "cinder/audio/SampleConversion.h"
 
 namespace cinder { namespace audio {
 
@@ -159,7 +160,7 @@ float OutputImplXAudio::Track::getVolume() const
 
 PcmBuffer32fRef OutputImplXAudio::Track::getPcmBuffer()
 {
-	boost::mutex::scoped_lock( mPcmBufferMutex );
+	boost::mutex::scoped_lock lock( mPcmBufferMutex );
 	return mLoadedPcmBuffer;
 }
 
@@ -210,23 +211,31 @@ void OutputImplXAudio::Track::fillBuffer()
 				boost::mutex::scoped_lock lock( mPcmBufferMutex );
 				//TODO: make this settable, 1470 ~= 44100(samples/sec)/30(frmaes/second), also make sure the buffer isn't going to be larger than this? perhaps wrap data across buffers?
 				uint32_t bufferSampleCount = 2500;
+				//reuse the previously loaded buffer if nobody else holds it anymore, so that steady playback doesn't allocate
+				PcmBuffer32fRef recycledBuffer;
+				if( mLoadedPcmBuffer && mLoadedPcmBuffer.unique() ) {
+					recycledBuffer = mLoadedPcmBuffer;
+					recycledBuffer->clear();
+				}
 				if( mLoadingPcmBuffer ) {
-					mLoadedPcmBuffer = PcmBuffer32fRef();
 					mLoadedPcmBuffer = mLoadingPcmBuffer;
 				}
-				mLoadingPcmBuffer = PcmBuffer32fRef( new PcmBuffer32f( bufferSampleCount, mVoiceDescription.nChannels, true ) );
+				if( recycledBuffer ) {
+					mLoadingPcmBuffer = recycledBuffer;
+				} else {
+					mLoadingPcmBuffer = PcmBuffer32fRef( new PcmBuffer32f( bufferSampleCount, mVoiceDescription.nChannels, true ) );
+				}
 			}
 
-			//TODO: only do this if Voice is not Float and make this more efficient
-			//TODO: right now this only supports uint16_t
-			float * copyBuffer = new float[sampleCount * buffer.mNumberChannels];
-			int16_t * srcBuffer = reinterpret_cast<int16_t *>( buffer.mData );
-			for( uint32_t i = 0; i < ( sampleCount * buffer.mNumberChannels ); i++ ) {
-				//TODO: abstract this conversion
-				copyBuffer[i] = ( ( srcBuffer[i] / 32767.0f ) + 1.0f ) * 0.5f;
+			//TODO: right now this only supports int16_t and float voices
+			if( mVoiceDescription.wFormatTag == WAVE_FORMAT_IEEE_FLOAT ) {
+				mLoadingPcmBuffer->appendInterleavedData( reinterpret_cast<float *>( buffer.mData ), sampleCount );
+			} else {
+				float * copyBuffer = BufferPool::getDefault()->allocate<float>( sampleCount * buffer.mNumberChannels );
+				convertSamples( reinterpret_cast<int16_t *>( buffer.mData ), copyBuffer, sampleCount * buffer.mNumberChannels );
+				mLoadingPcmBuffer->appendInterleavedData( copyBuffer, sampleCount );
+				BufferPool::release( copyBuffer );
 			}
-			mLoadingPcmBuffer->appendInterleavedData( copyBuffer, sampleCount );
-			delete [] copyBuffer;
 		}
 		
 		mCurrentBuffer++;
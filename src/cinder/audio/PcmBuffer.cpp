@@ -21,6 +21,9 @@
 */
 
 #include "cinder/audio/PcmBuffer.h"
+#include "cinder/audio/SampleConversion.h"
+
+#include <vector>
 
 namespace cinder { namespace audio {
 
@@ -33,8 +36,15 @@ void deleteBuffer( BufferT<T> * aBuffer )
 	delete aBuffer;
 }
 
+template<typename T> 
+void releaseBuffer( BufferT<T> * aBuffer ) 
+{
+	BufferPool::release( aBuffer->mData );
+	delete aBuffer;
+}
+
 template<typename T>
-std::shared_ptr<BufferListT<T> > createBufferList( uint32_t sampleCount, uint16_t channelCount, bool isInterleaved )
+std::shared_ptr<BufferListT<T> > createBufferList( uint32_t sampleCount, uint16_t channelCount, bool isInterleaved, BufferPoolRef pool )
 {
 	void (*fn)( BufferListT<T> * ) = deleteBufferList;
 	std::shared_ptr<BufferListT<T> > bufferList( new BufferListT<T>, fn );
@@ -57,7 +67,7 @@ std::shared_ptr<BufferListT<T> > createBufferList( uint32_t sampleCount, uint16_
 	for( int i = 0; i < bufferCount; i++ ) {
 		bufferList->mBuffers[i].mNumberChannels = channelsPerBuffer;
 		bufferList->mBuffers[i].mDataByteSize = bufferSize * sizeof(T);
-		bufferList->mBuffers[i].mData = new T[bufferSize];
+		bufferList->mBuffers[i].mData = pool->allocate<T>( bufferSize );
 		bufferList->mBuffers[i].mSampleCount = sampleCount;
 	}
 	
@@ -66,23 +76,25 @@ std::shared_ptr<BufferListT<T> > createBufferList( uint32_t sampleCount, uint16_
 
 template<typename T>
 void deleteBufferList( BufferListT<T> * aBufferList ) {
-	for( int i = 0; i < aBufferList->mNumberBuffers; i++ ) {
-		deleteBuffer( &( aBufferList->mBuffers[i] ) );
+	for( uint32_t i = 0; i < aBufferList->mNumberBuffers; i++ ) {
+		BufferPool::release( aBufferList->mBuffers[i].mData );
 	}
+	delete [] aBufferList->mBuffers;
 	delete aBufferList;
 }
 
 #define CREATE_BUFFERLIST_PROTOTYPES(r,data,T)\
 	template void deleteBuffer( BufferT<T> * aBuffer );\
-	template std::shared_ptr<BufferListT<T> > createBufferList( uint32_t sampleCount, uint16_t channelCount, bool isInterleaved );\
+	template void releaseBuffer( BufferT<T> * aBuffer );\
+	template std::shared_ptr<BufferListT<T> > createBufferList( uint32_t sampleCount, uint16_t channelCount, bool isInterleaved, BufferPoolRef pool );\
 	template void deleteBufferList( BufferListT<T> * aBuffer );
 
 BOOST_PP_SEQ_FOR_EACH( CREATE_BUFFERLIST_PROTOTYPES, ~, AUDIO_DATA_TYPES )
 
 
 template<typename T>
-PcmBufferT<T>::PcmBufferT( uint32_t aMaxSampleCount, uint16_t aChannelCount, bool isInterleaved ) 
-	: mMaxSampleCount( aMaxSampleCount ), mChannelCount( aChannelCount ), mIsInterleaved( isInterleaved )
+PcmBufferT<T>::PcmBufferT( uint32_t aMaxSampleCount, uint16_t aChannelCount, bool isInterleaved, BufferPoolRef pool ) 
+	: mMaxSampleCount( aMaxSampleCount ), mChannelCount( aChannelCount ), mIsInterleaved( isInterleaved ), mPool( pool )
 {
 	uint32_t bufferSize = 0;
 	uint16_t channelsPerBuffer = 0;
@@ -97,13 +109,13 @@ PcmBufferT<T>::PcmBufferT( uint32_t aMaxSampleCount, uint16_t aChannelCount, boo
 	}
 	
 	mBufferSampleCounts = new uint32_t[mBufferCount];
-	void (*fn)( BufferT<T> * ) = deleteBuffer;
+	void (*fn)( BufferT<T> * ) = releaseBuffer;
 	for( int i = 0; i < mBufferCount; i++ ) {
 		std::shared_ptr<BufferT<T> > buffer( new BufferT<T>, fn );
 		mBuffers.push_back( buffer );
 		buffer->mNumberChannels = channelsPerBuffer;
 		buffer->mDataByteSize = bufferSize * sizeof(T);
-		buffer->mData = new T[bufferSize];
+		buffer->mData = mPool->allocate<T>( bufferSize );
 		buffer->mSampleCount = 0;
 		mBufferSampleCounts[i] = 0;
 	}
@@ -122,15 +134,15 @@ std::shared_ptr<BufferT<T> > PcmBufferT<T>::getChannelData( ChannelIdentifier ch
 	}
 	
 	if( mIsInterleaved ) {
-		void (*fn)( BufferT<T> * ) = deleteBuffer;
+		void (*fn)( BufferT<T> * ) = releaseBuffer;
 		std::shared_ptr<BufferT<T> > buffer( new BufferT<T>, fn );
-		buffer->mData = new T[mMaxSampleCount];
+		buffer->mData = mPool->allocate<T>( mMaxSampleCount );
 		for( uint32_t i = 0; i < mMaxSampleCount; i++ ) {
 			buffer->mData[i] = mBuffers[0]->mData[i * mChannelCount + channelId];
 		}
 		buffer->mNumberChannels = 1;
 		buffer->mDataByteSize = mMaxSampleCount * sizeof( T );
-		buffer->mSampleCount = mBufferSampleCounts[channelId];
+		buffer->mSampleCount = mBufferSampleCounts[0];
 		return buffer;
 	}
 	
@@ -140,14 +152,14 @@ std::shared_ptr<BufferT<T> > PcmBufferT<T>::getChannelData( ChannelIdentifier ch
 template<typename T>
 std::shared_ptr<BufferT<T> > PcmBufferT<T>::getInterleavedData() const {
 	if( ! mIsInterleaved ) {
-		void (*fn)( BufferT<T> * ) = deleteBuffer;
+		void (*fn)( BufferT<T> * ) = releaseBuffer;
 		std::shared_ptr<BufferT<T> > buffer( new BufferT<T>, fn );
-		buffer->mData = new T[mMaxSampleCount * mChannelCount];
-		for( uint32_t i = 0; i < mMaxSampleCount; i++ ) {
-			for( uint16_t j = 0; j < mChannelCount; j++ ) {
-				buffer->mData[i * mChannelCount + j] = mBuffers[j]->mData[i];
-			}
+		buffer->mData = mPool->allocate<T>( mMaxSampleCount * mChannelCount );
+		std::vector<const T*> channels( mChannelCount );
+		for( uint16_t j = 0; j < mChannelCount; j++ ) {
+			channels[j] = mBuffers[j]->mData;
 		}
+		interleaveSamples( &channels[0], buffer->mData, mChannelCount, mMaxSampleCount );
 		buffer->mNumberChannels = mChannelCount;
 		buffer->mDataByteSize = mMaxSampleCount * mChannelCount * sizeof( T );
 		buffer->mSampleCount = mBufferSampleCounts[0];
@@ -156,6 +168,15 @@ std::shared_ptr<BufferT<T> > PcmBufferT<T>::getInterleavedData() const {
 	return mBuffers[0];
 }
 
+template<typename T>
+void PcmBufferT<T>::clear()
+{
+	for( uint16_t i = 0; i < mBufferCount; i++ ) {
+		mBuffers[i]->mSampleCount = 0;
+		mBufferSampleCounts[i] = 0;
+	}
+}
+
 template<typename T>
 void PcmBufferT<T>::appendInterleavedData( T * aData, uint32_t aSampleCount )
 {
@@ -164,13 +185,15 @@ void PcmBufferT<T>::appendInterleavedData( T * aData, uint32_t aSampleCount )
 	}
 
 	if( ! mIsInterleaved ) {
-		//iterate data and copy it into separate buffers
-		for( uint32_t i = 0; i < aSampleCount; i++ ) {
-			for( uint16_t j = 0; j < mChannelCount; j++ ) {
-				mBuffers[j]->mData[mBufferSampleCounts[j]] = aData[i + j];
-				mBuffers[j]->mSampleCount += 1;
-				mBufferSampleCounts[0] += 1;
-			}
+		//deinterleave the data into the end of each channel's buffer
+		std::vector<T*> channels( mChannelCount );
+		for( uint16_t j = 0; j < mChannelCount; j++ ) {
+			channels[j] = &( mBuffers[j]->mData[mBufferSampleCounts[j]] );
+		}
+		deinterleaveSamples( aData, &channels[0], mChannelCount, aSampleCount );
+		for( uint16_t j = 0; j < mChannelCount; j++ ) {
+			mBuffers[j]->mSampleCount += aSampleCount;
+			mBufferSampleCounts[j] += aSampleCount;
 		}
 	} else {
 		memcpy( &( mBuffers[0]->mData[mBufferSampleCounts[0] * mChannelCount] ), aData, aSampleCount * mChannelCount * sizeof(T) );
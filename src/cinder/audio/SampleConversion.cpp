@@ -0,0 +1,462 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cinder/audio/SampleConversion.h"
+#include "cinder/System.h"
+
+#include <boost/preprocessor/seq/for_each.hpp>
+#include <boost/preprocessor/seq/elem.hpp>
+#include <boost/preprocessor/seq/size.hpp>
+#include <boost/preprocessor/repetition/repeat.hpp>
+#include <boost/preprocessor/comparison/not_equal.hpp>
+#include <boost/preprocessor/control/expr_if.hpp>
+#include <boost/type_traits/is_floating_point.hpp>
+#include <algorithm>
+#include <cstring>
+
+#if defined( CINDER_SSE2 )
+	#include <emmintrin.h>
+#endif
+
+namespace cinder { namespace audio {
+
+SampleDither::SampleDither( uint32_t seed )
+{
+	// xorshift must never be seeded with 0
+	for( int lane = 0; lane < 4; ++lane ) {
+		seed = seed * 1664525 + 1013904223;
+		mState[lane] = seed ? seed : 1;
+	}
+}
+
+namespace {
+
+// Every conversion goes through float: samples are scaled to [-1, 1], then to the destination's range, optionally dithered, clamped and rounded to nearest even.
+// The scalar and SSE2 paths perform the same float operations in the same order so that their results are identical.
+template<typename T>
+struct SampleTraits;
+
+template<>
+struct SampleTraits<uint8_t> {
+	static const int	sBits = 8;
+	static float		toFloat( uint8_t v ) { return (float)( (int32_t)v - 128 ) * ( 1.0f / 128 ); }
+	static float		scale() { return 128.0f; }
+	static float		minValue() { return -128.0f; }
+	static float		maxValue() { return 127.0f; }
+	static uint8_t		fromRounded( int32_t v ) { return (uint8_t)( v + 128 ); }
+};
+
+template<>
+struct SampleTraits<int16_t> {
+	static const int	sBits = 16;
+	static float		toFloat( int16_t v ) { return (float)v * ( 1.0f / 32768 ); }
+	static float		scale() { return 32768.0f; }
+	static float		minValue() { return -32768.0f; }
+	static float		maxValue() { return 32767.0f; }
+	static int16_t		fromRounded( int32_t v ) { return (int16_t)v; }
+};
+
+template<>
+struct SampleTraits<int32_t> {
+	static const int	sBits = 32;
+	static float		toFloat( int32_t v ) { return (float)v * ( 1.0f / 2147483648.0f ); }
+	static float		scale() { return 2147483648.0f; }
+	static float		minValue() { return -2147483648.0f; }
+	// the largest float below 2^31
+	static float		maxValue() { return 2147483520.0f; }
+	static int32_t		fromRounded( int32_t v ) { return v; }
+};
+
+template<>
+struct SampleTraits<float> {
+	// the mantissa is what matters when deciding whether to dither
+	static const int	sBits = 24;
+	static float		toFloat( float v ) { return v; }
+};
+
+// Rounds to nearest even like _mm_cvtps_epi32() does, for values already clamped to the range of int32_t
+inline int32_t roundToInt( float v )
+{
+	// at 2^23 and beyond every float is an integer already
+	if( ( v >= 8388608.0f ) || ( v <= -8388608.0f ) )
+		return (int32_t)v;
+	// adding 2^23 of the same sign lands where the spacing of floats is exactly 1, so the addition itself rounds to nearest even.
+	// volatile keeps x87 builds from holding the sum at extended precision
+	const float offset = ( v < 0 ) ? -8388608.0f : 8388608.0f;
+	volatile float shifted = v + offset;
+	return (int32_t)( shifted - offset );
+}
+
+// Returns triangular noise in (-1, 1) and advances \a state
+inline float nextDither( uint32_t *state )
+{
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return (float)( (int32_t)( x >> 16 ) - (int32_t)( x & 0xFFFF ) ) * ( 1.0f / 65536 );
+}
+
+template<typename DstT>
+struct SampleStore {
+	static DstT store( float v, float noise )
+	{
+		typedef SampleTraits<DstT> Traits;
+		float scaled = v * Traits::scale() + noise;
+		scaled = std::max( scaled, Traits::minValue() );
+		scaled = std::min( scaled, Traits::maxValue() );
+		return Traits::fromRounded( roundToInt( scaled ) );
+	}
+};
+
+template<>
+struct SampleStore<float> {
+	static float store( float v, float /*noise*/ ) { return v; }
+};
+
+template<typename SrcT, typename DstT>
+void convertSamplesScalar( const SrcT *src, DstT *dst, size_t begin, size_t end, SampleDither *dither )
+{
+	if( dither ) {
+		for( size_t i = begin; i < end; ++i )
+			dst[i] = SampleStore<DstT>::store( SampleTraits<SrcT>::toFloat( src[i] ), nextDither( &dither->mState[i & 3] ) );
+	}
+	else {
+		for( size_t i = begin; i < end; ++i )
+			dst[i] = SampleStore<DstT>::store( SampleTraits<SrcT>::toFloat( src[i] ), 0 );
+	}
+}
+
+#if defined( CINDER_SSE2 )
+// Loads 8 samples as two vectors of floats in [-1, 1], and stores 8 samples which are already scaled, clamped and rounded
+template<typename T>
+struct SampleSse2;
+
+template<>
+struct SampleSse2<uint8_t> {
+	static void load( const uint8_t *src, __m128 *a, __m128 *b )
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i offset = _mm_set1_epi32( 128 );
+		const __m128 scale = _mm_set1_ps( 1.0f / 128 );
+		__m128i v16 = _mm_unpacklo_epi8( _mm_loadl_epi64( (const __m128i*)src ), zero );
+		*a = _mm_mul_ps( _mm_cvtepi32_ps( _mm_sub_epi32( _mm_unpacklo_epi16( v16, zero ), offset ) ), scale );
+		*b = _mm_mul_ps( _mm_cvtepi32_ps( _mm_sub_epi32( _mm_unpackhi_epi16( v16, zero ), offset ) ), scale );
+	}
+	static void store( uint8_t *dst, __m128i a, __m128i b )
+	{
+		__m128i v16 = _mm_add_epi16( _mm_packs_epi32( a, b ), _mm_set1_epi16( 128 ) );
+		_mm_storel_epi64( (__m128i*)dst, _mm_packus_epi16( v16, v16 ) );
+	}
+};
+
+template<>
+struct SampleSse2<int16_t> {
+	static void load( const int16_t *src, __m128 *a, __m128 *b )
+	{
+		const __m128 scale = _mm_set1_ps( 1.0f / 32768 );
+		__m128i v = _mm_loadu_si128( (const __m128i*)src );
+		// unpacking a register with itself and shifting right sign-extends
+		*a = _mm_mul_ps( _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( v, v ), 16 ) ), scale );
+		*b = _mm_mul_ps( _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( v, v ), 16 ) ), scale );
+	}
+	static void store( int16_t *dst, __m128i a, __m128i b )
+	{
+		_mm_storeu_si128( (__m128i*)dst, _mm_packs_epi32( a, b ) );
+	}
+};
+
+template<>
+struct SampleSse2<int32_t> {
+	static void load( const int32_t *src, __m128 *a, __m128 *b )
+	{
+		const __m128 scale = _mm_set1_ps( 1.0f / 2147483648.0f );
+		*a = _mm_mul_ps( _mm_cvtepi32_ps( _mm_loadu_si128( (const __m128i*)src ) ), scale );
+		*b = _mm_mul_ps( _mm_cvtepi32_ps( _mm_loadu_si128( (const __m128i*)( src + 4 ) ) ), scale );
+	}
+	static void store( int32_t *dst, __m128i a, __m128i b )
+	{
+		_mm_storeu_si128( (__m128i*)dst, a );
+		_mm_storeu_si128( (__m128i*)( dst + 4 ), b );
+	}
+};
+
+template<>
+struct SampleSse2<float> {
+	static void load( const float *src, __m128 *a, __m128 *b )
+	{
+		*a = _mm_loadu_ps( src );
+		*b = _mm_loadu_ps( src + 4 );
+	}
+};
+
+inline __m128 nextDitherSse2( __m128i *state )
+{
+	__m128i x = *state;
+	x = _mm_xor_si128( x, _mm_slli_epi32( x, 13 ) );
+	x = _mm_xor_si128( x, _mm_srli_epi32( x, 17 ) );
+	x = _mm_xor_si128( x, _mm_slli_epi32( x, 5 ) );
+	*state = x;
+	__m128i tri = _mm_sub_epi32( _mm_srli_epi32( x, 16 ), _mm_and_si128( x, _mm_set1_epi32( 0xFFFF ) ) );
+	return _mm_mul_ps( _mm_cvtepi32_ps( tri ), _mm_set1_ps( 1.0f / 65536 ) );
+}
+
+// convert() returns the number of samples it converted, which is \a count rounded down to a multiple of 8
+template<typename SrcT, typename DstT>
+struct ConvertSse2 {
+	static size_t convert( const SrcT *src, DstT *dst, size_t count, SampleDither *dither )
+	{
+		typedef SampleTraits<DstT> Traits;
+		const __m128 scale = _mm_set1_ps( Traits::scale() );
+		const __m128 minValue = _mm_set1_ps( Traits::minValue() );
+		const __m128 maxValue = _mm_set1_ps( Traits::maxValue() );
+		__m128i state = dither ? _mm_loadu_si128( (const __m128i*)dither->mState ) : _mm_setzero_si128();
+
+		const size_t end = count & ~(size_t)7;
+		for( size_t i = 0; i < end; i += 8 ) {
+			__m128 a, b;
+			SampleSse2<SrcT>::load( src + i, &a, &b );
+			a = _mm_mul_ps( a, scale );
+			b = _mm_mul_ps( b, scale );
+			if( dither ) {
+				a = _mm_add_ps( a, nextDitherSse2( &state ) );
+				b = _mm_add_ps( b, nextDitherSse2( &state ) );
+			}
+			a = _mm_min_ps( _mm_max_ps( a, minValue ), maxValue );
+			b = _mm_min_ps( _mm_max_ps( b, minValue ), maxValue );
+			SampleSse2<DstT>::store( dst + i, _mm_cvtps_epi32( a ), _mm_cvtps_epi32( b ) );
+		}
+
+		if( dither )
+			_mm_storeu_si128( (__m128i*)dither->mState, state );
+		return end;
+	}
+};
+
+template<typename SrcT>
+struct ConvertSse2<SrcT,float> {
+	static size_t convert( const SrcT *src, float *dst, size_t count, SampleDither * /*dither*/ )
+	{
+		const size_t end = count & ~(size_t)7;
+		for( size_t i = 0; i < end; i += 8 ) {
+			__m128 a, b;
+			SampleSse2<SrcT>::load( src + i, &a, &b );
+			_mm_storeu_ps( dst + i, a );
+			_mm_storeu_ps( dst + i + 4, b );
+		}
+		return end;
+	}
+};
+#endif // defined( CINDER_SSE2 )
+
+// Stereo is by far the most common layout, so it gets its own loops. These return the number of frames handled, leaving the rest to the scalar loops.
+template<typename T>
+size_t interleaveStereo( const T * /*left*/, const T * /*right*/, T * /*dst*/, size_t /*frameCount*/ ) { return 0; }
+template<typename T>
+size_t deinterleaveStereo( const T * /*src*/, T * /*left*/, T * /*right*/, size_t /*frameCount*/ ) { return 0; }
+
+#if defined( CINDER_SSE2 )
+size_t interleaveStereo( const float *left, const float *right, float *dst, size_t frameCount )
+{
+	static const bool useSse2 = System::hasSse2();
+	if( ! useSse2 )
+		return 0;
+
+	const size_t end = frameCount & ~(size_t)3;
+	for( size_t i = 0; i < end; i += 4 ) {
+		__m128 l = _mm_loadu_ps( left + i ), r = _mm_loadu_ps( right + i );
+		_mm_storeu_ps( dst + i * 2, _mm_unpacklo_ps( l, r ) );
+		_mm_storeu_ps( dst + i * 2 + 4, _mm_unpackhi_ps( l, r ) );
+	}
+	return end;
+}
+
+size_t interleaveStereo( const int32_t *left, const int32_t *right, int32_t *dst, size_t frameCount )
+{
+	return interleaveStereo( reinterpret_cast<const float*>( left ), reinterpret_cast<const float*>( right ), reinterpret_cast<float*>( dst ), frameCount );
+}
+
+size_t interleaveStereo( const int16_t *left, const int16_t *right, int16_t *dst, size_t frameCount )
+{
+	static const bool useSse2 = System::hasSse2();
+	if( ! useSse2 )
+		return 0;
+
+	const size_t end = frameCount & ~(size_t)7;
+	for( size_t i = 0; i < end; i += 8 ) {
+		__m128i l = _mm_loadu_si128( (const __m128i*)( left + i ) ), r = _mm_loadu_si128( (const __m128i*)( right + i ) );
+		_mm_storeu_si128( (__m128i*)( dst + i * 2 ), _mm_unpacklo_epi16( l, r ) );
+		_mm_storeu_si128( (__m128i*)( dst + i * 2 + 8 ), _mm_unpackhi_epi16( l, r ) );
+	}
+	return end;
+}
+
+size_t deinterleaveStereo( const float *src, float *left, float *right, size_t frameCount )
+{
+	static const bool useSse2 = System::hasSse2();
+	if( ! useSse2 )
+		return 0;
+
+	const size_t end = frameCount & ~(size_t)3;
+	for( size_t i = 0; i < end; i += 4 ) {
+		__m128 a = _mm_loadu_ps( src + i * 2 ), b = _mm_loadu_ps( src + i * 2 + 4 );
+		_mm_storeu_ps( left + i, _mm_shuffle_ps( a, b, _MM_SHUFFLE( 2, 0, 2, 0 ) ) );
+		_mm_storeu_ps( right + i, _mm_shuffle_ps( a, b, _MM_SHUFFLE( 3, 1, 3, 1 ) ) );
+	}
+	return end;
+}
+
+size_t deinterleaveStereo( const int32_t *src, int32_t *left, int32_t *right, size_t frameCount )
+{
+	return deinterleaveStereo( reinterpret_cast<const float*>( src ), reinterpret_cast<float*>( left ), reinterpret_cast<float*>( right ), frameCount );
+}
+
+size_t deinterleaveStereo( const int16_t *src, int16_t *left, int16_t *right, size_t frameCount )
+{
+	static const bool useSse2 = System::hasSse2();
+	if( ! useSse2 )
+		return 0;
+
+	const size_t end = frameCount & ~(size_t)7;
+	for( size_t i = 0; i < end; i += 8 ) {
+		__m128i a = _mm_loadu_si128( (const __m128i*)( src + i * 2 ) ), b = _mm_loadu_si128( (const __m128i*)( src + i * 2 + 8 ) );
+		// left samples are the low halves of each 32-bit frame; shifting them into place sign-extends so that packs_epi32() can't saturate
+		__m128i l = _mm_packs_epi32( _mm_srai_epi32( _mm_slli_epi32( a, 16 ), 16 ), _mm_srai_epi32( _mm_slli_epi32( b, 16 ), 16 ) );
+		__m128i r = _mm_packs_epi32( _mm_srai_epi32( a, 16 ), _mm_srai_epi32( b, 16 ) );
+		_mm_storeu_si128( (__m128i*)( left + i ), l );
+		_mm_storeu_si128( (__m128i*)( right + i ), r );
+	}
+	return end;
+}
+#endif // defined( CINDER_SSE2 )
+
+} // anonymous namespace
+
+template<typename SrcT, typename DstT>
+void convertSamples( const SrcT *src, DstT *dst, size_t count, SampleDither *dither )
+{
+	// only conversions to integers which lose precision are dithered
+	if( boost::is_floating_point<DstT>::value || ( SampleTraits<DstT>::sBits >= SampleTraits<SrcT>::sBits ) )
+		dither = 0;
+
+	size_t done = 0;
+#if defined( CINDER_SSE2 )
+	static const bool useSse2 = System::hasSse2();
+	if( useSse2 )
+		done = ConvertSse2<SrcT,DstT>::convert( src, dst, count, dither );
+#endif
+	convertSamplesScalar( src, dst, done, count, dither );
+}
+
+// conversions between identical types are plain copies
+#define CONVERT_SAMPLES_COPY(r,unused,T)\
+	template<> void convertSamples( const T *src, T *dst, size_t count, SampleDither * ) { memcpy( dst, src, count * sizeof(T) ); }
+
+// every other pair of types is instantiated, indexing AUDIO_DATA_TYPES so that the identical pairs specialized above can be skipped
+#define CONVERT_SAMPLES_PROTOTYPE(z,dstIndex,srcIndex)\
+	BOOST_PP_EXPR_IF( BOOST_PP_NOT_EQUAL( srcIndex, dstIndex ),\
+		template void convertSamples( const BOOST_PP_SEQ_ELEM(srcIndex,AUDIO_DATA_TYPES) *src, BOOST_PP_SEQ_ELEM(dstIndex,AUDIO_DATA_TYPES) *dst, size_t count, SampleDither *dither ); )
+
+#define CONVERT_SAMPLES_PROTOTYPES(z,srcIndex,unused)\
+	BOOST_PP_REPEAT_ ## z( BOOST_PP_SEQ_SIZE(AUDIO_DATA_TYPES), CONVERT_SAMPLES_PROTOTYPE, srcIndex )
+
+BOOST_PP_SEQ_FOR_EACH( CONVERT_SAMPLES_COPY, ~, AUDIO_DATA_TYPES )
+BOOST_PP_REPEAT( BOOST_PP_SEQ_SIZE(AUDIO_DATA_TYPES), CONVERT_SAMPLES_PROTOTYPES, ~ )
+
+template<typename T>
+void interleaveSamples( const T * const *src, T *dst, uint16_t channelCount, size_t frameCount )
+{
+	if( channelCount == 1 ) {
+		memcpy( dst, src[0], frameCount * sizeof(T) );
+	}
+	else if( channelCount == 2 ) {
+		const T *left = src[0], *right = src[1];
+		for( size_t i = interleaveStereo( left, right, dst, frameCount ); i < frameCount; ++i ) {
+			dst[i * 2] = left[i];
+			dst[i * 2 + 1] = right[i];
+		}
+	}
+	else {
+		for( size_t i = 0; i < frameCount; ++i, dst += channelCount ) {
+			for( uint16_t c = 0; c < channelCount; ++c )
+				dst[c] = src[c][i];
+		}
+	}
+}
+
+template<typename T>
+void deinterleaveSamples( const T *src, T * const *dst, uint16_t channelCount, size_t frameCount )
+{
+	if( channelCount == 1 ) {
+		memcpy( dst[0], src, frameCount * sizeof(T) );
+	}
+	else if( channelCount == 2 ) {
+		T *left = dst[0], *right = dst[1];
+		for( size_t i = deinterleaveStereo( src, left, right, frameCount ); i < frameCount; ++i ) {
+			left[i] = src[i * 2];
+			right[i] = src[i * 2 + 1];
+		}
+	}
+	else {
+		for( size_t i = 0; i < frameCount; ++i, src += channelCount ) {
+			for( uint16_t c = 0; c < channelCount; ++c )
+				dst[c][i] = src[c];
+		}
+	}
+}
+
+void mixSamples( const float *src, float *dst, size_t count, float gain )
+{
+	size_t i = 0;
+#if defined( CINDER_SSE2 )
+	static const bool useSse2 = System::hasSse2();
+	if( useSse2 ) {
+		const __m128 gainVec = _mm_set1_ps( gain );
+		for( ; i + 8 <= count; i += 8 ) {
+			__m128 a = _mm_add_ps( _mm_loadu_ps( dst + i ), _mm_mul_ps( _mm_loadu_ps( src + i ), gainVec ) );
+			__m128 b = _mm_add_ps( _mm_loadu_ps( dst + i + 4 ), _mm_mul_ps( _mm_loadu_ps( src + i + 4 ), gainVec ) );
+			_mm_storeu_ps( dst + i, a );
+			_mm_storeu_ps( dst + i + 4, b );
+		}
+	}
+#endif
+	for( ; i < count; ++i )
+		dst[i] += src[i] * gain;
+}
+
+template<typename T>
+void swapSampleBytes( T *data, size_t count )
+{
+	uint8_t *bytes = reinterpret_cast<uint8_t*>( data );
+	for( size_t i = 0; i < count; ++i, bytes += sizeof(T) )
+		std::reverse( bytes, bytes + sizeof(T) );
+}
+
+#define SAMPLE_LAYOUT_PROTOTYPES(r,unused,T)\
+	template void interleaveSamples( const T * const *src, T *dst, uint16_t channelCount, size_t frameCount );\
+	template void deinterleaveSamples( const T *src, T * const *dst, uint16_t channelCount, size_t frameCount );\
+	template void swapSampleBytes( T *data, size_t count );
+
+BOOST_PP_SEQ_FOR_EACH( SAMPLE_LAYOUT_PROTOTYPES, ~, AUDIO_DATA_TYPES )
+
+}} //namespace
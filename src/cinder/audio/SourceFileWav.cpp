@@ -21,6 +21,9 @@
 */
 #include "cinder/audio/SourceFileWav.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace cinder { namespace audio {
 
 #if defined(CINDER_LITTLE_ENDIAN)
@@ -62,15 +65,94 @@ void readStreamWithEndianess( IStreamRef aIStream, T* param, bool isBigEndian )
 	aIStream->readLittle( param );
 }
 
+namespace {
+
+bool isConvertibleDataType( Io::DataType dataType )
+{
+	return ( dataType == Io::UINT8 ) || ( dataType == Io::INT16 ) || ( dataType == Io::INT32 ) || ( dataType == Io::FLOAT32 );
+}
+
+void swapFileSampleBytes( void *data, Io::DataType dataType, size_t count )
+{
+	switch( dataType ) {
+		case Io::INT16: swapSampleBytes( reinterpret_cast<int16_t*>( data ), count ); break;
+		case Io::INT32: swapSampleBytes( reinterpret_cast<int32_t*>( data ), count ); break;
+		case Io::FLOAT32: swapSampleBytes( reinterpret_cast<float*>( data ), count ); break;
+		default: break;
+	}
+}
+
+// Converts \a frameCount interleaved frames from \a src into the buffers of \a ioData, deinterleaving them if there is a buffer per channel
+template<typename SrcT, typename DstT>
+void convertToBufferList( const SrcT *src, BufferList *ioData, uint16_t channelCount, uint32_t frameCount, SampleDither *dither )
+{
+	const size_t sampleCount = (size_t)frameCount * channelCount;
+	if( ioData->mNumberBuffers == 1 ) {
+		convertSamples( src, reinterpret_cast<DstT*>( ioData->mBuffers[0].mData ), sampleCount, dither );
+		ioData->mBuffers[0].mDataByteSize = sampleCount * sizeof(DstT);
+		return;
+	}
+	
+	if( ioData->mNumberBuffers != channelCount ) {
+		throw IoExceptionUnsupportedDataFormat();
+	}
+	
+	DstT *converted = BufferPool::getDefault()->allocate<DstT>( sampleCount );
+	convertSamples( src, converted, sampleCount, dither );
+	std::vector<DstT*> channels( channelCount );
+	for( uint16_t i = 0; i < channelCount; i++ ) {
+		channels[i] = reinterpret_cast<DstT*>( ioData->mBuffers[i].mData );
+		ioData->mBuffers[i].mSampleCount = frameCount;
+		ioData->mBuffers[i].mDataByteSize = frameCount * sizeof(DstT);
+	}
+	deinterleaveSamples( converted, &channels[0], channelCount, frameCount );
+	BufferPool::release( converted );
+}
+
+template<typename SrcT>
+void convertToBufferList( const SrcT *src, Io::DataType dstType, BufferList *ioData, uint16_t channelCount, uint32_t frameCount, SampleDither *dither )
+{
+	switch( dstType ) {
+		case Io::UINT8: convertToBufferList<SrcT,uint8_t>( src, ioData, channelCount, frameCount, dither ); break;
+		case Io::INT16: convertToBufferList<SrcT,int16_t>( src, ioData, channelCount, frameCount, dither ); break;
+		case Io::INT32: convertToBufferList<SrcT,int32_t>( src, ioData, channelCount, frameCount, dither ); break;
+		case Io::FLOAT32: convertToBufferList<SrcT,float>( src, ioData, channelCount, frameCount, dither ); break;
+		default: throw IoExceptionUnsupportedDataType();
+	}
+}
+
+void convertToBufferList( const void *src, Io::DataType srcType, Io::DataType dstType, BufferList *ioData, uint16_t channelCount, uint32_t frameCount, SampleDither *dither )
+{
+	switch( srcType ) {
+		case Io::UINT8: convertToBufferList( reinterpret_cast<const uint8_t*>( src ), dstType, ioData, channelCount, frameCount, dither ); break;
+		case Io::INT16: convertToBufferList( reinterpret_cast<const int16_t*>( src ), dstType, ioData, channelCount, frameCount, dither ); break;
+		case Io::INT32: convertToBufferList( reinterpret_cast<const int32_t*>( src ), dstType, ioData, channelCount, frameCount, dither ); break;
+		case Io::FLOAT32: convertToBufferList( reinterpret_cast<const float*>( src ), dstType, ioData, channelCount, frameCount, dither ); break;
+		default: throw IoExceptionUnsupportedDataType();
+	}
+}
+
+} // anonymous namespace
+
 LoaderSourceFileWavRef LoaderSourceFileWav::createRef( SourceFileWav *source, Target *target ) {
 	return LoaderSourceFileWavRef( new LoaderSourceFileWav( source, target ) );
 }
 
 LoaderSourceFileWav::LoaderSourceFileWav( SourceFileWav * source, Target * target ) 
-	: Loader(), mSource( source ), mSampleOffset( 0 )
+	: Loader(), mSource( source ), mSampleOffset( 0 ), mTargetDataType( Io::DATA_UNKNOWN )
 {
-	mStream = mSource->mDataSource->createStream();
-	mStream->seekAbsolute( mSource->mDataStart );
+	//mapped sources are read straight from memory, so each loader's position is just mSampleOffset
+	if( ! mSource->isMapped() ) {
+		mStream = mSource->mDataSource->createStream();
+		mStream->seekAbsolute( mSource->mDataStart );
+	}
+	
+	//only convert between the sample types SampleConversion handles, otherwise hand the file's samples over untouched
+	if( target && isConvertibleDataType( mSource->mDataType ) && isConvertibleDataType( target->getDataType() ) ) {
+		if( ( target->getDataType() != mSource->mDataType ) || ! target->isInterleaved() ) {
+			mTargetDataType = target->getDataType();
+		}
+	}
 }
 
 LoaderSourceFileWav::~LoaderSourceFileWav()
@@ -86,31 +168,65 @@ uint64_t LoaderSourceFileWav::getSampleOffset() const
 void LoaderSourceFileWav::setSampleOffset( uint64_t anOffset )
 {
 	mSampleOffset = anOffset;
-	mStream->seekAbsolute( mSource->mDataStart + ( anOffset * mSource->mBlockAlign ) );
+	if( mStream ) {
+		mStream->seekAbsolute( mSource->mDataStart + ( anOffset * mSource->mBlockAlign ) );
+	}
+}
+
+void LoaderSourceFileWav::readFileData( void *data, uint32_t dataSize )
+{
+	if( mSource->isMapped() ) {
+		memcpy( data, mSource->mMappedData + mSampleOffset * mSource->mBlockAlign, dataSize );
+	} else {
+		mStream->readData( data, dataSize );
+	}
 }
 
 void LoaderSourceFileWav::loadData( BufferList *ioData )
 {	
-	if( mSampleOffset + ioData->mBuffers[0].mSampleCount > mSource->mSampleCount ) {
+	if( mSampleOffset >= mSource->mSampleCount ) {
+		ioData->mBuffers[0].mSampleCount = 0;
+	} else if( mSampleOffset + ioData->mBuffers[0].mSampleCount > mSource->mSampleCount ) {
 		ioData->mBuffers[0].mSampleCount = mSource->mSampleCount - mSampleOffset;
 	}
 	
-	uint32_t dataSize = ioData->mBuffers[0].mSampleCount * mSource->mBlockAlign;
+	uint32_t frameCount = ioData->mBuffers[0].mSampleCount;
+	uint32_t dataSize = frameCount * mSource->mBlockAlign;
+	size_t sampleCount = (size_t)frameCount * mSource->mChannelCount;
 
 #if defined(CINDER_LITTLE_ENDIAN)
 	bool nativeLittleEndian = true;
-#elif
+#else
 	bool nativeLittleEndian = false;
 #endif
+	bool needsSwap = ( nativeLittleEndian == mSource->mIsBigEndian );
 
-	//if native endianess matches source endianess just read it
-	if( (nativeLittleEndian && ! mSource->mIsBigEndian ) || ( ! nativeLittleEndian && mSource->mIsBigEndian ) ) {
-		mStream->readData( ioData->mBuffers[0].mData, dataSize );
+	if( mTargetDataType == Io::DATA_UNKNOWN ) {
+		//the target takes the file's own format, so read straight into its buffer
+		readFileData( ioData->mBuffers[0].mData, dataSize );
+		if( needsSwap ) {
+			swapFileSampleBytes( ioData->mBuffers[0].mData, mSource->mDataType, sampleCount );
+		}
+		ioData->mBuffers[0].mDataByteSize = dataSize;
+	} else if( mSource->isMapped() && ! needsSwap ) {
+		//convert straight out of the mapping
+		convertToBufferList( mSource->mMappedData + mSampleOffset * mSource->mBlockAlign, mSource->mDataType, mTargetDataType, ioData, mSource->mChannelCount, frameCount, &mDither );
 	} else {
-		//TODO: readWithEndianess with casted buffers
+		uint8_t *fileData = BufferPool::getDefault()->allocate<uint8_t>( dataSize );
+		readFileData( fileData, dataSize );
+		if( needsSwap ) {
+			swapFileSampleBytes( fileData, mSource->mDataType, sampleCount );
+		}
+		try {
+			convertToBufferList( fileData, mSource->mDataType, mTargetDataType, ioData, mSource->mChannelCount, frameCount, &mDither );
+		}
+		catch( ... ) {
+			BufferPool::release( fileData );
+			throw;
+		}
+		BufferPool::release( fileData );
 	}
-	mSampleOffset += ioData->mBuffers[0].mSampleCount;
-	ioData->mBuffers[0].mDataByteSize = dataSize;
+	mSampleOffset += frameCount;
 }
 
 void SourceFileWav::registerSelf()
@@ -172,7 +288,9 @@ SourceFileWav::SourceFileWav( DataSourceRef dataSourceRef )
 	static const uint8_t hasFormat = 1;
 	static const uint8_t hasData = 1 << 1;
 	
-	while( stream->tell() < fileSize) {
+	//a truncated recording's chunks can claim more than the file holds
+	off_t streamEnd = std::min<off_t>( fileSize, stream->size() );
+	while( stream->tell() < streamEnd ) {
 		stream->readData( &chunkName, 4 );
 		readStreamWithEndianess( stream, &chunkSize, mIsBigEndian );
 		chunkEnd = stream->tell() + chunkSize;
@@ -185,13 +303,24 @@ SourceFileWav::SourceFileWav( DataSourceRef dataSourceRef )
 			mDataStart = stream->tell();
 			chunks |= hasData;
 		}
-		stream->seekAbsolute( chunkEnd );
+		stream->seekAbsolute( std::min<off_t>( chunkEnd, streamEnd ) );
 	}
 	
 	if( chunks != ( hasFormat | hasData ) ) {
 		throw IoExceptionFailedLoad();
 	}
 
+	if( mBlockAlign == 0 ) {
+		throw IoExceptionFailedLoad();
+	}
+	mDataLength = (uint32_t)std::min<off_t>( mDataLength, stream->size() - mDataStart );
+	
+	//views and loaders of a mapped file read the data chunk in place rather than through a stream
+	mMappedData = 0;
+	if( DataSourceMapped *mappedSource = dynamic_cast<DataSourceMapped*>( mDataSource.get() ) ) {
+		mMappedData = reinterpret_cast<const uint8_t*>( mappedSource->getData() ) + mDataStart;
+	}
+
 	mSampleCount = mDataLength / mBlockAlign;
 	
 	//Pull all of the data
@@ -206,6 +335,43 @@ SourceFileWav::~SourceFileWav()
 {
 }
 
+namespace {
+
+template<typename T> Io::DataType sampleDataType();
+template<> Io::DataType sampleDataType<uint8_t>() { return Io::UINT8; }
+template<> Io::DataType sampleDataType<int16_t>() { return Io::INT16; }
+template<> Io::DataType sampleDataType<int32_t>() { return Io::INT32; }
+template<> Io::DataType sampleDataType<float>() { return Io::FLOAT32; }
+
+} // anonymous namespace
+
+template<typename T>
+SampleWindowT<T> SourceFileWav::getSampleWindow( uint64_t sampleOffset, uint32_t sampleCount ) const
+{
+#if defined(CINDER_LITTLE_ENDIAN)
+	bool nativeEndian = ! mIsBigEndian;
+#else
+	bool nativeEndian = mIsBigEndian;
+#endif
+	//the view is the file's own bytes, so they must already be the requested type, in native order and aligned for it
+	if( ( ! isMapped() ) || ( mDataType != sampleDataType<T>() ) || ( ! nativeEndian ) || ( (size_t)mBlockAlign != sizeof(T) * mChannelCount ) || ( mDataStart % sizeof(T) ) ) {
+		throw IoExceptionUnsupportedDataType();
+	}
+
+	SampleWindowT<T> result;
+	result.mDataSource = mDataSource;
+	result.mChannelCount = mChannelCount;
+	result.mSampleOffset = std::min( sampleOffset, mSampleCount );
+	result.mSampleCount = (uint32_t)std::min<uint64_t>( sampleCount, mSampleCount - result.mSampleOffset );
+	result.mData = reinterpret_cast<const T*>( mMappedData + result.mSampleOffset * mBlockAlign );
+	return result;
+}
+
+#define SAMPLE_WINDOW_PROTOTYPES(r,data,T)\
+	template SampleWindowT<T> SourceFileWav::getSampleWindow( uint64_t sampleOffset, uint32_t sampleCount ) const;
+
+BOOST_PP_SEQ_FOR_EACH( SAMPLE_WINDOW_PROTOTYPES, ~, AUDIO_DATA_TYPES )
+
 void SourceFileWav::readFormatChunk( IStreamRef stream )
 {
 	readStreamWithEndianess( stream, &mAudioFormat, mIsBigEndian );
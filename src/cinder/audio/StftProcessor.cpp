@@ -0,0 +1,275 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cinder/audio/StftProcessor.h"
+#include "cinder/CinderMath.h"
+
+#include <cmath>
+
+namespace cinder { namespace audio {
+
+StftProcessor::Format::Format()
+	: mBandCount( 512 ), mHopSize( 256 ), mChannelCount( 1 ), mFrameCapacity( 64 ), mWindow( WINDOW_HANN ), mPhase( true )
+{
+}
+
+StftProcessorRef StftProcessor::createRef( const Format &format )
+{
+	return StftProcessorRef( new StftProcessor( format ) );
+}
+
+StftProcessor::StftProcessor( const Format &format )
+	: mFormat( format ), mFrameSize( format.getBandCount() * 2 )
+{
+	if( ( mFormat.getHopSize() == 0 ) || ( mFormat.getHopSize() > mFrameSize ) || ( mFormat.getChannelCount() == 0 ) || ( mFormat.getFrameCapacity() == 0 ) )
+		throw StftProcessorExceptionInvalidFormat();
+	if( ( ! mFormat.getCustomWindow().empty() ) && ( mFormat.getCustomWindow().size() != mFrameSize ) )
+		throw StftProcessorExceptionInvalidFormat();
+
+	mFft = FftProcessor::createRef( mFormat.getBandCount() );
+
+	// the windows are periodic rather than symmetric, so that they sum to a constant when overlapped at the usual hop sizes
+	if( ! mFormat.getCustomWindow().empty() )
+		mWindow = mFormat.getCustomWindow();
+	else {
+		mWindow.resize( mFrameSize );
+		for( uint32_t n = 0; n < mFrameSize; ++n ) {
+			double phase = 2 * M_PI * n / mFrameSize;
+			switch( mFormat.getWindow() ) {
+				case WINDOW_RECTANGULAR: mWindow[n] = 1; break;
+				case WINDOW_HANN: mWindow[n] = (float)( 0.5 - 0.5 * cos( phase ) ); break;
+				case WINDOW_HAMMING: mWindow[n] = (float)( 0.54 - 0.46 * cos( phase ) ); break;
+				case WINDOW_BLACKMAN: mWindow[n] = (float)( 0.42 - 0.5 * cos( phase ) + 0.08 * cos( 2 * phase ) ); break;
+			}
+		}
+	}
+
+	// the window is applied both before analysis and after synthesis, so each output sample is scaled by the sum of the squared windows which overlap it
+	const uint32_t hopSize = mFormat.getHopSize();
+	std::vector<double> sums( hopSize, 0.0 );
+	double maxSum = 0;
+	for( uint32_t p = 0; p < hopSize; ++p ) {
+		for( uint32_t n = p; n < mFrameSize; n += hopSize )
+			sums[p] += mWindow[n] * mWindow[n];
+		maxSum = std::max( maxSum, sums[p] );
+	}
+	// positions the windows barely overlap, such as the ends of a Hann or Blackman window with a hop of the whole frame, would be amplified
+	// by many orders of magnitude, so they are silenced instead
+	const double minSum = maxSum * 1.0e-4;
+	mSynthesisScale.resize( hopSize );
+	for( uint32_t p = 0; p < hopSize; ++p )
+		mSynthesisScale[p] = ( sums[p] > minSum ) ? (float)( 1 / sums[p] ) : 0;
+
+	const uint32_t ringSize = mFormat.getFrameCapacity() * getBinCount();
+	mChannels.resize( mFormat.getChannelCount() );
+	for( std::vector<Channel>::iterator channelIt = mChannels.begin(); channelIt != mChannels.end(); ++channelIt ) {
+		channelIt->mInput.resize( mFrameSize );
+		channelIt->mMagnitudes.resize( ringSize );
+		if( mFormat.hasPhase() )
+			channelIt->mPhases.resize( ringSize );
+		channelIt->mOverlap.resize( mFrameSize );
+	}
+	reset();
+
+	mFrame.resize( mFrameSize );
+	mReal.resize( mFormat.getBandCount() );
+	mImag.resize( mFormat.getBandCount() );
+}
+
+void StftProcessor::reset()
+{
+	for( std::vector<Channel>::iterator channelIt = mChannels.begin(); channelIt != mChannels.end(); ++channelIt ) {
+		channelIt->mInputCount = 0;
+		channelIt->mFirstFrame = 0;
+		channelIt->mFrameCount = 0;
+		channelIt->mNextFrameIndex = 0;
+		channelIt->mDroppedFrameCount = 0;
+		std::fill( channelIt->mOverlap.begin(), channelIt->mOverlap.end(), 0.0f );
+	}
+}
+
+void StftProcessor::write( const float *samples, uint32_t sampleCount, uint16_t channel )
+{
+	append( &mChannels[channel], samples, sampleCount, 1 );
+}
+
+void StftProcessor::writeInterleaved( const float *samples, uint32_t sampleCount )
+{
+	const uint16_t channelCount = getChannelCount();
+	for( uint16_t c = 0; c < channelCount; ++c )
+		append( &mChannels[c], samples + c, sampleCount, channelCount );
+}
+
+void StftProcessor::write( const CircularBuffer<float> &buffer, uint16_t channel )
+{
+	CircularBuffer<float>::ArrayRange one = buffer.arrayOne(), two = buffer.arrayTwo();
+	append( &mChannels[channel], one.first, one.second, 1 );
+	append( &mChannels[channel], two.first, two.second, 1 );
+}
+
+void StftProcessor::write( const PcmBuffer32f &buffer )
+{
+	if( buffer.getChannelCount() != getChannelCount() )
+		throw InvalidChannelPcmBufferException();
+
+	// neither of these copies the samples
+	if( buffer.isInterleaved() ) {
+		Buffer32fRef data = buffer.getInterleavedData();
+		writeInterleaved( data->mData, data->mSampleCount );
+	}
+	else {
+		for( uint16_t c = 0; c < getChannelCount(); ++c ) {
+			Buffer32fRef data = buffer.getChannelData( (ChannelIdentifier)c );
+			append( &mChannels[c], data->mData, data->mSampleCount, 1 );
+		}
+	}
+}
+
+void StftProcessor::flush()
+{
+	const uint32_t hopSize = getHopSize();
+	for( std::vector<Channel>::iterator channelIt = mChannels.begin(); channelIt != mChannels.end(); ++channelIt ) {
+		// every pending sample is still due to be part of the frames starting at or before it, so keep padding until the last one has shifted out
+		uint32_t pendingCount = channelIt->mInputCount;
+		while( pendingCount > 0 ) {
+			std::fill( channelIt->mInput.begin() + channelIt->mInputCount, channelIt->mInput.end(), 0.0f );
+			channelIt->mInputCount = mFrameSize;
+			analyze( &(*channelIt) );
+			pendingCount = ( pendingCount > hopSize ) ? ( pendingCount - hopSize ) : 0;
+		}
+		// what remains is padding, which the next frame starts after
+		channelIt->mInputCount = 0;
+	}
+}
+
+void StftProcessor::append( Channel *channel, const float *samples, uint32_t sampleCount, size_t stride )
+{
+	while( sampleCount > 0 ) {
+		uint32_t count = std::min( sampleCount, mFrameSize - channel->mInputCount );
+		float *dst = &channel->mInput[channel->mInputCount];
+		if( stride == 1 )
+			memcpy( dst, samples, count * sizeof(float) );
+		else {
+			for( uint32_t i = 0; i < count; ++i )
+				dst[i] = samples[i * stride];
+		}
+		samples += count * stride;
+		sampleCount -= count;
+		channel->mInputCount += count;
+
+		if( channel->mInputCount == mFrameSize )
+			analyze( channel );
+	}
+}
+
+void StftProcessor::analyze( Channel *channel )
+{
+	const uint32_t bandCount = getBandCount();
+	const uint32_t binCount = getBinCount();
+	const uint32_t hopSize = getHopSize();
+
+	for( uint32_t n = 0; n < mFrameSize; ++n )
+		mFrame[n] = channel->mInput[n] * mWindow[n];
+	mFft->processComplex( &mFrame[0], &mReal[0], &mImag[0] );
+
+	// a full ring overwrites its oldest frame
+	if( channel->mFrameCount == mFormat.getFrameCapacity() ) {
+		channel->mFirstFrame = ( channel->mFirstFrame + 1 ) % mFormat.getFrameCapacity();
+		--channel->mFrameCount;
+		++channel->mDroppedFrameCount;
+	}
+	const uint32_t slot = ( channel->mFirstFrame + channel->mFrameCount ) % mFormat.getFrameCapacity();
+	float *magnitudes = &channel->mMagnitudes[slot * binCount];
+
+	// band 0 packs the real DC and Nyquist terms
+	magnitudes[0] = math<float>::abs( mReal[0] );
+	magnitudes[bandCount] = math<float>::abs( mImag[0] );
+	for( uint32_t k = 1; k < bandCount; ++k )
+		magnitudes[k] = math<float>::sqrt( mReal[k] * mReal[k] + mImag[k] * mImag[k] );
+	if( mFormat.hasPhase() ) {
+		float *phases = &channel->mPhases[slot * binCount];
+		phases[0] = ( mReal[0] < 0 ) ? (float)M_PI : 0;
+		phases[bandCount] = ( mImag[0] < 0 ) ? (float)M_PI : 0;
+		for( uint32_t k = 1; k < bandCount; ++k )
+			phases[k] = math<float>::atan2( mImag[k], mReal[k] );
+	}
+	++channel->mFrameCount;
+	++channel->mNextFrameIndex;
+
+	// keep the part of the frame which overlaps the next one
+	const uint32_t overlap = mFrameSize - hopSize;
+	memmove( &channel->mInput[0], &channel->mInput[hopSize], overlap * sizeof(float) );
+	channel->mInputCount = overlap;
+}
+
+StftProcessor::Frame StftProcessor::getFrame( uint32_t index, uint16_t channel ) const
+{
+	const Channel &ch = mChannels[channel];
+	const uint32_t slot = ( ch.mFirstFrame + index ) % mFormat.getFrameCapacity();
+	Frame result;
+	result.mMagnitudes = &ch.mMagnitudes[slot * getBinCount()];
+	result.mPhases = mFormat.hasPhase() ? &ch.mPhases[slot * getBinCount()] : 0;
+	result.mIndex = ch.mNextFrameIndex - ch.mFrameCount + index;
+	return result;
+}
+
+void StftProcessor::popFrames( uint32_t count, uint16_t channel )
+{
+	Channel &ch = mChannels[channel];
+	count = std::min( count, ch.mFrameCount );
+	ch.mFirstFrame = ( ch.mFirstFrame + count ) % mFormat.getFrameCapacity();
+	ch.mFrameCount -= count;
+}
+
+void StftProcessor::synthesize( const float *magnitudes, const float *phases, float *outSamples, uint16_t channel )
+{
+	const uint32_t bandCount = getBandCount();
+	const uint32_t hopSize = getHopSize();
+
+	mReal[0] = magnitudes[0] * math<float>::cos( phases[0] );
+	mImag[0] = magnitudes[bandCount] * math<float>::cos( phases[bandCount] );
+	for( uint32_t k = 1; k < bandCount; ++k ) {
+		mReal[k] = magnitudes[k] * math<float>::cos( phases[k] );
+		mImag[k] = magnitudes[k] * math<float>::sin( phases[k] );
+	}
+	mFft->processInverse( &mReal[0], &mImag[0], &mFrame[0] );
+
+	float *overlap = &mChannels[channel].mOverlap[0];
+	for( uint32_t n = 0; n < mFrameSize; ++n )
+		overlap[n] += mFrame[n] * mWindow[n];
+
+	for( uint32_t n = 0; n < hopSize; ++n )
+		outSamples[n] = overlap[n] * mSynthesisScale[n];
+	memmove( overlap, overlap + hopSize, ( mFrameSize - hopSize ) * sizeof(float) );
+	std::fill( overlap + mFrameSize - hopSize, overlap + mFrameSize, 0.0f );
+}
+
+void StftProcessor::flushSynthesis( float *outSamples, uint16_t channel )
+{
+	const uint32_t hopSize = getHopSize();
+	std::vector<float> &overlap = mChannels[channel].mOverlap;
+	for( uint32_t n = 0; n < mFrameSize - hopSize; ++n )
+		outSamples[n] = overlap[n] * mSynthesisScale[n % hopSize];
+	std::fill( overlap.begin(), overlap.end(), 0.0f );
+}
+
+}} //namespace
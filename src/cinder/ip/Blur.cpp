@@ -0,0 +1,643 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cinder/ip/Blur.h"
+#include "cinder/ip/Parallel.h"
+#include "cinder/System.h"
+
+#include <cmath>
+#include <algorithm>
+
+#if defined( CINDER_SSE2 )
+	#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace cinder { namespace ip {
+
+namespace {
+
+// Describes the values of a Surface or Channel as rows of mComponents interleaved values, spaced mInc apart
+template<typename T>
+struct BlurImage {
+	BlurImage( T *data, int32_t rowBytes, int32_t width, int32_t height, uint8_t inc, uint8_t components )
+		: mData( data ), mRowBytes( rowBytes ), mWidth( width ), mHeight( height ), mInc( inc ), mComponents( components )
+	{}
+
+	T*	getRow( int32_t y ) const { return reinterpret_cast<T*>( reinterpret_cast<uint8_t*>( mData ) + y * mRowBytes ); }
+
+	T			*mData;
+	int32_t		mRowBytes, mWidth, mHeight;
+	uint8_t		mInc, mComponents;
+};
+
+// The source image is only ever read, so the const_casts below are safe
+template<typename T>
+BlurImage<T> blurImage( const SurfaceT<T> &surface )
+{
+	return BlurImage<T>( const_cast<T*>( surface.getData() ), surface.getRowBytes(), surface.getWidth(), surface.getHeight(), surface.getPixelInc(), surface.getPixelInc() );
+}
+
+template<typename T>
+BlurImage<T> blurImage( const ChannelT<T> &channel )
+{
+	return BlurImage<T>( const_cast<T*>( channel.getData() ), channel.getRowBytes(), channel.getWidth(), channel.getHeight(), channel.getIncrement(), 1 );
+}
+
+template<typename T>
+inline T fromFloat( float v );
+
+template<>
+inline uint8_t fromFloat<uint8_t>( float v )
+{
+	return ( v <= 0 ) ? 0 : ( ( v >= 255.0f ) ? 255 : static_cast<uint8_t>( v + 0.5f ) );
+}
+
+template<>
+inline float fromFloat<float>( float v )
+{
+	return v;
+}
+
+// Converts \a count contiguous values to float, returning how many the SIMD path handled
+template<typename T>
+int32_t loadValuesSimd( const T * /*src*/, float * /*dst*/, int32_t /*count*/ )
+{
+	return 0;
+}
+
+#if defined( CINDER_SSE2 )
+int32_t loadValuesSimd( const uint8_t *src, float *dst, int32_t count )
+{
+	int32_t i = 0;
+	static const bool useSse2 = System::hasSse2();
+	if( useSse2 ) {
+		const __m128i zero = _mm_setzero_si128();
+		for( ; i + 16 <= count; i += 16 ) {
+			__m128i bytes = _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + i ) );
+			__m128i lo = _mm_unpacklo_epi8( bytes, zero ), hi = _mm_unpackhi_epi8( bytes, zero );
+			_mm_storeu_ps( dst + i, _mm_cvtepi32_ps( _mm_unpacklo_epi16( lo, zero ) ) );
+			_mm_storeu_ps( dst + i + 4, _mm_cvtepi32_ps( _mm_unpackhi_epi16( lo, zero ) ) );
+			_mm_storeu_ps( dst + i + 8, _mm_cvtepi32_ps( _mm_unpacklo_epi16( hi, zero ) ) );
+			_mm_storeu_ps( dst + i + 12, _mm_cvtepi32_ps( _mm_unpackhi_epi16( hi, zero ) ) );
+		}
+	}
+	return i;
+}
+#endif
+
+// Converts \a count contiguous floats back to T, returning how many the SIMD path handled. Rounds exactly as fromFloat() does.
+template<typename T>
+int32_t storeValuesSimd( const float * /*src*/, T * /*dst*/, int32_t /*count*/ )
+{
+	return 0;
+}
+
+#if defined( CINDER_SSE2 )
+int32_t storeValuesSimd( const float *src, uint8_t *dst, int32_t count )
+{
+	int32_t i = 0;
+	static const bool useSse2 = System::hasSse2();
+	if( useSse2 ) {
+		const __m128 zero = _mm_setzero_ps(), maxValue = _mm_set1_ps( 255.0f ), half = _mm_set1_ps( 0.5f );
+		for( ; i + 8 <= count; i += 8 ) {
+			__m128 a = _mm_add_ps( _mm_min_ps( _mm_max_ps( _mm_loadu_ps( src + i ), zero ), maxValue ), half );
+			__m128 b = _mm_add_ps( _mm_min_ps( _mm_max_ps( _mm_loadu_ps( src + i + 4 ), zero ), maxValue ), half );
+			__m128i words = _mm_packs_epi32( _mm_cvttps_epi32( a ), _mm_cvttps_epi32( b ) );
+			_mm_storel_epi64( reinterpret_cast<__m128i*>( dst + i ), _mm_packus_epi16( words, words ) );
+		}
+	}
+	return i;
+}
+#endif
+
+template<typename T>
+void loadRow( const BlurImage<T> &image, int32_t y, int32_t width, float *dst )
+{
+	const T *src = image.getRow( y );
+	const uint8_t components = image.mComponents;
+	if( components == image.mInc ) {
+		const int32_t count = width * components;
+		for( int32_t i = loadValuesSimd( src, dst, count ); i < count; ++i )
+			dst[i] = static_cast<float>( src[i] );
+		return;
+	}
+	for( int32_t x = 0; x < width; ++x, src += image.mInc, dst += components )
+		for( uint8_t c = 0; c < components; ++c )
+			dst[c] = static_cast<float>( src[c] );
+}
+
+template<typename T>
+void storeRow( const float *src, int32_t width, const BlurImage<T> &image, int32_t y )
+{
+	T *dst = image.getRow( y );
+	const uint8_t components = image.mComponents;
+	if( components == image.mInc ) {
+		const int32_t count = width * components;
+		for( int32_t i = storeValuesSimd( src, dst, count ); i < count; ++i )
+			dst[i] = fromFloat<T>( src[i] );
+		return;
+	}
+	for( int32_t x = 0; x < width; ++x, dst += image.mInc, src += components )
+		for( uint8_t c = 0; c < components; ++c )
+			dst[c] = fromFloat<T>( src[c] );
+}
+
+template<typename T>
+void copyValues( const BlurImage<T> &src, const BlurImage<T> &dst, int32_t width, int32_t height )
+{
+	if( src.mData == dst.mData )
+		return;
+	for( int32_t y = 0; y < height; ++y ) {
+		const T *srcPtr = src.getRow( y );
+		T *dstPtr = dst.getRow( y );
+		for( int32_t x = 0; x < width; ++x, srcPtr += src.mInc, dstPtr += dst.mInc )
+			for( uint8_t c = 0; c < src.mComponents; ++c )
+				dstPtr[c] = srcPtr[c];
+	}
+}
+
+/** Gaussian **/
+
+// Computes \a numValues outputs of a symmetric kernel whose half is \a weights[0..radius], where \a weights[0] is the center.
+// \a in points at the center tap for the first output and consecutive taps are \a tapStride values apart.
+// The taps are always summed in the same order so the SSE and scalar paths produce identical results.
+void convolveSymmetric( const float *in, float *out, int32_t numValues, int32_t tapStride, const float *weights, int32_t radius )
+{
+	int32_t i = 0;
+#if defined( CINDER_SSE2 )
+	static const bool useSse2 = System::hasSse2();
+	if( useSse2 ) {
+		for( ; i + 4 <= numValues; i += 4 ) {
+			__m128 acc = _mm_mul_ps( _mm_set1_ps( weights[0] ), _mm_loadu_ps( in + i ) );
+			for( int32_t k = 1; k <= radius; ++k ) {
+				__m128 pair = _mm_add_ps( _mm_loadu_ps( in + i - k * tapStride ), _mm_loadu_ps( in + i + k * tapStride ) );
+				acc = _mm_add_ps( acc, _mm_mul_ps( _mm_set1_ps( weights[k] ), pair ) );
+			}
+			_mm_storeu_ps( out + i, acc );
+		}
+	}
+#endif
+	for( ; i < numValues; ++i ) {
+		float acc = weights[0] * in[i];
+		for( int32_t k = 1; k <= radius; ++k )
+			acc += weights[k] * ( in[i - k * tapStride] + in[i + k * tapStride] );
+		out[i] = acc;
+	}
+}
+
+// Accumulates the rows of \a scratch around output row \a y, clamping at the top and bottom edges. \a rows must have room for 2 * \a radius + 1 pointers.
+// The row is processed in short spans so the partial sums stay in cache while each pair of source rows is added in.
+void convolveColumns( const float *scratch, int32_t rowValues, int32_t height, int32_t y, float *out, const float *weights, int32_t radius, const float **rows )
+{
+	// rows[0] is the center, followed by the pairs of rows equidistant from it
+	rows[0] = scratch + y * rowValues;
+	for( int32_t k = 1; k <= radius; ++k ) {
+		rows[2 * k - 1] = scratch + std::max<int32_t>( 0, y - k ) * rowValues;
+		rows[2 * k] = scratch + std::min<int32_t>( height - 1, y + k ) * rowValues;
+	}
+
+	const int32_t spanValues = 512;
+#if defined( CINDER_SSE2 )
+	static const bool useSse2 = System::hasSse2();
+#endif
+	for( int32_t spanBegin = 0; spanBegin < rowValues; spanBegin += spanValues ) {
+		const int32_t spanEnd = std::min( rowValues, spanBegin + spanValues );
+		for( int32_t i = spanBegin; i < spanEnd; ++i )
+			out[i] = weights[0] * rows[0][i];
+		for( int32_t k = 1; k <= radius; ++k ) {
+			const float *above = rows[2 * k - 1], *below = rows[2 * k];
+			const float weight = weights[k];
+			int32_t i = spanBegin;
+#if defined( CINDER_SSE2 )
+			if( useSse2 ) {
+				const __m128 weightV = _mm_set1_ps( weight );
+				for( ; i + 4 <= spanEnd; i += 4 ) {
+					__m128 pair = _mm_add_ps( _mm_loadu_ps( above + i ), _mm_loadu_ps( below + i ) );
+					_mm_storeu_ps( out + i, _mm_add_ps( _mm_loadu_ps( out + i ), _mm_mul_ps( weightV, pair ) ) );
+				}
+			}
+#endif
+			for( ; i < spanEnd; ++i )
+				out[i] += weight * ( above[i] + below[i] );
+		}
+	}
+}
+
+template<typename T>
+struct GaussianRowsFn {
+	GaussianRowsFn( const BlurImage<T> &src, int32_t width, float *scratch, const std::vector<float> &weights )
+		: mSrc( src ), mWidth( width ), mScratch( scratch ), mWeights( weights )
+	{}
+
+	void operator()( int32_t y1, int32_t y2 ) const
+	{
+		const int32_t components = mSrc.mComponents;
+		const int32_t radius = (int32_t)mWeights.size() - 1;
+		const int32_t rowValues = mWidth * components;
+		// each row is padded by radius pixels of its edge values on both sides so the kernel never needs to clamp
+		std::vector<float> padded( ( mWidth + 2 * radius ) * components );
+		float *rowStart = &padded[radius * components];
+		for( int32_t y = y1; y < y2; ++y ) {
+			loadRow( mSrc, y, mWidth, rowStart );
+			for( int32_t p = 0; p < radius; ++p ) {
+				for( int32_t c = 0; c < components; ++c ) {
+					padded[p * components + c] = rowStart[c];
+					rowStart[rowValues + p * components + c] = rowStart[rowValues - components + c];
+				}
+			}
+			convolveSymmetric( rowStart, mScratch + y * rowValues, rowValues, components, &mWeights[0], radius );
+		}
+	}
+
+	BlurImage<T>				mSrc;
+	int32_t						mWidth;
+	float						*mScratch;
+	const std::vector<float>	&mWeights;
+};
+
+template<typename T>
+struct GaussianColumnsFn {
+	GaussianColumnsFn( const float *scratch, int32_t width, int32_t height, const BlurImage<T> &dst, const std::vector<float> &weights )
+		: mScratch( scratch ), mWidth( width ), mHeight( height ), mDst( dst ), mWeights( weights )
+	{}
+
+	void operator()( int32_t y1, int32_t y2 ) const
+	{
+		const int32_t rowValues = mWidth * mDst.mComponents;
+		const int32_t radius = (int32_t)mWeights.size() - 1;
+		std::vector<float> out( rowValues );
+		std::vector<const float*> rows( 2 * radius + 1 );
+		for( int32_t y = y1; y < y2; ++y ) {
+			convolveColumns( mScratch, rowValues, mHeight, y, &out[0], &mWeights[0], radius, &rows[0] );
+			storeRow( &out[0], mWidth, mDst, y );
+		}
+	}
+
+	const float					*mScratch;
+	int32_t						mWidth, mHeight;
+	BlurImage<T>				mDst;
+	const std::vector<float>	&mWeights;
+};
+
+// Returns the center and one side of a normalized Gaussian kernel truncated at 3 sigma
+std::vector<float> gaussianHalfKernel( float sigma )
+{
+	const int32_t radius = std::max<int32_t>( 1, (int32_t)ceil( 3 * sigma ) );
+	std::vector<float> weights( radius + 1 );
+	double sum = 0;
+	for( int32_t k = 0; k <= radius; ++k ) {
+		weights[k] = (float)exp( -( k * k ) / ( 2.0 * sigma * sigma ) );
+		sum += ( k == 0 ) ? weights[k] : 2.0 * weights[k];
+	}
+	for( int32_t k = 0; k <= radius; ++k )
+		weights[k] = (float)( weights[k] / sum );
+	return weights;
+}
+
+template<typename T>
+void gaussianBlur( const BlurImage<T> &src, const BlurImage<T> &dst, float sigma, int32_t numThreads, BlurBuffer *scratch )
+{
+	const int32_t width = std::min( src.mWidth, dst.mWidth ), height = std::min( src.mHeight, dst.mHeight );
+	if( ( width <= 0 ) || ( height <= 0 ) )
+		return;
+	if( sigma <= 0 ) {
+		copyValues( src, dst, width, height );
+		return;
+	}
+
+	BlurBuffer localScratch;
+	float *scratchData = ( scratch ? scratch : &localScratch )->getData( width * (size_t)height * src.mComponents );
+	const std::vector<float> weights = gaussianHalfKernel( sigma );
+
+	// every row must be filtered horizontally before any column is, which also makes in-place operation safe
+	parallelRows( 0, height, numThreads, GaussianRowsFn<T>( src, width, scratchData, weights ), 16 );
+	parallelRows( 0, height, numThreads, GaussianColumnsFn<T>( scratchData, width, height, dst, weights ), 16 );
+}
+
+/** Recursive Gaussian **/
+
+// Coefficients of the third order recursive filter from Young & van Vliet, normalized so that
+// output = mA * input + mC1 * output[-1] + mC2 * output[-2] + mC3 * output[-3]
+struct RecursiveCoefficients {
+	RecursiveCoefficients( float sigma )
+	{
+		const double q = ( sigma >= 2.5f ) ? ( 0.98711 * sigma - 0.96330 ) : ( 3.97156 - 4.14554 * sqrt( 1.0 - 0.26891 * sigma ) );
+		const double q2 = q * q, q3 = q2 * q;
+		const double b0 = 1.57825 + 2.44413 * q + 1.4281 * q2 + 0.422205 * q3;
+		const double b1 = 2.44413 * q + 2.85619 * q2 + 1.26661 * q3;
+		const double b2 = -( 1.4281 * q2 + 1.26661 * q3 );
+		const double b3 = 0.422205 * q3;
+		mC1 = (float)( b1 / b0 );
+		mC2 = (float)( b2 / b0 );
+		mC3 = (float)( b3 / b0 );
+		mA = 1.0f - ( mC1 + mC2 + mC3 );
+		calcEdgeMatrix( sigma );
+	}
+
+	/** Computes the three outputs past the end of a line that the anti-causal pass starts from, as if the line's last input value \a last continued forever.
+		\a u0, \a u1 and \a u2 are the last three outputs of the causal pass, from the end backwards. This is the boundary condition of Triggs & Sdika, without which
+		the anti-causal pass would start from the wrong steady state and smear the right and bottom edges. **/
+	void	anticausalInit( float last, float u0, float u1, float u2, float *p1, float *p2, float *p3 ) const
+	{
+		const float d0 = u0 - last, d1 = u1 - last, d2 = u2 - last;
+		*p1 = last + mM[0][0] * d0 + mM[0][1] * d1 + mM[0][2] * d2;
+		*p2 = last + mM[1][0] * d0 + mM[1][1] * d1 + mM[1][2] * d2;
+		*p3 = last + mM[2][0] * d0 + mM[2][1] * d1 + mM[2][2] * d2;
+	}
+
+	float	mA, mC1, mC2, mC3;
+	float	mM[3][3];
+
+ private:
+	// The boundary condition is linear in the causal outputs' deviation from the steady state, so rather than
+	// evaluating the closed form we measure it by running both passes over the decaying tail of each basis deviation
+	void	calcEdgeMatrix( float sigma )
+	{
+		const int32_t tailLength = (int32_t)( 20 * sigma ) + 64;
+		std::vector<double> tail( tailLength + 3 ), anticausal( tailLength + 3 );
+		for( int j = 0; j < 3; ++j ) {
+			// tail[0..2] hold the last three causal deviations, oldest first
+			std::fill( tail.begin(), tail.end(), 0.0 );
+			tail[2 - j] = 1.0;
+			for( int32_t n = 3; n < tailLength + 3; ++n )
+				tail[n] = mC1 * tail[n - 1] + mC2 * tail[n - 2] + mC3 * tail[n - 3];
+			std::fill( anticausal.begin(), anticausal.end(), 0.0 );
+			for( int32_t n = tailLength + 2; n >= 3; --n ) {
+				const double v1 = ( n + 1 < tailLength + 3 ) ? anticausal[n + 1] : 0.0;
+				const double v2 = ( n + 2 < tailLength + 3 ) ? anticausal[n + 2] : 0.0;
+				const double v3 = ( n + 3 < tailLength + 3 ) ? anticausal[n + 3] : 0.0;
+				anticausal[n] = mA * tail[n] + mC1 * v1 + mC2 * v2 + mC3 * v3;
+			}
+			for( int i = 0; i < 3; ++i )
+				mM[i][j] = (float)anticausal[3 + i];
+		}
+	}
+};
+
+// Runs the causal then anti-causal passes along a line of \a length elements, each \a stride values apart.
+// Both ends behave as though the edge value continued forever.
+void recursiveLine( float *line, int32_t length, int32_t stride, const RecursiveCoefficients &k )
+{
+	const float last = line[( length - 1 ) * stride];
+	float p1 = line[0], p2 = p1, p3 = p1;
+	for( int32_t i = 0; i < length; ++i ) {
+		float v = k.mA * line[i * stride] + k.mC1 * p1 + k.mC2 * p2 + k.mC3 * p3;
+		line[i * stride] = v;
+		p3 = p2; p2 = p1; p1 = v;
+	}
+	k.anticausalInit( last, p1, p2, p3, &p1, &p2, &p3 );
+	for( int32_t i = length - 1; i >= 0; --i ) {
+		float v = k.mA * line[i * stride] + k.mC1 * p1 + k.mC2 * p2 + k.mC3 * p3;
+		line[i * stride] = v;
+		p3 = p2; p2 = p1; p1 = v;
+	}
+}
+
+#if defined( CINDER_SSE2 )
+// recursiveLine() for 4 interleaved components at once
+void recursiveLine4Sse2( float *line, int32_t length, const RecursiveCoefficients &k )
+{
+	const __m128 a = _mm_set1_ps( k.mA ), c1 = _mm_set1_ps( k.mC1 ), c2 = _mm_set1_ps( k.mC2 ), c3 = _mm_set1_ps( k.mC3 );
+	float last[4];
+	std::copy( line + ( length - 1 ) * 4, line + length * 4, last );
+	__m128 p1 = _mm_loadu_ps( line ), p2 = p1, p3 = p1;
+	for( int32_t i = 0; i < length; ++i ) {
+		__m128 v = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( a, _mm_loadu_ps( line + i * 4 ) ), _mm_mul_ps( c1, p1 ) ), _mm_mul_ps( c2, p2 ) ), _mm_mul_ps( c3, p3 ) );
+		_mm_storeu_ps( line + i * 4, v );
+		p3 = p2; p2 = p1; p1 = v;
+	}
+	float u[3][4], init[3][4];
+	_mm_storeu_ps( u[0], p1 ); _mm_storeu_ps( u[1], p2 ); _mm_storeu_ps( u[2], p3 );
+	for( int c = 0; c < 4; ++c )
+		k.anticausalInit( last[c], u[0][c], u[1][c], u[2][c], &init[0][c], &init[1][c], &init[2][c] );
+	p1 = _mm_loadu_ps( init[0] ); p2 = _mm_loadu_ps( init[1] ); p3 = _mm_loadu_ps( init[2] );
+	for( int32_t i = length - 1; i >= 0; --i ) {
+		__m128 v = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( a, _mm_loadu_ps( line + i * 4 ) ), _mm_mul_ps( c1, p1 ) ), _mm_mul_ps( c2, p2 ) ), _mm_mul_ps( c3, p3 ) );
+		_mm_storeu_ps( line + i * 4, v );
+		p3 = p2; p2 = p1; p1 = v;
+	}
+}
+#endif
+
+template<typename T>
+struct RecursiveRowsFn {
+	RecursiveRowsFn( const BlurImage<T> &src, int32_t width, float *scratch, const RecursiveCoefficients &coeffs )
+		: mSrc( src ), mWidth( width ), mScratch( scratch ), mCoeffs( coeffs )
+	{}
+
+	void operator()( int32_t y1, int32_t y2 ) const
+	{
+		const int32_t components = mSrc.mComponents;
+#if defined( CINDER_SSE2 )
+		static const bool useSse2 = System::hasSse2();
+#endif
+		for( int32_t y = y1; y < y2; ++y ) {
+			float *row = mScratch + y * mWidth * components;
+			loadRow( mSrc, y, mWidth, row );
+#if defined( CINDER_SSE2 )
+			if( useSse2 && ( components == 4 ) ) {
+				recursiveLine4Sse2( row, mWidth, mCoeffs );
+				continue;
+			}
+#endif
+			for( int32_t c = 0; c < components; ++c )
+				recursiveLine( row + c, mWidth, components, mCoeffs );
+		}
+	}
+
+	BlurImage<T>			mSrc;
+	int32_t					mWidth;
+	float					*mScratch;
+	RecursiveCoefficients	mCoeffs;
+};
+
+// Filters the columns of values [i1, i2) of the scratch image, sweeping whole rows at a time so that memory is accessed sequentially
+struct RecursiveColumnsFn {
+	RecursiveColumnsFn( float *scratch, int32_t rowValues, int32_t height, const RecursiveCoefficients &coeffs )
+		: mScratch( scratch ), mRowValues( rowValues ), mHeight( height ), mCoeffs( coeffs )
+	{}
+
+	void operator()( int32_t i1, int32_t i2 ) const
+	{
+		// the rows standing in for those beyond the top and bottom edges are indexed like scratch rows
+		std::vector<float> edgeRows( mRowValues * 5 );
+		float *first = &edgeRows[0], *last = first + mRowValues, *init1 = last + mRowValues, *init2 = init1 + mRowValues, *init3 = init2 + mRowValues;
+		const float *lastRow = mScratch + ( mHeight - 1 ) * mRowValues;
+		std::copy( mScratch + i1, mScratch + i2, first + i1 );
+		std::copy( lastRow + i1, lastRow + i2, last + i1 );
+
+		sweep( first, first, first, 0, mHeight, 1, i1, i2 );
+
+		// columns shorter than 3 rows take their missing causal outputs from the steady state above the first row, as recursiveLine() does
+		const float *u0 = lastRow;
+		const float *u1 = ( mHeight >= 2 ) ? ( mScratch + ( mHeight - 2 ) * mRowValues ) : first;
+		const float *u2 = ( mHeight >= 3 ) ? ( mScratch + ( mHeight - 3 ) * mRowValues ) : first;
+		for( int32_t i = i1; i < i2; ++i )
+			mCoeffs.anticausalInit( last[i], u0[i], u1[i], u2[i], &init1[i], &init2[i], &init3[i] );
+		sweep( init1, init2, init3, mHeight - 1, -1, -1, i1, i2 );
+	}
+
+	// \a p1, \a p2 and \a p3 are indexed like scratch rows and stand in for the three rows preceding \a yBegin
+	void sweep( const float *p1, const float *p2, const float *p3, int32_t yBegin, int32_t yEnd, int32_t yStep, int32_t i1, int32_t i2 ) const
+	{
+		const RecursiveCoefficients &k( mCoeffs );
+#if defined( CINDER_SSE2 )
+		static const bool useSse2 = System::hasSse2();
+		const __m128 a = _mm_set1_ps( k.mA ), c1 = _mm_set1_ps( k.mC1 ), c2 = _mm_set1_ps( k.mC2 ), c3 = _mm_set1_ps( k.mC3 );
+#endif
+		for( int32_t y = yBegin; y != yEnd; y += yStep ) {
+			float *row = mScratch + y * mRowValues;
+			int32_t i = i1;
+#if defined( CINDER_SSE2 )
+			if( useSse2 ) {
+				for( ; i + 4 <= i2; i += 4 ) {
+					__m128 v = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( a, _mm_loadu_ps( row + i ) ), _mm_mul_ps( c1, _mm_loadu_ps( p1 + i ) ) ), _mm_mul_ps( c2, _mm_loadu_ps( p2 + i ) ) ), _mm_mul_ps( c3, _mm_loadu_ps( p3 + i ) ) );
+					_mm_storeu_ps( row + i, v );
+				}
+			}
+#endif
+			for( ; i < i2; ++i )
+				row[i] = k.mA * row[i] + k.mC1 * p1[i] + k.mC2 * p2[i] + k.mC3 * p3[i];
+			p3 = p2; p2 = p1; p1 = row;
+		}
+	}
+
+	float					*mScratch;
+	int32_t					mRowValues, mHeight;
+	RecursiveCoefficients	mCoeffs;
+};
+
+template<typename T>
+struct StoreRowsFn {
+	StoreRowsFn( const float *scratch, int32_t width, const BlurImage<T> &dst )
+		: mScratch( scratch ), mWidth( width ), mDst( dst )
+	{}
+
+	void operator()( int32_t y1, int32_t y2 ) const
+	{
+		for( int32_t y = y1; y < y2; ++y )
+			storeRow( mScratch + y * mWidth * mDst.mComponents, mWidth, mDst, y );
+	}
+
+	const float		*mScratch;
+	int32_t			mWidth;
+	BlurImage<T>	mDst;
+};
+
+template<typename T>
+void recursiveBlur( const BlurImage<T> &src, const BlurImage<T> &dst, float sigma, int32_t numThreads, BlurBuffer *scratch )
+{
+	// the recursive approximation is poor for very small sigmas, where the direct kernel is cheap anyway
+	if( sigma < 1.0f ) {
+		gaussianBlur( src, dst, sigma, numThreads, scratch );
+		return;
+	}
+
+	const int32_t width = std::min( src.mWidth, dst.mWidth ), height = std::min( src.mHeight, dst.mHeight );
+	if( ( width <= 0 ) || ( height <= 0 ) )
+		return;
+
+	BlurBuffer localScratch;
+	float *scratchData = ( scratch ? scratch : &localScratch )->getData( width * (size_t)height * src.mComponents );
+	const RecursiveCoefficients coeffs( sigma );
+
+	parallelRows( 0, height, numThreads, RecursiveRowsFn<T>( src, width, scratchData, coeffs ), 16 );
+	parallelRows( 0, width * src.mComponents, numThreads, RecursiveColumnsFn( scratchData, width * src.mComponents, height, coeffs ), 64 );
+	parallelRows( 0, height, numThreads, StoreRowsFn<T>( scratchData, width, dst ), 16 );
+}
+
+} // anonymous namespace
+
+template<typename T>
+void blur( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface, float sigma, int32_t numThreads, BlurBuffer *scratch )
+{
+	// the blur itself requires matching layouts, so convert first when they differ
+	if( ! ( srcSurface.getChannelOrder() == dstSurface->getChannelOrder() ) ) {
+		dstSurface->copyFrom( srcSurface, srcSurface.getBounds() );
+		gaussianBlur( blurImage( *dstSurface ), blurImage( *dstSurface ), sigma, numThreads, scratch );
+	}
+	else
+		gaussianBlur( blurImage( srcSurface ), blurImage( *dstSurface ), sigma, numThreads, scratch );
+}
+
+template<typename T>
+void blur( SurfaceT<T> *surface, float sigma, int32_t numThreads, BlurBuffer *scratch )
+{
+	gaussianBlur( blurImage( *surface ), blurImage( *surface ), sigma, numThreads, scratch );
+}
+
+template<typename T>
+void blur( const ChannelT<T> &srcChannel, ChannelT<T> *dstChannel, float sigma, int32_t numThreads, BlurBuffer *scratch )
+{
+	gaussianBlur( blurImage( srcChannel ), blurImage( *dstChannel ), sigma, numThreads, scratch );
+}
+
+template<typename T>
+void blur( ChannelT<T> *channel, float sigma, int32_t numThreads, BlurBuffer *scratch )
+{
+	gaussianBlur( blurImage( *channel ), blurImage( *channel ), sigma, numThreads, scratch );
+}
+
+template<typename T>
+void blurRecursive( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface, float sigma, int32_t numThreads, BlurBuffer *scratch )
+{
+	if( ! ( srcSurface.getChannelOrder() == dstSurface->getChannelOrder() ) ) {
+		dstSurface->copyFrom( srcSurface, srcSurface.getBounds() );
+		recursiveBlur( blurImage( *dstSurface ), blurImage( *dstSurface ), sigma, numThreads, scratch );
+	}
+	else
+		recursiveBlur( blurImage( srcSurface ), blurImage( *dstSurface ), sigma, numThreads, scratch );
+}
+
+template<typename T>
+void blurRecursive( SurfaceT<T> *surface, float sigma, int32_t numThreads, BlurBuffer *scratch )
+{
+	recursiveBlur( blurImage( *surface ), blurImage( *surface ), sigma, numThreads, scratch );
+}
+
+template<typename T>
+void blurRecursive( const ChannelT<T> &srcChannel, ChannelT<T> *dstChannel, float sigma, int32_t numThreads, BlurBuffer *scratch )
+{
+	recursiveBlur( blurImage( srcChannel ), blurImage( *dstChannel ), sigma, numThreads, scratch );
+}
+
+template<typename T>
+void blurRecursive( ChannelT<T> *channel, float sigma, int32_t numThreads, BlurBuffer *scratch )
+{
+	recursiveBlur( blurImage( *channel ), blurImage( *channel ), sigma, numThreads, scratch );
+}
+
+#define blur_PROTOTYPES(r,data,T)\
+	template void blur( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface, float sigma, int32_t numThreads, BlurBuffer *scratch ); \
+	template void blur( SurfaceT<T> *surface, float sigma, int32_t numThreads, BlurBuffer *scratch ); \
+	template void blur( const ChannelT<T> &srcChannel, ChannelT<T> *dstChannel, float sigma, int32_t numThreads, BlurBuffer *scratch ); \
+	template void blur( ChannelT<T> *channel, float sigma, int32_t numThreads, BlurBuffer *scratch ); \
+	template void blurRecursive( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface, float sigma, int32_t numThreads, BlurBuffer *scratch ); \
+	template void blurRecursive( SurfaceT<T> *surface, float sigma, int32_t numThreads, BlurBuffer *scratch ); \
+	template void blurRecursive( const ChannelT<T> &srcChannel, ChannelT<T> *dstChannel, float sigma, int32_t numThreads, BlurBuffer *scratch ); \
+	template void blurRecursive( ChannelT<T> *channel, float sigma, int32_t numThreads, BlurBuffer *scratch );
+
+BOOST_PP_SEQ_FOR_EACH( blur_PROTOTYPES, ~, CHANNEL_TYPES )
+
+} } // namespace cinder::ip
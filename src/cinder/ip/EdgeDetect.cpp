@@ -21,8 +21,17 @@
 */
 
 #include "cinder/ip/EdgeDetect.h"
+#include "cinder/ip/Parallel.h"
 #include "cinder/Surface.h"
 #include "cinder/CinderMath.h"
+#include "cinder/System.h"
+
+#include <vector>
+#include <algorithm>
+
+#if defined( CINDER_SSE2 )
+	#include <emmintrin.h>
+#endif
 
 namespace cinder { namespace ip {
 
@@ -32,63 +41,326 @@ namespace cinder { namespace ip {
 // -1  0  1    -1 -2 -1
 // NOTE: this leaves garbage in the top and bottom rows, as well as the left and right columns
 
+namespace {
+
+// Computes the X and Y responses for the \a count pixels that follow the first value of three contiguous rows.
+// Returns how many pixels the SIMD path handled; sobelRow() finishes the rest.
 template<typename T>
-void edgeDetectSobel( const ChannelT<T> &srcChannel, const Area &srcArea, const Vec2i &dstLT, ChannelT<T> *dstChannel )
+int32_t sobelRowSimd( const T * /*above*/, const T * /*center*/, const T * /*below*/, int32_t /*count*/, typename CHANTRAIT<T>::SignedSum * /*gx*/, typename CHANTRAIT<T>::SignedSum * /*gy*/ )
 {
-	std::pair<Area,Vec2i> srcDst = clippedSrcDst( srcChannel.getBounds(), srcArea, dstChannel->getBounds(), dstLT );
-	const Area &area( srcDst.first );
-	const Vec2i &dstOffset( srcDst.second );
-	typename CHANTRAIT<T>::Sum sumX, sumY;
+	return 0;
+}
+
+#if defined( CINDER_SSE2 )
+inline __m128i loadWidened( const uint8_t *p )
+{
+	return _mm_unpacklo_epi8( _mm_loadl_epi64( reinterpret_cast<const __m128i*>( p ) ), _mm_setzero_si128() );
+}
+
+inline void storeSignExtended( __m128i v, int32_t *dst )
+{
+	_mm_storeu_si128( reinterpret_cast<__m128i*>( dst ), _mm_srai_epi32( _mm_unpacklo_epi16( v, v ), 16 ) );
+	_mm_storeu_si128( reinterpret_cast<__m128i*>( dst + 4 ), _mm_srai_epi32( _mm_unpackhi_epi16( v, v ), 16 ) );
+}
 
-	int32_t srcRowBytes = srcChannel.getRowBytes();
-	int8_t srcPixelBytes = srcChannel.getIncrement() * sizeof(T);
-	int8_t dstPixelBytes = dstChannel->getIncrement() * sizeof(T);
+int32_t sobelRowSimd( const uint8_t *above, const uint8_t *center, const uint8_t *below, int32_t count, int32_t *gx, int32_t *gy )
+{
+	int32_t i = 0;
+	static const bool useSse2 = System::hasSse2();
+	if( useSse2 ) {
+		// responses are at most 4 * 255 in magnitude, so 16 bit lanes suffice
+		for( ; i + 8 <= count; i += 8 ) {
+			__m128i a0 = loadWidened( above + i ), a1 = loadWidened( above + i + 1 ), a2 = loadWidened( above + i + 2 );
+			__m128i b0 = loadWidened( center + i ), b2 = loadWidened( center + i + 2 );
+			__m128i c0 = loadWidened( below + i ), c1 = loadWidened( below + i + 1 ), c2 = loadWidened( below + i + 2 );
+			__m128i x = _mm_add_epi16( _mm_add_epi16( _mm_sub_epi16( a2, a0 ), _mm_slli_epi16( _mm_sub_epi16( b2, b0 ), 1 ) ), _mm_sub_epi16( c2, c0 ) );
+			__m128i y = _mm_sub_epi16( _mm_add_epi16( _mm_add_epi16( a0, _mm_slli_epi16( a1, 1 ) ), a2 ), _mm_add_epi16( _mm_add_epi16( c0, _mm_slli_epi16( c1, 1 ) ), c2 ) );
+			storeSignExtended( x, gx + i );
+			storeSignExtended( y, gy + i );
+		}
+	}
+	return i;
+}
+
+int32_t sobelRowSimd( const float *above, const float *center, const float *below, int32_t count, float *gx, float *gy )
+{
+	int32_t i = 0;
+	static const bool useSse2 = System::hasSse2();
+	if( useSse2 ) {
+		const __m128 two = _mm_set1_ps( 2.0f );
+		// the operations are ordered as in sobelRow() so the results are identical
+		for( ; i + 4 <= count; i += 4 ) {
+			__m128 a0 = _mm_loadu_ps( above + i ), a1 = _mm_loadu_ps( above + i + 1 ), a2 = _mm_loadu_ps( above + i + 2 );
+			__m128 b0 = _mm_loadu_ps( center + i ), b2 = _mm_loadu_ps( center + i + 2 );
+			__m128 c0 = _mm_loadu_ps( below + i ), c1 = _mm_loadu_ps( below + i + 1 ), c2 = _mm_loadu_ps( below + i + 2 );
+			__m128 x = _mm_sub_ps( a2, a0 );
+			x = _mm_sub_ps( x, _mm_mul_ps( two, b0 ) );
+			x = _mm_add_ps( x, _mm_mul_ps( two, b2 ) );
+			x = _mm_add_ps( _mm_sub_ps( x, c0 ), c2 );
+			__m128 y = _mm_add_ps( _mm_add_ps( a0, _mm_mul_ps( two, a1 ) ), a2 );
+			y = _mm_sub_ps( y, c0 );
+			y = _mm_sub_ps( _mm_sub_ps( y, _mm_mul_ps( two, c1 ) ), c2 );
+			_mm_storeu_ps( gx + i, x );
+			_mm_storeu_ps( gy + i, y );
+		}
+	}
+	return i;
+}
+#endif
+
+template<typename T>
+void sobelRow( const T *above, const T *center, const T *below, int32_t count, typename CHANTRAIT<T>::SignedSum *gx, typename CHANTRAIT<T>::SignedSum *gy )
+{
+	typedef typename CHANTRAIT<T>::SignedSum SUMT;
+	for( int32_t i = sobelRowSimd( above, center, below, count, gx, gy ); i < count; ++i ) {
+		SUMT x = SUMT( above[i + 2] ) - above[i];
+		x -= 2 * SUMT( center[i] );
+		x += 2 * SUMT( center[i + 2] );
+		x = x - below[i] + below[i + 2];
+		SUMT y = SUMT( above[i] ) + 2 * SUMT( above[i + 1] ) + above[i + 2];
+		y -= below[i];
+		y = y - 2 * SUMT( below[i + 1] ) - below[i + 2];
+		gx[i] = x;
+		gy[i] = y;
+	}
+}
+
+// Writes the clamped gradient magnitudes of \a count contiguous pixels, returning how many the SIMD path handled
+template<typename T>
+int32_t sobelMagnitudeSimd( const typename CHANTRAIT<T>::SignedSum * /*gx*/, const typename CHANTRAIT<T>::SignedSum * /*gy*/, int32_t /*count*/, T * /*dst*/ )
+{
+	return 0;
+}
+
+#if defined( CINDER_SSE2 )
+int32_t sobelMagnitudeSimd( const int32_t *gx, const int32_t *gy, int32_t count, uint8_t *dst )
+{
+	int32_t i = 0;
+	static const bool useSse2 = System::hasSse2();
+	if( useSse2 ) {
+		// the squared magnitudes are below 2^24, so computing them in float is exact
+		for( ; i + 8 <= count; i += 8 ) {
+			__m128 xLo = _mm_cvtepi32_ps( _mm_loadu_si128( reinterpret_cast<const __m128i*>( gx + i ) ) ), yLo = _mm_cvtepi32_ps( _mm_loadu_si128( reinterpret_cast<const __m128i*>( gy + i ) ) );
+			__m128 xHi = _mm_cvtepi32_ps( _mm_loadu_si128( reinterpret_cast<const __m128i*>( gx + i + 4 ) ) ), yHi = _mm_cvtepi32_ps( _mm_loadu_si128( reinterpret_cast<const __m128i*>( gy + i + 4 ) ) );
+			__m128i lo = _mm_cvttps_epi32( _mm_sqrt_ps( _mm_add_ps( _mm_mul_ps( xLo, xLo ), _mm_mul_ps( yLo, yLo ) ) ) );
+			__m128i hi = _mm_cvttps_epi32( _mm_sqrt_ps( _mm_add_ps( _mm_mul_ps( xHi, xHi ), _mm_mul_ps( yHi, yHi ) ) ) );
+			// saturating packs clamp to 255
+			__m128i words = _mm_packs_epi32( lo, hi );
+			_mm_storel_epi64( reinterpret_cast<__m128i*>( dst + i ), _mm_packus_epi16( words, words ) );
+		}
+	}
+	return i;
+}
+
+int32_t sobelMagnitudeSimd( const float *gx, const float *gy, int32_t count, float *dst )
+{
+	int32_t i = 0;
+	static const bool useSse2 = System::hasSse2();
+	if( useSse2 ) {
+		const __m128 maxValue = _mm_set1_ps( CHANTRAIT<float>::max() );
+		for( ; i + 4 <= count; i += 4 ) {
+			__m128 x = _mm_loadu_ps( gx + i ), y = _mm_loadu_ps( gy + i );
+			_mm_storeu_ps( dst + i, _mm_min_ps( _mm_sqrt_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ) ), maxValue ) );
+		}
+	}
+	return i;
+}
+#endif
+
+template<typename T>
+void sobelMagnitude( const typename CHANTRAIT<T>::SignedSum *gx, const typename CHANTRAIT<T>::SignedSum *gy, int32_t count, T *dst, int8_t dstInc )
+{
+	typedef typename CHANTRAIT<T>::Sum SUMT;
 	const T maxValue = CHANTRAIT<T>::max();
-	for( int32_t y = 1; y < area.getHeight() - 1; ++y ) {
-		const uint8_t *srcLine = reinterpret_cast<const uint8_t*>( srcChannel.getData( area.getX1() + 1, area.getY1() + y ) );
-		uint8_t *dstLine = reinterpret_cast<uint8_t*>( dstChannel->getData( dstOffset.x + area.getX1() + 1, dstOffset.y + y ) );
-		for( int32_t x = area.getX1() + 1; x < area.getX2() - 1; ++x ) {
-//			sumX = -srcLine[-srcRowPixels-srcPixelStride] + srcLine[-srcRowPixels+srcPixelStride] - 2 * srcLine[-srcPixelStride] + 2 * srcLine[srcPixelStride] - srcLine[srcRowPixels-srcPixelStride] + srcLine[srcRowPixels+srcPixelStride];
-			sumX = -*(T*)(srcLine-srcRowBytes-srcPixelBytes) + *(T*)(srcLine-srcRowBytes+srcPixelBytes) - 2 * *(T*)(srcLine-srcPixelBytes) + 2 * *(T*)(srcLine+srcPixelBytes) - *(T*)(srcLine+srcRowBytes-srcPixelBytes) + *(T*)(srcLine+srcRowBytes+srcPixelBytes);
-//			sumY = srcLine[-srcRowPixels-srcPixelStride] + 2 * srcLine[-srcRowPixels] + srcLine[-srcRowPixels + srcPixelStride]				- srcLine[srcRowPixels-srcPixelStride] - 2 * srcLine[srcRowPixels] - srcLine[srcRowPixels+srcPixelStride];
-			sumY = *(T*)(srcLine-srcRowBytes-srcPixelBytes) + 2 * *(T*)(srcLine-srcRowBytes) + *(T*)(srcLine-srcRowBytes+srcPixelBytes) - *(T*)(srcLine+srcRowBytes-srcPixelBytes) - 2 * *(T*)(srcLine+srcPixelBytes) - *(T*)(srcLine+srcRowBytes+srcPixelBytes);
-			sumX = static_cast<typename CHANTRAIT<T>::Sum>( math<float>::sqrt( float( sumX * sumX + sumY * sumY ) ) );
-			if( sumX > maxValue ) sumX = maxValue;
-			*dstLine = static_cast<uint8_t>( sumX );
-			dstLine += dstPixelBytes;
-			srcLine += srcPixelBytes;
+	int32_t i = ( dstInc == 1 ) ? sobelMagnitudeSimd( gx, gy, count, dst ) : 0;
+	for( ; i < count; ++i ) {
+		SUMT magnitude = static_cast<SUMT>( math<float>::sqrt( float( gx[i] * gx[i] + gy[i] * gy[i] ) ) );
+		if( magnitude > maxValue ) magnitude = maxValue;
+		dst[i * dstInc] = static_cast<T>( magnitude );
+	}
+}
+
+// A minimax polynomial for atan() on [0, 1], accurate to about 1e-5 radians, which is far faster than atan2f() and can be vectorized.
+// fastAtan2() and fastAtan2Sse2() perform the same operations in the same order and so agree exactly.
+const float kAtanCoeffs[6] = { 0.99997726f, -0.33262347f, 0.19354346f, -0.11643287f, 0.05265332f, -0.01172120f };
+
+inline float fastAtan2( float y, float x )
+{
+	const float ax = math<float>::abs( x ), ay = math<float>::abs( y );
+	const float maxAxis = std::max( ax, ay );
+	const float z = ( maxAxis > 0 ) ? ( std::min( ax, ay ) / maxAxis ) : 0.0f;
+	const float z2 = z * z;
+	float a = z * ( kAtanCoeffs[0] + z2 * ( kAtanCoeffs[1] + z2 * ( kAtanCoeffs[2] + z2 * ( kAtanCoeffs[3] + z2 * ( kAtanCoeffs[4] + z2 * kAtanCoeffs[5] ) ) ) ) );
+	if( ay > ax ) a = (float)( M_PI / 2 ) - a;
+	if( x < 0 ) a = (float)M_PI - a;
+	return ( y < 0 ) ? -a : a;
+}
+
+#if defined( CINDER_SSE2 )
+inline __m128 select( __m128 mask, __m128 ifTrue, __m128 ifFalse )
+{
+	return _mm_or_ps( _mm_and_ps( mask, ifTrue ), _mm_andnot_ps( mask, ifFalse ) );
+}
+
+inline __m128 fastAtan2Sse2( __m128 y, __m128 x )
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 signMask = _mm_set1_ps( -0.0f );
+	const __m128 ax = _mm_andnot_ps( signMask, x ), ay = _mm_andnot_ps( signMask, y );
+	const __m128 maxAxis = _mm_max_ps( ax, ay );
+	const __m128 z = _mm_and_ps( _mm_cmpgt_ps( maxAxis, zero ), _mm_div_ps( _mm_min_ps( ax, ay ), maxAxis ) );
+	const __m128 z2 = _mm_mul_ps( z, z );
+	__m128 poly = _mm_add_ps( _mm_set1_ps( kAtanCoeffs[4] ), _mm_mul_ps( z2, _mm_set1_ps( kAtanCoeffs[5] ) ) );
+	poly = _mm_add_ps( _mm_set1_ps( kAtanCoeffs[3] ), _mm_mul_ps( z2, poly ) );
+	poly = _mm_add_ps( _mm_set1_ps( kAtanCoeffs[2] ), _mm_mul_ps( z2, poly ) );
+	poly = _mm_add_ps( _mm_set1_ps( kAtanCoeffs[1] ), _mm_mul_ps( z2, poly ) );
+	poly = _mm_add_ps( _mm_set1_ps( kAtanCoeffs[0] ), _mm_mul_ps( z2, poly ) );
+	__m128 a = _mm_mul_ps( z, poly );
+	a = select( _mm_cmpgt_ps( ay, ax ), _mm_sub_ps( _mm_set1_ps( (float)( M_PI / 2 ) ), a ), a );
+	a = select( _mm_cmplt_ps( x, zero ), _mm_sub_ps( _mm_set1_ps( (float)M_PI ), a ), a );
+	return select( _mm_cmplt_ps( y, zero ), _mm_xor_ps( a, signMask ), a );
+}
+#endif
+
+// Writes the gradient directions of \a count contiguous pixels, returning how many the SIMD path handled
+template<typename SUMT>
+int32_t sobelDirectionSimd( const SUMT * /*gx*/, const SUMT * /*gy*/, int32_t /*count*/, float * /*dst*/ )
+{
+	return 0;
+}
+
+#if defined( CINDER_SSE2 )
+inline __m128 loadFloats( const int32_t *p ) { return _mm_cvtepi32_ps( _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) ) ); }
+inline __m128 loadFloats( const float *p ) { return _mm_loadu_ps( p ); }
+
+template<typename SUMT>
+int32_t sobelDirectionSimdImpl( const SUMT *gx, const SUMT *gy, int32_t count, float *dst )
+{
+	int32_t i = 0;
+	static const bool useSse2 = System::hasSse2();
+	if( useSse2 ) {
+		for( ; i + 4 <= count; i += 4 )
+			_mm_storeu_ps( dst + i, fastAtan2Sse2( loadFloats( gy + i ), loadFloats( gx + i ) ) );
+	}
+	return i;
+}
+
+int32_t sobelDirectionSimd( const int32_t *gx, const int32_t *gy, int32_t count, float *dst ) { return sobelDirectionSimdImpl( gx, gy, count, dst ); }
+int32_t sobelDirectionSimd( const float *gx, const float *gy, int32_t count, float *dst ) { return sobelDirectionSimdImpl( gx, gy, count, dst ); }
+#endif
+
+template<typename SUMT>
+void sobelDirection( const SUMT *gx, const SUMT *gy, int32_t count, float *dst, int8_t dstInc )
+{
+	int32_t i = ( dstInc == 1 ) ? sobelDirectionSimd( gx, gy, count, dst ) : 0;
+	for( ; i < count; ++i )
+		dst[i * dstInc] = fastAtan2( float( gy[i] ), float( gx[i] ) );
+}
+
+// Processes a band of rows, sliding a window of three source rows down the image. Strided sources are copied into contiguous
+// row buffers first so that the SIMD kernels always see contiguous data; each source row is copied only once per band.
+template<typename T>
+struct SobelRowsFn {
+	SobelRowsFn( const ChannelT<T> &srcChannel, const Area &area, const Vec2i &dstLT, ChannelT<T> *dstMagnitude, Channel32f *dstDirection )
+		: mSrcChannel( srcChannel ), mArea( area ), mDstLT( dstLT ), mDstMagnitude( dstMagnitude ), mDstDirection( dstDirection )
+	{}
+
+	void operator()( int32_t y1, int32_t y2 ) const
+	{
+		typedef typename CHANTRAIT<T>::SignedSum SUMT;
+		const int32_t width = mArea.getWidth();
+		const int32_t count = width - 2;
+		if( count <= 0 )
+			return;
+
+		std::vector<T> rowBuffers( ( mSrcChannel.getIncrement() == 1 ) ? 0 : 3 * width );
+		std::vector<SUMT> gx( count ), gy( count );
+		const T *above = sourceRow( y1 - 1, rowBuffers ), *center = sourceRow( y1, rowBuffers );
+		for( int32_t y = y1; y < y2; ++y ) {
+			const T *below = sourceRow( y + 1, rowBuffers );
+			sobelRow( above, center, below, count, &gx[0], &gy[0] );
+			if( mDstMagnitude )
+				sobelMagnitude( &gx[0], &gy[0], count, mDstMagnitude->getData( mDstLT.x + 1, mDstLT.y + y - mArea.getY1() ), mDstMagnitude->getIncrement() );
+			if( mDstDirection )
+				sobelDirection( &gx[0], &gy[0], count, mDstDirection->getData( mDstLT.x + 1, mDstLT.y + y - mArea.getY1() ), mDstDirection->getIncrement() );
+			above = center;
+			center = below;
 		}
 	}
+
+	const T*	sourceRow( int32_t y, std::vector<T> &rowBuffers ) const
+	{
+		const T *src = mSrcChannel.getData( mArea.getX1(), y );
+		const int8_t inc = mSrcChannel.getIncrement();
+		if( inc == 1 )
+			return src;
+		T *row = &rowBuffers[( y % 3 ) * mArea.getWidth()];
+		for( int32_t x = 0; x < mArea.getWidth(); ++x, src += inc )
+			row[x] = *src;
+		return row;
+	}
+
+	const ChannelT<T>	&mSrcChannel;
+	Area				mArea;
+	Vec2i				mDstLT; // where mArea's upper-left corner lands in the destination
+	ChannelT<T>			*mDstMagnitude;
+	Channel32f			*mDstDirection;
+};
+
+template<typename T>
+void sobelImpl( const ChannelT<T> &srcChannel, const Area &area, const Vec2i &dstLT, ChannelT<T> *dstMagnitude, Channel32f *dstDirection, int32_t numThreads )
+{
+	parallelRows( area.getY1() + 1, area.getY2() - 1, numThreads, SobelRowsFn<T>( srcChannel, area, dstLT, dstMagnitude, dstDirection ), 32 );
+}
+
+} // anonymous namespace
+
+template<typename T>
+void edgeDetectSobel( const ChannelT<T> &srcChannel, const Area &srcArea, const Vec2i &dstLT, ChannelT<T> *dstChannel, int32_t numThreads )
+{
+	std::pair<Area,Vec2i> srcDst = clippedSrcDst( srcChannel.getBounds(), srcArea, dstChannel->getBounds(), dstLT );
+	sobelImpl<T>( srcChannel, srcDst.first, srcDst.second, dstChannel, 0, numThreads );
 }
 
 template<typename T>
-void edgeDetectSobel( const SurfaceT<T> &srcSurface, const Area &srcArea, const Vec2i &dstLT, SurfaceT<T> *dstSurface )
+void edgeDetectSobel( const SurfaceT<T> &srcSurface, const Area &srcArea, const Vec2i &dstLT, SurfaceT<T> *dstSurface, int32_t numThreads )
 {
-	edgeDetectSobel( srcSurface.getChannelRed(), srcArea, dstLT, &dstSurface->getChannelRed() );
-	edgeDetectSobel( srcSurface.getChannelGreen(), srcArea, dstLT, &dstSurface->getChannelGreen() );
-	edgeDetectSobel( srcSurface.getChannelBlue(), srcArea, dstLT, &dstSurface->getChannelBlue() );
+	edgeDetectSobel( srcSurface.getChannelRed(), srcArea, dstLT, &dstSurface->getChannelRed(), numThreads );
+	edgeDetectSobel( srcSurface.getChannelGreen(), srcArea, dstLT, &dstSurface->getChannelGreen(), numThreads );
+	edgeDetectSobel( srcSurface.getChannelBlue(), srcArea, dstLT, &dstSurface->getChannelBlue(), numThreads );
 	if( srcSurface.hasAlpha() && dstSurface->hasAlpha() )
-		edgeDetectSobel( srcSurface.getChannelAlpha(), srcArea, dstLT, &dstSurface->getChannelAlpha() );
+		edgeDetectSobel( srcSurface.getChannelAlpha(), srcArea, dstLT, &dstSurface->getChannelAlpha(), numThreads );
 }
 
 template<typename T>
-void edgeDetectSobel( const ChannelT<T> &srcChannel, ChannelT<T> *dstChannel )
+void edgeDetectSobel( const ChannelT<T> &srcChannel, ChannelT<T> *dstChannel, int32_t numThreads )
 {
-	edgeDetectSobel( srcChannel, srcChannel.getBounds(), Vec2i::zero(), dstChannel );
+	edgeDetectSobel( srcChannel, srcChannel.getBounds(), Vec2i::zero(), dstChannel, numThreads );
 }
 
 template<typename T>
-void edgeDetectSobel( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSuface )
+void edgeDetectSobel( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSuface, int32_t numThreads )
 {
-	edgeDetectSobel( srcSurface, srcSurface.getBounds(), Vec2i::zero(), dstSuface );
+	edgeDetectSobel( srcSurface, srcSurface.getBounds(), Vec2i::zero(), dstSuface, numThreads );
 }
 
+template<typename T>
+void edgeDetectSobel( const ChannelT<T> &srcChannel, ChannelT<T> *dstMagnitude, Channel32f *dstDirection, int32_t numThreads )
+{
+	Area area = srcChannel.getBounds();
+	if( dstMagnitude )
+		area.clipBy( dstMagnitude->getBounds() );
+	if( dstDirection )
+		area.clipBy( dstDirection->getBounds() );
+	sobelImpl( srcChannel, area, Vec2i::zero(), dstMagnitude, dstDirection, numThreads );
+}
 
 #define edgeDetect_PROTOTYPES(r,data,T)\
-	template void edgeDetectSobel( const ChannelT<T> &srcChannel, const Area &srcArea, const Vec2i &dstLT, ChannelT<T> *dstChannel ); \
-	template void edgeDetectSobel( const SurfaceT<T> &srcSurface, const Area &srcArea, const Vec2i &dstLT, SurfaceT<T> *dstSurface ); \
-	template void edgeDetectSobel( const ChannelT<T> &srcChannel, ChannelT<T> *dstChannel );	\
-	template void edgeDetectSobel( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface );	
+	template void edgeDetectSobel( const ChannelT<T> &srcChannel, const Area &srcArea, const Vec2i &dstLT, ChannelT<T> *dstChannel, int32_t numThreads ); \
+	template void edgeDetectSobel( const SurfaceT<T> &srcSurface, const Area &srcArea, const Vec2i &dstLT, SurfaceT<T> *dstSurface, int32_t numThreads ); \
+	template void edgeDetectSobel( const ChannelT<T> &srcChannel, ChannelT<T> *dstChannel, int32_t numThreads );	\
+	template void edgeDetectSobel( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface, int32_t numThreads );	\
+	template void edgeDetectSobel( const ChannelT<T> &srcChannel, ChannelT<T> *dstMagnitude, Channel32f *dstDirection, int32_t numThreads );
 
 BOOST_PP_SEQ_FOR_EACH( edgeDetect_PROTOTYPES, ~, CHANNEL_TYPES )
 
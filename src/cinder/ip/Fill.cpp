@@ -21,14 +21,64 @@
 */
 
 #include "cinder/ip/Fill.h"
+#include "cinder/ip/PixelLayout.h"
+#include "cinder/ChanTraits.h"
+
+#include <algorithm>
+#include <cstring>
 
 namespace cinder { namespace ip {
 
+// Writes \a color into every pixel of the first row of \a clippedArea, then replicates that row. When \a wholePixels is true
+// every value of each pixel is overwritten, so the remaining rows can be copied wholesale rather than rewritten value by value.
+template<typename T, typename LAYOUT>
+void fillRows( SurfaceT<T> *surface, const ColorAT<T> &color, bool writeAlpha, const Area &clippedArea )
+{
+	const bool wholePixels = ( LAYOUT::INC == 3 ) || writeAlpha;
+	const size_t rowSpanBytes = clippedArea.getWidth() * LAYOUT::INC * sizeof(T);
+	const T *firstRow = 0;
+	for( int32_t y = clippedArea.getY1(); y < clippedArea.getY2(); ++y ) {
+		T *dstPtr = surface->getData( Vec2i( clippedArea.getX1(), y ) );
+		if( firstRow && wholePixels ) {
+			memcpy( dstPtr, firstRow, rowSpanBytes );
+			continue;
+		}
+		for( int32_t x = 0; x < clippedArea.getWidth(); ++x ) {
+			dstPtr[LAYOUT::R] = color.r;
+			dstPtr[LAYOUT::G] = color.g;
+			dstPtr[LAYOUT::B] = color.b;
+			if( LAYOUT::HAS_ALPHA && writeAlpha )
+				dstPtr[LAYOUT::A] = color.a;
+			dstPtr += LAYOUT::INC;
+		}
+		firstRow = surface->getData( Vec2i( clippedArea.getX1(), y ) );
+	}
+}
+
+template<typename T>
+struct FillLayoutOp {
+	FillLayoutOp( SurfaceT<T> *surface, const ColorAT<T> &color, bool writeAlpha, const Area &clippedArea )
+		: mSurface( surface ), mColor( color ), mWriteAlpha( writeAlpha ), mClippedArea( clippedArea )
+	{}
+
+	template<typename LAYOUT>
+	void process() { fillRows<T,LAYOUT>( mSurface, mColor, mWriteAlpha, mClippedArea ); }
+
+	SurfaceT<T>		*mSurface;
+	ColorAT<T>		mColor;
+	bool			mWriteAlpha;
+	Area			mClippedArea;
+};
+
 template<typename T>
 void fill_impl( SurfaceT<T> *surface, const ColorT<T> &color, const Area &area )
 {
 	const Area clippedArea = area.getClipBy( surface->getBounds() );
 
+	FillLayoutOp<T> op( surface, ColorAT<T>( color.r, color.g, color.b, CHANTRAIT<T>::max() ), false, clippedArea );
+	if( dispatchPixelLayout( surface->getChannelOrder(), op ) )
+		return;
+
 	int32_t rowBytes = surface->getRowBytes();
 	uint8_t pixelInc = surface->getPixelInc();
 	const T red = color.r, green = color.g, blue = color.b;
@@ -55,6 +105,10 @@ void fill_impl( SurfaceT<T> *surface, const ColorAT<T> &color, const Area &area
 	
 	const Area clippedArea = area.getClipBy( surface->getBounds() );
 
+	FillLayoutOp<T> op( surface, color, true, clippedArea );
+	if( dispatchPixelLayout( surface->getChannelOrder(), op ) )
+		return;
+
 	int32_t rowBytes = surface->getRowBytes();
 	uint8_t pixelInc = surface->getPixelInc();
 	const T red = color.r, green = color.g, blue = color.b, alpha = color.a;
@@ -108,6 +162,10 @@ void fill( ChannelT<T> *channel, T value, const Area &area )
 	uint8_t inc = channel->getIncrement();
 	for( int32_t y = clippedArea.getY1(); y < clippedArea.getY2(); ++y ) {
 		T *dstPtr = reinterpret_cast<T*>( reinterpret_cast<uint8_t*>( channel->getData() + clippedArea.getX1() * inc ) + y * rowBytes );
+		if( inc == 1 ) {
+			std::fill( dstPtr, dstPtr + clippedArea.getWidth(), value );
+			continue;
+		}
 		for( int32_t x = 0; x < clippedArea.getWidth(); ++x ) {
 			*dstPtr = value;
 			dstPtr += inc;
@@ -20,21 +20,44 @@
  POSSIBILITY OF SUCH DAMAGE.
 */
 
+
 #include "cinder/ip/Grayscale.h"
+#include "cinder/ip/PixelLayout.h"
+#include "cinder/ip/Parallel.h"
 #include "cinder/ChanTraits.h"
+#include "cinder/System.h"
+
+#if defined( CINDER_SSE2 )
+	#include <emmintrin.h>
+#endif
 
 namespace cinder { namespace ip {
 
-template<typename T>
-void grayscale( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface )
+template<typename T, typename LAYOUT>
+void grayscaleRows( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface, const Area &area, int32_t y1, int32_t y2 )
 {
-	Area area = srcSurface.getBounds().getClipBy( dstSurface->getBounds() );
+	for( int32_t y = y1; y < y2; ++y ) {
+		T *dstPtr = dstSurface->getData( Vec2i( area.getX1(), y ) );
+		const T *srcPtr = srcSurface.getData( Vec2i( area.getX1(), y ) );
+		for( int32_t x = area.getX1(); x < area.getX2(); ++x ) {
+			T gray = CHANTRAIT<T>::grayscale( srcPtr[LAYOUT::R], srcPtr[LAYOUT::G], srcPtr[LAYOUT::B] );
+			dstPtr[LAYOUT::R] = gray;
+			dstPtr[LAYOUT::G] = gray;
+			dstPtr[LAYOUT::B] = gray;
+			dstPtr += LAYOUT::INC;
+			srcPtr += LAYOUT::INC;
+		}
+	}
+}
 
+template<typename T>
+void grayscaleRowsGeneric( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface, const Area &area, int32_t y1, int32_t y2 )
+{
 	int8_t srcPixelInc = srcSurface.getPixelInc();
 	uint8_t srcRedOffset = srcSurface.getRedOffset(), srcGreenOffset = srcSurface.getGreenOffset(), srcBlueOffset = srcSurface.getBlueOffset();
 	uint8_t dstRedOffset = dstSurface->getRedOffset(), dstGreenOffset = dstSurface->getGreenOffset(), dstBlueOffset = dstSurface->getBlueOffset();	
 	int8_t dstPixelInc = dstSurface->getPixelInc();
-	for( int32_t y = 0; y < area.getHeight(); ++y ) {
+	for( int32_t y = y1; y < y2; ++y ) {
 		T *dstPtr = dstSurface->getData( Vec2i( area.getX1(), y ) );
 		const T *srcPtr = srcSurface.getData( Vec2i( area.getX1(), y ) );
 		for( int32_t x = area.getX1(); x < area.getX2(); ++x ) {
@@ -49,49 +72,179 @@ void grayscale( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface )
 }
 
 template<typename T>
-void grayscale( const SurfaceT<T> &srcSurface, ChannelT<T> *dstChannel )
+struct GrayscaleSurfaceRowsFn {
+	GrayscaleSurfaceRowsFn( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface, const Area &area )
+		: mSrcSurface( srcSurface ), mDstSurface( dstSurface ), mArea( area )
+	{}
+
+	void operator()( int32_t y1, int32_t y2 ) const
+	{
+		LayoutOp op( *this, y1, y2 );
+		// the specialized loops require both Surfaces to share a layout
+		if( ( ! ( mSrcSurface.getChannelOrder() == mDstSurface->getChannelOrder() ) ) || ( ! dispatchPixelLayout( mSrcSurface.getChannelOrder(), op ) ) )
+			grayscaleRowsGeneric( mSrcSurface, mDstSurface, mArea, y1, y2 );
+	}
+
+	struct LayoutOp {
+		LayoutOp( const GrayscaleSurfaceRowsFn &fn, int32_t y1, int32_t y2 ) : mFn( fn ), mY1( y1 ), mY2( y2 ) {}
+		template<typename LAYOUT>
+		void process() { grayscaleRows<T,LAYOUT>( mFn.mSrcSurface, mFn.mDstSurface, mFn.mArea, mY1, mY2 ); }
+
+		const GrayscaleSurfaceRowsFn	&mFn;
+		int32_t							mY1, mY2;
+	};
+
+	const SurfaceT<T>	&mSrcSurface;
+	SurfaceT<T>			*mDstSurface;
+	Area				mArea;
+};
+
+template<typename T>
+void grayscale( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface, int32_t numThreads )
 {
-	Area area = srcSurface.getBounds().getClipBy( dstChannel->getBounds() );
+	Area area = srcSurface.getBounds().getClipBy( dstSurface->getBounds() );
 
-	int8_t srcPixelInc = srcSurface.getPixelInc();
-	uint8_t srcRedOffset = srcSurface.getRedOffset(), srcGreenOffset = srcSurface.getGreenOffset(), srcBlueOffset = srcSurface.getBlueOffset();
+	parallelRows( 0, area.getHeight(), numThreads, GrayscaleSurfaceRowsFn<T>( srcSurface, dstSurface, area ), 64 );
+}
+
+// Converts as many leading pixels of \a srcPtr into the tightly packed \a dstPtr as the SIMD kernel handles and returns how many it did
+template<typename LAYOUT>
+int32_t grayscaleRowSimd( const float * /*srcPtr*/, float * /*dstPtr*/, int32_t /*width*/ )
+{
+	return 0;
+}
+
+#if defined( CINDER_SSE2 )
+template<typename LAYOUT>
+int32_t grayscaleRowSimd( const uint8_t *srcPtr, uint8_t *dstPtr, int32_t width )
+{
+	static const bool useSse2 = System::hasSse2();
+	if( ( ! useSse2 ) || ( LAYOUT::INC != 4 ) )
+		return 0;
+
+	// per-pixel weights in channel order; _mm_madd_epi16 sums them in pairs
+	int16_t weights[4] = { 0, 0, 0, 0 };
+	weights[LAYOUT::R] = 74; weights[LAYOUT::G] = 147; weights[LAYOUT::B] = 35;
+	const __m128i w = _mm_set_epi16( weights[3], weights[2], weights[1], weights[0], weights[3], weights[2], weights[1], weights[0] );
+	const __m128i zero = _mm_setzero_si128();
+
+	int32_t x = 0;
+	for( ; x + 8 <= width; x += 8 ) {
+		__m128i sums[2];
+		for( int h = 0; h < 2; ++h ) {
+			__m128i px = _mm_loadu_si128( reinterpret_cast<const __m128i*>( srcPtr + ( x + h * 4 ) * 4 ) );
+			__m128 lo = _mm_castsi128_ps( _mm_madd_epi16( _mm_unpacklo_epi8( px, zero ), w ) );
+			__m128 hi = _mm_castsi128_ps( _mm_madd_epi16( _mm_unpackhi_epi8( px, zero ), w ) );
+			// add the two partial sums of each pixel
+			sums[h] = _mm_add_epi32( _mm_castps_si128( _mm_shuffle_ps( lo, hi, _MM_SHUFFLE( 2, 0, 2, 0 ) ) ), _mm_castps_si128( _mm_shuffle_ps( lo, hi, _MM_SHUFFLE( 3, 1, 3, 1 ) ) ) );
+			sums[h] = _mm_srli_epi32( sums[h], 8 );
+		}
+		__m128i gray = _mm_packus_epi16( _mm_packs_epi32( sums[0], sums[1] ), zero );
+		_mm_storel_epi64( reinterpret_cast<__m128i*>( dstPtr + x ), gray );
+	}
+	return x;
+}
+#else
+template<typename LAYOUT>
+int32_t grayscaleRowSimd( const uint8_t * /*srcPtr*/, uint8_t * /*dstPtr*/, int32_t /*width*/ )
+{
+	return 0;
+}
+#endif
+
+inline uint8_t grayscaleToChannel( uint8_t r, uint8_t g, uint8_t b )
+{
+	const uint8_t redWeight = 74, greenWeight = 147, blueWeight = 35;
+	uint32_t sum = r * redWeight + g * greenWeight + b * blueWeight;
+	return static_cast<uint8_t>( sum >> 8 );
+}
+
+inline float grayscaleToChannel( float r, float g, float b )
+{
+	return CHANTRAIT<float>::grayscale( r, g, b );
+}
+
+template<typename T, typename LAYOUT>
+void grayscaleToChannelRows( const SurfaceT<T> &srcSurface, ChannelT<T> *dstChannel, const Area &area, int32_t y1, int32_t y2 )
+{
 	int8_t dstPixelInc = dstChannel->getIncrement();
-	for( int32_t y = 0; y < area.getHeight(); ++y ) {
+	for( int32_t y = y1; y < y2; ++y ) {
 		T *dstPtr = dstChannel->getData( Vec2i( area.getX1(), y ) );
 		const T *srcPtr = srcSurface.getData( Vec2i( area.getX1(), y ) );
-		for( int32_t x = area.getX1(); x < area.getX2(); ++x ) {
-			*dstPtr = CHANTRAIT<T>::grayscale( srcPtr[srcRedOffset], srcPtr[srcGreenOffset], srcPtr[srcBlueOffset] );
-			dstPtr += dstPixelInc;
-			srcPtr += srcPixelInc;
+		int32_t x = area.getX1();
+		if( dstPixelInc == 1 ) {
+			int32_t done = grayscaleRowSimd<LAYOUT>( srcPtr, dstPtr, area.getWidth() );
+			x += done; srcPtr += done * LAYOUT::INC; dstPtr += done;
+			for( ; x < area.getX2(); ++x ) {
+				*dstPtr++ = grayscaleToChannel( srcPtr[LAYOUT::R], srcPtr[LAYOUT::G], srcPtr[LAYOUT::B] );
+				srcPtr += LAYOUT::INC;
+			}
+		}
+		else {
+			for( ; x < area.getX2(); ++x ) {
+				*dstPtr = grayscaleToChannel( srcPtr[LAYOUT::R], srcPtr[LAYOUT::G], srcPtr[LAYOUT::B] );
+				dstPtr += dstPixelInc;
+				srcPtr += LAYOUT::INC;
+			}
 		}
 	}
 }
 
-template<>
-void grayscale( const Surface8u &srcSurface, Channel8u *dstChannel )
+template<typename T>
+void grayscaleToChannelRowsGeneric( const SurfaceT<T> &srcSurface, ChannelT<T> *dstChannel, const Area &area, int32_t y1, int32_t y2 )
 {
-	Area area = srcSurface.getBounds().getClipBy( dstChannel->getBounds() );
-
 	int8_t srcPixelInc = srcSurface.getPixelInc();
 	uint8_t srcRedOffset = srcSurface.getRedOffset(), srcGreenOffset = srcSurface.getGreenOffset(), srcBlueOffset = srcSurface.getBlueOffset();
 	int8_t dstPixelInc = dstChannel->getIncrement();
-	const uint8_t redWeight = 74, greenWeight = 147, blueWeight = 35;
-	for( int32_t y = 0; y < area.getHeight(); ++y ) {
-		uint8_t *dstPtr = dstChannel->getData( Vec2i( area.getX1(), y ) );
-		const uint8_t *srcPtr = srcSurface.getData( Vec2i( area.getX1(), y ) );
+	for( int32_t y = y1; y < y2; ++y ) {
+		T *dstPtr = dstChannel->getData( Vec2i( area.getX1(), y ) );
+		const T *srcPtr = srcSurface.getData( Vec2i( area.getX1(), y ) );
 		for( int32_t x = area.getX1(); x < area.getX2(); ++x ) {
-			uint32_t sum = srcPtr[srcRedOffset] * redWeight + srcPtr[srcGreenOffset] * greenWeight + srcPtr[srcBlueOffset] * blueWeight;
-			*dstPtr = static_cast<uint8_t>( sum >> 8 );
+			*dstPtr = grayscaleToChannel( srcPtr[srcRedOffset], srcPtr[srcGreenOffset], srcPtr[srcBlueOffset] );
 			dstPtr += dstPixelInc;
 			srcPtr += srcPixelInc;
 		}
 	}
 }
 
+template<typename T>
+struct GrayscaleChannelRowsFn {
+	GrayscaleChannelRowsFn( const SurfaceT<T> &srcSurface, ChannelT<T> *dstChannel, const Area &area )
+		: mSrcSurface( srcSurface ), mDstChannel( dstChannel ), mArea( area )
+	{}
+
+	void operator()( int32_t y1, int32_t y2 ) const
+	{
+		LayoutOp op( *this, y1, y2 );
+		if( ! dispatchPixelLayout( mSrcSurface.getChannelOrder(), op ) )
+			grayscaleToChannelRowsGeneric( mSrcSurface, mDstChannel, mArea, y1, y2 );
+	}
+
+	struct LayoutOp {
+		LayoutOp( const GrayscaleChannelRowsFn &fn, int32_t y1, int32_t y2 ) : mFn( fn ), mY1( y1 ), mY2( y2 ) {}
+		template<typename LAYOUT>
+		void process() { grayscaleToChannelRows<T,LAYOUT>( mFn.mSrcSurface, mFn.mDstChannel, mFn.mArea, mY1, mY2 ); }
+
+		const GrayscaleChannelRowsFn	&mFn;
+		int32_t							mY1, mY2;
+	};
+
+	const SurfaceT<T>	&mSrcSurface;
+	ChannelT<T>			*mDstChannel;
+	Area				mArea;
+};
+
+template<typename T>
+void grayscale( const SurfaceT<T> &srcSurface, ChannelT<T> *dstChannel, int32_t numThreads )
+{
+	Area area = srcSurface.getBounds().getClipBy( dstChannel->getBounds() );
+
+	parallelRows( 0, area.getHeight(), numThreads, GrayscaleChannelRowsFn<T>( srcSurface, dstChannel, area ), 64 );
+}
+
 #define grayscale_PROTOTYPES(r,data,T)\
-	template void grayscale( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface );
-	
-template void grayscale( const SurfaceT<float> &srcSurface, ChannelT<float> *dstChannel );
+	template void grayscale( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface, int32_t numThreads ); \
+	template void grayscale( const SurfaceT<T> &srcSurface, ChannelT<T> *dstChannel, int32_t numThreads );
 
 BOOST_PP_SEQ_FOR_EACH( grayscale_PROTOTYPES, ~, CHANNEL_TYPES )
 
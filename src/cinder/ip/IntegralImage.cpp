@@ -0,0 +1,317 @@
+/*
+ Copyright (c) 2010, The Barbarian Group
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "cinder/ip/IntegralImage.h"
+#include "cinder/ip/Parallel.h"
+
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cassert>
+
+using namespace std;
+
+namespace cinder { namespace ip {
+
+template<typename T, typename SUMT>
+IntegralImageT<T,SUMT>::Obj::Obj( int32_t width, int32_t height, bool squaredSums )
+	: mWidth( width ), mHeight( height ), mStride( width + 1 ), mSquaredSums( 0 )
+{
+	const size_t numEntries = ( width + 1 ) * (size_t)( height + 1 );
+	mSums = new SUMT[numEntries];
+	// the first row and column are the (always zero) sums of empty rectangles
+	std::fill( mSums, mSums + mStride, SUMT( 0 ) );
+	if( squaredSums ) {
+		mSquaredSums = new SUMT[numEntries];
+		std::fill( mSquaredSums, mSquaredSums + mStride, SUMT( 0 ) );
+	}
+}
+
+template<typename T, typename SUMT>
+IntegralImageT<T,SUMT>::Obj::~Obj()
+{
+	delete [] mSums;
+	delete [] mSquaredSums;
+}
+
+namespace {
+
+// First pass: the running sum along each row, which is independent per row
+template<typename T, typename SUMT>
+struct IntegralRowSumsFn {
+	IntegralRowSumsFn( const ChannelT<T> &channel, SUMT *sums, SUMT *squaredSums, int32_t stride )
+		: mChannel( channel ), mSums( sums ), mSquaredSums( squaredSums ), mStride( stride )
+	{}
+
+	void operator()( int32_t y1, int32_t y2 ) const
+	{
+		const int32_t width = mChannel.getWidth();
+		const int8_t inc = mChannel.getIncrement();
+		for( int32_t y = y1; y < y2; ++y ) {
+			const T *src = mChannel.getData( 0, y );
+			SUMT *sumRow = mSums + ( y + 1 ) * mStride;
+			SUMT sum = 0;
+			sumRow[0] = 0;
+			if( mSquaredSums ) {
+				SUMT *squaredRow = mSquaredSums + ( y + 1 ) * mStride;
+				SUMT squaredSum = 0;
+				squaredRow[0] = 0;
+				for( int32_t x = 0; x < width; ++x, src += inc ) {
+					const SUMT v = static_cast<SUMT>( *src );
+					sum += v;
+					squaredSum += v * v;
+					sumRow[x + 1] = sum;
+					squaredRow[x + 1] = squaredSum;
+				}
+			}
+			else {
+				for( int32_t x = 0; x < width; ++x, src += inc ) {
+					sum += static_cast<SUMT>( *src );
+					sumRow[x + 1] = sum;
+				}
+			}
+		}
+	}
+
+	const ChannelT<T>	&mChannel;
+	SUMT				*mSums, *mSquaredSums;
+	int32_t				mStride;
+};
+
+// Second pass: accumulates the row sums down each column. Each call handles a band of columns across every row
+template<typename SUMT>
+struct IntegralColumnSumsFn {
+	IntegralColumnSumsFn( SUMT *table, int32_t height, int32_t stride )
+		: mTable( table ), mHeight( height ), mStride( stride )
+	{}
+
+	void operator()( int32_t x1, int32_t x2 ) const
+	{
+		for( int32_t y = 2; y <= mHeight; ++y ) {
+			const SUMT *above = mTable + ( y - 1 ) * mStride;
+			SUMT *row = mTable + y * mStride;
+			for( int32_t x = x1; x < x2; ++x )
+				row[x] += above[x];
+		}
+	}
+
+	SUMT		*mTable;
+	int32_t		mHeight, mStride;
+};
+
+} // anonymous namespace
+
+template<typename T, typename SUMT>
+IntegralImageT<T,SUMT>::IntegralImageT( const ChannelT<T> &channel, bool squaredSums, int32_t numThreads )
+	: mObj( new Obj( channel.getWidth(), channel.getHeight(), squaredSums ) )
+{
+	update( channel, numThreads );
+}
+
+template<typename T, typename SUMT>
+void IntegralImageT<T,SUMT>::update( const ChannelT<T> &channel, int32_t numThreads )
+{
+	if( ( ! mObj ) || ( channel.getWidth() != mObj->mWidth ) || ( channel.getHeight() != mObj->mHeight ) )
+		mObj = std::shared_ptr<Obj>( new Obj( channel.getWidth(), channel.getHeight(), mObj && mObj->mSquaredSums ) );
+
+	parallelRows( 0, mObj->mHeight, numThreads, IntegralRowSumsFn<T,SUMT>( channel, mObj->mSums, mObj->mSquaredSums, mObj->mStride ), 64 );
+	// column 0 is always zero, so only columns [1, stride) need accumulating
+	parallelRows( 1, mObj->mStride, numThreads, IntegralColumnSumsFn<SUMT>( mObj->mSums, mObj->mHeight, mObj->mStride ), 256 );
+	if( mObj->mSquaredSums )
+		parallelRows( 1, mObj->mStride, numThreads, IntegralColumnSumsFn<SUMT>( mObj->mSquaredSums, mObj->mHeight, mObj->mStride ), 256 );
+}
+
+namespace {
+
+// Clips the window of \a radius around \a center to [0, size)
+inline void windowExtent( int32_t center, int32_t radius, int32_t size, int32_t *begin, int32_t *end )
+{
+	*begin = std::max<int32_t>( 0, center - radius );
+	*end = std::min<int32_t>( size, center + radius + 1 );
+}
+
+template<typename T, typename SUMT>
+inline T boxAverage( SUMT sum, int32_t count )
+{
+	return static_cast<T>( static_cast<double>( sum ) / count + ( std::numeric_limits<T>::is_integer ? 0.5 : 0.0 ) );
+}
+
+// Calls OP::process( x, y, sum, squaredSum, count ) for each pixel of a band of rows, with the sums taken over that pixel's clipped window
+template<typename T, typename SUMT, typename OP>
+struct WindowRowsFn {
+	WindowRowsFn( const IntegralImageT<T,SUMT> &integralImage, int32_t radius, int32_t width, const OP &op )
+		: mIntegralImage( integralImage ), mRadius( radius ), mWidth( width ), mOp( op )
+	{}
+
+	void operator()( int32_t y1, int32_t y2 ) const
+	{
+		const int32_t imageWidth = mIntegralImage.getWidth(), imageHeight = mIntegralImage.getHeight();
+		OP op( mOp );
+		for( int32_t y = y1; y < y2; ++y ) {
+			int32_t wy1, wy2;
+			windowExtent( y, mRadius, imageHeight, &wy1, &wy2 );
+			op.beginRow( y );
+			for( int32_t x = 0; x < mWidth; ++x ) {
+				int32_t wx1, wx2;
+				windowExtent( x, mRadius, imageWidth, &wx1, &wx2 );
+				const int32_t count = ( wx2 - wx1 ) * ( wy2 - wy1 );
+				op.process( x, mIntegralImage, wx1, wy1, wx2, wy2, count );
+			}
+		}
+	}
+
+	const IntegralImageT<T,SUMT>	&mIntegralImage;
+	int32_t							mRadius, mWidth;
+	OP								mOp;
+};
+
+template<typename T, typename SUMT, typename OP>
+void processWindows( const IntegralImageT<T,SUMT> &integralImage, int32_t radius, const Vec2i &dstSize, const OP &op, int32_t numThreads )
+{
+	const int32_t width = std::min( dstSize.x, integralImage.getWidth() );
+	const int32_t height = std::min( dstSize.y, integralImage.getHeight() );
+	parallelRows( 0, height, numThreads, WindowRowsFn<T,SUMT,OP>( integralImage, std::max<int32_t>( 0, radius ), width, op ), 32 );
+}
+
+template<typename T, typename SUMT>
+struct BoxBlurOp {
+	BoxBlurOp( ChannelT<T> *dstChannel ) : mDstChannel( dstChannel ), mDst( 0 ) {}
+
+	void beginRow( int32_t y ) { mDst = mDstChannel->getData( 0, y ); }
+	void process( int32_t x, const IntegralImageT<T,SUMT> &ii, int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t count )
+	{
+		mDst[x * mDstChannel->getIncrement()] = boxAverage<T>( ii.getSum( x1, y1, x2, y2 ), count );
+	}
+
+	ChannelT<T>		*mDstChannel;
+	T				*mDst;
+};
+
+template<typename T, typename SUMT>
+struct LocalMeanOp {
+	LocalMeanOp( Channel32f *dstChannel ) : mDstChannel( dstChannel ), mDst( 0 ) {}
+
+	void beginRow( int32_t y ) { mDst = mDstChannel->getData( 0, y ); }
+	void process( int32_t x, const IntegralImageT<T,SUMT> &ii, int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t count )
+	{
+		mDst[x * mDstChannel->getIncrement()] = static_cast<float>( static_cast<double>( ii.getSum( x1, y1, x2, y2 ) ) / count );
+	}
+
+	Channel32f		*mDstChannel;
+	float			*mDst;
+};
+
+// Returns the variance of a window from its sum and sum of squares, clamping the small negative results rounding can produce
+template<typename T, typename SUMT>
+inline double windowVariance( const IntegralImageT<T,SUMT> &ii, int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t count, double *mean )
+{
+	*mean = static_cast<double>( ii.getSum( x1, y1, x2, y2 ) ) / count;
+	const double variance = static_cast<double>( ii.getSquaredSum( x1, y1, x2, y2 ) ) / count - *mean * *mean;
+	return std::max( 0.0, variance );
+}
+
+template<typename T, typename SUMT>
+struct LocalVarianceOp {
+	LocalVarianceOp( Channel32f *dstChannel ) : mDstChannel( dstChannel ), mDst( 0 ) {}
+
+	void beginRow( int32_t y ) { mDst = mDstChannel->getData( 0, y ); }
+	void process( int32_t x, const IntegralImageT<T,SUMT> &ii, int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t count )
+	{
+		double mean;
+		mDst[x * mDstChannel->getIncrement()] = static_cast<float>( windowVariance( ii, x1, y1, x2, y2, count, &mean ) );
+	}
+
+	Channel32f		*mDstChannel;
+	float			*mDst;
+};
+
+template<typename T, typename SUMT>
+struct LocalContrastOp {
+	LocalContrastOp( const ChannelT<T> &srcChannel, float minStdDev, Channel32f *dstChannel )
+		: mSrcChannel( srcChannel ), mMinStdDev( minStdDev ), mDstChannel( dstChannel ), mSrc( 0 ), mDst( 0 )
+	{}
+
+	void beginRow( int32_t y ) { mSrc = mSrcChannel.getData( 0, y ); mDst = mDstChannel->getData( 0, y ); }
+	void process( int32_t x, const IntegralImageT<T,SUMT> &ii, int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t count )
+	{
+		double mean;
+		const double stdDev = std::max<double>( mMinStdDev, sqrt( windowVariance( ii, x1, y1, x2, y2, count, &mean ) ) );
+		mDst[x * mDstChannel->getIncrement()] = static_cast<float>( ( mSrc[x * mSrcChannel.getIncrement()] - mean ) / stdDev );
+	}
+
+	const ChannelT<T>	&mSrcChannel;
+	float				mMinStdDev;
+	Channel32f			*mDstChannel;
+	const T				*mSrc;
+	float				*mDst;
+};
+
+} // anonymous namespace
+
+template<typename T, typename SUMT>
+void boxBlur( const IntegralImageT<T,SUMT> &integralImage, int32_t radius, ChannelT<T> *dstChannel, int32_t numThreads )
+{
+	processWindows( integralImage, radius, dstChannel->getSize(), BoxBlurOp<T,SUMT>( dstChannel ), numThreads );
+}
+
+template<typename T>
+void boxBlur( const ChannelT<T> &srcChannel, int32_t radius, ChannelT<T> *dstChannel, int32_t numThreads )
+{
+	boxBlur( IntegralImageT<T>( srcChannel, false, numThreads ), radius, dstChannel, numThreads );
+}
+
+template<typename T, typename SUMT>
+void localMean( const IntegralImageT<T,SUMT> &integralImage, int32_t radius, Channel32f *dstChannel, int32_t numThreads )
+{
+	processWindows( integralImage, radius, dstChannel->getSize(), LocalMeanOp<T,SUMT>( dstChannel ), numThreads );
+}
+
+template<typename T, typename SUMT>
+void localVariance( const IntegralImageT<T,SUMT> &integralImage, int32_t radius, Channel32f *dstChannel, int32_t numThreads )
+{
+	assert( integralImage.hasSquaredSums() );
+	processWindows( integralImage, radius, dstChannel->getSize(), LocalVarianceOp<T,SUMT>( dstChannel ), numThreads );
+}
+
+template<typename T, typename SUMT>
+void localContrast( const ChannelT<T> &srcChannel, const IntegralImageT<T,SUMT> &integralImage, int32_t radius, float minStdDev, Channel32f *dstChannel, int32_t numThreads )
+{
+	assert( integralImage.hasSquaredSums() );
+	assert( srcChannel.getSize() == integralImage.getSize() );
+	processWindows( integralImage, radius, dstChannel->getSize(), LocalContrastOp<T,SUMT>( srcChannel, minStdDev, dstChannel ), numThreads );
+}
+
+#define integralImage_PROTOTYPES(r,data,TS)\
+	template class IntegralImageT<BOOST_PP_TUPLE_ELEM(2,0,TS),BOOST_PP_TUPLE_ELEM(2,1,TS)>; \
+	template void boxBlur( const IntegralImageT<BOOST_PP_TUPLE_ELEM(2,0,TS),BOOST_PP_TUPLE_ELEM(2,1,TS)> &integralImage, int32_t radius, ChannelT<BOOST_PP_TUPLE_ELEM(2,0,TS)> *dstChannel, int32_t numThreads ); \
+	template void localMean( const IntegralImageT<BOOST_PP_TUPLE_ELEM(2,0,TS),BOOST_PP_TUPLE_ELEM(2,1,TS)> &integralImage, int32_t radius, Channel32f *dstChannel, int32_t numThreads ); \
+	template void localVariance( const IntegralImageT<BOOST_PP_TUPLE_ELEM(2,0,TS),BOOST_PP_TUPLE_ELEM(2,1,TS)> &integralImage, int32_t radius, Channel32f *dstChannel, int32_t numThreads ); \
+	template void localContrast( const ChannelT<BOOST_PP_TUPLE_ELEM(2,0,TS)> &srcChannel, const IntegralImageT<BOOST_PP_TUPLE_ELEM(2,0,TS),BOOST_PP_TUPLE_ELEM(2,1,TS)> &integralImage, int32_t radius, float minStdDev, Channel32f *dstChannel, int32_t numThreads );
+
+BOOST_PP_SEQ_FOR_EACH( integralImage_PROTOTYPES, ~, ((uint8_t,uint32_t))((uint8_t,uint64_t))((uint8_t,double))((float,float))((float,double)) )
+
+#define boxBlur_PROTOTYPES(r,data,T)\
+	template void boxBlur( const ChannelT<T> &srcChannel, int32_t radius, ChannelT<T> *dstChannel, int32_t numThreads );
+
+BOOST_PP_SEQ_FOR_EACH( boxBlur_PROTOTYPES, ~, CHANNEL_TYPES )
+
+} } // namespace cinder::ip
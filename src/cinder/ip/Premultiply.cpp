@@ -20,29 +20,88 @@
  POSSIBILITY OF SUCH DAMAGE.
 */
 
+
 #include "cinder/ip/Premultiply.h"
+#include "cinder/ip/PixelLayout.h"
+#include "cinder/ip/Parallel.h"
 #include "cinder/ChanTraits.h"
+#include "cinder/System.h"
+
+#if defined( CINDER_SSE2 )
+	#include <emmintrin.h>
+#endif
 
 namespace cinder { namespace ip {
 
-// this is a candidate for sse2
-template<typename T>
-void premultiply( SurfaceT<T> *surface )
+// Premultiplies as many leading pixels of \a row as the SIMD kernel handles and returns how many it did
+template<typename LAYOUT>
+int32_t premultiplyRowSimd( float * /*row*/, int32_t /*width*/ )
 {
-	const Area clippedArea = surface->getBounds();
+	return 0;
+}
 
-	if( ! surface->hasAlpha() )
-		return;
+#if defined( CINDER_SSE2 )
+template<typename LAYOUT>
+int32_t premultiplyRowSimd( uint8_t *row, int32_t width )
+{
+	static const bool useSse2 = System::hasSse2();
+	if( ! useSse2 )
+		return 0;
 
-	surface->setPremultiplied( true );
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi16( 1 );
+	const __m128i alphaMask = _mm_set_epi16( ( LAYOUT::A == 3 ) ? -1 : 0, ( LAYOUT::A == 2 ) ? -1 : 0, ( LAYOUT::A == 1 ) ? -1 : 0, ( LAYOUT::A == 0 ) ? -1 : 0,
+											( LAYOUT::A == 3 ) ? -1 : 0, ( LAYOUT::A == 2 ) ? -1 : 0, ( LAYOUT::A == 1 ) ? -1 : 0, ( LAYOUT::A == 0 ) ? -1 : 0 );
+	int32_t x = 0;
+	for( ; x + 4 <= width; x += 4 ) {
+		__m128i px = _mm_loadu_si128( reinterpret_cast<const __m128i*>( row + x * 4 ) );
+		__m128i halves[2] = { _mm_unpacklo_epi8( px, zero ), _mm_unpackhi_epi8( px, zero ) };
+		for( int h = 0; h < 2; ++h ) {
+			__m128i alpha = _mm_shufflehi_epi16( _mm_shufflelo_epi16( halves[h], _MM_SHUFFLE( LAYOUT::A, LAYOUT::A, LAYOUT::A, LAYOUT::A ) ), _MM_SHUFFLE( LAYOUT::A, LAYOUT::A, LAYOUT::A, LAYOUT::A ) );
+			__m128i prod = _mm_mullo_epi16( halves[h], alpha );
+			// exact a * c / 255 for a * c <= 65025: ( x + 1 + ( x >> 8 ) ) >> 8
+			prod = _mm_srli_epi16( _mm_add_epi16( _mm_add_epi16( prod, one ), _mm_srli_epi16( prod, 8 ) ), 8 );
+			halves[h] = _mm_or_si128( _mm_and_si128( alphaMask, halves[h] ), _mm_andnot_si128( alphaMask, prod ) );
+		}
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( row + x * 4 ), _mm_packus_epi16( halves[0], halves[1] ) );
+	}
+	return x;
+}
+#else
+template<typename LAYOUT>
+int32_t premultiplyRowSimd( uint8_t * /*row*/, int32_t /*width*/ )
+{
+	return 0;
+}
+#endif
+
+template<typename T, typename LAYOUT>
+void premultiplyRows( SurfaceT<T> *surface, int32_t y1, int32_t y2 )
+{
+	const int32_t width = surface->getWidth();
+	for( int32_t y = y1; y < y2; ++y ) {
+		T *dstPtr = surface->getData( Vec2i( 0, y ) );
+		int32_t x = premultiplyRowSimd<LAYOUT>( dstPtr, width );
+		dstPtr += x * LAYOUT::INC;
+		for( ; x < width; ++x ) {
+			T alpha = dstPtr[LAYOUT::A];
+			dstPtr[LAYOUT::R] = CHANTRAIT<T>::premultiply( dstPtr[LAYOUT::R], alpha );
+			dstPtr[LAYOUT::G] = CHANTRAIT<T>::premultiply( dstPtr[LAYOUT::G], alpha );
+			dstPtr[LAYOUT::B] = CHANTRAIT<T>::premultiply( dstPtr[LAYOUT::B], alpha );
+			dstPtr += LAYOUT::INC;
+		}
+	}
+}
 
+template<typename T>
+void premultiplyRowsGeneric( SurfaceT<T> *surface, int32_t y1, int32_t y2 )
+{
 	int32_t rowBytes = surface->getRowBytes();
 	uint8_t pixelInc = surface->getPixelInc();
 	uint8_t redOffset = surface->getRedOffset(), greenOffset = surface->getGreenOffset(), blueOffset = surface->getBlueOffset(), alphaOffset = surface->getAlphaOffset();
-	for( int32_t y = clippedArea.getY1(); y < clippedArea.getY2(); ++y ) {
-		T *dstPtr = reinterpret_cast<T*>( reinterpret_cast<uint8_t*>( surface->getData() + clippedArea.getX1() * pixelInc ) + y * rowBytes );
-		for( int32_t x = 0; x < clippedArea.getWidth(); ++x ) {
-			// The basic formula for unpremultiplication is to divide by the alpha
+	for( int32_t y = y1; y < y2; ++y ) {
+		T *dstPtr = reinterpret_cast<T*>( reinterpret_cast<uint8_t*>( surface->getData() ) + y * rowBytes );
+		for( int32_t x = 0; x < surface->getWidth(); ++x ) {
 			T alpha = dstPtr[alphaOffset];
 			
 			dstPtr[redOffset] = CHANTRAIT<T>::premultiply( dstPtr[redOffset], alpha );
@@ -53,23 +112,64 @@ void premultiply( SurfaceT<T> *surface )
 	}
 }
 
-// this is a candidate for sse2
-template<>
-void unpremultiply<uint8_t>( SurfaceT<uint8_t> *surface )
+// 8-bit unpremultiplication is a lookup of c * 255 / a, truncated to 8 bits, in a table indexed by [alpha][c]
+struct UnpremultiplyTable {
+	UnpremultiplyTable()
+	{
+		for( int32_t c = 0; c < 256; ++c )
+			mValues[0][c] = static_cast<uint8_t>( c );
+		for( int32_t a = 1; a < 256; ++a )
+			for( int32_t c = 0; c < 256; ++c )
+				mValues[a][c] = static_cast<uint8_t>( c * 255 / a );
+	}
+
+	uint8_t		mValues[256][256];
+};
+
+static const UnpremultiplyTable sUnpremultiplyTable;
+
+template<typename LAYOUT>
+void unpremultiplyRow( uint8_t *dstPtr, int32_t width )
 {
-	const Area clippedArea = surface->getBounds();
+	for( int32_t x = 0; x < width; ++x ) {
+		const uint8_t *table = sUnpremultiplyTable.mValues[dstPtr[LAYOUT::A]];
+		dstPtr[LAYOUT::R] = table[dstPtr[LAYOUT::R]];
+		dstPtr[LAYOUT::G] = table[dstPtr[LAYOUT::G]];
+		dstPtr[LAYOUT::B] = table[dstPtr[LAYOUT::B]];
+		dstPtr += LAYOUT::INC;
+	}
+}
 
-	if( ! surface->hasAlpha() )
-		return;
+template<typename LAYOUT>
+void unpremultiplyRow( float *dstPtr, int32_t width )
+{
+	for( int32_t x = 0; x < width; ++x ) {
+		// The basic formula for unpremultiplication is to divide by the alpha
+		if( dstPtr[LAYOUT::A] != 0 ) {
+			float invAlpha = 1.0f / dstPtr[LAYOUT::A];
+			dstPtr[LAYOUT::R] *= invAlpha;
+			dstPtr[LAYOUT::G] *= invAlpha;
+			dstPtr[LAYOUT::B] *= invAlpha;
+		}
+		dstPtr += LAYOUT::INC;
+	}
+}
 
-	surface->setPremultiplied( false );
+template<typename T, typename LAYOUT>
+void unpremultiplyRows( SurfaceT<T> *surface, int32_t y1, int32_t y2 )
+{
+	for( int32_t y = y1; y < y2; ++y )
+		unpremultiplyRow<LAYOUT>( surface->getData( Vec2i( 0, y ) ), surface->getWidth() );
+}
 
+void unpremultiplyRowsGeneric( SurfaceT<uint8_t> *surface, int32_t y1, int32_t y2 )
+{
 	int32_t rowBytes = surface->getRowBytes();
 	uint8_t pixelInc = surface->getPixelInc();
 	uint8_t redOffset = surface->getRedOffset(), greenOffset = surface->getGreenOffset(), blueOffset = surface->getBlueOffset(), alphaOffset = surface->getAlphaOffset();
-	for( int32_t y = clippedArea.getY1(); y < clippedArea.getY2(); ++y ) {
-		uint8_t *dstPtr = reinterpret_cast<uint8_t*>( surface->getData() + clippedArea.getX1() * pixelInc ) + y * rowBytes;
-		for( int32_t x = 0; x < clippedArea.getWidth(); ++x ) {
+	for( int32_t y = y1; y < y2; ++y ) {
+		uint8_t *dstPtr = reinterpret_cast<uint8_t*>( surface->getData() ) + y * rowBytes;
+		for( int32_t x = 0; x < surface->getWidth(); ++x ) {
 			// The basic formula for unpremultiplication is to divide by the alpha
 			// which in 8bit pixel arithmetic is to multiply by 255 and divide by the alpha
 			uint8_t alpha = dstPtr[alphaOffset];
@@ -83,22 +183,14 @@ void unpremultiply<uint8_t>( SurfaceT<uint8_t> *surface )
 	}	
 }
 
-template<>
-void unpremultiply<float>( SurfaceT<float> *surface )
+void unpremultiplyRowsGeneric( SurfaceT<float> *surface, int32_t y1, int32_t y2 )
 {
-	const Area clippedArea = surface->getBounds();
-
-	if( ! surface->hasAlpha() )
-		return;
-
-	surface->setPremultiplied( false );
-
 	int32_t rowBytes = surface->getRowBytes();
 	uint8_t pixelInc = surface->getPixelInc();
 	uint8_t redOffset = surface->getRedOffset(), greenOffset = surface->getGreenOffset(), blueOffset = surface->getBlueOffset(), alphaOffset = surface->getAlphaOffset();
-	for( int32_t y = clippedArea.getY1(); y < clippedArea.getY2(); ++y ) {
-		float *dstPtr = reinterpret_cast<float*>( reinterpret_cast<uint8_t*>( surface->getData() + clippedArea.getX1() * pixelInc ) + y * rowBytes );
-		for( int32_t x = 0; x < clippedArea.getWidth(); ++x ) {
+	for( int32_t y = y1; y < y2; ++y ) {
+		float *dstPtr = reinterpret_cast<float*>( reinterpret_cast<uint8_t*>( surface->getData() ) + y * rowBytes );
+		for( int32_t x = 0; x < surface->getWidth(); ++x ) {
 			// The basic formula for unpremultiplication is to divide by the alpha
 			if( dstPtr[alphaOffset] != 0 ) {
 				float invAlpha = 1.0f / dstPtr[alphaOffset];
@@ -111,10 +203,66 @@ void unpremultiply<float>( SurfaceT<float> *surface )
 	}	
 }
 
+// Dispatches a band of rows to the PixelLayout-specialized loop, or the runtime-offset loop for other channel orders
+template<typename T, bool PREMULTIPLY>
+struct PremultiplyRowsFn {
+	PremultiplyRowsFn( SurfaceT<T> *surface ) : mSurface( surface ) {}
+
+	void operator()( int32_t y1, int32_t y2 ) const
+	{
+		LayoutOp op( mSurface, y1, y2 );
+		if( ! dispatchPixelLayoutAlpha( mSurface->getChannelOrder(), op ) ) {
+			if( PREMULTIPLY )
+				premultiplyRowsGeneric( mSurface, y1, y2 );
+			else
+				unpremultiplyRowsGeneric( mSurface, y1, y2 );
+		}
+	}
+
+	struct LayoutOp {
+		LayoutOp( SurfaceT<T> *surface, int32_t y1, int32_t y2 ) : mSurface( surface ), mY1( y1 ), mY2( y2 ) {}
+
+		template<typename LAYOUT>
+		void process()
+		{
+			if( PREMULTIPLY )
+				premultiplyRows<T,LAYOUT>( mSurface, mY1, mY2 );
+			else
+				unpremultiplyRows<T,LAYOUT>( mSurface, mY1, mY2 );
+		}
+
+		SurfaceT<T>		*mSurface;
+		int32_t			mY1, mY2;
+	};
+
+	SurfaceT<T>		*mSurface;
+};
+
+template<typename T>
+void premultiply( SurfaceT<T> *surface, int32_t numThreads )
+{
+	if( ! surface->hasAlpha() )
+		return;
+
+	surface->setPremultiplied( true );
+
+	parallelRows( 0, surface->getHeight(), numThreads, PremultiplyRowsFn<T,true>( surface ), 64 );
+}
+
+template<typename T>
+void unpremultiply( SurfaceT<T> *surface, int32_t numThreads )
+{
+	if( ! surface->hasAlpha() )
+		return;
+
+	surface->setPremultiplied( false );
 
+	parallelRows( 0, surface->getHeight(), numThreads, PremultiplyRowsFn<T,false>( surface ), 64 );
+}
 
 #define premult_PROTOTYPES(r,data,T)\
-	template void premultiply( SurfaceT<T> *Surface );
+	template void premultiply( SurfaceT<T> *Surface, int32_t numThreads ); \
+	template void unpremultiply( SurfaceT<T> *Surface, int32_t numThreads );
 
 BOOST_PP_SEQ_FOR_EACH( premult_PROTOTYPES, ~, CHANNEL_TYPES )
 	
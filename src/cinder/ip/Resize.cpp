@@ -25,6 +25,14 @@
 #include "cinder/Filter.h"
 #include "cinder/Rect.h"
 #include "cinder/ChanTraits.h"
+#include "cinder/Thread.h"
+#include "cinder/System.h"
+
+#include <boost/noncopyable.hpp>
+
+#if defined( CINDER_SSE2 )
+	#include <emmintrin.h>
+#endif
 
 #include <math.h>
 #include <vector>
@@ -91,7 +99,7 @@ class WeightTable {		/* SAMPLED FILTER WEIGHT TABLE */
 };
 
 template<typename LT, typename AT>
-void scanlineAccumulate( LT weight, LT *lineBuffer, int32_t lineBufferWidth, AT *accum );
+void scanlineAccumulate( LT weight, const LT *lineBuffer, int32_t lineBufferWidth, AT *accum );
 template<typename T, typename WT>
 void makeWeightTable( int32_t b, float cen, const FilterBase &filter, const FilterParams *params, int32_t len, bool trimzeros, WeightTable<WT> *wtab );
 
@@ -112,11 +120,11 @@ void scanlineShiftAccumToChannel( AT *accum, int32_t x1, int32_t y, int32_t widt
 }
 
 template<typename T, typename WT, typename AT>
-void scanlineFilterChannelToBuffer( WeightTable<WT> *weights, int32_t x, int32_t y, const ChannelT<T> &channel, AT *lineBuffer, int32_t width )
+void scanlineFilterChannelToBuffer( const WeightTable<WT> *weights, int32_t x, int32_t y, const ChannelT<T> &channel, AT *lineBuffer, int32_t width )
 {
 	int32_t b, af;
 	AT sum;
-	AT *wp;
+	const AT *wp;
 	const T *srcLine, *src;
 
 	srcLine = channel.getData( x, y );
@@ -138,86 +146,411 @@ void scanlineFilterChannelToBuffer( WeightTable<WT> *weights, int32_t x, int32_t
 	}	
 }
 
-// assumes channels are of same dimensions
+// Filters one scanline of four interleaved channels in a single pass. \a lineBuffer receives 4 * \a width values
+template<typename T, typename WT, typename AT>
+void scanlineFilterRgbaToBuffer( const WeightTable<WT> *weights, const T *srcLine, AT *lineBuffer, int32_t width )
+{
+	AT sum[4];
+	const AT *wp;
+	const T *src;
+
+	for( int32_t b = 0; b < width; b++ ) {
+		for( int c = 0; c < 4; ++c )
+			sum[c] = ( std::numeric_limits<AT>::is_integer ) ? ( 1 << 7 ) : 0;
+		src = srcLine + weights->start * 4;
+		wp = weights->weight;
+		for( int32_t af = weights->start; af < weights->end; af++, src += 4 ) {
+			sum[0] += *wp * src[0];
+			sum[1] += *wp * src[1];
+			sum[2] += *wp * src[2];
+			sum[3] += *wp * src[3];
+			wp++;
+		}
+		for( int c = 0; c < 4; ++c )
+			*lineBuffer++ = SCALETRAIT<T>::CHANNELTOBUFFER( sum[c] );
+		weights++;
+	}
+}
+
+template<typename AT, typename T>
+void scanlineShiftAccumToRgba( const AT *accum, T *dst, int32_t width )
+{
+	for( int32_t i = 0; i < width * 4; i++ )
+		dst[i] = static_cast<T>( SCALETRAIT<T>::ACCUMTOCHANNEL( accum[i] ) );
+}
+
+#if defined( CINDER_SSE2 )
+// The SSE2 kernels perform the same operations in the same order per channel as the scalar versions, so the results are identical
+
+// Requires every weight to fit in 16 bits; pairs of taps are multiplied and summed by a single _mm_madd_epi16
+void scanlineFilterRgbaToBufferSse2( const WeightTable<int32_t> *weights, const uint8_t *srcLine, int32_t *lineBuffer, int32_t width )
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi32( 1 << 7 );
+
+	for( int32_t b = 0; b < width; b++, weights++, lineBuffer += 4 ) {
+		const uint8_t *src = srcLine + weights->start * 4;
+		const int32_t *wp = weights->weight;
+		const int32_t taps = weights->end - weights->start;
+		__m128i sum = round;
+		int32_t t = 0;
+		for( ; t + 1 < taps; t += 2, src += 8 ) {
+			// two neighboring pixels as 16-bit [r0 r1 g0 g1 b0 b1 a0 a1] against [w0 w1 w0 w1 ...]
+			__m128i pix = _mm_unpacklo_epi8( _mm_loadl_epi64( reinterpret_cast<const __m128i*>( src ) ), zero );
+			pix = _mm_unpacklo_epi16( pix, _mm_srli_si128( pix, 8 ) );
+			__m128i w = _mm_set1_epi32( static_cast<int32_t>( ( static_cast<uint32_t>( wp[t+1] ) << 16 ) | ( static_cast<uint32_t>( wp[t] ) & 0xFFFF ) ) );
+			sum = _mm_add_epi32( sum, _mm_madd_epi16( pix, w ) );
+		}
+		if( t < taps ) {
+			__m128i pix = _mm_unpacklo_epi16( _mm_unpacklo_epi8( _mm_cvtsi32_si128( *reinterpret_cast<const int32_t*>( src ) ), zero ), zero );
+			sum = _mm_add_epi32( sum, _mm_madd_epi16( pix, _mm_set1_epi32( wp[t] & 0xFFFF ) ) );
+		}
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( lineBuffer ), _mm_srai_epi32( sum, 8 ) );
+	}
+}
+
+void scanlineFilterRgbaToBufferSse2( const WeightTable<float> *weights, const float *srcLine, float *lineBuffer, int32_t width )
+{
+	for( int32_t b = 0; b < width; b++, weights++, lineBuffer += 4 ) {
+		const float *src = srcLine + weights->start * 4;
+		const float *wp = weights->weight;
+		__m128 sum = _mm_setzero_ps();
+		for( int32_t af = weights->start; af < weights->end; af++, src += 4 )
+			sum = _mm_add_ps( sum, _mm_mul_ps( _mm_set1_ps( *wp++ ), _mm_loadu_ps( src ) ) );
+		_mm_storeu_ps( lineBuffer, sum );
+	}
+}
+
+// SSE2 has no 32-bit multiply-low; assemble it from the even and odd lanes of _mm_mul_epu32, whose low halves are sign-agnostic
+inline __m128i mulLo32Sse2( __m128i a, __m128i b )
+{
+	__m128i even = _mm_mul_epu32( a, b );
+	__m128i odd = _mm_mul_epu32( _mm_srli_si128( a, 4 ), _mm_srli_si128( b, 4 ) );
+	return _mm_unpacklo_epi32( _mm_shuffle_epi32( even, _MM_SHUFFLE( 0, 0, 2, 0 ) ), _mm_shuffle_epi32( odd, _MM_SHUFFLE( 0, 0, 2, 0 ) ) );
+}
+
+void scanlineAccumulateSse2( int32_t weight, const int32_t *lineBuffer, int32_t width, int32_t *accum )
+{
+	const __m128i w = _mm_set1_epi32( weight );
+	int32_t x = 0;
+	for( ; x + 4 <= width; x += 4 ) {
+		__m128i line = _mm_loadu_si128( reinterpret_cast<const __m128i*>( lineBuffer + x ) );
+		__m128i acc = _mm_loadu_si128( reinterpret_cast<const __m128i*>( accum + x ) );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( accum + x ), _mm_add_epi32( acc, mulLo32Sse2( line, w ) ) );
+	}
+	for( ; x < width; x++ )
+		accum[x] += lineBuffer[x] * weight;
+}
+
+void scanlineAccumulateSse2( float weight, const float *lineBuffer, int32_t width, float *accum )
+{
+	const __m128 w = _mm_set1_ps( weight );
+	int32_t x = 0;
+	for( ; x + 4 <= width; x += 4 )
+		_mm_storeu_ps( accum + x, _mm_add_ps( _mm_loadu_ps( accum + x ), _mm_mul_ps( _mm_loadu_ps( lineBuffer + x ), w ) ) );
+	for( ; x < width; x++ )
+		accum[x] += lineBuffer[x] * weight;
+}
+
+// _mm_packs_epi32 followed by _mm_packus_epi16 clamps to [0,255] exactly as ACCUMTOCHANNEL does
+void scanlineShiftAccumToRgbaSse2( const int32_t *accum, uint8_t *dst, int32_t width )
+{
+	const int32_t count = width * 4;
+	const __m128i half = _mm_set1_epi32( SCALETRAIT<uint8_t>::HALFFINALSHIFT );
+	int32_t i = 0;
+	for( ; i + 16 <= count; i += 16 ) {
+		__m128i a0 = _mm_srai_epi32( _mm_add_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>( accum + i ) ), half ), SCALETRAIT<uint8_t>::FINALSHIFT );
+		__m128i a1 = _mm_srai_epi32( _mm_add_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>( accum + i + 4 ) ), half ), SCALETRAIT<uint8_t>::FINALSHIFT );
+		__m128i a2 = _mm_srai_epi32( _mm_add_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>( accum + i + 8 ) ), half ), SCALETRAIT<uint8_t>::FINALSHIFT );
+		__m128i a3 = _mm_srai_epi32( _mm_add_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>( accum + i + 12 ) ), half ), SCALETRAIT<uint8_t>::FINALSHIFT );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( dst + i ), _mm_packus_epi16( _mm_packs_epi32( a0, a1 ), _mm_packs_epi32( a2, a3 ) ) );
+	}
+	for( ; i < count; i++ )
+		dst[i] = SCALETRAIT<uint8_t>::ACCUMTOCHANNEL( accum[i] );
+}
+
+void scanlineShiftAccumToRgbaSse2( const float *accum, float *dst, int32_t width )
+{
+	memcpy( dst, accum, width * 4 * sizeof(float) );
+}
+#endif // defined( CINDER_SSE2 )
+
+// Filter weights for a particular source and destination geometry. These are shared (read-only) by every band of a resample
 template<typename T>
-void resample( const vector<const ChannelT<T>*> &srcChannels, const FilterBase &filter, const Area &srcArea, const Area &dstArea, const vector<ChannelT<T>*> &dstChannels )
+struct ResampleWeights : private boost::noncopyable {
+	typedef typename SCALETRAIT<T>::SUMT SUMT;
+
+	ResampleWeights( const Area &srcBounds, const Area &srcArea, const Area &dstBounds, const Area &dstArea, const FilterBase &filter );
+
+	bool		isEmpty() const { return mEmpty; }
+
+	bool					mEmpty, mUseSse2;
+	Area					mClippedDstArea;
+	int32_t					mDstWidth, mDstHeight, mSrcWidth, mSrcHeight;
+	int32_t					mSrcOffsetX, mSrcOffsetY;
+	FilterParams			mFilterParamsX, mFilterParamsY;
+	vector<WeightTable<SUMT> >	mXWeights, mYWeights;
+	vector<SUMT>			mXWeightBuffer, mYWeightBuffer;
+};
+
+template<typename T>
+ResampleWeights<T>::ResampleWeights( const Area &srcBounds, const Area &srcArea, const Area &dstBounds, const Area &dstArea, const FilterBase &filter )
 {
 	Rectf clippedSrcRect;
-	Area clippedDstArea;
-	getClippedScaledRects( srcChannels[0]->getBounds(), Rectf( srcArea ), dstChannels[0]->getBounds(), dstArea, &clippedSrcRect, &clippedDstArea );
-	
-	if ( ( clippedSrcRect.getWidth() <= 0 ) || ( clippedDstArea.getWidth() <= 0 ) 
-		|| ( clippedSrcRect.getHeight() <= 0 ) || ( clippedDstArea.getHeight() <= 0 ) )
+	getClippedScaledRects( srcBounds, Rectf( srcArea ), dstBounds, dstArea, &clippedSrcRect, &mClippedDstArea );
+
+	mEmpty = ( clippedSrcRect.getWidth() <= 0 ) || ( mClippedDstArea.getWidth() <= 0 ) 
+		|| ( clippedSrcRect.getHeight() <= 0 ) || ( mClippedDstArea.getHeight() <= 0 );
+	if( mEmpty )
 		return;
 	
-	FilterParams filterParamsX, filterParamsY;
 	Mapping m;
-	std::shared_ptr<typename SCALETRAIT<T>::SUMT> accum;
-	int32_t dstWidth = (int32_t)clippedDstArea.getWidth(), dstHeight = (int32_t)clippedDstArea.getHeight();
-	int32_t srcWidth = (int32_t)clippedSrcRect.getWidth(), srcHeight = (int32_t)clippedSrcRect.getHeight();
-	int32_t srcOffsetX = static_cast<int32_t>( floor( clippedSrcRect.getX1() ) );
-	int32_t srcOffsetY = static_cast<int32_t>( floor( clippedSrcRect.getY1() ) );
-	vector<pair<int32_t,std::shared_ptr<typename SCALETRAIT<T>::SUMT> > > linesBuffer;
-
-	m.sx = dstWidth / (float)srcWidth;
-	m.sy = dstHeight / (float)srcHeight;
-	m.tx = clippedDstArea.getX1() - 0.5f - m.sx * ( clippedSrcRect.getX1() - 0.5f );
-	m.ty = clippedDstArea.getY1() - 0.5f - m.sy * ( clippedSrcRect.getY1() - 0.5f );
-	m.ux = clippedDstArea.getX1() - m.sx * ( clippedSrcRect.getX1()- 0.5f ) - m.tx;
-	m.uy = clippedDstArea.getY1() - m.sy * ( clippedSrcRect.getY1()- 0.5f ) - m.ty;
-
-	filterParamsX.scale = std::max( 1.0f, 1.0f / m.sx );
-	filterParamsX.supp = std::max( 0.5f, filterParamsX.scale * filter.getSupport() );
-	filterParamsX.width = (int32_t)ceil( 2.0f * filterParamsX.supp );
-
-	filterParamsY.scale = std::max( 1.0f, 1.0f / m.sy );
-	filterParamsY.supp = std::max( 0.5f, filterParamsY.scale * filter.getSupport() );
-	filterParamsY.width = (int32_t)ceil( 2.0f * filterParamsY.supp );
-
-	for( int32_t i = 0; i < filterParamsY.width; i++ )
-		linesBuffer.push_back( std::make_pair( -1, std::shared_ptr<typename SCALETRAIT<T>::SUMT>( new typename SCALETRAIT<T>::SUMT[dstWidth], checked_array_deleter<typename SCALETRAIT<T>::SUMT>() ) ) );
-
-	WeightTable<typename SCALETRAIT<T>::SUMT> *xWeights, yWeights;
-	typename SCALETRAIT<T>::SUMT *xWeightBuffer, *xWeightPtr;
-	xWeights = (WeightTable<typename SCALETRAIT<T>::SUMT>*)malloc( sizeof(WeightTable<int32_t>) * dstWidth );
-	xWeightBuffer = (typename SCALETRAIT<T>::SUMT*)malloc( sizeof(typename SCALETRAIT<T>::SUMT) * dstWidth * filterParamsX.width );
-	yWeights.weight = (typename SCALETRAIT<T>::SUMT*)malloc( sizeof(typename SCALETRAIT<T>::SUMT) * filterParamsY.width );
-	accum = std::shared_ptr<typename SCALETRAIT<T>::SUMT>( new typename SCALETRAIT<T>::SUMT[dstWidth], checked_array_deleter<typename SCALETRAIT<T>::SUMT>() );
-
-	xWeightPtr = xWeightBuffer;
-	for ( int32_t bx = 0; bx < dstWidth; bx++, xWeightPtr += filterParamsX.width ) {
-		xWeights[bx].weight = xWeightPtr;
-		makeWeightTable<T,typename SCALETRAIT<T>::SUMT>( bx, MAP(bx, m.sx, m.ux), filter, &filterParamsX, srcWidth, true, &xWeights[bx] );
+	mDstWidth = (int32_t)mClippedDstArea.getWidth(); mDstHeight = (int32_t)mClippedDstArea.getHeight();
+	mSrcWidth = (int32_t)clippedSrcRect.getWidth(); mSrcHeight = (int32_t)clippedSrcRect.getHeight();
+	mSrcOffsetX = static_cast<int32_t>( floor( clippedSrcRect.getX1() ) );
+	mSrcOffsetY = static_cast<int32_t>( floor( clippedSrcRect.getY1() ) );
+
+	m.sx = mDstWidth / (float)mSrcWidth;
+	m.sy = mDstHeight / (float)mSrcHeight;
+	m.tx = mClippedDstArea.getX1() - 0.5f - m.sx * ( clippedSrcRect.getX1() - 0.5f );
+	m.ty = mClippedDstArea.getY1() - 0.5f - m.sy * ( clippedSrcRect.getY1() - 0.5f );
+	m.ux = mClippedDstArea.getX1() - m.sx * ( clippedSrcRect.getX1()- 0.5f ) - m.tx;
+	m.uy = mClippedDstArea.getY1() - m.sy * ( clippedSrcRect.getY1()- 0.5f ) - m.ty;
+
+	mFilterParamsX.scale = std::max( 1.0f, 1.0f / m.sx );
+	mFilterParamsX.supp = std::max( 0.5f, mFilterParamsX.scale * filter.getSupport() );
+	mFilterParamsX.width = (int32_t)ceil( 2.0f * mFilterParamsX.supp );
+
+	mFilterParamsY.scale = std::max( 1.0f, 1.0f / m.sy );
+	mFilterParamsY.supp = std::max( 0.5f, mFilterParamsY.scale * filter.getSupport() );
+	mFilterParamsY.width = (int32_t)ceil( 2.0f * mFilterParamsY.supp );
+
+	mXWeights.resize( mDstWidth );
+	mXWeightBuffer.resize( mDstWidth * mFilterParamsX.width );
+	for( int32_t bx = 0; bx < mDstWidth; bx++ ) {
+		mXWeights[bx].weight = &mXWeightBuffer[bx * mFilterParamsX.width];
+		makeWeightTable<T,SUMT>( bx, MAP(bx, m.sx, m.ux), filter, &mFilterParamsX, mSrcWidth, true, &mXWeights[bx] );
+	}
+
+	// the y weight tables are computed up front rather than per scanline so that bands can be filtered independently
+	mYWeights.resize( mDstHeight );
+	mYWeightBuffer.resize( mDstHeight * mFilterParamsY.width );
+	for( int32_t by = 0; by < mDstHeight; by++ ) {
+		mYWeights[by].weight = &mYWeightBuffer[by * mFilterParamsY.width];
+		makeWeightTable<T,SUMT>( by, MAP(by, m.sy, m.uy), filter, &mFilterParamsY, mSrcHeight, false, &mYWeights[by] );
 	}
 
-	for( size_t chan = 0; chan < srcChannels.size(); ++chan ) {
-		for ( int32_t dstY = 0; dstY < dstHeight; ++dstY ) {     // loop over dest scanlines
-			// prepare a weight table for dest y position by
-			makeWeightTable<T,typename SCALETRAIT<T>::SUMT>( dstY, MAP(dstY, m.sy, m.uy), filter, &filterParamsY, srcHeight, false, &yWeights );
+#if defined( CINDER_SSE2 )
+	mUseSse2 = System::hasSse2();
+	// the 8-bit kernel multiplies in 16 bits, which some negative-lobed filters at extreme scales can exceed
+	if( std::numeric_limits<SUMT>::is_integer ) {
+		for( size_t w = 0; w < mXWeightBuffer.size(); ++w )
+			if( mXWeightBuffer[w] > 32767 || mXWeightBuffer[w] < -32768 )
+				mUseSse2 = false;
+	}
+#else
+	mUseSse2 = false;
+#endif
+}
+
+// Per-thread line buffers; a ring of x-filtered source scanlines plus a y accumulator
+template<typename T>
+struct ResampleScratch {
+	typedef typename SCALETRAIT<T>::SUMT SUMT;
+
+	void allocate( const ResampleWeights<T> &weights, int32_t lanes )
+	{
+		mLineWidth = weights.mDstWidth * lanes;
+		mLineRows.resize( weights.mFilterParamsY.width );
+		mLines.resize( weights.mFilterParamsY.width * mLineWidth );
+		mAccum.resize( mLineWidth );
+	}
+
+	// marks every cached line as stale; necessary whenever the source channel changes
+	void invalidate() { std::fill( mLineRows.begin(), mLineRows.end(), -1 ); }
+
+	SUMT*	getLine( size_t slot ) { return &mLines[slot * mLineWidth]; }
+
+	int32_t				mLineWidth;
+	vector<int32_t>		mLineRows;
+	vector<SUMT>		mLines;
+	vector<SUMT>		mAccum;
+};
+
+// The channels being resampled. When both Surfaces are 4-channel interleaved in the same order,
+// mSrcRgba and mDstRgba are set and all four channels are filtered in one pass
+template<typename T>
+struct ResampleJob {
+	ResampleJob() : mNumChannels( 0 ), mSrcRgba( 0 ), mDstRgba( 0 ) {}
+
+	void		addChannels( const ChannelT<T> *src, ChannelT<T> *dst ) { mSrcChannels[mNumChannels] = src; mDstChannels[mNumChannels++] = dst; }
+	int32_t		getLanes() const { return ( mSrcRgba ) ? 4 : 1; }
+
+	int32_t				mNumChannels;
+	const ChannelT<T>	*mSrcChannels[4];
+	ChannelT<T>			*mDstChannels[4];
+	const SurfaceT<T>	*mSrcRgba;
+	SurfaceT<T>			*mDstRgba;
+};
+
+template<typename T>
+void accumulateLine( const ResampleWeights<T> &weights, typename SCALETRAIT<T>::SUMT weight, const typename SCALETRAIT<T>::SUMT *line, int32_t width, typename SCALETRAIT<T>::SUMT *accum )
+{
+#if defined( CINDER_SSE2 )
+	if( weights.mUseSse2 ) {
+		scanlineAccumulateSse2( weight, line, width, accum );
+		return;
+	}
+#endif
+	scanlineAccumulate( weight, line, width, accum );
+}
+
+// Filters destination scanlines [dstYBegin,dstYEnd) of every channel
+template<typename T>
+void resampleBand( const ResampleJob<T> &job, const ResampleWeights<T> &weights, int32_t dstYBegin, int32_t dstYEnd, ResampleScratch<T> *scratch )
+{
+	typedef typename SCALETRAIT<T>::SUMT SUMT;
+	const int32_t dstWidth = weights.mDstWidth;
+	const int32_t numLines = weights.mFilterParamsY.width;
+	const WeightTable<SUMT> *xWeights = &weights.mXWeights[0];
+	SUMT *accum = &scratch->mAccum[0];
+
+	for( int32_t chan = 0; chan < job.mNumChannels; ++chan ) {
+		scratch->invalidate();
+		for( int32_t dstY = dstYBegin; dstY < dstYEnd; ++dstY ) {     // loop over dest scanlines
+			const WeightTable<SUMT> &yWeights = weights.mYWeights[dstY];
 
-			memset( accum.get(), 0, sizeof(int32_t) * dstWidth );
+			memset( accum, 0, sizeof(SUMT) * dstWidth );
 
 			// loop over source scanlines that influence this dest scanline
-			for ( int32_t ayf = yWeights.start; ayf < yWeights.end; ayf++ ) {
-				typename SCALETRAIT<T>::SUMT *line = linesBuffer[ayf % filterParamsY.width].second.get();
-				if( linesBuffer[ayf % filterParamsY.width].first != ayf ) {
-					scanlineFilterChannelToBuffer( xWeights, srcOffsetX, srcOffsetY + ayf, *(srcChannels[chan]), line, dstWidth );
-					linesBuffer[ayf % filterParamsY.width].first = ayf;
+			for( int32_t ayf = yWeights.start; ayf < yWeights.end; ayf++ ) {
+				SUMT *line = scratch->getLine( ayf % numLines );
+				if( scratch->mLineRows[ayf % numLines] != ayf ) {
+					scanlineFilterChannelToBuffer( xWeights, weights.mSrcOffsetX, weights.mSrcOffsetY + ayf, *(job.mSrcChannels[chan]), line, dstWidth );
+					scratch->mLineRows[ayf % numLines] = ayf;
 				}
-				scanlineAccumulate<typename SCALETRAIT<T>::SUMT,typename SCALETRAIT<T>::SUMT>( yWeights.weight[ayf - yWeights.start], line, dstWidth, accum.get() );
+				accumulateLine( weights, yWeights.weight[ayf - yWeights.start], line, dstWidth, accum );
 			}
 
-			scanlineShiftAccumToChannel( accum.get(), clippedDstArea.getX1(), clippedDstArea.getY1() + dstY, dstWidth, dstChannels[chan] );
+			scanlineShiftAccumToChannel( accum, weights.mClippedDstArea.getX1(), weights.mClippedDstArea.getY1() + dstY, dstWidth, job.mDstChannels[chan] );
+		}
+	}
+}
+
+// Same as resampleBand() but filters all four channels of an interleaved Surface per pass
+template<typename T>
+void resampleBandRgba( const ResampleJob<T> &job, const ResampleWeights<T> &weights, int32_t dstYBegin, int32_t dstYEnd, ResampleScratch<T> *scratch )
+{
+	typedef typename SCALETRAIT<T>::SUMT SUMT;
+	const int32_t dstWidth = weights.mDstWidth;
+	const int32_t numLines = weights.mFilterParamsY.width;
+	const WeightTable<SUMT> *xWeights = &weights.mXWeights[0];
+	SUMT *accum = &scratch->mAccum[0];
+
+	scratch->invalidate();
+	for( int32_t dstY = dstYBegin; dstY < dstYEnd; ++dstY ) {
+		const WeightTable<SUMT> &yWeights = weights.mYWeights[dstY];
+
+		memset( accum, 0, sizeof(SUMT) * dstWidth * 4 );
+
+		for( int32_t ayf = yWeights.start; ayf < yWeights.end; ayf++ ) {
+			SUMT *line = scratch->getLine( ayf % numLines );
+			if( scratch->mLineRows[ayf % numLines] != ayf ) {
+				const T *srcLine = job.mSrcRgba->getData( Vec2i( weights.mSrcOffsetX, weights.mSrcOffsetY + ayf ) );
+#if defined( CINDER_SSE2 )
+				if( weights.mUseSse2 )
+					scanlineFilterRgbaToBufferSse2( xWeights, srcLine, line, dstWidth );
+				else
+#endif
+					scanlineFilterRgbaToBuffer( xWeights, srcLine, line, dstWidth );
+				scratch->mLineRows[ayf % numLines] = ayf;
+			}
+			accumulateLine( weights, yWeights.weight[ayf - yWeights.start], line, dstWidth * 4, accum );
 		}
+
+		T *dstLine = job.mDstRgba->getData( Vec2i( weights.mClippedDstArea.getX1(), weights.mClippedDstArea.getY1() + dstY ) );
+#if defined( CINDER_SSE2 )
+		if( weights.mUseSse2 )
+			scanlineShiftAccumToRgbaSse2( accum, dstLine, dstWidth );
+		else
+#endif
+			scanlineShiftAccumToRgba( accum, dstLine, dstWidth );
+	}
+}
+
+template<typename T>
+struct ResampleBandFn {
+	ResampleBandFn( const ResampleJob<T> &job, const ResampleWeights<T> &weights, int32_t dstYBegin, int32_t dstYEnd, ResampleScratch<T> *scratch )
+		: mJob( job ), mWeights( weights ), mDstYBegin( dstYBegin ), mDstYEnd( dstYEnd ), mScratch( scratch )
+	{}
+
+	void operator()() const
+	{
+		mScratch->allocate( mWeights, mJob.getLanes() );
+		if( mJob.mSrcRgba )
+			resampleBandRgba( mJob, mWeights, mDstYBegin, mDstYEnd, mScratch );
+		else
+			resampleBand( mJob, mWeights, mDstYBegin, mDstYEnd, mScratch );
+	}
+
+	const ResampleJob<T>		&mJob;
+	const ResampleWeights<T>	&mWeights;
+	int32_t						mDstYBegin, mDstYEnd;
+	ResampleScratch<T>			*mScratch;
+};
+
+// Returns the number of bands to split the destination into for a requested thread count
+template<typename T>
+int32_t calcNumResampleBands( const ResampleWeights<T> &weights, int32_t numThreads )
+{
+	if( weights.isEmpty() )
+		return 1;
+	if( numThreads <= 0 )
+		numThreads = std::max<int32_t>( 1, std::thread::hardware_concurrency() );
+	// every band re-filters the source scanlines it shares with its neighbors, so don't make bands thinner than the filter
+	return std::max<int32_t>( 1, std::min<int32_t>( numThreads, weights.mDstHeight / std::max<int32_t>( 1, weights.mFilterParamsY.width ) ) );
+}
+
+// Splits the destination into one horizontal band per entry of \a scratch. Each band reads only the shared weights and writes
+// only its own scanlines, so the result is identical to filtering serially.
+template<typename T>
+void resampleParallel( const ResampleJob<T> &job, const ResampleWeights<T> &weights, vector<ResampleScratch<T> > *scratch )
+{
+	const int32_t numBands = (int32_t)scratch->size();
+	if( numBands == 1 ) {
+		ResampleBandFn<T>( job, weights, 0, weights.mDstHeight, &(*scratch)[0] )();
+		return;
+	}
+
+	const int32_t bandHeight = ( weights.mDstHeight + numBands - 1 ) / numBands;
+	vector<std::shared_ptr<std::thread> > threads;
+	for( int32_t band = 1; band < numBands; ++band ) {
+		int32_t dstYBegin = band * bandHeight;
+		int32_t dstYEnd = std::min( weights.mDstHeight, dstYBegin + bandHeight );
+		if( dstYBegin < dstYEnd )
+			threads.push_back( std::shared_ptr<std::thread>( new std::thread( ResampleBandFn<T>( job, weights, dstYBegin, dstYEnd, &(*scratch)[band] ) ) ) );
 	}
+	// the calling thread takes the first band
+	ResampleBandFn<T>( job, weights, 0, std::min( weights.mDstHeight, bandHeight ), &(*scratch)[0] )();
 
-	free( xWeights );
-	free( xWeightBuffer );
-	free( yWeights.weight );
+	for( size_t t = 0; t < threads.size(); ++t )
+		threads[t]->join();
+}
+
+// assumes channels are of same dimensions
+template<typename T>
+void resample( const ResampleJob<T> &job, const FilterBase &filter, const Area &srcArea, const Area &dstArea, int32_t numThreads )
+{
+	ResampleWeights<T> weights( job.mSrcChannels[0]->getBounds(), srcArea, job.mDstChannels[0]->getBounds(), dstArea, filter );
+	if( weights.isEmpty() )
+		return;
+
+	vector<ResampleScratch<T> > scratch( calcNumResampleBands( weights, numThreads ) );
+	resampleParallel( job, weights, &scratch );
 }
 
 template<typename LT, typename AT>
-void scanlineAccumulate( LT weight, LT *lineBuffer, int32_t width, AT *accum )
+void scanlineAccumulate( LT weight, const LT *lineBuffer, int32_t width, AT *accum )
 {
 	AT *dest = accum;
 	int32_t x;
@@ -306,64 +639,136 @@ void makeWeightTable( int32_t b, float cen, const FilterBase &filter, const Filt
 	}   
 }
 
+// Describes the channels of \a srcSurface and \a dstSurface to be resampled
 template<typename T>
-void resize( const SurfaceT<T> &srcSurface, const Area &srcArea, SurfaceT<T> *dstSurface, const Area &dstArea, const FilterBase &filter )
+ResampleJob<T> makeResampleJob( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface )
 {
-	vector<const ChannelT<T>*> srcChannels;
-	vector<ChannelT<T>*> dstChannels;
+	ResampleJob<T> job;
 
-	srcChannels.push_back( &srcSurface.getChannelRed() );
-	dstChannels.push_back( &dstSurface->getChannelRed() );
-	srcChannels.push_back( &srcSurface.getChannelGreen() );
-	dstChannels.push_back( &dstSurface->getChannelGreen() );
-	srcChannels.push_back( &srcSurface.getChannelBlue() );
-	dstChannels.push_back( &dstSurface->getChannelBlue() );
+	job.addChannels( &srcSurface.getChannelRed(), &dstSurface->getChannelRed() );
+	job.addChannels( &srcSurface.getChannelGreen(), &dstSurface->getChannelGreen() );
+	job.addChannels( &srcSurface.getChannelBlue(), &dstSurface->getChannelBlue() );
 	if ( srcSurface.hasAlpha() && dstSurface->hasAlpha() ) {
-		srcChannels.push_back( &srcSurface.getChannelAlpha() );
-		dstChannels.push_back( &dstSurface->getChannelAlpha() );	
+		job.addChannels( &srcSurface.getChannelAlpha(), &dstSurface->getChannelAlpha() );
+		// identical interleaved layouts let every channel share a single pass
+		if( srcSurface.getChannelOrder() == dstSurface->getChannelOrder() ) {
+			job.mSrcRgba = &srcSurface;
+			job.mDstRgba = dstSurface;
+		}
 	}
 
-	resample( srcChannels, filter, srcArea, dstArea, dstChannels );
+	return job;
 }
 
 template<typename T>
-void resize( const ChannelT<T> &srcChannel, const Area &srcArea, ChannelT<T> *dstChannel, const Area &dstArea, const FilterBase &filter )
+void resize( const SurfaceT<T> &srcSurface, const Area &srcArea, SurfaceT<T> *dstSurface, const Area &dstArea, const FilterBase &filter, int32_t numThreads )
 {
-	vector<const ChannelT<T>*> srcChannels;
-	vector<ChannelT<T>*> dstChannels;
-	
-	srcChannels.push_back( &srcChannel );
-	dstChannels.push_back( dstChannel );
+	resample( makeResampleJob( srcSurface, dstSurface ), filter, srcArea, dstArea, numThreads );
+}
+
+template<typename T>
+void resize( const ChannelT<T> &srcChannel, const Area &srcArea, ChannelT<T> *dstChannel, const Area &dstArea, const FilterBase &filter, int32_t numThreads )
+{
+	ResampleJob<T> job;
+	job.addChannels( &srcChannel, dstChannel );
 	
-	resample( srcChannels, filter, srcArea, dstArea, dstChannels );
+	resample( job, filter, srcArea, dstArea, numThreads );
 }
 
 template<typename T>
-void resize( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface, const FilterBase &filter )
+void resize( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface, const FilterBase &filter, int32_t numThreads )
 {
-	resize( srcSurface, srcSurface.getBounds(), dstSurface, dstSurface->getBounds(), filter );
+	resize( srcSurface, srcSurface.getBounds(), dstSurface, dstSurface->getBounds(), filter, numThreads );
 }
 
 template<typename T>
-SurfaceT<T> resizeCopy( const SurfaceT<T> &srcSurface, const Area &srcArea, const Vec2i &dstSize, const FilterBase &filter )
+SurfaceT<T> resizeCopy( const SurfaceT<T> &srcSurface, const Area &srcArea, const Vec2i &dstSize, const FilterBase &filter, int32_t numThreads )
 {
 	SurfaceT<T> result( dstSize.x, dstSize.y, srcSurface.hasAlpha(), srcSurface.getChannelOrder() );
-	resize( srcSurface, srcSurface.getBounds(), &result, result.getBounds(), filter );
+	resize( srcSurface, srcSurface.getBounds(), &result, result.getBounds(), filter, numThreads );
 	return result;
 }
 
 template<typename T>
-void resize( const ChannelT<T> &srcChannel, ChannelT<T> *dstChannel, const FilterBase &filter )
+void resize( const ChannelT<T> &srcChannel, ChannelT<T> *dstChannel, const FilterBase &filter, int32_t numThreads )
+{
+	resize( srcChannel, srcChannel.getBounds(), dstChannel, dstChannel->getBounds(), filter, numThreads );
+}
+
+template<typename T>
+struct ResizePlanT<T>::Obj {
+	Obj( const Vec2i &srcSize, const Area &srcArea, const Vec2i &dstSize, const Area &dstArea, const FilterBase &filter, int32_t numThreads )
+		: mSrcSize( srcSize ), mDstSize( dstSize ),
+		mWeights( Area( Vec2i::zero(), srcSize ), srcArea, Area( Vec2i::zero(), dstSize ), dstArea, filter ),
+		mScratch( calcNumResampleBands( mWeights, numThreads ) )
+	{
+		// size the scratch for the widest (interleaved) case up front so that apply() never allocates
+		if( ! mWeights.isEmpty() )
+			for( size_t band = 0; band < mScratch.size(); ++band )
+				mScratch[band].allocate( mWeights, 4 );
+	}
+
+	void	apply( const ResampleJob<T> &job, const Vec2i &srcSize, const Vec2i &dstSize )
+	{
+		if( ( srcSize != mSrcSize ) || ( dstSize != mDstSize ) )
+			throw ResizePlanExcGeometryMismatch();
+		if( ! mWeights.isEmpty() )
+			resampleParallel( job, mWeights, &mScratch );
+	}
+
+	Vec2i						mSrcSize, mDstSize;
+	ResampleWeights<T>			mWeights;
+	vector<ResampleScratch<T> >	mScratch;
+};
+
+template<typename T>
+ResizePlanT<T>::ResizePlanT( const Vec2i &srcSize, const Area &srcArea, const Vec2i &dstSize, const Area &dstArea, const FilterBase &filter, int32_t numThreads )
+	: mObj( new Obj( srcSize, srcArea, dstSize, dstArea, filter, numThreads ) )
+{
+}
+
+template<typename T>
+ResizePlanT<T>::ResizePlanT( const Vec2i &srcSize, const Vec2i &dstSize, const FilterBase &filter, int32_t numThreads )
+	: mObj( new Obj( srcSize, Area( Vec2i::zero(), srcSize ), dstSize, Area( Vec2i::zero(), dstSize ), filter, numThreads ) )
 {
-	resize( srcChannel, srcChannel.getBounds(), dstChannel, dstChannel->getBounds(), filter );
 }
 
+template<typename T>
+const Vec2i& ResizePlanT<T>::getSrcSize() const
+{
+	return mObj->mSrcSize;
+}
+
+template<typename T>
+const Vec2i& ResizePlanT<T>::getDstSize() const
+{
+	return mObj->mDstSize;
+}
+
+template<typename T>
+void ResizePlanT<T>::apply( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface )
+{
+	mObj->apply( makeResampleJob( srcSurface, dstSurface ), srcSurface.getSize(), dstSurface->getSize() );
+}
+
+template<typename T>
+void ResizePlanT<T>::apply( const ChannelT<T> &srcChannel, ChannelT<T> *dstChannel )
+{
+	ResampleJob<T> job;
+	job.addChannels( &srcChannel, dstChannel );
+
+	mObj->apply( job, srcChannel.getSize(), dstChannel->getSize() );
+}
+
+template class ResizePlanT<uint8_t>;
+template class ResizePlanT<float>;
+
 #define resize_PROTOTYPES(r,data,T)\
-	template void resize( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface, const FilterBase &filter ); \
-	template void resize( const SurfaceT<T> &srcSurface, const Area &srcArea, SurfaceT<T> *dstSurface, const Area &dstArea, const FilterBase &filter ); \
-	template void resize( const ChannelT<T> &srcChannel, ChannelT<T> *dstChannel, const FilterBase &filter ); \
-	template SurfaceT<T> resizeCopy( const SurfaceT<T> &srcSurface, const Area &srcArea, const Vec2i &dstSize, const FilterBase &filter ); \
-	template void resize( const ChannelT<T> &srcChannel, const Area &srcArea, ChannelT<T> *dstChannel, const Area &dstArea, const FilterBase &filter );
+	template void resize( const SurfaceT<T> &srcSurface, SurfaceT<T> *dstSurface, const FilterBase &filter, int32_t numThreads ); \
+	template void resize( const SurfaceT<T> &srcSurface, const Area &srcArea, SurfaceT<T> *dstSurface, const Area &dstArea, const FilterBase &filter, int32_t numThreads ); \
+	template void resize( const ChannelT<T> &srcChannel, ChannelT<T> *dstChannel, const FilterBase &filter, int32_t numThreads ); \
+	template SurfaceT<T> resizeCopy( const SurfaceT<T> &srcSurface, const Area &srcArea, const Vec2i &dstSize, const FilterBase &filter, int32_t numThreads ); \
+	template void resize( const ChannelT<T> &srcChannel, const Area &srcArea, ChannelT<T> *dstChannel, const Area &dstArea, const FilterBase &filter, int32_t numThreads );
 
 BOOST_PP_SEQ_FOR_EACH( resize_PROTOTYPES, ~, CHANNEL_TYPES )
 
@@ -21,38 +21,81 @@
 */
 
 #include "cinder/ip/Threshold.h"
+#include "cinder/ip/IntegralImage.h"
+#include "cinder/ip/PixelLayout.h"
+#include "cinder/ip/Parallel.h"
 #include "cinder/ChanTraits.h"
+#include "cinder/System.h"
+
+#if defined( CINDER_SSE2 )
+	#include <emmintrin.h>
+#endif
 
 #include <stdlib.h>
 
 namespace cinder { namespace ip {
 
+// Thresholds as many leading values of \a srcPtr into \a dstPtr as the SIMD kernel handles and returns how many it did.
+// Values are handled without regard to pixel boundaries; \a alphaOffset is the offset of alpha within each run of \a pixelInc values,
+// or SurfaceChannelOrder::INVALID, and dstPtr's alpha values are left untouched.
 template<typename T>
-void thresholdImpl( SurfaceT<T> *surface, T value, const Area &area )
+int32_t thresholdValuesSimd( const T *srcPtr, T *dstPtr, int32_t count, T value, uint8_t pixelInc, uint8_t alphaOffset )
 {
-	const Area clippedArea = area.getClipBy( surface->getBounds() );
-	int32_t rowBytes = surface->getRowBytes();
-	uint8_t pixelInc = surface->getPixelInc();
-	uint8_t redOffset = surface->getRedOffset(), greenOffset = surface->getGreenOffset(), blueOffset = surface->getBlueOffset();
-	T maxValue = CHANTRAIT<T>::max();
-	for( int32_t y = clippedArea.getY1(); y < clippedArea.getY2(); ++y ) {
-		T *dstPtr = reinterpret_cast<T*>( reinterpret_cast<uint8_t*>( surface->getData() + clippedArea.getX1() * pixelInc ) + y * rowBytes );
-		for( int32_t x = 0; x < clippedArea.getWidth(); ++x ) {
-			dstPtr[redOffset] = ( dstPtr[redOffset] > value ) ? maxValue : 0;
-			dstPtr[greenOffset] = ( dstPtr[greenOffset] > value ) ? maxValue : 0;
-			dstPtr[blueOffset] = ( dstPtr[blueOffset] > value ) ? maxValue : 0;;
-			dstPtr += pixelInc;
+	return 0;
+}
+
+int32_t thresholdValuesSimd( const uint8_t *srcPtr, uint8_t *dstPtr, int32_t count, uint8_t value, uint8_t pixelInc, uint8_t alphaOffset )
+{
+#if defined( CINDER_SSE2 )
+	static const bool useSse2 = System::hasSse2();
+	// a 16 byte vector only holds a whole number of pixels when the pixels are 1 or 4 bytes, unless no value needs to be preserved
+	if( ( ! useSse2 ) || ( ( alphaOffset != SurfaceChannelOrder::INVALID ) && ( pixelInc != 4 ) ) )
+		return 0;
+
+	uint8_t keep[16];
+	for( int i = 0; i < 16; ++i )
+		keep[i] = ( ( alphaOffset != SurfaceChannelOrder::INVALID ) && ( i % 4 == alphaOffset ) ) ? 0xFF : 0;
+	const __m128i keepMask = _mm_loadu_si128( reinterpret_cast<const __m128i*>( keep ) );
+	// SSE2 only compares signed bytes, so bias both sides by 128
+	const __m128i bias = _mm_set1_epi8( (char)0x80 );
+	const __m128i threshold = _mm_set1_epi8( (char)( value ^ 0x80 ) );
+
+	int32_t i = 0;
+	for( ; i + 16 <= count; i += 16 ) {
+		__m128i src = _mm_loadu_si128( reinterpret_cast<const __m128i*>( srcPtr + i ) );
+		__m128i above = _mm_cmpgt_epi8( _mm_xor_si128( src, bias ), threshold );
+		__m128i dst = _mm_loadu_si128( reinterpret_cast<const __m128i*>( dstPtr + i ) );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>( dstPtr + i ), _mm_or_si128( _mm_and_si128( keepMask, dst ), _mm_andnot_si128( keepMask, above ) ) );
+	}
+	return i;
+#else
+	return 0;
+#endif
+}
+
+template<typename T, typename LAYOUT>
+void thresholdRows( const SurfaceT<T> &srcSurface, T value, const Area &area, const Vec2i &dstOffset, SurfaceT<T> *dstSurface, int32_t y1, int32_t y2 )
+{
+	const T maxValue = CHANTRAIT<T>::max();
+	for( int32_t y = y1; y < y2; ++y ) {
+		T *dstPtr = dstSurface->getData( Vec2i( area.getX1(), y ) + dstOffset );
+		const T *srcPtr = srcSurface.getData( Vec2i( area.getX1(), y ) );
+		// a multiple of 16 pixels is always a whole number of vectors, so the SIMD kernel never stops partway through a pixel
+		int32_t done = thresholdValuesSimd( srcPtr, dstPtr, ( area.getWidth() & ~15 ) * LAYOUT::INC, value, LAYOUT::INC, LAYOUT::A ) / LAYOUT::INC;
+		dstPtr += done * LAYOUT::INC; srcPtr += done * LAYOUT::INC;
+		for( int32_t x = area.getX1() + done; x < area.getX2(); ++x ) {
+			dstPtr[LAYOUT::R] = ( srcPtr[LAYOUT::R] > value ) ? maxValue : 0;
+			dstPtr[LAYOUT::G] = ( srcPtr[LAYOUT::G] > value ) ? maxValue : 0;
+			dstPtr[LAYOUT::B] = ( srcPtr[LAYOUT::B] > value ) ? maxValue : 0;
+			dstPtr += LAYOUT::INC;
+			srcPtr += LAYOUT::INC;
 		}
-	}	
+	}
 }
 
 template<typename T>
-void thresholdImpl( const SurfaceT<T> &srcSurface, T value, const Area &srcArea, const Vec2i &dstLT, SurfaceT<T> *dstSurface )
+void thresholdRowsGeneric( const SurfaceT<T> &srcSurface, T value, const Area &area, const Vec2i &dstOffset, SurfaceT<T> *dstSurface, int32_t y1, int32_t y2 )
 {
-	std::pair<Area,Vec2i> srcDst = clippedSrcDst( srcSurface.getBounds(), srcArea, dstSurface->getBounds(), dstLT );
-	const Area &area( srcDst.first );
-	const Vec2i &dstOffset( srcDst.second );
-
 	int32_t srcRowBytes = srcSurface.getRowBytes();
 	int8_t srcPixelInc = srcSurface.getPixelInc();
 	uint8_t srcRedOffset = srcSurface.getRedOffset(), srcGreenOffset = srcSurface.getGreenOffset(), srcBlueOffset = srcSurface.getBlueOffset();
@@ -60,9 +103,9 @@ void thresholdImpl( const SurfaceT<T> &srcSurface, T value, const Area &srcArea,
 	int8_t dstPixelInc = dstSurface->getPixelInc();
 	uint8_t dstRedOffset = dstSurface->getRedOffset(), dstGreenOffset = dstSurface->getGreenOffset(), dstBlueOffset = dstSurface->getBlueOffset();
 	const T maxValue = CHANTRAIT<T>::max();
-	for( int32_t y = 0; y < area.getHeight(); ++y ) {
+	for( int32_t y = y1; y < y2; ++y ) {
 		T *dstPtr = reinterpret_cast<T*>( reinterpret_cast<uint8_t*>( dstSurface->getData() + ( dstOffset.x + area.getX1() ) * dstPixelInc ) + ( y + dstOffset.y ) * dstRowBytes );
-		const T *srcPtr = reinterpret_cast<const T*>( reinterpret_cast<const uint8_t*>( srcSurface.getData() + area.getX1() * srcPixelInc ) + ( y + area.getY1() ) * srcRowBytes );
+		const T *srcPtr = reinterpret_cast<const T*>( reinterpret_cast<const uint8_t*>( srcSurface.getData() + area.getX1() * srcPixelInc ) + y * srcRowBytes );
 		for( int32_t x = area.getX1(); x < area.getX2(); ++x ) {
 			dstPtr[dstRedOffset] = ( srcPtr[srcRedOffset] > value ) ? maxValue : 0;
 			dstPtr[dstGreenOffset] = ( srcPtr[srcGreenOffset] > value ) ? maxValue : 0;
@@ -74,52 +117,122 @@ void thresholdImpl( const SurfaceT<T> &srcSurface, T value, const Area &srcArea,
 }
 
 template<typename T>
-void thresholdImpl( const ChannelT<T> &srcChannel, T value, const Area &srcArea, const Vec2i &dstLT, ChannelT<T> *dstChannel )
+struct ThresholdRowsFn {
+	ThresholdRowsFn( const SurfaceT<T> &srcSurface, T value, const Area &area, const Vec2i &dstOffset, SurfaceT<T> *dstSurface )
+		: mSrcSurface( srcSurface ), mValue( value ), mArea( area ), mDstOffset( dstOffset ), mDstSurface( dstSurface )
+	{}
+
+	void operator()( int32_t y1, int32_t y2 ) const
+	{
+		LayoutOp op( *this, y1, y2 );
+		// the specialized loops require both Surfaces to share a layout
+		if( ( ! ( mSrcSurface.getChannelOrder() == mDstSurface->getChannelOrder() ) ) || ( ! dispatchPixelLayout( mSrcSurface.getChannelOrder(), op ) ) )
+			thresholdRowsGeneric( mSrcSurface, mValue, mArea, mDstOffset, mDstSurface, y1, y2 );
+	}
+
+	struct LayoutOp {
+		LayoutOp( const ThresholdRowsFn &fn, int32_t y1, int32_t y2 ) : mFn( fn ), mY1( y1 ), mY2( y2 ) {}
+		template<typename LAYOUT>
+		void process() { thresholdRows<T,LAYOUT>( mFn.mSrcSurface, mFn.mValue, mFn.mArea, mFn.mDstOffset, mFn.mDstSurface, mY1, mY2 ); }
+
+		const ThresholdRowsFn	&mFn;
+		int32_t					mY1, mY2;
+	};
+
+	const SurfaceT<T>	&mSrcSurface;
+	T					mValue;
+	Area				mArea;
+	Vec2i				mDstOffset;
+	SurfaceT<T>			*mDstSurface;
+};
+
+template<typename T>
+void thresholdImpl( SurfaceT<T> *surface, T value, const Area &area, int32_t numThreads )
+{
+	const Area clippedArea = area.getClipBy( surface->getBounds() );
+	parallelRows( clippedArea.getY1(), clippedArea.getY2(), numThreads, ThresholdRowsFn<T>( *surface, value, clippedArea, Vec2i::zero(), surface ), 64 );
+}
+
+template<typename T>
+void thresholdImpl( const SurfaceT<T> &srcSurface, T value, const Area &srcArea, const Vec2i &dstLT, SurfaceT<T> *dstSurface, int32_t numThreads )
 {
-	std::pair<Area,Vec2i> srcDst = clippedSrcDst( srcChannel.getBounds(), srcArea, dstChannel->getBounds(), dstLT );
+	std::pair<Area,Vec2i> srcDst = clippedSrcDst( srcSurface.getBounds(), srcArea, dstSurface->getBounds(), dstLT );
 	const Area &area( srcDst.first );
 	const Vec2i &dstOffset( srcDst.second );
 
-	int8_t srcInc = srcChannel.getIncrement();
-	int8_t dstInc = dstChannel->getIncrement();
-	const T maxValue = CHANTRAIT<T>::max();
-	for( int32_t y = 0; y < area.getHeight(); ++y ) {
-		T *dstPtr = dstChannel->getData( Vec2i( area.getX1(), y ) + dstOffset );
-		const T *srcPtr = srcChannel.getData( Vec2i( area.getX1(), y ) );
-		for( int32_t x = area.getX1(); x < area.getX2(); ++x ) {
-			*dstPtr = ( *srcPtr > value ) ? maxValue : 0;
-			dstPtr += dstInc;
-			srcPtr += srcInc;
+	parallelRows( area.getY1(), area.getY2(), numThreads, ThresholdRowsFn<T>( srcSurface, value, area, dstOffset, dstSurface ), 64 );
+}
+
+template<typename T>
+struct ThresholdChannelRowsFn {
+	ThresholdChannelRowsFn( const ChannelT<T> &srcChannel, T value, const Area &area, const Vec2i &dstOffset, ChannelT<T> *dstChannel )
+		: mSrcChannel( srcChannel ), mValue( value ), mArea( area ), mDstOffset( dstOffset ), mDstChannel( dstChannel )
+	{}
+
+	void operator()( int32_t y1, int32_t y2 ) const
+	{
+		int8_t srcInc = mSrcChannel.getIncrement();
+		int8_t dstInc = mDstChannel->getIncrement();
+		const T maxValue = CHANTRAIT<T>::max();
+		for( int32_t y = y1; y < y2; ++y ) {
+			T *dstPtr = mDstChannel->getData( Vec2i( mArea.getX1(), y ) + mDstOffset );
+			const T *srcPtr = mSrcChannel.getData( Vec2i( mArea.getX1(), y ) );
+			int32_t x = mArea.getX1();
+			if( ( srcInc == 1 ) && ( dstInc == 1 ) ) {
+				int32_t done = thresholdValuesSimd( srcPtr, dstPtr, mArea.getWidth(), mValue, 1, SurfaceChannelOrder::INVALID );
+				x += done; dstPtr += done; srcPtr += done;
+			}
+			for( ; x < mArea.getX2(); ++x ) {
+				*dstPtr = ( *srcPtr > mValue ) ? maxValue : 0;
+				dstPtr += dstInc;
+				srcPtr += srcInc;
+			}
 		}
 	}
+
+	const ChannelT<T>	&mSrcChannel;
+	T					mValue;
+	Area				mArea;
+	Vec2i				mDstOffset;
+	ChannelT<T>			*mDstChannel;
+};
+
+template<typename T>
+void thresholdImpl( const ChannelT<T> &srcChannel, T value, const Area &srcArea, const Vec2i &dstLT, ChannelT<T> *dstChannel, int32_t numThreads )
+{
+	std::pair<Area,Vec2i> srcDst = clippedSrcDst( srcChannel.getBounds(), srcArea, dstChannel->getBounds(), dstLT );
+	const Area &area( srcDst.first );
+	const Vec2i &dstOffset( srcDst.second );
+
+	parallelRows( area.getY1(), area.getY2(), numThreads, ThresholdChannelRowsFn<T>( srcChannel, value, area, dstOffset, dstChannel ), 64 );
 }
 
 template<typename T>
-void threshold( SurfaceT<T> *surface, T value, const Area &area )
+void threshold( SurfaceT<T> *surface, T value, const Area &area, int32_t numThreads )
 {
-	thresholdImpl( surface, value, area );
+	thresholdImpl( surface, value, area, numThreads );
 }
 
 template<typename T>
-void threshold( SurfaceT<T> *surface, T value )
+void threshold( SurfaceT<T> *surface, T value, int32_t numThreads )
 {
-	thresholdImpl( surface, value, surface->getBounds() );
+	thresholdImpl( surface, value, surface->getBounds(), numThreads );
 }
 
 template<typename T>
-void threshold( const SurfaceT<T> &surface, T value, SurfaceT<T> *dstSurface )
+void threshold( const SurfaceT<T> &surface, T value, SurfaceT<T> *dstSurface, int32_t numThreads )
 {
-	thresholdImpl( surface, value, surface.getBounds(), Vec2i::zero(), dstSurface );
+	thresholdImpl( surface, value, surface.getBounds(), Vec2i::zero(), dstSurface, numThreads );
 }
 
 template<typename T>
-void threshold( const ChannelT<T> &srcChannel, T value, ChannelT<T> *dstChannel )
+void threshold( const ChannelT<T> &srcChannel, T value, ChannelT<T> *dstChannel, int32_t numThreads )
 {
-	thresholdImpl( srcChannel, value, srcChannel.getBounds(), Vec2i::zero(), dstChannel );
+	thresholdImpl( srcChannel, value, srcChannel.getBounds(), Vec2i::zero(), dstChannel, numThreads );
 }
 
 template<typename T>
-void calculateAdaptiveThreshold( const ChannelT<T> *srcChannel, typename CHANTRAIT<T>::Accum *integralImage, int32_t windowSize, float percentageDelta, ChannelT<T> *dstChannel )
+void calculateAdaptiveThreshold( const ChannelT<T> *srcChannel, const IntegralImageT<T> &integralImage, int32_t windowSize, float percentageDelta, ChannelT<T> *dstChannel )
 {
 	typedef typename CHANTRAIT<T>::Accum SUMT; 
 
@@ -153,11 +266,8 @@ void calculateAdaptiveThreshold( const ChannelT<T> *srcChannel, typename CHANTRA
 			
 			int32_t count = ( x2 - x1 ) * ( y2 - y1 );
 
-			// I(x,y)=s(x2,y2)-s(x1,y2)-s(x2,y1)+s(x1,x1)
-			SUMT sum =	integralImage[y2 * imageWidth + x2] -
-						integralImage[y1 * imageWidth + x2] -
-						integralImage[y2 * imageWidth + x1] +
-						integralImage[y1 * imageWidth + x1];
+			// I(x,y)=s(x2,y2)-s(x1,y2)-s(x2,y1)+s(x1,x1), where s(x,y) includes row y and column x
+			SUMT sum = integralImage.getSum( x1 + 1, y1 + 1, x2 + 1, y2 + 1 );
 
 			*dst = ( (SUMT)(*src * count) < (sum * comparisonMult / 256) ) ? 0 : maxValue;
 			dst += dstInc;
@@ -167,7 +277,7 @@ void calculateAdaptiveThreshold( const ChannelT<T> *srcChannel, typename CHANTRA
 }
 
 template<typename T>
-void calculateAdaptiveThresholdZero( const ChannelT<T> *srcChannel, typename CHANTRAIT<T>::Accum *integralImage, int32_t windowSize, ChannelT<T> *dstChannel )
+void calculateAdaptiveThresholdZero( const ChannelT<T> *srcChannel, const IntegralImageT<T> &integralImage, int32_t windowSize, ChannelT<T> *dstChannel )
 {
 	typedef typename CHANTRAIT<T>::Accum SUMT; 
 
@@ -197,11 +307,8 @@ void calculateAdaptiveThresholdZero( const ChannelT<T> *srcChannel, typename CHA
 			
 			int32_t count = ( x2 - x1 ) * ( y2 - y1 );
 
-			// I(x,y)=s(x2,y2)-s(x1,y2)-s(x2,y1)+s(x1,x1)
-			SUMT sum =	integralImage[y2 * imageWidth + x2] -
-						integralImage[y1 * imageWidth + x2] -
-						integralImage[y2 * imageWidth + x1] +
-						integralImage[y1 * imageWidth + x1];
+			// I(x,y)=s(x2,y2)-s(x1,y2)-s(x2,y1)+s(x1,x1), where s(x,y) includes row y and column x
+			SUMT sum = integralImage.getSum( x1 + 1, y1 + 1, x2 + 1, y2 + 1 );
 
 			//*dst = ( (*dst * count) < sum ) ? 0 : maxValue;
 			int32_t diffSignExtended = (int32_t)( sum - *src * count );
@@ -214,134 +321,60 @@ void calculateAdaptiveThresholdZero( const ChannelT<T> *srcChannel, typename CHA
 
 }
 
-template<typename T>
-void calculateIntegralImage( const ChannelT<T> &channel, typename CHANTRAIT<T>::Accum *integralImage )
-{
-	int32_t imageWidth = channel.getWidth(), imageHeight = channel.getHeight();
-	int32_t srcRowBytes = channel.getRowBytes();
-	uint8_t srcInc = channel.getIncrement();
-	const T *src = channel.getData();
-	/*for( int32_t i = 0; i < imageWidth; i++ ) {
-		// reset this column sum
-		typename CHANTRAIT<T>::Accum sum = 0;
-
-		for( int32_t j = 0; j < imageHeight; j++ ) {
-			uint32_t index = j * imageWidth + i;
-
-			sum += src[j*srcRowBytes+i*srcInc];
-			if( i == 0 )
-				integralImage[index] = sum;
-			else
-				integralImage[index] = integralImage[index-1] + sum;
-		}
-	}*/
-	for( int32_t j = 0; j < imageHeight; j++ ) {
-		// reset this column sum
-		typename CHANTRAIT<T>::Accum sum = 0;
-
-		for( int32_t i = 0; i < imageWidth; i++ ) {		
-			uint32_t index = j * imageWidth + i;
-
-			sum += src[j*srcRowBytes+i*srcInc];
-			if( j == 0 )
-				integralImage[index] = sum;
-			else
-				integralImage[index] = integralImage[index-imageWidth] + sum;
-		}
-	}
-}
-
 template<typename T>
 void adaptiveThreshold( const ChannelT<T> &srcChannel, int32_t windowSize, float percentageDelta, ChannelT<T> *dstChannel )
 {
-	typedef typename CHANTRAIT<T>::Accum SUMT; 
-
-	int32_t imageWidth = srcChannel.getWidth();
-	int32_t imageHeight = srcChannel.getHeight();
-	SUMT *integralImage;
-
 	// create the integral image
-	integralImage = (SUMT*)malloc( imageWidth * imageHeight * sizeof( typename CHANTRAIT<T>::Accum ) );
-	calculateIntegralImage( srcChannel, integralImage );
-	
-	calculateAdaptiveThreshold( &srcChannel, integralImage, windowSize, percentageDelta, dstChannel );
+	IntegralImageT<T> integralImage( srcChannel );
 
-	free( integralImage );	
+	calculateAdaptiveThreshold( &srcChannel, integralImage, windowSize, percentageDelta, dstChannel );
 }
 
 template<typename T>
 void adaptiveThreshold( ChannelT<T> *channel, int32_t windowSize, float percentageDelta )
 {
-	typedef typename CHANTRAIT<T>::Accum SUMT; 
-
-	int32_t imageWidth = channel->getWidth();
-	int32_t imageHeight = channel->getHeight();
-	SUMT *integralImage;
-
 	// create the integral image
-	integralImage = (SUMT*)malloc( imageWidth * imageHeight * sizeof( typename CHANTRAIT<T>::Accum ) );
-	calculateIntegralImage( *channel, integralImage );
+	IntegralImageT<T> integralImage( *channel );
 
 	calculateAdaptiveThreshold( channel, integralImage, windowSize, percentageDelta, channel );
-
-	free( integralImage );	
 }
 
 template<typename T>
 void adaptiveThresholdZero( ChannelT<T> *channel, int32_t windowSize )
 {
-	typedef typename CHANTRAIT<T>::Accum SUMT; 
-
-	int32_t imageWidth = channel->getWidth();
-	int32_t imageHeight = channel->getHeight();
-	SUMT *integralImage;
-
 	// create the integral image
-	integralImage = (SUMT*)malloc( imageWidth * imageHeight * sizeof( typename CHANTRAIT<T>::Accum ) );
-	calculateIntegralImage( *channel, integralImage );
-	
-	calculateAdaptiveThresholdZero( channel, integralImage, windowSize, channel );
+	IntegralImageT<T> integralImage( *channel );
 
-	free( integralImage );	
+	calculateAdaptiveThresholdZero( channel, integralImage, windowSize, channel );
 }
 
 template<typename T>
 void adaptiveThresholdZero( const ChannelT<T> &srcChannel, int32_t windowSize, ChannelT<T> *dstChannel )
 {
-	typedef typename CHANTRAIT<T>::Accum SUMT; 
-
-	int32_t imageWidth = srcChannel.getWidth();
-	int32_t imageHeight = srcChannel.getHeight();
-	SUMT *integralImage;
-
 	// create the integral image
-	integralImage = (SUMT*)malloc( imageWidth * imageHeight * sizeof( typename CHANTRAIT<T>::Accum ) );
-	calculateIntegralImage( srcChannel, integralImage );
-	
-	calculateAdaptiveThresholdZero( &srcChannel, integralImage, windowSize, dstChannel );
+	IntegralImageT<T> integralImage( srcChannel );
 
-	free( integralImage );	
+	calculateAdaptiveThresholdZero( &srcChannel, integralImage, windowSize, dstChannel );
 }
 
 template<typename T>
-AdaptiveThresholdT<T>::Obj::Obj( ChannelT<T> *channel ) : mChannel( channel ) {
+AdaptiveThresholdT<T>::Obj::Obj( ChannelT<T> *channel, const IntegralImageType &integralImage )
+	: mChannel( channel ), mIntegralImage( integralImage )
+{
 	mImageWidth = mChannel->getWidth();
 	mImageHeight = mChannel->getHeight();
 	mIncrement = mChannel->getIncrement();
-
-	// create the integral image
-	mIntegralImage = (SUMT*)malloc( mImageWidth * mImageHeight * sizeof( typename CHANTRAIT<T>::Accum ) );
-	calculateIntegralImage( *channel, mIntegralImage );
 }
 
 template<typename T>
-AdaptiveThresholdT<T>::Obj::~Obj() {
-	free( mIntegralImage );
+AdaptiveThresholdT<T>::AdaptiveThresholdT( ChannelT<T> *channel ) 
+	: mObj( new Obj( channel, IntegralImageType( *channel ) ) ) 
+{
 }
 
 template<typename T>
-AdaptiveThresholdT<T>::AdaptiveThresholdT( ChannelT<T> *channel ) 
-	: mObj( new Obj( channel ) ) 
+AdaptiveThresholdT<T>::AdaptiveThresholdT( ChannelT<T> *channel, const IntegralImageType &integralImage ) 
+	: mObj( new Obj( channel, integralImage ) ) 
 {
 }
 
@@ -359,10 +392,10 @@ template class AdaptiveThresholdT<uint8_t>;
 template class AdaptiveThresholdT<float>;
 
 #define threshold_PROTOTYPES(r,data,T)\
-	template void threshold( SurfaceT<T> *surface, T value ); \
-	template void threshold( SurfaceT<T> *surface, T value, const Area &area ); \
-	template void threshold( const SurfaceT<T> &srcSurface, T value, SurfaceT<T> *dstSurface );\
-	template void threshold( const ChannelT<T> &srcChannel, T value, ChannelT<T> *dstChannel );\
+	template void threshold( SurfaceT<T> *surface, T value, int32_t numThreads ); \
+	template void threshold( SurfaceT<T> *surface, T value, const Area &area, int32_t numThreads ); \
+	template void threshold( const SurfaceT<T> &srcSurface, T value, SurfaceT<T> *dstSurface, int32_t numThreads );\
+	template void threshold( const ChannelT<T> &srcChannel, T value, ChannelT<T> *dstChannel, int32_t numThreads );\
 	template void adaptiveThreshold( const ChannelT<T> &srcChannel, int32_t windowSize, float percentageDelta, ChannelT<T> *dstChannel ); \
 	template void adaptiveThreshold( ChannelT<T> *channel, int32_t windowSize, float percentageDelta ); \
 	template void adaptiveThresholdZero( ChannelT<T> *channel, int32_t windowSize ); \
@@ -0,0 +1,95 @@
+#include "cinder/audio/SampleConversion.h"
+#include "cinder/Timer.h"
+#include "cinder/Rand.h"
+#include "cinder/CinderMath.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace ci;
+using namespace ci::audio;
+using namespace std;
+
+// One hour of 8 channel, 48kHz audio, processed a second at a time
+const uint16_t	CHANNEL_COUNT = 8;
+const size_t	FRAMES_PER_BLOCK = 48000;
+const int		BLOCK_COUNT = 3600;
+
+void report( const string &label, const Timer &timer )
+{
+	cout << label << ": " << timer.getSeconds() << "s / hour, " << ( 3600.0 / timer.getSeconds() ) << "x realtime" << endl;
+}
+
+// Decoding a 16-bit WAV for processing: interleaved int16_t to a float array per channel
+void benchmarkDecode( const vector<int16_t> &file, vector<vector<float> > *channels )
+{
+	vector<float> converted( file.size() );
+	vector<float*> channelPtrs( CHANNEL_COUNT );
+	for( uint16_t c = 0; c < CHANNEL_COUNT; ++c )
+		channelPtrs[c] = &(*channels)[c][0];
+
+	Timer timer( true );
+	for( int block = 0; block < BLOCK_COUNT; ++block ) {
+		for( size_t i = 0; i < FRAMES_PER_BLOCK; ++i ) {
+			for( uint16_t c = 0; c < CHANNEL_COUNT; ++c )
+				channelPtrs[c][i] = file[i * CHANNEL_COUNT + c] / 32768.0f;
+		}
+	}
+	timer.stop();
+	report( "int16 to float deinterleave, per sample", timer );
+
+	timer.start();
+	for( int block = 0; block < BLOCK_COUNT; ++block ) {
+		convertSamples( &file[0], &converted[0], file.size() );
+		deinterleaveSamples( &converted[0], &channelPtrs[0], CHANNEL_COUNT, FRAMES_PER_BLOCK );
+	}
+	timer.stop();
+	report( "int16 to float deinterleave, SampleConversion", timer );
+}
+
+// Rendering for a 16-bit WAV: a float array per channel to dithered interleaved int16_t
+void benchmarkEncode( const vector<vector<float> > &channels, vector<int16_t> *file )
+{
+	vector<float> interleaved( file->size() );
+	vector<const float*> channelPtrs( CHANNEL_COUNT );
+	for( uint16_t c = 0; c < CHANNEL_COUNT; ++c )
+		channelPtrs[c] = &channels[c][0];
+
+	Rand rnd;
+	Timer timer( true );
+	for( int block = 0; block < BLOCK_COUNT; ++block ) {
+		for( size_t i = 0; i < FRAMES_PER_BLOCK; ++i ) {
+			for( uint16_t c = 0; c < CHANNEL_COUNT; ++c ) {
+				float v = channelPtrs[c][i] * 32768.0f + rnd.nextFloat() - rnd.nextFloat();
+				v = math<float>::clamp( v, -32768.0f, 32767.0f );
+				(*file)[i * CHANNEL_COUNT + c] = static_cast<int16_t>( math<float>::floor( v + 0.5f ) );
+			}
+		}
+	}
+	timer.stop();
+	report( "float to dithered int16 interleave, per sample", timer );
+
+	SampleDither dither;
+	timer.start();
+	for( int block = 0; block < BLOCK_COUNT; ++block ) {
+		interleaveSamples( &channelPtrs[0], &interleaved[0], CHANNEL_COUNT, FRAMES_PER_BLOCK );
+		convertSamples( &interleaved[0], &(*file)[0], interleaved.size(), &dither );
+	}
+	timer.stop();
+	report( "float to dithered int16 interleave, SampleConversion", timer );
+}
+
+int main( int /*argc*/, char * const /*argv*/[] )
+{
+	Rand rnd;
+	vector<int16_t> file( FRAMES_PER_BLOCK * CHANNEL_COUNT );
+	for( size_t i = 0; i < file.size(); ++i )
+		file[i] = static_cast<int16_t>( rnd.nextInt( -32768, 32768 ) );
+	vector<vector<float> > channels( CHANNEL_COUNT, vector<float>( FRAMES_PER_BLOCK ) );
+
+	benchmarkDecode( file, &channels );
+	benchmarkEncode( channels, &file );
+
+	return 0;
+}
@@ -0,0 +1,100 @@
+#include "cinder/Surface.h"
+#include "cinder/ImageIo.h"
+#include "cinder/Timer.h"
+#include "cinder/Rand.h"
+#include "cinder/Utilities.h"
+
+#include <iostream>
+#include <string>
+
+using namespace ci;
+using namespace std;
+
+// Forces a Surface loaded from an ImageSource into a particular channel order
+class ChannelOrderConstraints : public SurfaceConstraints {
+  public:
+	ChannelOrderConstraints( const SurfaceChannelOrder &channelOrder ) : mChannelOrder( channelOrder ) {}
+
+	virtual SurfaceChannelOrder getChannelOrder( bool /*alpha*/ ) const { return mChannelOrder; }
+
+  private:
+	SurfaceChannelOrder		mChannelOrder;
+};
+
+void randomize( Surface8u *surface )
+{
+	Rand rnd;
+	for( int32_t y = 0; y < surface->getHeight(); ++y ) {
+		uint8_t *line = surface->getData( Vec2i( 0, y ) );
+		for( int32_t x = 0; x < surface->getWidth() * surface->getPixelInc(); ++x )
+			line[x] = static_cast<uint8_t>( rnd.nextInt( 256 ) );
+	}
+}
+
+void report( const string &label, const Timer &timer, int iterations )
+{
+	cout << label << ": " << ( timer.getSeconds() / iterations ) * 1000.0 << "ms / image" << endl;
+}
+
+// Times only the ImageSource row conversion, by loading a Surface of type T in \a dstOrder from an RGBA Surface8u
+template<typename T>
+void benchmarkConversion( const string &label, const Vec2i &size, const SurfaceChannelOrder &dstOrder, int iterations )
+{
+	Surface8u src( size.x, size.y, true, SurfaceChannelOrder::RGBA );
+	randomize( &src );
+
+	Timer timer( true );
+	for( int i = 0; i < iterations; ++i )
+		SurfaceT<T> dst( src, ChannelOrderConstraints( dstOrder ) );
+	timer.stop();
+	report( label, timer, iterations );
+}
+
+// Times decoding the PNG at \a path, which includes the conversion into the target Surface
+void benchmarkPngDecode( const string &path, int iterations )
+{
+	Timer timer( true );
+	for( int i = 0; i < iterations; ++i )
+		Surface8u dst( loadImage( path ) );
+	timer.stop();
+	report( "PNG decode to Surface8u", timer, iterations );
+
+	timer.start();
+	for( int i = 0; i < iterations; ++i )
+		Surface8u dst( loadImage( path ), ChannelOrderConstraints( SurfaceChannelOrder::BGRA ) );
+	timer.stop();
+	report( "PNG decode to Surface8u BGRA", timer, iterations );
+
+	timer.start();
+	for( int i = 0; i < iterations; ++i )
+		Surface32f dst( loadImage( path ) );
+	timer.stop();
+	report( "PNG decode to Surface32f", timer, iterations );
+}
+
+// Pass the path of a PNG to decode; otherwise a random 1080p RGBA PNG is written to the temporary directory
+int main( int argc, char * const argv[] )
+{
+	const Vec2i size( 1920, 1080 );
+	benchmarkConversion<uint8_t>( "RGBA to Surface8u RGBA", size, SurfaceChannelOrder::RGBA, 20 );
+	benchmarkConversion<uint8_t>( "RGBA to Surface8u BGRA", size, SurfaceChannelOrder::BGRA, 20 );
+	benchmarkConversion<uint8_t>( "RGBA to Surface8u ARGB", size, SurfaceChannelOrder::ARGB, 20 );
+	benchmarkConversion<float>( "RGBA to Surface32f RGBA", size, SurfaceChannelOrder::RGBA, 20 );
+	benchmarkConversion<float>( "RGBA to Surface32f BGRA", size, SurfaceChannelOrder::BGRA, 20 );
+
+	if( argc > 1 )
+		benchmarkPngDecode( argv[1], 10 );
+	else {
+		Surface8u image( size.x, size.y, true );
+		randomize( &image );
+		// on MSW getTemporaryFilePath() creates the file it names, so remove that as well as the PNG
+		const string tempPath = getTemporaryFilePath( "ImageIoBenchmark" );
+		const string path = tempPath + ".png";
+		writeImage( path, image );
+		benchmarkPngDecode( path, 10 );
+		deleteFile( path );
+		deleteFile( tempPath );
+	}
+
+	return 0;
+}
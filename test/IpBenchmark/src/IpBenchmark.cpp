@@ -0,0 +1,170 @@
+#include "cinder/Surface.h"
+#include "cinder/Timer.h"
+#include "cinder/Rand.h"
+#include "cinder/ip/Fill.h"
+#include "cinder/ip/Grayscale.h"
+#include "cinder/ip/Premultiply.h"
+#include "cinder/ip/Threshold.h"
+#include "cinder/ip/IntegralImage.h"
+#include "cinder/ip/Blur.h"
+#include "cinder/ip/EdgeDetect.h"
+
+#include <iostream>
+#include <string>
+
+using namespace ci;
+using namespace std;
+
+template<typename T>
+void randomize( SurfaceT<T> *surface )
+{
+	Rand rnd( 1234 );
+	for( int32_t y = 0; y < surface->getHeight(); ++y ) {
+		T *line = surface->getData( Vec2i( 0, y ) );
+		for( int32_t x = 0; x < surface->getWidth() * surface->getPixelInc(); ++x )
+			line[x] = static_cast<T>( rnd.nextFloat() * CHANTRAIT<T>::max() );
+	}
+}
+
+void report( const string &label, const Vec2i &size, const Timer &timer, int iterations )
+{
+	cout << label << " " << size.x << "x" << size.y << ": " << ( timer.getSeconds() / iterations ) * 1000.0 << "ms / frame" << endl;
+}
+
+// Times grayscale, premultiply / unpremultiply and fill on a single frame of \a size, using \a numThreads threads where supported
+template<typename T>
+void benchmarkOps( const string &label, const Vec2i &size, int32_t numThreads, int iterations )
+{
+	SurfaceT<T> src( size.x, size.y, true );
+	randomize( &src );
+	SurfaceT<T> dst( size.x, size.y, true );
+	ChannelT<T> gray( size.x, size.y );
+
+	Timer timer( true );
+	for( int i = 0; i < iterations; ++i )
+		ip::grayscale( src, &gray, numThreads );
+	timer.stop();
+	report( label + " grayscale to Channel", size, timer, iterations );
+
+	timer.start();
+	for( int i = 0; i < iterations; ++i ) {
+		ip::premultiply( &src, numThreads );
+		ip::unpremultiply( &src, numThreads );
+	}
+	timer.stop();
+	report( label + " premultiply + unpremultiply", size, timer, iterations );
+
+	timer.start();
+	for( int i = 0; i < iterations; ++i )
+		ip::fill( &dst, ColorA( 0.25f, 0.5f, 0.75f, 1.0f ) );
+	timer.stop();
+	report( label + " fill", size, timer, iterations );
+}
+
+// Compares the direct Gaussian at a small and a large sigma against the recursive Gaussian, reusing one scratch buffer throughout
+template<typename T>
+void benchmarkBlur( const string &label, const Vec2i &size, int32_t numThreads, int iterations )
+{
+	SurfaceT<T> src( size.x, size.y, true );
+	randomize( &src );
+	SurfaceT<T> dst( size.x, size.y, true );
+	ip::BlurBuffer scratch;
+
+	const float sigmas[] = { 2.0f, 8.0f };
+	for( int s = 0; s < 2; ++s ) {
+		Timer timer( true );
+		for( int i = 0; i < iterations; ++i )
+			ip::blur( src, &dst, sigmas[s], numThreads, &scratch );
+		timer.stop();
+		report( label + " blur sigma " + ( s ? "8" : "2" ), size, timer, iterations );
+
+		timer.start();
+		for( int i = 0; i < iterations; ++i )
+			ip::blurRecursive( src, &dst, sigmas[s], numThreads, &scratch );
+		timer.stop();
+		report( label + " blurRecursive sigma " + ( s ? "8" : "2" ), size, timer, iterations );
+	}
+}
+
+// Sobel magnitude alone, then magnitude and direction together, on the grayscale of a frame
+void benchmarkSobel( const Vec2i &size, int32_t numThreads, int iterations )
+{
+	Surface8u src( size.x, size.y, false );
+	randomize( &src );
+	Channel8u gray( size.x, size.y ), magnitude( size.x, size.y );
+	Channel32f direction( size.x, size.y );
+	ip::grayscale( src, &gray );
+
+	Timer timer( true );
+	for( int i = 0; i < iterations; ++i )
+		ip::edgeDetectSobel( gray, &magnitude, numThreads );
+	timer.stop();
+	report( "Channel8u Sobel magnitude", size, timer, iterations );
+
+	timer.start();
+	for( int i = 0; i < iterations; ++i )
+		ip::edgeDetectSobel( gray, &magnitude, &direction, numThreads );
+	timer.stop();
+	report( "Channel8u Sobel magnitude + direction", size, timer, iterations );
+}
+
+// threshold is only implemented for 8-bit data
+void benchmarkThreshold( const Vec2i &size, int32_t numThreads, int iterations )
+{
+	Surface8u src( size.x, size.y, true );
+	randomize( &src );
+	Surface8u dst( size.x, size.y, true );
+
+	Timer timer( true );
+	for( int i = 0; i < iterations; ++i )
+		ip::threshold( src, (uint8_t)128, &dst, numThreads );
+	timer.stop();
+	report( "Surface8u threshold", size, timer, iterations );
+}
+
+// Runs three window-based filters on one frame, sharing a single IntegralImage between them
+void benchmarkWindowFilters( const Vec2i &size, int32_t numThreads, int iterations )
+{
+	Surface8u src( size.x, size.y, false );
+	randomize( &src );
+	Channel8u gray( size.x, size.y ), blurred( size.x, size.y ), thresholded( size.x, size.y );
+	ip::grayscale( src, &gray );
+	Channel32f variance( size.x, size.y );
+
+	ip::IntegralImage8u integralImage( gray, true, numThreads );
+	Timer timer( true );
+	for( int i = 0; i < iterations; ++i )
+		integralImage.update( gray, numThreads );
+	timer.stop();
+	report( "IntegralImage8u with squared sums", size, timer, iterations );
+
+	timer.start();
+	for( int i = 0; i < iterations; ++i ) {
+		integralImage.update( gray, numThreads );
+		ip::boxBlur( integralImage, 8, &blurred, numThreads );
+		ip::localVariance( integralImage, 8, &variance, numThreads );
+		ip::AdaptiveThreshold( &gray, integralImage ).calculate( size.x / 8, 0.15f, &thresholded );
+	}
+	timer.stop();
+	report( "box blur + variance + adaptive threshold", size, timer, iterations );
+}
+
+int main( int /*argc*/, char * const /*argv*/[] )
+{
+	const Vec2i sizes[] = { Vec2i( 1920, 1080 ), Vec2i( 3840, 2160 ) };
+	const int32_t threadCounts[] = { 1, 0 };
+	for( int t = 0; t < 2; ++t ) {
+		cout << "-- " << ( threadCounts[t] ? "1 thread" : "all cores" ) << " --" << endl;
+		for( int s = 0; s < 2; ++s ) {
+			benchmarkOps<uint8_t>( "Surface8u", sizes[s], threadCounts[t], 20 );
+			benchmarkOps<float>( "Surface32f", sizes[s], threadCounts[t], 20 );
+			benchmarkThreshold( sizes[s], threadCounts[t], 20 );
+			benchmarkBlur<uint8_t>( "Surface8u", sizes[s], threadCounts[t], 5 );
+			benchmarkBlur<float>( "Surface32f", sizes[s], threadCounts[t], 5 );
+			benchmarkWindowFilters( sizes[s], threadCounts[t], 5 );
+			benchmarkSobel( sizes[s], threadCounts[t], 20 );
+		}
+	}
+
+	return 0;
+}
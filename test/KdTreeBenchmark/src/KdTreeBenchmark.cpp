@@ -0,0 +1,83 @@
+#include "cinder/KdTree.h"
+#include "cinder/Timer.h"
+#include "cinder/Rand.h"
+
+#include <iostream>
+#include <string>
+
+using namespace ci;
+using namespace std;
+
+void report( const string &label, const Timer &timer )
+{
+	cout << label << ": " << timer.getSeconds() * 1000.0 << "ms" << endl;
+}
+
+// Compares findKNearest() for the first \a numQueries particles against a linear search, returning the number of queries that disagree
+size_t verify( const KdTree<Vec3f> &tree, const vector<Vec3f> &particles, size_t numQueries, uint32_t k )
+{
+	size_t mismatches = 0;
+	vector<uint32_t> indices( k );
+	vector<float> distancesSqrd( k ), expected;
+	for( size_t q = 0; q < numQueries; ++q ) {
+		float p[3] = { particles[q].x, particles[q].y, particles[q].z };
+		tree.findKNearest( p, k, &indices[0], &distancesSqrd[0] );
+		expected.clear();
+		for( size_t i = 0; i < particles.size(); ++i )
+			expected.push_back( particles[i].distanceSquared( particles[q] ) );
+		partial_sort( expected.begin(), expected.begin() + k, expected.end() );
+		if( ! equal( distancesSqrd.begin(), distancesSqrd.end(), expected.begin() ) )
+			++mismatches;
+	}
+	return mismatches;
+}
+
+// Times building a tree over 1M random particles and finding each one's nearest neighbors
+int main( int /*argc*/, char * const /*argv*/[] )
+{
+	const size_t numParticles = 1000 * 1000;
+	const uint32_t k = 8;
+	Rand rnd;
+	vector<Vec3f> particles( numParticles );
+	for( size_t i = 0; i < numParticles; ++i )
+		particles[i] = Vec3f( rnd.nextFloat(), rnd.nextFloat(), rnd.nextFloat() );
+
+	Timer timer( true );
+	KdTree<Vec3f> serialTree( particles, 1 );
+	timer.stop();
+	report( "Build on one thread", timer );
+
+	timer.start();
+	KdTree<Vec3f> tree( particles );
+	timer.stop();
+	report( "Build on all cores", timer );
+
+	vector<uint32_t> indices( numParticles * k );
+	vector<float> distancesSqrd( numParticles * k );
+	timer.start();
+	for( size_t i = 0; i < numParticles; ++i ) {
+		float p[3] = { particles[i].x, particles[i].y, particles[i].z }, nearest[3];
+		tree.findNearest( p, nearest, &indices[i] );
+	}
+	timer.stop();
+	report( "findNearest() for every particle", timer );
+
+	timer.start();
+	tree.findKNearest( &particles[0], numParticles, k, &indices[0], &distancesSqrd[0], FLT_MAX, 1 );
+	timer.stop();
+	report( "findKNearest() for every particle on one thread", timer );
+
+	timer.start();
+	tree.findKNearest( &particles[0], numParticles, k, &indices[0], &distancesSqrd[0] );
+	timer.stop();
+	report( "findKNearest() for every particle on all cores", timer );
+
+	timer.start();
+	tree.findKNearest( &particles[0], numParticles, k, &indices[0], &distancesSqrd[0], 0.01f );
+	timer.stop();
+	report( "findKNearest() within 0.01 for every particle on all cores", timer );
+
+	cout << "Mismatches against linear search: " << verify( tree, particles, 100, k ) << " of 100" << endl;
+
+	return 0;
+}
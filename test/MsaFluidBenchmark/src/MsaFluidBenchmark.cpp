@@ -0,0 +1,77 @@
+#include "cinder/Timer.h"
+#include "cinder/Rand.h"
+#include "cinder/System.h"
+
+#include "ciMsaFluidSolver.h"
+
+#include <iostream>
+#include <string>
+
+using namespace ci;
+using namespace std;
+
+// Stirs the fluid the same way every run, so that serial and parallel solvers see the same input
+void stir( ciMsaFluidSolver *solver, int frame )
+{
+	Rand rnd( frame );
+	for( int i = 0; i < 20; ++i ) {
+		Vec2f pos( rnd.nextFloat( 0.1f, 0.9f ), rnd.nextFloat( 0.1f, 0.9f ) );
+		solver->addForceAtPos( pos, rnd.nextVec2f() * 0.01f );
+		solver->addColorAtPos( pos.x, pos.y, rnd.nextFloat(), rnd.nextFloat(), rnd.nextFloat() );
+	}
+}
+
+// Returns the average difference in color and velocity between two solvers of the same size
+float difference( const ciMsaFluidSolver &a, const ciMsaFluidSolver &b )
+{
+	float result = 0;
+	for( int i = 0; i < a.getNumCells(); ++i ) {
+		Vec2f velA, velB;
+		Color colorA, colorB;
+		a.getInfoAtCell( i, &velA, &colorA );
+		b.getInfoAtCell( i, &velB, &colorB );
+		result += velA.distance( velB ) + colorA.distance( colorB );
+	}
+	return result / a.getNumCells();
+}
+
+void setup( ciMsaFluidSolver *solver, int size, int numThreads )
+{
+	solver->setup( size, size );
+	solver->enableRGB( true ).setColorDiffusion( 0.0001f ).setFadeSpeed( 0.002f );
+	if( numThreads > 0 )
+		solver->enableParallel( true, numThreads );
+}
+
+// Returns cells per second for frames steps of a size x size RGB fluid, serial if numThreads is 0
+double benchmark( ciMsaFluidSolver *solver, int size, int numThreads, int frames )
+{
+	setup( solver, size, numThreads );
+	Timer timer( true );
+	for( int frame = 0; frame < frames; ++frame ) {
+		stir( solver, frame );
+		solver->update();
+	}
+	return (double)size * size * frames / timer.getSeconds();
+}
+
+int main( int /*argc*/, char * const /*argv*/[] )
+{
+	const int cores = System::getNumCores();
+	const int sizes[] = { 128, 256, 512, 1024 };
+	for( int s = 0; s < 4; ++s ) {
+		const int size = sizes[s];
+		const int frames = ( 512 * 512 * 20 ) / ( size * size ) + 5;
+
+		ciMsaFluidSolver serial, parallel, single;
+		double serialRate = benchmark( &serial, size, 0, frames );
+		double parallelRate = benchmark( &parallel, size, cores, frames );
+		double singleRate = benchmark( &single, size, 1, frames );
+
+		cout << size << "x" << size << ": serial " << serialRate / 1e6 << "M cells/s, parallel on one thread " << singleRate / 1e6
+			<< "M cells/s, parallel on " << cores << " threads " << parallelRate / 1e6 << "M cells/s (" << parallelRate / serialRate << "x)" << endl;
+		cout << "  average difference from serial " << difference( serial, parallel ) << ", between thread counts " << difference( single, parallel ) << endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,86 @@
+#include "cinder/ObjLoader.h"
+#include "cinder/DataSource.h"
+#include "cinder/Timer.h"
+#include "cinder/Rand.h"
+#include "cinder/Utilities.h"
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+using namespace ci;
+using namespace std;
+
+// Writes a (resolution x resolution) grid of quads, split into 2 * resolution^2 triangles with position, tex coord and normal indices
+void writeGrid( const string &path, int resolution )
+{
+	FILE *file = fopen( path.c_str(), "wb" );
+	Rand rnd;
+	const int side = resolution + 1;
+	for( int y = 0; y < side; ++y )
+		for( int x = 0; x < side; ++x )
+			fprintf( file, "v %f %f %f\n", x / (float)resolution, y / (float)resolution, rnd.nextFloat() * 0.1f );
+	for( int y = 0; y < side; ++y )
+		for( int x = 0; x < side; ++x )
+			fprintf( file, "vt %f %f\n", x / (float)resolution, y / (float)resolution );
+	for( int y = 0; y < side; ++y )
+		for( int x = 0; x < side; ++x )
+			fprintf( file, "vn %f %f %f\n", rnd.nextFloat( -0.1f, 0.1f ), rnd.nextFloat( -0.1f, 0.1f ), 1.0f );
+	for( int y = 0; y < resolution; ++y ) {
+		for( int x = 0; x < resolution; ++x ) {
+			int a = y * side + x + 1, b = a + 1, c = a + side, d = c + 1;
+			fprintf( file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, d, d, d );
+			fprintf( file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, d, d, d, c, c, c );
+		}
+	}
+	fclose( file );
+}
+
+void report( const string &label, const Timer &timer )
+{
+	cout << label << ": " << timer.getSeconds() << "s" << endl;
+}
+
+// Pass the path of an OBJ to load; otherwise a 10M triangle grid is written to the temporary directory
+int main( int argc, char * const argv[] )
+{
+	string path, tempPath;
+	if( argc > 1 )
+		path = argv[1];
+	else {
+		tempPath = getTemporaryFilePath( "ObjLoaderBenchmark" );
+		path = tempPath + ".obj";
+		Timer timer( true );
+		writeGrid( path, 2237 );
+		cout << "Wrote " << path << " in " << timer.getSeconds() << "s" << endl;
+	}
+
+	{
+		Timer timer( true );
+		ObjLoader loader( DataSourceRef( loadFileMapped( path ) ) );
+		timer.stop();
+		report( "Parse from mapped file", timer );
+	}
+
+	{
+		Timer timer( true );
+		ObjLoader loader( loadFile( path ) );
+		timer.stop();
+		report( "Parse from file stream", timer );
+
+		TriMesh mesh;
+		timer.start();
+		loader.load( &mesh );
+		timer.stop();
+		report( "Load into TriMesh", timer );
+		cout << mesh.getNumTriangles() << " triangles" << endl;
+	}
+
+	// on MSW getTemporaryFilePath() creates the file it names, so remove that as well as the generated OBJ
+	if( ! tempPath.empty() ) {
+		deleteFile( path );
+		deleteFile( tempPath );
+	}
+
+	return 0;
+}
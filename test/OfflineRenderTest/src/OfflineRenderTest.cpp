@@ -0,0 +1,130 @@
+#include "cinder/audio/OutputImplOffline.h"
+#include "cinder/audio/Callback.h"
+#include "cinder/audio/SourceFileWav.h"
+#include "cinder/CinderMath.h"
+#include "cinder/Timer.h"
+#include "cinder/Utilities.h"
+
+#include <iostream>
+#include <string>
+
+using namespace ci;
+using namespace ci::audio;
+using namespace std;
+
+// A stereo sine with a different frequency in each channel
+class SineGenerator {
+  public:
+	SineGenerator( float leftFreq, float rightFreq ) : mLeftFreq( leftFreq ), mRightFreq( rightFreq ) {}
+
+	void generate( uint64_t inSampleOffset, uint32_t inSampleCount, Buffer32f *ioBuffer )
+	{
+		for( uint32_t i = 0; i < inSampleCount; i++ ) {
+			double t = ( inSampleOffset + i ) / 44100.0;
+			ioBuffer->mData[i * 2] = math<float>::sin( (float)( t * mLeftFreq * 2 * M_PI ) ) * 0.5f;
+			ioBuffer->mData[i * 2 + 1] = math<float>::sin( (float)( t * mRightFreq * 2 * M_PI ) ) * 0.5f;
+		}
+	}
+
+	float	mLeftFreq, mRightFreq;
+};
+
+int gFailures = 0;
+
+void check( bool condition, const string &description )
+{
+	if( ! condition ) {
+		cout << "FAILED: " << description << endl;
+		gFailures++;
+	}
+}
+
+// Two generators, one at half volume, must sum exactly
+void testMix()
+{
+	SineGenerator a( 440, 660 ), b( 220, 330 );
+	OutputImplOffline output( OutputImplOffline::Format().setBlockSize( 100 ) );
+	TrackRef trackA = output.addTrack( createCallback( &a, &SineGenerator::generate ), true );
+	TrackRef trackB = output.addTrack( createCallback( &b, &SineGenerator::generate ), true );
+	trackB->setVolume( 0.5f );
+
+	PcmBuffer32fRef mix = output.render( 1000 );
+	std::shared_ptr<Buffer32f> mixData = mix->getInterleavedData();
+
+	Buffer32f expectedA, expectedB;
+	vector<float> dataA( 2000 ), dataB( 2000 );
+	expectedA.mData = &dataA[0];
+	expectedB.mData = &dataB[0];
+	a.generate( 0, 1000, &expectedA );
+	b.generate( 0, 1000, &expectedB );
+
+	bool matches = true;
+	for( size_t i = 0; i < 2000; i++ )
+		matches = matches && ( math<float>::abs( mixData->mData[i] - ( dataA[i] + dataB[i] * 0.5f ) ) < 1e-6f );
+	check( matches, "mix of two tracks" );
+	check( output.getSampleOffset() == 1000, "sample offset after render" );
+	check( math<double>::abs( trackA->getTime() - 1000 / 44100.0 ) < 1e-9, "track time after render" );
+}
+
+// A rendered WAV must load back as what was rendered, and a non-looping WAV track must stop at its end
+void testWavRoundTrip( const string &path )
+{
+	SineGenerator sine( 440, 880 );
+	OutputImplOffline output;
+	output.addTrack( createCallback( &sine, &SineGenerator::generate ), true );
+	output.renderToWav( path, 44100, Io::FLOAT32 );
+
+	OutputImplOffline playback( OutputImplOffline::Format().setBlockSize( 333 ) );
+	TrackRef track = playback.addTrack( SourceFileWav::createRef( loadFile( path ) ), true );
+	PcmBuffer32fRef loaded = playback.render( 44100 + 1000 );
+	std::shared_ptr<Buffer32f> loadedData = loaded->getInterleavedData();
+
+	Buffer32f expected;
+	vector<float> expectedData( 2 * 44100 );
+	expected.mData = &expectedData[0];
+	sine.generate( 0, 44100, &expected );
+
+	bool matches = true;
+	for( size_t i = 0; i < expectedData.size(); i++ )
+		matches = matches && ( loadedData->mData[i] == expectedData[i] );
+	for( size_t i = expectedData.size(); i < 2 * ( 44100 + 1000 ); i++ )
+		matches = matches && ( loadedData->mData[i] == 0 );
+	check( matches, "float WAV round trip" );
+	check( ! track->isPlaying(), "track stops at the end of its source" );
+}
+
+// Rendering an hour of an 8 track mix measures how far faster than realtime the offline output runs
+void benchmarkRender()
+{
+	// reserved up front so the callbacks' pointers into it stay valid
+	vector<SineGenerator> generators;
+	generators.reserve( 8 );
+	OutputImplOffline output( OutputImplOffline::Format().setBlockSize( 1024 ) );
+	for( int i = 0; i < 8; i++ ) {
+		generators.push_back( SineGenerator( 110.0f * ( i + 1 ), 165.0f * ( i + 1 ) ) );
+		output.addTrack( createCallback( &generators.back(), &SineGenerator::generate ), true );
+	}
+
+	vector<float> block( 2 * 44100 );
+	Timer timer( true );
+	for( int second = 0; second < 3600; second++ )
+		output.render( &block[0], 44100 );
+	timer.stop();
+	cout << "8 track mix: " << timer.getSeconds() << "s / hour, " << ( 3600.0 / timer.getSeconds() ) << "x realtime" << endl;
+}
+
+int main( int /*argc*/, char * const /*argv*/[] )
+{
+	testMix();
+
+	// on MSW getTemporaryFilePath() creates the file it names, so remove that as well as the WAV
+	const string tempPath = getTemporaryFilePath( "OfflineRenderTest" );
+	testWavRoundTrip( tempPath + ".wav" );
+	deleteFile( tempPath + ".wav" );
+	deleteFile( tempPath );
+
+	benchmarkRender();
+
+	cout << ( gFailures ? "FAILED" : "passed" ) << endl;
+	return gFailures ? 1 : 0;
+}
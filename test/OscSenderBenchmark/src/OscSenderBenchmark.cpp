@@ -0,0 +1,90 @@
+#include "cinder/Timer.h"
+#include "cinder/Utilities.h"
+
+#include "OscSender.h"
+#include "OscListener.h"
+
+#include <iostream>
+#include <string>
+
+using namespace ci;
+using namespace std;
+
+static const int PORT = 3000;
+static const int FRAMES = 60;
+static const int MESSAGES_PER_FRAME = 5000;
+
+static size_t sReceived = 0;
+
+void countMessage( const osc::PooledMessage & )
+{
+	++sReceived;
+}
+
+// Sends FRAMES frames of MESSAGES_PER_FRAME per-particle messages, the way an app would from update(), and counts what arrives. The
+// sender is shut down, which waits for its background thread to send everything queued, before the send time is taken.
+void benchmark( const string &label, osc::Sender &sender, osc::Listener &listener, bool batched )
+{
+	sReceived = 0;
+	uint32_t droppedBefore = listener.getDroppedMessageCount();
+	const size_t sent = FRAMES * MESSAGES_PER_FRAME;
+
+	osc::Message message;
+	Timer timer( true );
+	for( int frame = 0; frame < FRAMES; ++frame ) {
+		for( int i = 0; i < MESSAGES_PER_FRAME; ++i ) {
+			message.clear();
+			message.setAddress( "/particle" );
+			message.addIntArg( i );
+			message.addFloatArg( i * 0.5f );
+			message.addFloatArg( i * 0.25f );
+			sender.sendMessage( message );
+		}
+		if( batched )
+			sender.flush();
+		listener.drainMessages( countMessage );
+	}
+	sender.shutdown();
+	double sendSeconds = timer.getSeconds();
+
+	// keep draining until every message is accounted for, or nothing more has arrived for half a second
+	double receiveSeconds = timer.getSeconds();
+	double lastArrival = receiveSeconds;
+	while( ( sReceived + ( listener.getDroppedMessageCount() - droppedBefore ) < sent ) && ( timer.getSeconds() - lastArrival < 0.5 ) ) {
+		if( listener.drainMessages( countMessage ) > 0 )
+			receiveSeconds = lastArrival = timer.getSeconds();
+		else
+			ci::sleep( 1 );
+	}
+	timer.stop();
+
+	cout << label << ": " << sent / sendSeconds << " messages/s sent, " << sReceived / receiveSeconds << " messages/s received, "
+		<< sReceived << " of " << sent << " received, " << listener.getDroppedMessageCount() - droppedBefore << " dropped by the listener" << endl;
+}
+
+int main( int /*argc*/, char * const /*argv*/[] )
+{
+	osc::Listener listener;
+	listener.setupPooled( PORT, 16384 );
+
+	{
+		osc::Sender sender;
+		sender.setup( "localhost", PORT );
+		benchmark( "one datagram per message", sender, listener, false );
+	}
+
+	{
+		osc::Sender sender;
+		sender.setupBatched( "localhost", PORT, osc::Sender::FLUSH_PER_FRAME );
+		benchmark( "batched, flushed per frame", sender, listener, true );
+	}
+
+	{
+		osc::Sender sender;
+		sender.setupBatched( "localhost", PORT, osc::Sender::FLUSH_WHEN_FULL );
+		benchmark( "batched, flushed when full", sender, listener, true );
+	}
+
+	listener.shutdown();
+	return 0;
+}
@@ -0,0 +1,75 @@
+#include "cinder/Surface.h"
+#include "cinder/Timer.h"
+#include "cinder/Rand.h"
+#include "cinder/ip/Resize.h"
+
+#include <iostream>
+#include <cstring>
+
+using namespace ci;
+using namespace std;
+
+// Downscales a 4K frame to a thumbnail with 1, 2, 4 and 8 threads and verifies the results are bit-identical
+template<typename T>
+bool benchmarkThreads( const char *label, int iterations )
+{
+	SurfaceT<T> src( 3840, 2160, true );
+	Rand rnd( 1234 );
+	for( int32_t y = 0; y < src.getHeight(); ++y ) {
+		T *line = src.getData( Vec2i( 0, y ) );
+		for( int32_t x = 0; x < src.getWidth() * src.getPixelInc(); ++x )
+			line[x] = static_cast<T>( rnd.nextFloat() * CHANTRAIT<T>::max() );
+	}
+
+	const Vec2i thumbSize( 320, 180 );
+	SurfaceT<T> reference = ip::resizeCopy( src, src.getBounds(), thumbSize, FilterGaussian(), 1 );
+
+	const int32_t threadCounts[] = { 1, 2, 4, 8 };
+	for( int t = 0; t < 4; ++t ) {
+		SurfaceT<T> dst( thumbSize.x, thumbSize.y, true );
+		Timer timer( true );
+		for( int i = 0; i < iterations; ++i )
+			ip::resize( src, &dst, FilterGaussian(), threadCounts[t] );
+		timer.stop();
+
+		for( int32_t y = 0; y < dst.getHeight(); ++y ) {
+			if( memcmp( dst.getData( Vec2i( 0, y ) ), reference.getData( Vec2i( 0, y ) ), dst.getWidth() * dst.getPixelInc() * sizeof(T) ) != 0 ) {
+				cout << label << " " << threadCounts[t] << " thread(s): row " << y << " differs from the single threaded result" << endl;
+				return false;
+			}
+		}
+
+		cout << label << " " << threadCounts[t] << " thread(s): " << ( timer.getSeconds() / iterations ) * 1000.0 << "ms / frame" << endl;
+	}
+
+	return true;
+}
+
+// Compares resizing 720p video frames with and without a reusable ResizePlan
+void benchmarkPlan( int iterations )
+{
+	Surface8u src( 1280, 720, true );
+	Surface8u dst( 480, 270, true );
+	ip::ResizePlan plan( src.getSize(), dst.getSize(), FilterTriangle() );
+
+	Timer timer( true );
+	for( int i = 0; i < iterations; ++i )
+		ip::resize( src, &dst, FilterTriangle() );
+	timer.stop();
+	cout << "720p resize without plan: " << ( timer.getSeconds() / iterations ) * 1000.0 << "ms / frame" << endl;
+
+	timer.start();
+	for( int i = 0; i < iterations; ++i )
+		ip::resize( plan, src, &dst );
+	timer.stop();
+	cout << "720p resize with plan: " << ( timer.getSeconds() / iterations ) * 1000.0 << "ms / frame" << endl;
+}
+
+int main( int /*argc*/, char * const /*argv*/[] )
+{
+	if( ! benchmarkThreads<uint8_t>( "Surface8u", 20 ) || ! benchmarkThreads<float>( "Surface32f", 20 ) )
+		return 1;
+	benchmarkPlan( 200 );
+
+	return 0;
+}
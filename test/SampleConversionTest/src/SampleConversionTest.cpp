@@ -0,0 +1,59 @@
+#include "cinder/audio/SampleConversion.h"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace ci;
+using namespace ci::audio;
+using namespace std;
+
+// Rounds \a v to the nearest integer, ties to even, as _mm_cvtps_epi32() does
+int32_t roundHalfEven( double v )
+{
+	double rounded = floor( v + 0.5 );
+	if( ( rounded - v == 0.5 ) && ( fmod( rounded, 2.0 ) != 0 ) )
+		rounded -= 1;
+	return (int32_t)rounded;
+}
+
+// Converts float samples which scale to between 2^22 and 2^23 in magnitude, where floats are spaced by halves, to int32_t. The whole array goes
+// through the SIMD path, except for a tail of fewer than 8 samples, and each sample is also converted on its own, which always takes the scalar path.
+bool testInt32Rounding()
+{
+	vector<float> src;
+	for( int32_t v = 4194304; v <= 8388608; v += 65537 ) {
+		// odd and even integers, and the halves between them
+		for( int32_t k = 0; k < 4; ++k ) {
+			float scaled = (float)( v + k / 2 ) + ( ( k & 1 ) ? 0.5f : 0.0f );
+			src.push_back( scaled / 2147483648.0f );
+			src.push_back( -scaled / 2147483648.0f );
+		}
+	}
+	src.push_back( 6442451.0f / 2147483648.0f );
+	src.push_back( 5000001.0f / 2147483648.0f );
+	src.push_back( 4194305.5f / 2147483648.0f );
+
+	vector<int32_t> block( src.size() ), single( src.size() );
+	convertSamples( &src[0], &block[0], src.size() );
+	for( size_t i = 0; i < src.size(); ++i )
+		convertSamples( &src[i], &single[i], 1 );
+
+	size_t failures = 0;
+	for( size_t i = 0; i < src.size(); ++i ) {
+		int32_t expected = roundHalfEven( (double)src[i] * 2147483648.0 );
+		if( ( block[i] != expected ) || ( single[i] != expected ) ) {
+			if( failures++ < 10 )
+				cout << "  " << (double)src[i] * 2147483648.0 << ": expected " << expected << ", block " << block[i] << ", single " << single[i] << endl;
+		}
+	}
+
+	bool passed = failures == 0;
+	cout << "float to int32_t rounding between 2^22 and 2^23: " << src.size() << " samples, " << failures << " wrong" << ( passed ? "" : " FAILED" ) << endl;
+	return passed;
+}
+
+int main( int /*argc*/, char * const /*argv*/[] )
+{
+	return testInt32Rounding() ? 0 : 1;
+}
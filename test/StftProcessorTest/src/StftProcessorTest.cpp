@@ -0,0 +1,104 @@
+#include "cinder/audio/StftProcessor.h"
+#include "cinder/Rand.h"
+#include "cinder/CinderMath.h"
+
+#include <iostream>
+#include <vector>
+
+using namespace ci;
+using namespace ci::audio;
+using namespace std;
+
+// Runs every frame of \a stft back through synthesize(), appending the output to \a out
+void synthesizeFrames( StftProcessorRef stft, vector<float> *out )
+{
+	while( stft->getFrameCount() > 0 ) {
+		StftProcessor::Frame frame = stft->getFrame( 0 );
+		size_t offset = out->size();
+		out->resize( offset + stft->getHopSize() );
+		stft->synthesize( frame.mMagnitudes, frame.mPhases, &(*out)[offset] );
+		stft->popFrames( 1 );
+	}
+}
+
+// Writes noise whose length is not a multiple of the hop in uneven blocks, flushes, and checks that synthesis reproduces every sample
+// after the first getFrameSize() - getHopSize(), up to and including the last one
+bool testRoundTrip( StftProcessor::WindowType window, uint32_t hopSize )
+{
+	StftProcessor::Format format;
+	format.setWindow( window );
+	format.setHopSize( hopSize );
+	format.setFrameCapacity( 16 );
+	StftProcessorRef stft = StftProcessor::createRef( format );
+
+	Rand rnd( 5678 );
+	vector<float> input( 20000 + hopSize / 2 + 1 );
+	for( size_t i = 0; i < input.size(); ++i )
+		input[i] = rnd.nextFloat( -1.0f, 1.0f );
+
+	vector<float> output;
+	for( size_t written = 0; written < input.size(); ) {
+		uint32_t count = std::min<uint32_t>( input.size() - written, 1 + rnd.nextInt( 700 ) );
+		stft->write( &input[written], count );
+		written += count;
+		synthesizeFrames( stft, &output );
+	}
+	stft->flush();
+	synthesizeFrames( stft, &output );
+	size_t offset = output.size();
+	output.resize( offset + stft->getFrameSize() - hopSize );
+	stft->flushSynthesis( &output[offset] );
+
+	float maxError = 0;
+	for( size_t i = stft->getFrameSize() - hopSize; i < input.size(); ++i )
+		maxError = std::max( maxError, math<float>::abs( output[i] - input[i] ) );
+
+	bool passed = maxError < 1.0e-4f;
+	cout << "window " << window << " hop " << hopSize << ": max error " << maxError << ( passed ? "" : " FAILED" ) << endl;
+	return passed;
+}
+
+// A hop of the whole frame leaves the ends of a Blackman window almost uncovered. Once a frame's phases are modified its ends no longer
+// cancel the window, so those samples must not be amplified.
+bool testSparseOverlap()
+{
+	StftProcessor::Format format;
+	format.setWindow( StftProcessor::WINDOW_BLACKMAN );
+	format.setHopSize( 1024 );
+	StftProcessorRef stft = StftProcessor::createRef( format );
+
+	vector<float> input( 4096, 1.0f ), output, phases( stft->getBinCount() );
+	stft->write( &input[0], input.size() );
+	while( stft->getFrameCount() > 0 ) {
+		StftProcessor::Frame frame = stft->getFrame( 0 );
+		for( uint32_t k = 0; k < stft->getBinCount(); ++k )
+			phases[k] = frame.mPhases[k] + 1.0f;
+		size_t offset = output.size();
+		output.resize( offset + stft->getHopSize() );
+		stft->synthesize( frame.mMagnitudes, &phases[0], &output[offset] );
+		stft->popFrames( 1 );
+	}
+
+	float maxValue = 0;
+	for( size_t i = 0; i < output.size(); ++i )
+		maxValue = std::max( maxValue, math<float>::abs( output[i] ) );
+
+	bool passed = maxValue < 100.0f;
+	cout << "Blackman hop 1024: max output " << maxValue << ( passed ? "" : " FAILED" ) << endl;
+	return passed;
+}
+
+int main( int /*argc*/, char * const /*argv*/[] )
+{
+	const StftProcessor::WindowType windows[] = { StftProcessor::WINDOW_HANN, StftProcessor::WINDOW_HAMMING, StftProcessor::WINDOW_BLACKMAN, StftProcessor::WINDOW_RECTANGULAR };
+	const uint32_t hopSizes[] = { 512, 256, 100 };
+
+	bool passed = true;
+	for( int w = 0; w < 4; ++w ) {
+		for( int h = 0; h < 3; ++h )
+			passed = testRoundTrip( windows[w], hopSizes[h] ) && passed;
+	}
+	passed = testSparseOverlap() && passed;
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+#include "cinder/TriMeshBvh.h"
+#include "cinder/ObjLoader.h"
+#include "cinder/Timer.h"
+#include "cinder/Rand.h"
+#include "cinder/CinderMath.h"
+
+#include <iostream>
+#include <string>
+
+using namespace ci;
+using namespace std;
+
+// Fills \a mesh with a bumpy (resolution x resolution) grid of quads over the unit square
+void makeGrid( TriMesh *mesh, int resolution )
+{
+	Rand rnd;
+	const int side = resolution + 1;
+	for( int y = 0; y < side; ++y )
+		for( int x = 0; x < side; ++x )
+			mesh->appendVertex( Vec3f( x / (float)resolution, y / (float)resolution, rnd.nextFloat() * 0.01f ) );
+	for( int y = 0; y < resolution; ++y ) {
+		for( int x = 0; x < resolution; ++x ) {
+			int a = y * side + x, b = a + 1, c = a + side, d = c + 1;
+			mesh->appendTriangle( a, b, d );
+			mesh->appendTriangle( a, d, c );
+		}
+	}
+}
+
+void report( const string &label, const Timer &timer, size_t numRays )
+{
+	cout << label << ": " << timer.getSeconds() * 1000.0 << "ms, " << numRays / timer.getSeconds() / 1000000.0 << " Mrays/s" << endl;
+}
+
+// Compares the BVH's closest hits for \a rays against testing every triangle, returning the number of rays that disagree
+size_t verify( const TriMesh &mesh, const TriMeshBvh &bvh, const vector<Ray> &rays, size_t numRays )
+{
+	size_t mismatches = 0;
+	for( size_t r = 0; r < numRays; ++r ) {
+		float closest = numeric_limits<float>::max();
+		for( size_t t = 0; t < mesh.getNumTriangles(); ++t ) {
+			Vec3f a, b, c;
+			float distance;
+			mesh.getTriangleVertices( t, &a, &b, &c );
+			if( rays[r].calcTriangleIntersection( a, b, c, &distance ) && ( distance > 0 ) && ( distance < closest ) )
+				closest = distance;
+		}
+		TriMeshBvh::Hit hit;
+		bool found = bvh.intersect( rays[r], &hit );
+		if( ( found != ( closest < numeric_limits<float>::max() ) ) || ( found && ( math<float>::abs( hit.mDistance - closest ) > closest * 1e-5f ) ) )
+			++mismatches;
+	}
+	return mismatches;
+}
+
+// Pass the path of an OBJ to trace against; otherwise a 2M triangle grid is used
+int main( int argc, char * const argv[] )
+{
+	TriMesh mesh;
+	if( argc > 1 )
+		ObjLoader( loadFile( argv[1] ) ).load( &mesh );
+	else
+		makeGrid( &mesh, 1000 );
+	cout << mesh.getNumTriangles() << " triangles" << endl;
+
+	Timer timer( true );
+	TriMeshBvh bvh( mesh );
+	timer.stop();
+	cout << "Build: " << timer.getSeconds() * 1000.0 << "ms, " << bvh.getNumNodes() << " nodes" << endl;
+
+	timer.start();
+	TriMeshBvh bvhSerial( mesh, TriMeshBvh::Options().numThreads( 1 ) );
+	timer.stop();
+	cout << "Build on one thread: " << timer.getSeconds() * 1000.0 << "ms" << endl;
+
+	// coherent rays, like a camera's, looking down on the mesh from above its bounds
+	const AxisAlignedBox3f bounds = bvh.getBoundingBox();
+	const size_t numRays = 1000 * 1000;
+	vector<Ray> rays( numRays );
+	vector<TriMeshBvh::Hit> hits( numRays );
+	for( size_t r = 0; r < numRays; ++r ) {
+		Vec3f target = bounds.getMin() + bounds.getSize() * Vec3f( ( r % 1000 + 0.5f ) / 1000.0f, ( r / 1000 + 0.5f ) / 1000.0f, 0.5f );
+		Vec3f origin = bounds.getCenter() + Vec3f( 0, 0, bounds.getSize().length() );
+		rays[r] = Ray( origin, target - origin );
+	}
+
+	timer.start();
+	for( size_t r = 0; r < numRays; ++r )
+		bvh.intersect( rays[r], &hits[r] );
+	timer.stop();
+	report( "Closest hit, coherent", timer, numRays );
+
+	timer.start();
+	bvh.intersect( &rays[0], numRays, &hits[0] );
+	timer.stop();
+	report( "Packets, coherent", timer, numRays );
+
+	timer.start();
+	bvh.intersect( &rays[0], numRays, &hits[0], 0 );
+	timer.stop();
+	report( "Packets, coherent, all cores", timer, numRays );
+
+	// incoherent rays, like those of light baking, from random points in the bounds in random directions
+	Rand rnd;
+	for( size_t r = 0; r < numRays; ++r ) {
+		Vec3f origin = bounds.getMin() + bounds.getSize() * Vec3f( rnd.nextFloat(), rnd.nextFloat(), rnd.nextFloat() );
+		rays[r] = Ray( origin, rnd.nextVec3f() );
+	}
+
+	timer.start();
+	for( size_t r = 0; r < numRays; ++r )
+		bvh.intersect( rays[r], &hits[r] );
+	timer.stop();
+	report( "Closest hit, incoherent", timer, numRays );
+
+	timer.start();
+	size_t occluded = 0;
+	for( size_t r = 0; r < numRays; ++r )
+		occluded += bvh.intersects( rays[r] ) ? 1 : 0;
+	timer.stop();
+	report( "Any hit, incoherent", timer, numRays );
+	cout << occluded << " rays occluded" << endl;
+
+	timer.start();
+	bvh.intersect( &rays[0], numRays, &hits[0], 0 );
+	timer.stop();
+	report( "Packets, incoherent, all cores", timer, numRays );
+
+	cout << "Mismatches against brute force: " << verify( mesh, bvh, rays, 100 ) << " of 100" << endl;
+
+	return 0;
+}
@@ -0,0 +1,108 @@
+#include "cinder/TriMesh.h"
+#include "cinder/DataSource.h"
+#include "cinder/DataTarget.h"
+#include "cinder/Timer.h"
+#include "cinder/Rand.h"
+#include "cinder/Utilities.h"
+
+#include <iostream>
+#include <string>
+
+using namespace ci;
+using namespace std;
+
+// Fills \a mesh with a (resolution x resolution) grid of quads with random heights, normals and tex coords
+void makeGrid( TriMesh *mesh, int resolution )
+{
+	Rand rnd;
+	const int side = resolution + 1;
+	for( int y = 0; y < side; ++y ) {
+		for( int x = 0; x < side; ++x ) {
+			mesh->appendVertex( Vec3f( x / (float)resolution, y / (float)resolution, rnd.nextFloat() * 0.1f ) );
+			mesh->appendNormal( Vec3f( rnd.nextFloat( -0.1f, 0.1f ), rnd.nextFloat( -0.1f, 0.1f ), 1.0f ).normalized() );
+			mesh->appendTexCoord( Vec2f( x / (float)resolution, y / (float)resolution ) );
+		}
+	}
+	for( int y = 0; y < resolution; ++y ) {
+		for( int x = 0; x < resolution; ++x ) {
+			int a = y * side + x, b = a + 1, c = a + side, d = c + 1;
+			mesh->appendTriangle( a, b, d );
+			mesh->appendTriangle( a, d, c );
+		}
+	}
+}
+
+void report( const string &label, const Timer &timer, int iterations )
+{
+	cout << label << ": " << ( timer.getSeconds() / iterations ) * 1000.0 << "ms / mesh" << endl;
+}
+
+// Times reading the file at \a path through a file stream, a mapped file and a TriMeshMapped view
+void benchmarkRead( const string &label, const string &path, int iterations )
+{
+	Timer timer( true );
+	for( int i = 0; i < iterations; ++i ) {
+		TriMesh mesh;
+		mesh.read( loadFile( path ) );
+	}
+	timer.stop();
+	report( label + " from file stream", timer, iterations );
+
+	timer.start();
+	for( int i = 0; i < iterations; ++i ) {
+		TriMesh mesh;
+		mesh.read( loadFileMapped( path ) );
+	}
+	timer.stop();
+	report( label + " from mapped file", timer, iterations );
+
+	// files in the original format can't be viewed in place
+	try {
+		timer.start();
+		for( int i = 0; i < iterations; ++i )
+			TriMeshMappedRef mesh = TriMeshMapped::createRef( loadFileMapped( path ) );
+		timer.stop();
+		report( label + " as TriMeshMapped", timer, iterations );
+	}
+	catch( TriMeshExc & ) {
+		cout << label << " as TriMeshMapped: unsupported format" << endl;
+	}
+}
+
+void benchmarkMesh( const string &label, int resolution, int iterations )
+{
+	TriMesh mesh;
+	makeGrid( &mesh, resolution );
+	cout << label << ": " << mesh.getNumTriangles() << " triangles" << endl;
+
+	const string tempPath = getTemporaryFilePath( "TriMeshIoBenchmark" );
+	const string path = tempPath + ".msh";
+	Timer timer( true );
+	for( int i = 0; i < iterations; ++i )
+		mesh.write( writeFile( path ) );
+	timer.stop();
+	report( label + " write", timer, iterations );
+	benchmarkRead( label, path, iterations );
+
+	const string quantizedPath = tempPath + "-quantized.msh";
+	mesh.write( writeFile( quantizedPath ), TriMesh::WriteOptions().quantizeNormals().quantizeTexCoords() );
+	benchmarkRead( label + " quantized", quantizedPath, iterations );
+
+	// on MSW getTemporaryFilePath() creates the file it names, so remove that as well as the meshes
+	deleteFile( path );
+	deleteFile( quantizedPath );
+	deleteFile( tempPath );
+}
+
+int main( int argc, char * const argv[] )
+{
+	// many small meshes exercise the per-file overhead, one large mesh the bulk transfer
+	benchmarkMesh( "Small", 16, 10000 );
+	benchmarkMesh( "Large", 1000, 10 );
+
+	// pass the path of an existing .msh to time it as well, e.g. one in the original format
+	if( argc > 1 )
+		benchmarkRead( argv[1], argv[1], 100 );
+
+	return 0;
+}